@@ -0,0 +1,391 @@
+/**
+ * Benchmark de host: kernels de píxeles (proyecto TPI2)
+ *
+ * Microbenchmarks al estilo de Google Benchmark para image_kernels.h, sin
+ * dependencias: cada caso se registra con BENCHMARK(), se repite hasta
+ * llenar --min-time y se informa del tiempo por iteración, las iteraciones y
+ * los bytes por segundo. Antes de medir, cada kernel se compara con una
+ * versión de referencia trivial sobre imágenes aleatorias de tamaños y
+ * alineaciones variadas (el camino vectorial tiene que dar lo mismo).
+ *
+ * El camino (escalar o vectorial) se elige al compilar, como en el firmware:
+ *   pio run -e bench_image          && .pio/build/bench_image/program
+ *   pio run -e bench_image_scalar   && .pio/build/bench_image_scalar/program
+ * Opciones: --filter TEXTO (solo los casos que lo contienen), --min-time S
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../src/image_kernels.h"
+#include "../src/motion_detect.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// ============================================================================
+// REGISTRO Y MEDICIÓN
+// ============================================================================
+
+struct BenchState {
+  uint16_t w;
+  uint16_t h;
+  size_t iterations;
+  size_t bytesPerIteration;   // Lo fija el caso: bytes leídos por iteración
+  double seconds;             // Solo el bucle medido (sin preparar los datos)
+  Clock::time_point start;
+
+  void startTiming() { start = Clock::now(); }
+  void stopTiming() { seconds = std::chrono::duration<double>(Clock::now() - start).count(); }
+};
+
+typedef void (*BenchFn)(BenchState &state);
+
+struct BenchCase {
+  const char *name;
+  BenchFn fn;
+};
+
+static std::vector<BenchCase> &registry() {
+  static std::vector<BenchCase> cases;
+  return cases;
+}
+
+struct BenchRegistrar {
+  BenchRegistrar(const char *name, BenchFn fn) { registry().push_back({name, fn}); }
+};
+
+#define BENCHMARK(fn) static BenchRegistrar registrar_##fn(#fn, fn)
+
+// Evita que el compilador elimine un resultado que no se usa
+static volatile uint32_t sink;
+
+// Tamaños de imagen: rejilla del detector, QVGA y VGA
+static const uint16_t kSizes[][2] = {{96, 96}, {320, 240}, {640, 480}};
+
+static uint32_t rngState = 12345;
+
+static uint8_t randomByte() {
+  rngState = rngState * 1103515245u + 12345u;
+  return (uint8_t)(rngState >> 16);
+}
+
+static std::vector<uint8_t> randomImage(size_t bytes) {
+  std::vector<uint8_t> img(bytes);
+  for (auto &p : img) p = randomByte();
+  return img;
+}
+
+// ============================================================================
+// CASOS
+// ============================================================================
+
+static void BM_BoxDownscaleTo96(BenchState &state) {
+  std::vector<uint8_t> src = randomImage((size_t)state.w * state.h);
+  std::vector<uint8_t> dst(96 * 96);
+  std::vector<uint32_t> sums(96);
+  state.startTiming();
+  for (size_t i = 0; i < state.iterations; i++) {
+    imgBoxDownscale(src.data(), state.w, state.h, state.w, dst.data(), 96, 96, sums.data());
+  }
+  state.stopTiming();
+  sink = dst[0];
+  state.bytesPerIteration = src.size();
+}
+BENCHMARK(BM_BoxDownscaleTo96);
+
+static void BM_YuyvToGray(BenchState &state) {
+  size_t n = (size_t)state.w * state.h;
+  std::vector<uint8_t> yuyv = randomImage(2 * n);
+  std::vector<uint8_t> gray(n);
+  state.startTiming();
+  for (size_t i = 0; i < state.iterations; i++) imgYuyvToGray(yuyv.data(), gray.data(), n);
+  state.stopTiming();
+  sink = gray[0];
+  state.bytesPerIteration = yuyv.size();
+}
+BENCHMARK(BM_YuyvToGray);
+
+static void BM_Rgb888ToGray(BenchState &state) {
+  size_t n = (size_t)state.w * state.h;
+  std::vector<uint8_t> rgb = randomImage(3 * n);
+  std::vector<uint8_t> gray(n);
+  state.startTiming();
+  for (size_t i = 0; i < state.iterations; i++) imgRgb888ToGray(rgb.data(), gray.data(), n);
+  state.stopTiming();
+  sink = gray[0];
+  state.bytesPerIteration = rgb.size();
+}
+BENCHMARK(BM_Rgb888ToGray);
+
+static void BM_AbsDiff(BenchState &state) {
+  size_t n = (size_t)state.w * state.h;
+  std::vector<uint8_t> a = randomImage(n), b = randomImage(n), out(n);
+  state.startTiming();
+  for (size_t i = 0; i < state.iterations; i++) imgAbsDiff(a.data(), b.data(), out.data(), n);
+  state.stopTiming();
+  sink = out[0];
+  state.bytesPerIteration = 2 * n;
+}
+BENCHMARK(BM_AbsDiff);
+
+static void BM_AbsDiffSum(BenchState &state) {
+  size_t n = (size_t)state.w * state.h;
+  std::vector<uint8_t> a = randomImage(n), b = randomImage(n);
+  uint32_t total = 0;
+  state.startTiming();
+  for (size_t i = 0; i < state.iterations; i++) total += imgAbsDiffSum(a.data(), b.data(), n);
+  state.stopTiming();
+  sink = total;
+  state.bytesPerIteration = 2 * n;
+}
+BENCHMARK(BM_AbsDiffSum);
+
+static void BM_BlockSums8(BenchState &state) {
+  std::vector<uint8_t> img = randomImage((size_t)state.w * state.h);
+  std::vector<uint32_t> sums((size_t)(state.w / 8) * (state.h / 8));
+  state.startTiming();
+  for (size_t i = 0; i < state.iterations; i++) {
+    imgBlockSums(img.data(), state.w, state.h, state.w, 8, sums.data());
+  }
+  state.stopTiming();
+  sink = sums[0];
+  state.bytesPerIteration = img.size();
+}
+BENCHMARK(BM_BlockSums8);
+
+static void BM_Histogram(BenchState &state) {
+  std::vector<uint8_t> img = randomImage((size_t)state.w * state.h);
+  uint32_t hist[256];
+  state.startTiming();
+  for (size_t i = 0; i < state.iterations; i++) {
+    memset(hist, 0, sizeof(hist));
+    imgHistogram(img.data(), state.w, state.h, state.w, hist);
+  }
+  state.stopTiming();
+  sink = hist[0];
+  state.bytesPerIteration = img.size();
+}
+BENCHMARK(BM_Histogram);
+
+static void BM_BlockSadQ8(BenchState &state) {
+  size_t n = (size_t)state.w * state.h;
+  std::vector<uint8_t> gray = randomImage(n);
+  std::vector<uint16_t> bg(n);
+  for (auto &v : bg) v = (uint16_t)(randomByte() << 8 | randomByte());
+  std::vector<uint32_t> sums((size_t)(state.w / 8) * (state.h / 8));
+  state.startTiming();
+  for (size_t i = 0; i < state.iterations; i++) {
+    imgBlockSadQ8(gray.data(), bg.data(), state.w, state.h, 8, sums.data());
+  }
+  state.stopTiming();
+  sink = sums[0];
+  state.bytesPerIteration = 3 * n;
+}
+BENCHMARK(BM_BlockSadQ8);
+
+static void BM_BlendQ8(BenchState &state) {
+  size_t n = (size_t)state.w * state.h;
+  std::vector<uint8_t> gray = randomImage(n);
+  std::vector<uint16_t> bg(n, 128 << 8);
+  state.startTiming();
+  for (size_t i = 0; i < state.iterations; i++) imgBlendQ8(bg.data(), gray.data(), n, 4);
+  state.stopTiming();
+  sink = bg[0];
+  state.bytesPerIteration = 3 * n;
+}
+BENCHMARK(BM_BlendQ8);
+
+// El detector de movimiento completo (fondo, bloques, aprendizaje) sobre kernels
+static void BM_MotionProcess(BenchState &state) {
+  MotionParams params = {state.w, state.h, 8, 12, 3, 60, 4, 1};
+  MotionDetector detector;
+  if (!detector.begin(params)) return;
+  std::vector<uint8_t> a = randomImage((size_t)state.w * state.h);
+  std::vector<uint8_t> b = a;
+  for (size_t p = 0; p < b.size(); p += 7) b[p] ^= 0x10;
+  uint32_t changed = 0;
+  state.startTiming();
+  for (size_t i = 0; i < state.iterations; i++) {
+    changed += detector.process((i & 1) ? a.data() : b.data()).changedBlocks;
+  }
+  state.stopTiming();
+  sink = changed;
+  state.bytesPerIteration = a.size();
+}
+BENCHMARK(BM_MotionProcess);
+
+// ============================================================================
+// VERIFICACIÓN CONTRA LA REFERENCIA
+// ============================================================================
+
+static int failures = 0;
+
+static void expect(bool ok, const char *kernel, size_t n, size_t offset) {
+  if (ok) return;
+  if (failures++ < 10) fprintf(stderr, "✗ %s distinto de la referencia (n=%zu, desfase %zu)\n",
+                               kernel, n, offset);
+}
+
+static int verify() {
+  for (size_t n = 1; n < 300; n += 37) {
+    for (size_t off = 0; off < 4; off++) {
+      // Desfases distintos en cada buffer para probar también el camino sin alinear
+      std::vector<uint8_t> a = randomImage(n + 8), b = randomImage(n + 8);
+      std::vector<uint8_t> out(n + 8), yuyv = randomImage(2 * n + 8), rgb = randomImage(3 * n + 8);
+      const uint8_t *pa = a.data() + off;
+      const uint8_t *pb = b.data() + (off & 2);
+
+      uint32_t sad = 0;
+      bool same = true;
+      imgAbsDiff(pa, pb, out.data() + off, n);
+      for (size_t i = 0; i < n; i++) {
+        int d = abs((int)pa[i] - pb[i]);
+        sad += (uint32_t)d;
+        same = same && out[off + i] == d;
+      }
+      expect(same, "imgAbsDiff", n, off);
+      expect(imgAbsDiffSum(pa, pb, n) == sad, "imgAbsDiffSum", n, off);
+
+      imgYuyvToGray(yuyv.data() + 2 * (off & 2), out.data() + off, n);
+      same = true;
+      for (size_t i = 0; i < n; i++) same = same && out[off + i] == yuyv[2 * (off & 2) + 2 * i];
+      expect(same, "imgYuyvToGray", n, off);
+
+      imgRgb888ToGray(rgb.data() + off, out.data(), n);
+      same = true;
+      for (size_t i = 0; i < n; i++) {
+        const uint8_t *px = rgb.data() + off + 3 * i;
+        same = same && out[i] == ((77 * px[0] + 150 * px[1] + 29 * px[2]) >> 8);
+      }
+      expect(same, "imgRgb888ToGray", n, off);
+    }
+  }
+
+  // Bloques, histograma, fondo 8.8 y reducción sobre imágenes con stride
+  const uint16_t w = 96, h = 64, stride = 100;
+  for (uint8_t block : {4, 6, 8, 16}) {
+    std::vector<uint8_t> img = randomImage((size_t)stride * h);
+    std::vector<uint32_t> sums((size_t)(w / block) * (h / block));
+    imgBlockSums(img.data(), w, h, stride, block, sums.data());
+    bool same = true;
+    for (int by = 0; by < h / block; by++) {
+      for (int bx = 0; bx < w / block; bx++) {
+        uint32_t s = 0;
+        for (int y = 0; y < block; y++) {
+          for (int x = 0; x < block; x++) s += img[(size_t)(by * block + y) * stride + bx * block + x];
+        }
+        same = same && sums[by * (w / block) + bx] == s;
+      }
+    }
+    expect(same, "imgBlockSums", block, 0);
+
+    std::vector<uint8_t> gray = randomImage((size_t)w * h);
+    std::vector<uint16_t> bg((size_t)w * h);
+    for (auto &v : bg) v = (uint16_t)(randomByte() << 8 | randomByte());
+    imgBlockSadQ8(gray.data(), bg.data(), w, h, block, sums.data());
+    same = true;
+    for (int by = 0; by < h / block; by++) {
+      for (int bx = 0; bx < w / block; bx++) {
+        uint32_t s = 0;
+        for (int y = 0; y < block; y++) {
+          for (int x = 0; x < block; x++) {
+            size_t i = (size_t)(by * block + y) * w + bx * block + x;
+            s += (uint32_t)abs((int)gray[i] - (bg[i] >> 8));
+          }
+        }
+        same = same && sums[by * (w / block) + bx] == s;
+      }
+    }
+    expect(same, "imgBlockSadQ8", block, 0);
+  }
+
+  std::vector<uint8_t> img = randomImage((size_t)stride * h);
+  uint32_t hist[256] = {0}, ref[256] = {0};
+  imgHistogram(img.data(), w, h, stride, hist);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) ref[img[(size_t)y * stride + x]]++;
+  }
+  expect(memcmp(hist, ref, sizeof(hist)) == 0, "imgHistogram", (size_t)w * h, 0);
+
+  // Reducción exacta 2x: cada salida es la media redondeada de 2x2
+  std::vector<uint8_t> small(48 * 32);
+  std::vector<uint32_t> rowSums(48);
+  imgBoxDownscale(img.data(), w, h, stride, small.data(), 48, 32, rowSums.data());
+  bool same = true;
+  for (int y = 0; y < 32; y++) {
+    for (int x = 0; x < 48; x++) {
+      const uint8_t *p = img.data() + (size_t)(2 * y) * stride + 2 * x;
+      uint32_t s = p[0] + p[1] + p[stride] + p[stride + 1];
+      same = same && small[y * 48 + x] == (s + 2) / 4;
+    }
+  }
+  expect(same, "imgBoxDownscale", 48 * 32, 0);
+  return failures;
+}
+
+// ============================================================================
+// PRINCIPAL
+// ============================================================================
+
+int main(int argc, char **argv) {
+  const char *filter = NULL;
+  double minTime = 0.2;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--filter")) {
+      filter = argv[i + 1];
+    } else if (!strcmp(argv[i], "--min-time")) {
+      minTime = atof(argv[i + 1]);
+    } else {
+      fprintf(stderr, "Opción desconocida: %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  printf("Camino de image_kernels: %s\n", imgKernelsPath());
+  if (verify() != 0) {
+    fprintf(stderr, "%d kernels no coinciden con la referencia\n", failures);
+    return 1;
+  }
+  printf("Verificación contra la referencia: OK\n\n");
+
+  printf("%-32s %12s %12s %12s\n", "Benchmark", "Tiempo", "Iteraciones", "MB/s");
+  printf("%s\n", std::string(71, '-').c_str());
+  for (const BenchCase &c : registry()) {
+    for (const auto &size : kSizes) {
+      char name[64];
+      snprintf(name, sizeof(name), "%s/%ux%u", c.name, size[0], size[1]);
+      if (filter && !strstr(name, filter)) continue;
+
+      // Como Google Benchmark: se multiplica el número de iteraciones hasta
+      // que una tanda dura al menos minTime
+      BenchState state = {size[0], size[1], 1, 0, 0, Clock::time_point()};
+      double seconds = 0;
+      for (;;) {
+        c.fn(state);
+        seconds = state.seconds;
+        if (seconds >= minTime || state.iterations >= (1u << 30)) break;
+        double grow = seconds > 0 ? 1.4 * minTime / seconds : 10;
+        if (grow > 10) grow = 10;
+        if (grow < 2) grow = 2;
+        state.iterations = (size_t)(state.iterations * grow);
+      }
+      double ns = seconds * 1e9 / state.iterations;
+      double mbps = state.bytesPerIteration * state.iterations / seconds / 1e6;
+      char time[24];
+      if (ns >= 1e6) {
+        snprintf(time, sizeof(time), "%.2f ms", ns / 1e6);
+      } else if (ns >= 1e3) {
+        snprintf(time, sizeof(time), "%.2f us", ns / 1e3);
+      } else {
+        snprintf(time, sizeof(time), "%.0f ns", ns);
+      }
+      printf("%-32s %12s %12zu %12.0f\n", name, time, state.iterations, mbps);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,278 @@
+/**
+ * Benchmark de host: detector de movimiento de la cámara (proyecto TPI2)
+ *
+ * Pasa una secuencia de frames por el mismo código que el firmware
+ * (motion_jpeg.h + motion_detect.h) y, para varios umbrales de bloque, cuenta
+ * los frames con movimiento. Sirve para ajustar la sensibilidad de config.h
+ * y para ver el coste por frame:
+ *  - decodificar: JPEG -> rejilla en gris (solo con frames grabados)
+ *  - detectar: comparación con el fondo y actualización
+ *
+ * Con JPEG grabados (en el orden de los argumentos) se listan los frames que
+ * disparan. Sin argumentos se genera una secuencia sintética con la verdad
+ * conocida: fondo con ruido, un objeto grande que cruza la imagen, un cambio
+ * de luz brusco y un objeto pequeño; se cuentan aciertos y falsos positivos.
+ *
+ * Uso:
+ *   pio run -e bench_motion
+ *   .pio/build/bench_motion/program [opciones] [frame.jpg ...]
+ * Opciones: --grid WxH, --block N, --min-blocks N, --learn N, --warmup N,
+ *           --max-changed PCT, --thresholds a,b,c, --noise N (sintética)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../src/motion_detect.h"
+#include "../src/motion_jpeg.h"
+
+typedef std::chrono::steady_clock Clock;
+
+struct Sequence {
+  std::vector<std::vector<uint8_t>> frames;  // Rejillas en gris
+  std::vector<std::string> names;
+  std::vector<bool> truth;                   // Solo en la sintética
+  double decodeUs;                           // Media por frame (0 si no hubo JPEG)
+};
+
+// ============================================================================
+// SECUENCIA SINTÉTICA
+// ============================================================================
+
+static uint32_t rngState = 12345;
+
+static int noise(int amplitude) {
+  rngState = rngState * 1103515245u + 12345u;
+  return amplitude ? (int)((rngState >> 16) % (2 * amplitude + 1)) - amplitude : 0;
+}
+
+static uint8_t clampPixel(int v) {
+  return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static void drawSquare(std::vector<uint8_t> &f, int w, int h, int x0, int y0, int size, int value) {
+  for (int y = y0; y < y0 + size; y++) {
+    for (int x = x0; x < x0 + size; x++) {
+      if (x >= 0 && x < w && y >= 0 && y < h) f[(size_t)y * w + x] = (uint8_t)value;
+    }
+  }
+}
+
+// 120 frames: 0-39 quietos, 40-59 objeto de 16 px cruzando, 60-79 quietos,
+// 80 sube la luz (+40) y sigue así, 100-119 objeto de 6 px
+static Sequence syntheticSequence(int w, int h, int noiseAmp) {
+  Sequence seq;
+  seq.decodeUs = 0;
+  std::vector<uint8_t> base((size_t)w * h);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      // Degradado con algo de textura, como vegetación / agua
+      base[(size_t)y * w + x] = clampPixel(60 + x * 80 / w + y * 40 / h + ((x * 7 + y * 13) % 17));
+    }
+  }
+
+  for (int i = 0; i < 120; i++) {
+    int light = i >= 80 ? 40 : 0;
+    std::vector<uint8_t> f(base.size());
+    for (size_t p = 0; p < f.size(); p++) f[p] = clampPixel(base[p] + light + noise(noiseAmp));
+    bool moving = false;
+    if (i >= 40 && i < 60) {
+      drawSquare(f, w, h, (i - 40) * (w - 16) / 19, h / 2 - 8, 16, 20);
+      moving = true;
+    }
+    if (i >= 100) {
+      drawSquare(f, w, h, w / 4 + (i - 100) * 2, h / 4, 6, 230);
+      moving = true;
+    }
+    seq.frames.push_back(f);
+    seq.truth.push_back(moving);
+    seq.names.push_back(std::to_string(i));
+  }
+  return seq;
+}
+
+// ============================================================================
+// FRAMES GRABADOS
+// ============================================================================
+
+static bool loadFile(const char *path, std::vector<uint8_t> &out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  out.resize(size > 0 ? (size_t)size : 0);
+  size_t n = fread(out.data(), 1, out.size(), f);
+  fclose(f);
+  return n == out.size();
+}
+
+static Sequence recordedSequence(char **paths, int count, int w, int h) {
+  Sequence seq;
+  std::vector<uint16_t> scratch((size_t)w * h);
+  double totalUs = 0;
+  for (int i = 0; i < count; i++) {
+    std::vector<uint8_t> jpeg;
+    if (!loadFile(paths[i], jpeg)) {
+      fprintf(stderr, "No se pudo leer %s\n", paths[i]);
+      continue;
+    }
+    std::vector<uint8_t> gray((size_t)w * h);
+    auto start = Clock::now();
+    bool ok = motionJpegToGray(jpeg.data(), jpeg.size(), gray.data(), w, h, scratch.data());
+    totalUs += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    if (!ok) {
+      fprintf(stderr, "No se pudo decodificar %s\n", paths[i]);
+      continue;
+    }
+    const char *name = strrchr(paths[i], '/');
+    seq.frames.push_back(gray);
+    seq.names.push_back(name ? name + 1 : paths[i]);
+  }
+  seq.decodeUs = seq.frames.empty() ? 0 : totalUs / seq.frames.size();
+  return seq;
+}
+
+// ============================================================================
+// MEDICIÓN
+// ============================================================================
+
+struct RunResult {
+  std::vector<bool> motion;
+  int lighting;
+  double detectUs;
+};
+
+static RunResult run(const MotionParams &params, const Sequence &seq) {
+  RunResult r;
+  r.lighting = 0;
+  MotionDetector detector;
+  if (!detector.begin(params)) {
+    r.detectUs = 0;
+    return r;
+  }
+  for (const auto &f : seq.frames) {
+    MotionResult m = detector.process(f.data());
+    r.motion.push_back(m.motion);
+    if (m.lightingChange) r.lighting++;
+  }
+
+  // Tiempo: la secuencia entera varias veces para que la medida sea estable
+  const int reps = 50;
+  auto start = Clock::now();
+  for (int k = 0; k < reps; k++) {
+    detector.reset();
+    for (const auto &f : seq.frames) detector.process(f.data());
+  }
+  double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+  r.detectUs = us / (reps * (double)seq.frames.size());
+  return r;
+}
+
+static std::vector<int> parseList(const char *s) {
+  std::vector<int> out;
+  while (*s) {
+    out.push_back(atoi(s));
+    const char *comma = strchr(s, ',');
+    if (!comma) break;
+    s = comma + 1;
+  }
+  return out;
+}
+
+int main(int argc, char **argv) {
+  MotionParams params = {96, 96, 8, 12, 3, 60, 4, 4};
+  std::vector<int> thresholds = {6, 8, 12, 16, 24};
+  int noiseAmp = 6;
+
+  int first = 1;
+  for (; first < argc && strncmp(argv[first], "--", 2) == 0; first += 2) {
+    if (first + 1 >= argc) {
+      fprintf(stderr, "Falta el valor de %s\n", argv[first]);
+      return 1;
+    }
+    const char *opt = argv[first];
+    const char *val = argv[first + 1];
+    if (!strcmp(opt, "--grid")) {
+      unsigned w = 0, h = 0;
+      sscanf(val, "%ux%u", &w, &h);
+      params.width = (uint16_t)w;
+      params.height = (uint16_t)h;
+    } else if (!strcmp(opt, "--block")) {
+      params.blockSize = (uint8_t)atoi(val);
+    } else if (!strcmp(opt, "--min-blocks")) {
+      params.minBlocks = (uint16_t)atoi(val);
+    } else if (!strcmp(opt, "--learn")) {
+      params.learnShift = (uint8_t)atoi(val);
+    } else if (!strcmp(opt, "--warmup")) {
+      params.warmupFrames = (uint8_t)atoi(val);
+    } else if (!strcmp(opt, "--max-changed")) {
+      params.maxChangedPct = (uint8_t)atoi(val);
+    } else if (!strcmp(opt, "--thresholds")) {
+      thresholds = parseList(val);
+    } else if (!strcmp(opt, "--noise")) {
+      noiseAmp = atoi(val);
+    } else {
+      fprintf(stderr, "Opción desconocida: %s\n", opt);
+      return 1;
+    }
+  }
+
+  bool synthetic = first >= argc;
+  Sequence seq = synthetic ? syntheticSequence(params.width, params.height, noiseAmp)
+                           : recordedSequence(argv + first, argc - first, params.width,
+                                              params.height);
+  if (seq.frames.empty()) {
+    fprintf(stderr, "Sin frames\n");
+    return 1;
+  }
+
+  printf("%s: %zu frames, rejilla %ux%u, bloques de %u, mín %u bloques, fondo 1/%d, "
+         "luz > %u%%\n",
+         synthetic ? "Secuencia sintética" : "Frames grabados", seq.frames.size(),
+         params.width, params.height, params.blockSize, params.minBlocks, 1 << params.learnShift,
+         params.maxChangedPct);
+  if (!synthetic) printf("Decodificar: %.1f us/frame\n", seq.decodeUs);
+
+  if (synthetic) {
+    printf("%9s | %8s %8s %8s | %6s | %10s\n", "umbral", "aciertos", "de", "falsos", "luz",
+           "us/frame");
+  } else {
+    printf("%9s | %8s | %6s | %10s | %s\n", "umbral", "disparos", "luz", "us/frame", "frames");
+  }
+
+  for (int t : thresholds) {
+    params.blockThreshold = (uint8_t)t;
+    RunResult r = run(params, seq);
+    if (r.motion.empty()) {
+      fprintf(stderr, "Parámetros no válidos (el bloque tiene que dividir la rejilla)\n");
+      return 1;
+    }
+
+    if (synthetic) {
+      int hits = 0, expected = 0, falsePos = 0;
+      for (size_t i = 0; i < r.motion.size(); i++) {
+        if (seq.truth[i]) expected++;
+        if (r.motion[i] && seq.truth[i]) hits++;
+        if (r.motion[i] && !seq.truth[i]) falsePos++;
+      }
+      printf("%9d | %8d %8d %8d | %6d | %10.2f\n", t, hits, expected, falsePos, r.lighting,
+             r.detectUs);
+    } else {
+      int fired = 0;
+      std::string list;
+      for (size_t i = 0; i < r.motion.size(); i++) {
+        if (!r.motion[i]) continue;
+        fired++;
+        if (list.size() < 60) list += (list.empty() ? "" : " ") + seq.names[i];
+      }
+      printf("%9d | %8d | %6d | %10.2f | %s\n", t, fired, r.lighting, r.detectUs, list.c_str());
+    }
+  }
+  return 0;
+}
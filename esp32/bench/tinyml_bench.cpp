@@ -0,0 +1,406 @@
+/**
+ * Benchmark de host: clasificador int8 de la cámara (proyecto TPI2)
+ *
+ * Pasa imágenes por el mismo código que el firmware (motion_jpeg.h para
+ * reducirlas a la rejilla en gris y tinyml_model.h para la red) y mide:
+ *  - latencia: decodificar y inferir, media / p50 / p95 / peor por imagen
+ *  - memoria: blob del modelo (flash), arena de activaciones y rejilla
+ *  - coste por capa: forma de salida, MACs y bytes de pesos
+ *  - concordancia con el modelo del servidor: con --labels (una línea
+ *    "<imagen> <hipopótamos>" por imagen, la escribe yolo/export_tinyml.py
+ *    con --label-images) cuenta aciertos, positivos perdidos y fotos subidas
+ *    para varios umbrales de negativo, para ajustar TINYML_NEGATIVE_BELOW_PCT.
+ *
+ * El modelo sale de --model (el .bin de export_tinyml.py), del compilado en
+ * tinyml_model_data.h o, si no hay ninguno, de pesos aleatorios con la
+ * arquitectura de export_tinyml.py (vale para latencia y memoria, no para la
+ * concordancia).
+ *
+ * Uso:
+ *   pio run -e bench_tinyml
+ *   .pio/build/bench_tinyml/program [opciones] ../runs/detect/val/val_batch*.jpg
+ * Opciones: --model m.bin, --labels f.txt, --reps N, --negative PCT, --positive PCT,
+ *           --thresholds a,b,c
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../src/motion_jpeg.h"
+#include "../src/tinyml_model.h"
+#include "../src/tinyml_model_data.h"
+
+typedef std::chrono::steady_clock Clock;
+
+struct Image {
+  std::string name;
+  std::vector<uint8_t> gray;
+  double decodeUs;
+  int hippos;               // Del servidor (--labels), -1 si no se sabe
+  float probability;
+  std::vector<double> inferUs;
+};
+
+// ============================================================================
+// MODELO ALEATORIO
+// ============================================================================
+
+// Arquitectura de yolo/export_tinyml.py: tipo, kernel, stride, pad, canales
+struct LayerSpec {
+  uint8_t type;
+  uint8_t kernel;
+  uint8_t stride;
+  uint8_t pad;
+  uint16_t outC;
+};
+
+static const LayerSpec kArchitecture[] = {
+    {TINYML_LAYER_CONV, 3, 2, 1, 8},      {TINYML_LAYER_DEPTHWISE, 3, 2, 1, 8},
+    {TINYML_LAYER_CONV, 1, 1, 0, 16},     {TINYML_LAYER_DEPTHWISE, 3, 2, 1, 16},
+    {TINYML_LAYER_CONV, 1, 1, 0, 32},     {TINYML_LAYER_DEPTHWISE, 3, 2, 1, 32},
+    {TINYML_LAYER_CONV, 1, 1, 0, 64},     {TINYML_LAYER_AVGPOOL, 0, 0, 0, 64},
+    {TINYML_LAYER_DENSE, 0, 0, 0, 1},
+};
+
+static uint32_t rngState = 12345;
+
+static int8_t randomWeight() {
+  rngState = rngState * 1103515245u + 12345u;
+  return (int8_t)((int)((rngState >> 16) % 255) - 127);
+}
+
+static void put16(std::vector<uint8_t> &b, uint16_t v) {
+  b.push_back(v & 0xFF);
+  b.push_back(v >> 8);
+}
+
+static void put32(std::vector<uint8_t> &b, uint32_t v) {
+  for (int i = 0; i < 4; i++) b.push_back((v >> (8 * i)) & 0xFF);
+}
+
+// Multiplicador en punto fijo de un factor real (como quantize_multiplier del exportador)
+static void quantizeMultiplier(double real, int32_t *mult, int32_t *shift) {
+  int exponent;
+  double mantissa = frexp(real, &exponent);
+  int64_t q = llround(mantissa * (1ll << 31));
+  if (q == (1ll << 31)) {
+    q /= 2;
+    exponent++;
+  }
+  *mult = (int32_t)q;
+  *shift = exponent;
+}
+
+static std::vector<uint8_t> randomModel(uint16_t w, uint16_t h) {
+  const size_t count = sizeof(kArchitecture) / sizeof(kArchitecture[0]);
+  std::vector<uint8_t> blob = {'H', 'T', 'M', '1'};
+  put16(blob, w);
+  put16(blob, h);
+  blob.push_back(1);
+  blob.push_back((uint8_t)count);
+  put16(blob, 0);
+  put32(blob, 0);  // Longitud: se rellena al final
+
+  uint16_t inC = 1;
+  for (size_t i = 0; i < count; i++) {
+    const LayerSpec &s = kArchitecture[i];
+    size_t weights = 0;
+    uint32_t fanIn = 1;
+    if (s.type == TINYML_LAYER_CONV) {
+      weights = (size_t)s.kernel * s.kernel * inC * s.outC;
+      fanIn = s.kernel * s.kernel * inC;
+    } else if (s.type == TINYML_LAYER_DEPTHWISE) {
+      weights = (size_t)s.kernel * s.kernel * s.outC;
+      fanIn = s.kernel * s.kernel;
+    } else if (s.type == TINYML_LAYER_DENSE) {
+      weights = (size_t)inC * s.outC;
+      fanIn = inC;
+    }
+    size_t data = s.type == TINYML_LAYER_AVGPOOL ? 0 : (12 * (size_t)s.outC + weights + 3) & ~3u;
+
+    blob.push_back(s.type);
+    blob.push_back(s.kernel);
+    blob.push_back(s.stride);
+    blob.push_back(s.pad);
+    put16(blob, s.outC);
+    blob.push_back(0);                                // Zero de salida
+    blob.push_back(s.type != TINYML_LAYER_DENSE && s.type != TINYML_LAYER_AVGPOOL);
+    float scale = 1.0f / 16;
+    uint32_t bits;
+    memcpy(&bits, &scale, sizeof(bits));
+    put32(blob, bits);
+    put32(blob, (uint32_t)data);
+    if (data) {
+      // Factor que deja las activaciones en el rango de int8
+      int32_t mult, shift;
+      quantizeMultiplier(1.0 / (64.0 * sqrt((double)fanIn)), &mult, &shift);
+      for (uint16_t c = 0; c < s.outC; c++) put32(blob, 0);
+      for (uint16_t c = 0; c < s.outC; c++) put32(blob, (uint32_t)mult);
+      for (uint16_t c = 0; c < s.outC; c++) put32(blob, (uint32_t)shift);
+      for (size_t k = 0; k < weights; k++) blob.push_back((uint8_t)randomWeight());
+      while (blob.size() % 4) blob.push_back(0);
+    }
+    inC = s.outC;
+  }
+  uint32_t len = (uint32_t)blob.size();
+  for (int i = 0; i < 4; i++) blob[12 + i] = (len >> (8 * i)) & 0xFF;
+  return blob;
+}
+
+// ============================================================================
+// ENTRADAS
+// ============================================================================
+
+static bool loadFile(const char *path, std::vector<uint8_t> &out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  out.resize(size > 0 ? (size_t)size : 0);
+  size_t n = fread(out.data(), 1, out.size(), f);
+  fclose(f);
+  return n == out.size();
+}
+
+static const char *baseName(const char *path) {
+  const char *slash = strrchr(path, '/');
+  return slash ? slash + 1 : path;
+}
+
+// "<imagen> <hipopótamos>" por línea; la imagen sin directorio
+static std::map<std::string, int> loadLabels(const char *path) {
+  std::map<std::string, int> labels;
+  FILE *f = fopen(path, "r");
+  if (!f) return labels;
+  char line[512];
+  while (fgets(line, sizeof(line), f)) {
+    char name[400];
+    int hippos;
+    if (line[0] != '#' && sscanf(line, "%399s %d", name, &hippos) == 2) {
+      labels[baseName(name)] = hippos;
+    }
+  }
+  fclose(f);
+  return labels;
+}
+
+static std::vector<int> parseList(const char *s) {
+  std::vector<int> out;
+  while (*s) {
+    out.push_back(atoi(s));
+    const char *comma = strchr(s, ',');
+    if (!comma) break;
+    s = comma + 1;
+  }
+  return out;
+}
+
+static double percentile(std::vector<double> v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+  return v[i];
+}
+
+static const char *layerName(uint8_t type) {
+  switch (type) {
+    case TINYML_LAYER_CONV: return "conv";
+    case TINYML_LAYER_DEPTHWISE: return "depthwise";
+    case TINYML_LAYER_AVGPOOL: return "avgpool";
+    case TINYML_LAYER_DENSE: return "densa";
+    default: return "?";
+  }
+}
+
+// ============================================================================
+// MEDICIÓN
+// ============================================================================
+
+int main(int argc, char **argv) {
+  const char *modelPath = NULL;
+  const char *labelsPath = NULL;
+  int reps = 20;
+  int negativePct = 20, positivePct = 60;
+  std::vector<int> thresholds = {5, 10, 20, 30, 40, 50};
+
+  int first = 1;
+  for (; first < argc && strncmp(argv[first], "--", 2) == 0; first += 2) {
+    if (first + 1 >= argc) {
+      fprintf(stderr, "Falta el valor de %s\n", argv[first]);
+      return 1;
+    }
+    const char *opt = argv[first];
+    const char *val = argv[first + 1];
+    if (!strcmp(opt, "--model")) {
+      modelPath = val;
+    } else if (!strcmp(opt, "--labels")) {
+      labelsPath = val;
+    } else if (!strcmp(opt, "--reps")) {
+      reps = std::max(1, atoi(val));
+    } else if (!strcmp(opt, "--negative")) {
+      negativePct = atoi(val);
+    } else if (!strcmp(opt, "--positive")) {
+      positivePct = atoi(val);
+    } else if (!strcmp(opt, "--thresholds")) {
+      thresholds = parseList(val);
+    } else {
+      fprintf(stderr, "Opción desconocida: %s\n", opt);
+      return 1;
+    }
+  }
+  if (first >= argc) {
+    fprintf(stderr, "Uso: %s [opciones] imagen.jpg ...\n", argv[0]);
+    return 1;
+  }
+
+  // Modelo: --model, el compilado o uno aleatorio
+  std::vector<uint8_t> bytes;
+  const char *source;
+  if (modelPath) {
+    if (!loadFile(modelPath, bytes)) {
+      fprintf(stderr, "No se pudo leer %s\n", modelPath);
+      return 1;
+    }
+    source = modelPath;
+  } else if (TINYML_MODEL_LEN > 0) {
+    bytes.assign(kTinymlModel, kTinymlModel + TINYML_MODEL_LEN);
+    source = "tinyml_model_data.h";
+  } else {
+    bytes = randomModel(96, 96);
+    source = "pesos aleatorios (sin modelo exportado)";
+  }
+  // En un vector de uint32_t el blob queda alineado a 4, como en flash
+  std::vector<uint32_t> aligned((bytes.size() + 3) / 4);
+  memcpy(aligned.data(), bytes.data(), bytes.size());
+  TinymlModel model;
+  if (!model.begin(reinterpret_cast<const uint8_t *>(aligned.data()), bytes.size())) {
+    fprintf(stderr, "Modelo no válido: %s\n", source);
+    return 1;
+  }
+  const TinymlShape in = model.input();
+  const size_t cells = (size_t)in.w * in.h;
+
+  printf("Modelo: %s\n", source);
+  printf("%-10s | %-11s | %9s | %8s\n", "capa", "salida", "MACs", "pesos");
+  for (uint8_t i = 0; i < model.layerCount(); i++) {
+    const TinymlLayer &l = model.layer(i);
+    size_t weights = 0;
+    if (l.type == TINYML_LAYER_CONV) weights = (size_t)l.conv.kernel * l.conv.kernel * l.in.c * l.out.c;
+    if (l.type == TINYML_LAYER_DEPTHWISE) weights = (size_t)l.conv.kernel * l.conv.kernel * l.out.c;
+    if (l.type == TINYML_LAYER_DENSE) weights = (size_t)l.in.c * l.out.c;
+    char shape[24];
+    snprintf(shape, sizeof(shape), "%ux%ux%u", l.out.w, l.out.h, l.out.c);
+    printf("%-10s | %-11s | %9u | %8zu\n", layerName(l.type), shape, (unsigned)l.macs, weights);
+  }
+  printf("Memoria: modelo %zu B (flash), arena %zu B, rejilla %zu B + %zu B de sumas\n",
+         bytes.size(), model.arenaBytes(), cells, cells * sizeof(uint16_t));
+  printf("Entrada %ux%u en gris, %u MACs por inferencia\n\n", in.w, in.h, (unsigned)model.macs());
+
+  std::map<std::string, int> labels;
+  if (labelsPath) {
+    labels = loadLabels(labelsPath);
+    if (labels.empty()) fprintf(stderr, "Sin etiquetas en %s\n", labelsPath);
+  }
+
+  // Decodificación de cada imagen, con la rejilla del modelo
+  std::vector<Image> images;
+  std::vector<uint16_t> scratch(cells);
+  for (int i = first; i < argc; i++) {
+    std::vector<uint8_t> jpeg;
+    if (!loadFile(argv[i], jpeg)) {
+      fprintf(stderr, "No se pudo leer %s\n", argv[i]);
+      continue;
+    }
+    Image img;
+    img.name = baseName(argv[i]);
+    img.gray.resize(cells);
+    auto start = Clock::now();
+    bool ok = motionJpegToGray(jpeg.data(), jpeg.size(), img.gray.data(), in.w, in.h,
+                               scratch.data());
+    img.decodeUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    if (!ok) {
+      fprintf(stderr, "No se pudo decodificar %s\n", argv[i]);
+      continue;
+    }
+    auto it = labels.find(img.name);
+    img.hippos = it == labels.end() ? -1 : it->second;
+    images.push_back(img);
+  }
+  if (images.empty()) {
+    fprintf(stderr, "Sin imágenes\n");
+    return 1;
+  }
+
+  // Inferencia: reps veces cada imagen para que la medida sea estable
+  std::vector<int8_t> arena(model.arenaBytes());
+  std::vector<double> decodeAll, inferAll;
+  for (Image &img : images) {
+    for (int k = 0; k < reps; k++) {
+      auto start = Clock::now();
+      model.run(img.gray.data(), arena.data(), &img.probability);
+      img.inferUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    decodeAll.push_back(img.decodeUs);
+    inferAll.push_back(percentile(img.inferUs, 0.5));
+  }
+
+  printf("%-32s | %7s | %9s | %6s | %s\n", "imagen", "prob", "veredicto", "server",
+         "infer us");
+  for (const Image &img : images) {
+    int pct = (int)(img.probability * 100 + 0.5f);
+    const char *verdict = pct < negativePct ? "negativo" : (pct >= positivePct ? "positivo" : "dudoso");
+    char server[12] = "-";
+    if (img.hippos >= 0) snprintf(server, sizeof(server), "%d", img.hippos);
+    printf("%-32.32s | %6d%% | %9s | %6s | %.0f\n", img.name.c_str(), pct, verdict, server,
+           percentile(img.inferUs, 0.5));
+  }
+
+  double decodeMean = 0, inferMean = 0;
+  for (double v : decodeAll) decodeMean += v;
+  for (double v : inferAll) inferMean += v;
+  decodeMean /= decodeAll.size();
+  inferMean /= inferAll.size();
+  printf("\nLatencia (%zu imágenes, %d repeticiones):\n", images.size(), reps);
+  printf("  decodificar: media %.0f us, p50 %.0f, p95 %.0f, peor %.0f\n", decodeMean,
+         percentile(decodeAll, 0.5), percentile(decodeAll, 0.95), percentile(decodeAll, 1));
+  printf("  inferir:     media %.0f us, p50 %.0f, p95 %.0f, peor %.0f\n", inferMean,
+         percentile(inferAll, 0.5), percentile(inferAll, 0.95), percentile(inferAll, 1));
+
+  // Concordancia con el servidor según el umbral de negativo
+  int labelled = 0, serverPositive = 0;
+  for (const Image &img : images) {
+    if (img.hippos < 0) continue;
+    labelled++;
+    if (img.hippos > 0) serverPositive++;
+  }
+  if (labelled == 0) {
+    if (labelsPath) printf("\nNinguna imagen tiene etiqueta en %s\n", labelsPath);
+    return 0;
+  }
+  printf("\nConcordancia con el servidor (%d imágenes etiquetadas, %d con hipopótamos):\n",
+         labelled, serverPositive);
+  printf("%9s | %9s | %9s | %8s | %8s\n", "negativo<", "acuerdo", "perdidos", "subidas",
+         "ahorro");
+  for (int t : thresholds) {
+    int agree = 0, missed = 0, uploaded = 0;
+    for (const Image &img : images) {
+      if (img.hippos < 0) continue;
+      bool keep = (int)(img.probability * 100 + 0.5f) >= t;
+      if (keep == (img.hippos > 0)) agree++;
+      if (!keep && img.hippos > 0) missed++;
+      if (keep) uploaded++;
+    }
+    printf("%8d%% | %8.1f%% | %9d | %8d | %7.1f%%\n", t, 100.0 * agree / labelled, missed,
+           uploaded, 100.0 * (labelled - uploaded) / labelled);
+  }
+  return 0;
+}
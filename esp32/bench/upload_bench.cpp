@@ -0,0 +1,206 @@
+/**
+ * Benchmark de host: coste de memoria de una subida multipart (proyecto TPI2)
+ *
+ * Compara, para cada JPEG de entrada, el camino anterior de
+ * `sendImageToServer()` (String para cabecera/cola + malloc de
+ * head + frame + tail + memcpy) con el camino actual de `multipart.h`
+ * (sobre en la pila y escritura directa desde el frame buffer).
+ *
+ * Mide por subida: bytes copiados por la aplicación, pico de heap,
+ * número de reservas y tiempo. El "socket" es un sumidero que solo cuenta
+ * bytes, igual para ambos caminos (la copia a pbufs de lwip no cambia).
+ *
+ * Uso:
+ *   pio run -e bench_upload
+ *   .pio/build/bench_upload/program ../runs/detect/val/val_batch0_pred.jpg ...
+ * Sin argumentos usa tamaños sintéticos típicos de QVGA / VGA / UXGA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../src/multipart.h"
+
+// ============================================================================
+// CONTABILIDAD DE HEAP
+// ============================================================================
+
+static size_t heapInUse = 0;
+static size_t heapPeak = 0;
+static size_t heapAllocs = 0;
+static size_t bytesCopied = 0;
+
+static void *trackedAlloc(size_t size) {
+  // Cabecera con el tamaño para poder descontarlo al liberar
+  size_t *p = (size_t *)malloc(size + sizeof(size_t));
+  if (!p) return nullptr;
+  *p = size;
+  heapInUse += size;
+  heapAllocs++;
+  if (heapInUse > heapPeak) heapPeak = heapInUse;
+  return p + 1;
+}
+
+static void trackedFree(void *ptr) {
+  if (!ptr) return;
+  size_t *p = (size_t *)ptr - 1;
+  heapInUse -= *p;
+  free(p);
+}
+
+// Las String de Arduino reservan en el heap: se modelan con std::string
+void *operator new(size_t size) {
+  void *p = trackedAlloc(size);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void *p) noexcept { trackedFree(p); }
+void operator delete(void *p, size_t) noexcept { trackedFree(p); }
+
+static void *countedMemcpy(void *dst, const void *src, size_t len) {
+  bytesCopied += len;
+  return memcpy(dst, src, len);
+}
+
+static void resetCounters() {
+  heapPeak = heapInUse;
+  heapAllocs = 0;
+  bytesCopied = 0;
+}
+
+// ============================================================================
+// SUMIDERO ("socket")
+// ============================================================================
+
+struct CountingSink {
+  size_t bytes;
+  uint32_t checksum;
+};
+
+static size_t sinkWrite(void *ctx, const uint8_t *data, size_t len) {
+  CountingSink *sink = (CountingSink *)ctx;
+  sink->bytes += len;
+  // Se toca el primer y último byte para que el compilador no elimine nada
+  if (len) sink->checksum += data[0] + data[len - 1];
+  return len;
+}
+
+// ============================================================================
+// CAMINOS DE SUBIDA
+// ============================================================================
+
+// Reproducción del sendImageToServer() original
+static bool uploadLegacy(const uint8_t *frame, size_t frameLen, CountingSink *sink) {
+  std::string boundary = "ESP32CAM-" + std::to_string(1000 + rand() % 8999);
+  std::string head = "--" + boundary + "\r\n";
+  head += "Content-Disposition: form-data; name=\"image\"; filename=\"esp32cam.jpg\"\r\n";
+  head += "Content-Type: image/jpeg\r\n\r\n";
+  std::string tail = "\r\n--" + boundary + "--\r\n";
+
+  size_t totalLen = head.size() + frameLen + tail.size();
+  uint8_t *buf = (uint8_t *)trackedAlloc(totalLen);
+  if (!buf) return false;
+
+  countedMemcpy(buf, head.c_str(), head.size());
+  countedMemcpy(buf + head.size(), frame, frameLen);
+  countedMemcpy(buf + head.size() + frameLen, tail.c_str(), tail.size());
+
+  sinkWrite(sink, buf, totalLen);
+  trackedFree(buf);
+  return true;
+}
+
+// Camino actual: multipart.h escribe directamente desde el frame
+static bool uploadStreaming(const uint8_t *frame, size_t frameLen, CountingSink *sink) {
+  MultipartEnvelope env;
+  if (!multipartInit(&env, 1000 + rand() % 8999, "image", "esp32cam.jpg")) return false;
+  return multipartWrite(&env, frame, frameLen, sinkWrite, sink);
+}
+
+// ============================================================================
+// MEDICIÓN
+// ============================================================================
+
+struct Result {
+  size_t copied;
+  size_t peak;
+  size_t allocs;
+  double usPerUpload;
+};
+
+static Result measure(bool (*upload)(const uint8_t *, size_t, CountingSink *),
+                      const uint8_t *frame, size_t frameLen, int iterations) {
+  CountingSink sink = {0, 0};
+  size_t base = heapInUse;
+  resetCounters();
+  upload(frame, frameLen, &sink);
+  Result r;
+  r.copied = bytesCopied;
+  r.peak = heapPeak - base;
+  r.allocs = heapAllocs;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) upload(frame, frameLen, &sink);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  r.usPerUpload =
+      std::chrono::duration<double, std::micro>(elapsed).count() / (iterations > 0 ? iterations : 1);
+  return r;
+}
+
+static bool loadFile(const char *path, std::vector<uint8_t> &out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  out.resize(size > 0 ? (size_t)size : 0);
+  size_t n = fread(out.data(), 1, out.size(), f);
+  fclose(f);
+  return n == out.size();
+}
+
+static void report(const char *name, const std::vector<uint8_t> &frame, int iterations) {
+  Result legacy = measure(uploadLegacy, frame.data(), frame.size(), iterations);
+  Result streaming = measure(uploadStreaming, frame.data(), frame.size(), iterations);
+
+  printf("%-32s %8zu | %10zu %10zu %6zu %9.2f | %10zu %10zu %6zu %9.2f\n", name, frame.size(),
+         legacy.copied, legacy.peak, legacy.allocs, legacy.usPerUpload, streaming.copied,
+         streaming.peak, streaming.allocs, streaming.usPerUpload);
+}
+
+int main(int argc, char **argv) {
+  const int iterations = 2000;
+
+  printf("%-32s %8s | %10s %10s %6s %9s | %10s %10s %6s %9s\n", "frame", "bytes", "copy(old)",
+         "peak(old)", "allocs", "us(old)", "copy(new)", "peak(new)", "allocs", "us(new)");
+
+  if (argc < 2) {
+    const struct { const char *name; size_t size; } synthetic[] = {
+        {"sintético QVGA q20", 9 * 1024},
+        {"sintético VGA q10", 35 * 1024},
+        {"sintético UXGA q10", 160 * 1024},
+    };
+    for (const auto &s : synthetic) {
+      std::vector<uint8_t> frame(s.size, 0xA5);
+      report(s.name, frame, iterations);
+    }
+    return 0;
+  }
+
+  for (int i = 1; i < argc; i++) {
+    std::vector<uint8_t> frame;
+    if (!loadFile(argv[i], frame)) {
+      fprintf(stderr, "No se pudo leer %s\n", argv[i]);
+      continue;
+    }
+    const char *name = strrchr(argv[i], '/');
+    report(name ? name + 1 : argv[i], frame, iterations);
+  }
+  return 0;
+}
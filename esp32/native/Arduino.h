@@ -0,0 +1,196 @@
+/**
+ * Shim mínimo de Arduino para compilar el firmware en el host (entorno `native`)
+ *
+ * Solo cubre lo que usa `src/`: tiempo, GPIO simulado, Serial sobre stdout,
+ * String, Client y algunas utilidades de `ESP`. No pretende ser completo.
+ */
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <string>
+
+#include "driver/gpio.h"
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define INPUT_PULLDOWN 3
+#define RISING 1
+#define FALLING 2
+#define CHANGE 3
+
+#define IRAM_ATTR
+// La "RAM RTC" es una sección propia que el deep sleep simulado conserva (ver esp_sleep.h)
+#define RTC_DATA_ATTR __attribute__((section("hipotrack_rtc")))
+#define RTC_NOINIT_ATTR __attribute__((section("hipotrack_rtc")))
+
+// ============================================================================
+// TIEMPO Y GPIO
+// ============================================================================
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+uint32_t esp_random();
+
+// Entradas simuladas. HIPOTRACK_GPIO_EVENTS: pulsos a nivel alto
+// "pin:inicio+duración" en ms, separados por comas (p. ej. "13:5000+1500").
+// El tiempo cuenta desde el primer arranque: sigue corriendo a través del
+// deep sleep simulado. attachInterrupt() recibe los flancos de esos pulsos.
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t pin);
+#define digitalPinToInterrupt(p) (p)
+
+float temperatureRead();
+bool psramFound();
+void *ps_malloc(size_t size);
+
+template <typename T> T constrain(T x, T lo, T hi) { return x < lo ? lo : (x > hi ? hi : x); }
+// Como el core de ESP32: min/max son los de <algorithm>
+using std::max;
+using std::min;
+
+// ============================================================================
+// STRING
+// ============================================================================
+
+class String {
+ public:
+  String() {}
+  String(const char *s) : s_(s ? s : "") {}
+  String(const std::string &s) : s_(s) {}
+  String(char c) : s_(1, c) {}
+  String(int v, unsigned char base = 10) : s_(fromLong(v, base)) {}
+  String(unsigned int v, unsigned char base = 10) : s_(fromULong(v, base)) {}
+  String(long v, unsigned char base = 10) : s_(fromLong(v, base)) {}
+  String(unsigned long v, unsigned char base = 10) : s_(fromULong(v, base)) {}
+  String(float v, unsigned int decimals = 2) : s_(fromDouble(v, decimals)) {}
+  String(double v, unsigned int decimals = 2) : s_(fromDouble(v, decimals)) {}
+
+  const char *c_str() const { return s_.c_str(); }
+  unsigned int length() const { return (unsigned int)s_.size(); }
+  bool isEmpty() const { return s_.empty(); }
+  int indexOf(const char *needle) const {
+    size_t p = s_.find(needle);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  String substring(unsigned int from) const { return String(s_.substr(from)); }
+  String substring(unsigned int from, unsigned int to) const { return String(s_.substr(from, to - from)); }
+  int toInt() const { return atoi(s_.c_str()); }
+  void trim();
+  void reserve(unsigned int n) { s_.reserve(n); }
+
+  String &operator+=(const String &o) { s_ += o.s_; return *this; }
+  String &operator+=(const char *o) { s_ += o; return *this; }
+  String &operator+=(char c) { s_ += c; return *this; }
+  friend String operator+(const String &a, const String &b) { return String(a.s_ + b.s_); }
+  friend String operator+(const String &a, const char *b) { return String(a.s_ + b); }
+  friend String operator+(const char *a, const String &b) { return String(a + b.s_); }
+  bool operator==(const String &o) const { return s_ == o.s_; }
+  bool operator==(const char *o) const { return s_ == o; }
+  bool operator!=(const String &o) const { return s_ != o.s_; }
+  bool operator!=(const char *o) const { return s_ != o; }
+
+ private:
+  static std::string fromLong(long v, unsigned char base);
+  static std::string fromULong(unsigned long v, unsigned char base);
+  static std::string fromDouble(double v, unsigned int decimals);
+  std::string s_;
+};
+
+// ============================================================================
+// STREAM / SERIAL
+// ============================================================================
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buf, size_t size);
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t print(const String &s) { return print(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return print(String(v)); }
+  size_t print(unsigned int v) { return print(String(v)); }
+  size_t print(long v) { return print(String(v)); }
+  size_t print(unsigned long v) { return print(String(v)); }
+  size_t print(double v) { return print(String(v)); }
+  size_t println() { return print("\r\n"); }
+  template <typename T> size_t println(const T &v) { return print(v) + println(); }
+  size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() { return -1; }
+};
+
+class HardwareSerial : public Stream {
+ public:
+  void begin(unsigned long) {}
+  void flush() { fflush(stdout); }
+  size_t write(uint8_t c) override { return fwrite(&c, 1, 1, stdout); }
+  size_t write(const uint8_t *buf, size_t size) override { return fwrite(buf, 1, size, stdout); }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// ============================================================================
+// CLIENT (interfaz común de sockets)
+// ============================================================================
+
+class Client : public Stream {
+ public:
+  virtual int connect(const char *host, uint16_t port) = 0;
+  virtual size_t write(uint8_t c) override = 0;
+  virtual size_t write(const uint8_t *buf, size_t size) override = 0;
+  virtual int read(uint8_t *buf, size_t size) = 0;
+  int read() override = 0;
+  virtual void stop() = 0;
+  virtual uint8_t connected() = 0;
+  virtual operator bool() = 0;
+};
+
+// ============================================================================
+// ESP
+// ============================================================================
+
+class EspClass {
+ public:
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  uint32_t getPsramSize();
+  uint32_t getFreePsram();
+  void restart();
+};
+
+extern EspClass ESP;
+
+#endif // NATIVE_ARDUINO_H
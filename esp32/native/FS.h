@@ -0,0 +1,63 @@
+/**
+ * Shim de FS (File / sistema de ficheros) para el entorno `native`
+ *
+ * Solo lo que usa el firmware; los ficheros viven en un directorio del host
+ * (ver SD_MMC.h).
+ */
+
+#ifndef NATIVE_FS_H
+#define NATIVE_FS_H
+
+#include "Arduino.h"
+
+#include <memory>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+class FileImpl;
+
+class File {
+ public:
+  File() {}
+  explicit File(std::shared_ptr<FileImpl> impl) : impl_(impl) {}
+
+  operator bool() const;
+  size_t write(const uint8_t *buf, size_t size);
+  size_t read(uint8_t *buf, size_t size);
+  int available();
+  size_t size() const;
+  bool seek(uint32_t pos);
+  void flush();
+  void close();
+  const char *name() const;
+  bool isDirectory() const;
+  File openNextFile();
+
+ private:
+  std::shared_ptr<FileImpl> impl_;
+};
+
+class FS {
+ public:
+  File open(const char *path, const char *mode = FILE_READ);
+  bool exists(const char *path);
+  bool remove(const char *path);
+  bool rename(const char *from, const char *to);
+  bool mkdir(const char *path);
+  bool rmdir(const char *path);
+
+ protected:
+  std::string hostPath(const char *path) const;
+  std::string root_;
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif  // NATIVE_FS_H
@@ -0,0 +1,30 @@
+/**
+ * Shim de Preferences (NVS) para el entorno `native`
+ *
+ * Cada clave es un fichero HIPOTRACK_NVS_DIR/<espacio>.<clave> en el host
+ * (por defecto ./nvs, se crea si no existe), así que sobrevive entre
+ * ejecuciones igual que la NVS sobrevive a un apagado.
+ */
+
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include "Arduino.h"
+
+class Preferences {
+ public:
+  bool begin(const char *name, bool readOnly = false);
+  void end();
+  bool remove(const char *key);
+  size_t putBytes(const char *key, const void *value, size_t len);
+  size_t getBytesLength(const char *key);
+  size_t getBytes(const char *key, void *buf, size_t maxLen);
+
+ private:
+  std::string path(const char *key) const;
+  std::string ns_;
+  bool open_ = false;
+  bool readOnly_ = false;
+};
+
+#endif // NATIVE_PREFERENCES_H
@@ -0,0 +1,30 @@
+/**
+ * Shim de SD_MMC para el entorno `native`
+ *
+ * La "tarjeta" es el directorio HIPOTRACK_SD_DIR del host (por defecto
+ * ./sdcard, se crea si no existe).
+ */
+
+#ifndef NATIVE_SD_MMC_H
+#define NATIVE_SD_MMC_H
+
+#include "FS.h"
+
+typedef enum { CARD_NONE, CARD_MMC, CARD_SD, CARD_SDHC, CARD_UNKNOWN } sdcard_type_t;
+
+class SDMMCFS : public fs::FS {
+ public:
+  bool begin(const char *mountpoint = "/sdcard", bool mode1bit = false);
+  void end();
+  sdcard_type_t cardType();
+  uint64_t cardSize();
+  uint64_t totalBytes();
+  uint64_t usedBytes();
+
+ private:
+  bool mounted_ = false;
+};
+
+extern SDMMCFS SD_MMC;
+
+#endif  // NATIVE_SD_MMC_H
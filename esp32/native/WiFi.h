@@ -0,0 +1,133 @@
+/**
+ * Shim de WiFi para el entorno `native`
+ *
+ * En el host la "red WiFi" siempre está conectada: `WiFiClient` es un socket
+ * TCP POSIX real, de modo que el firmware habla con un `server.js` local.
+ */
+
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include "Arduino.h"
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+class IPAddress {
+ public:
+  IPAddress() : addr_(0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+      : addr_((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24)) {}
+  IPAddress(uint32_t addr) : addr_(addr) {}
+  operator uint32_t() const { return addr_; }
+  uint8_t operator[](int i) const { return (addr_ >> (8 * i)) & 0xFF; }
+  String toString() const;
+
+ private:
+  uint32_t addr_;
+};
+
+class WiFiClient : public Client {
+ public:
+  WiFiClient() : fd_(-1) {}
+  ~WiFiClient() override { stop(); }
+  WiFiClient(const WiFiClient &) = delete;
+  WiFiClient &operator=(const WiFiClient &) = delete;
+
+  int connect(const char *host, uint16_t port) override { return connect(host, port, 5000); }
+  int connect(const char *host, uint16_t port, int32_t timeoutMs);
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buf, size_t size) override;
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return connected(); }
+  void setNoDelay(bool nodelay);
+
+ private:
+  int fd_;
+};
+
+// En el host no hay TLS: se usa el mismo socket TCP (USE_HTTPS debe ser false)
+class WiFiClientSecure : public WiFiClient {
+ public:
+  void setInsecure() {}
+};
+
+// Eventos de WiFi (subconjunto de los del core 2.x de Arduino-ESP32)
+typedef enum {
+  ARDUINO_EVENT_WIFI_STA_START = 2,
+  ARDUINO_EVENT_WIFI_STA_CONNECTED = 4,
+  ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5,
+  ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+  ARDUINO_EVENT_WIFI_STA_LOST_IP = 8,
+  ARDUINO_EVENT_MAX = 100
+} arduino_event_id_t;
+typedef arduino_event_id_t WiFiEvent_t;
+
+typedef union {
+  struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+    int8_t rssi;
+  } wifi_sta_disconnected;
+} arduino_event_info_t;
+typedef arduino_event_info_t WiFiEventInfo_t;
+
+typedef void (*WiFiEventFuncCb)(arduino_event_id_t event, arduino_event_info_t info);
+typedef size_t wifi_event_id_t;
+
+// Códigos de wifi_err_reason_t que simula el shim
+#define WIFI_REASON_ASSOC_LEAVE     8
+#define WIFI_REASON_BEACON_TIMEOUT  200
+#define WIFI_REASON_NO_AP_FOUND     201
+
+// Red simulada. Variables de entorno:
+//  HIPOTRACK_WIFI_CONNECT_MS  tiempo de escaneo + asociación + DHCP (200 ms por defecto)
+//  HIPOTRACK_WIFI_FAST_CONNECT_MS  tiempo con BSSID y canal conocidos (40 ms)
+//  HIPOTRACK_WIFI_CHANNEL     canal del punto de acceso (6); si begin() recibe
+//                             otro canal el intento falla con NO_AP_FOUND
+//  HIPOTRACK_WIFI_OUTAGES     cortes "inicio+duración" en ms desde el arranque,
+//                             separados por comas (p. ej. "8000+15000,60000+5000")
+// Durante un corte no hay IP, WiFiClient::connect falla y las escrituras se pierden.
+class WiFiClass {
+ public:
+  void mode(wifi_mode_t) {}
+  wl_status_t begin(const char *ssid, const char *passphrase, int32_t channel = 0,
+                    const uint8_t *bssid = NULL, bool connect = true);
+  bool config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress());
+  void persistent(bool) {}
+  bool reconnect();
+  bool disconnect(bool wifioff = false);
+  wl_status_t status();
+  bool isConnected() { return status() == WL_CONNECTED; }
+  bool setAutoReconnect(bool) { return true; }
+  bool setSleep(bool) { return true; }
+  wifi_event_id_t onEvent(WiFiEventFuncCb cb, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+  IPAddress localIP() { return isConnected() ? IPAddress(127, 0, 0, 1) : IPAddress(); }
+  int8_t RSSI() { return isConnected() ? -50 : 0; }
+  uint8_t *BSSID();
+  int32_t channel();
+  IPAddress gatewayIP() { return isConnected() ? IPAddress(127, 0, 0, 254) : IPAddress(); }
+  IPAddress subnetMask() { return isConnected() ? IPAddress(255, 0, 0, 0) : IPAddress(); }
+  IPAddress dnsIP() { return isConnected() ? IPAddress(127, 0, 0, 254) : IPAddress(); }
+
+  // Solo en el shim: ¿hay un corte simulado en este instante?
+  bool linkDown();
+};
+
+extern WiFiClass WiFi;
+
+#endif // NATIVE_WIFI_H
@@ -0,0 +1,207 @@
+/**
+ * Implementación del shim de Arduino para el host y punto de entrada `main()`
+ * que reproduce el ciclo setup()/loop() del core de Arduino.
+ */
+
+#include "Arduino.h"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static const auto kBootTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - kBootTime)
+      .count();
+}
+
+unsigned long micros() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - kBootTime)
+      .count();
+}
+
+void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void delayMicroseconds(unsigned int us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+void yield() { std::this_thread::yield(); }
+
+long random(long howbig) { return howbig <= 0 ? 0 : rand() % howbig; }
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return howsmall + random(howbig - howsmall);
+}
+void randomSeed(unsigned long seed) { srand((unsigned)seed); }
+uint32_t esp_random() { return ((uint32_t)rand() << 16) ^ (uint32_t)rand(); }
+
+// GPIO simulado: se recuerda el último nivel escrito; las entradas pueden
+// tener pulsos programados (HIPOTRACK_GPIO_EVENTS, ver Arduino.h)
+static uint8_t gpioLevels[64];
+
+struct GpioPulse {
+  uint8_t pin;
+  unsigned long start;
+  unsigned long end;
+};
+
+// Milisegundos desde el primer arranque (el deep sleep simulado hereda el origen)
+static unsigned long simMs() {
+  static const long long epoch = [] {
+    long long now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count();
+    const char *v = getenv("HIPOTRACK_SIM_EPOCH");
+    if (v) return atoll(v);
+    setenv("HIPOTRACK_SIM_EPOCH", std::to_string(now).c_str(), 1);
+    return now;
+  }();
+  long long now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch())
+                      .count();
+  return (unsigned long)(now - epoch);
+}
+
+static const std::vector<GpioPulse> &gpioPulses() {
+  static std::vector<GpioPulse> list;
+  static std::once_flag parsed;
+  std::call_once(parsed, [] {
+    const char *v = getenv("HIPOTRACK_GPIO_EVENTS");
+    while (v && *v) {
+      char *end;
+      unsigned long pin = strtoul(v, &end, 10);
+      unsigned long start = *end == ':' ? strtoul(end + 1, &end, 10) : 0;
+      unsigned long dur = *end == '+' ? strtoul(end + 1, &end, 10) : 0;
+      list.push_back({(uint8_t)pin, start, start + dur});
+      v = *end == ',' ? end + 1 : NULL;
+    }
+  });
+  return list;
+}
+
+// Fija el origen del reloj simulado en el arranque, no en la primera lectura
+[[maybe_unused]] static const unsigned long kSimStart = simMs();
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t pin, uint8_t val) { if (pin < 64) gpioLevels[pin] = val; }
+
+int digitalRead(uint8_t pin) {
+  unsigned long now = simMs();
+  for (const auto &p : gpioPulses()) {
+    if (p.pin == pin && now >= p.start && now < p.end) return HIGH;
+  }
+  return pin < 64 ? gpioLevels[pin] : LOW;
+}
+
+// Un hilo por pin vigila los flancos y llama a la rutina, como la ISR
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+  std::thread([pin, isr, mode] {
+    int last = digitalRead(pin);
+    for (;;) {
+      delay(2);
+      int level = digitalRead(pin);
+      bool rising = last == LOW && level == HIGH;
+      bool falling = last == HIGH && level == LOW;
+      if ((mode == RISING && rising) || (mode == FALLING && falling) ||
+          (mode == CHANGE && (rising || falling))) {
+        isr();
+      }
+      last = level;
+    }
+  }).detach();
+}
+
+void detachInterrupt(uint8_t) {}
+
+float temperatureRead() { return 45.0f; }
+bool psramFound() { return true; }
+void *ps_malloc(size_t size) { return malloc(size); }
+
+// ============================================================================
+// STRING
+// ============================================================================
+
+std::string String::fromLong(long v, unsigned char base) {
+  if (v < 0 && base == 10) return "-" + fromULong((unsigned long)(-v), base);
+  return fromULong((unsigned long)v, base);
+}
+
+std::string String::fromULong(unsigned long v, unsigned char base) {
+  if (base < 2 || base > 36) base = 10;
+  char buf[72];
+  int i = sizeof(buf) - 1;
+  buf[i] = '\0';
+  do {
+    int d = (int)(v % base);
+    buf[--i] = (char)(d < 10 ? '0' + d : 'a' + d - 10);
+    v /= base;
+  } while (v && i > 0);
+  return std::string(&buf[i]);
+}
+
+std::string String::fromDouble(double v, unsigned int decimals) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+  return std::string(buf);
+}
+
+void String::trim() {
+  size_t a = s_.find_first_not_of(" \t\r\n");
+  size_t b = s_.find_last_not_of(" \t\r\n");
+  s_ = (a == std::string::npos) ? std::string() : s_.substr(a, b - a + 1);
+}
+
+// ============================================================================
+// PRINT
+// ============================================================================
+
+size_t Print::write(const uint8_t *buf, size_t size) {
+  size_t n = 0;
+  while (size--) n += write(*buf++);
+  return n;
+}
+
+size_t Print::printf(const char *fmt, ...) {
+  char buf[512];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (n <= 0) return 0;
+  return write((const uint8_t *)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+// ============================================================================
+// ESP
+// ============================================================================
+
+uint32_t EspClass::getFreeHeap() { return 200 * 1024; }
+uint32_t EspClass::getMinFreeHeap() { return 180 * 1024; }
+uint32_t EspClass::getMaxAllocHeap() { return 110 * 1024; }
+uint32_t EspClass::getPsramSize() { return 4 * 1024 * 1024; }
+uint32_t EspClass::getFreePsram() { return 4 * 1024 * 1024; }
+
+void EspClass::restart() {
+  fflush(stdout);
+  exit(1);
+}
+
+// ============================================================================
+// PUNTO DE ENTRADA
+// ============================================================================
+
+void setup();
+void loop();
+
+int main() {
+  // Salida por líneas, como el monitor serie (también al redirigir a fichero)
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  setup();
+  for (;;) {
+    loop();
+  }
+}
@@ -0,0 +1,235 @@
+/**
+ * Cámara falsa que reproduce ficheros JPEG grabados (entorno `native`)
+ */
+
+#include "esp_camera.h"
+#include "Arduino.h"
+
+#include <dirent.h>
+#include <setjmp.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <jpeglib.h>
+
+static std::vector<std::string> frameFiles;
+static size_t nextFrame = 0;
+static size_t framesOut = 0;
+static camera_config_t activeConfig;
+static bool initialized = false;
+
+// Ventana de set_res_raw() (como set_window() del OV2640); set_framesize() la quita
+struct RawWindow {
+  bool active;
+  int mode;  // 0 = UXGA (1600x1200), 1 = SVGA (800x600), 2 = CIF (400x296)
+  int offX, offY, width, height;
+  int outW, outH;
+};
+static RawWindow rawWindow = {};
+
+static int setFramesize(sensor_t *s, framesize_t v) {
+  s->status.framesize = v;
+  rawWindow.active = false;
+  return 0;
+}
+static int setQuality(sensor_t *s, int v) { s->status.quality = (uint8_t)v; return 0; }
+static int setPixformat(sensor_t *s, pixformat_t v) { s->pixformat = v; return 0; }
+static int setInt(sensor_t *, int) { return 0; }
+static int setGainceiling(sensor_t *, gainceiling_t) { return 0; }
+static int setResRaw(sensor_t *, int startX, int, int, int, int offsetX, int offsetY, int totalX,
+                     int totalY, int outputX, int outputY, bool, bool) {
+  if (startX < 0 || startX > 2 || totalX <= 0 || totalY <= 0 || outputX <= 0 || outputY <= 0 ||
+      outputX > totalX || outputY > totalY) {
+    return -1;
+  }
+  rawWindow = {true, startX, offsetX, offsetY, totalX, totalY, outputX, outputY};
+  return 0;
+}
+
+struct ShimJpegError {
+  jpeg_error_mgr mgr;
+  jmp_buf jump;
+};
+
+static void onJpegError(j_common_ptr cinfo) {
+  longjmp(reinterpret_cast<ShimJpegError *>(cinfo->err)->jump, 1);
+}
+
+// Recorta el JPEG a la ventana activa (proporcional al campo del modo) y lo
+// reescala a la salida. Devuelve false si el fichero no se pudo decodificar.
+static bool applyRawWindow(const std::vector<uint8_t> &src, int quality,
+                           std::vector<uint8_t> *out) {
+  static const int kModeW[] = {1600, 800, 400};
+  static const int kModeH[] = {1200, 600, 296};
+
+  jpeg_decompress_struct din;
+  ShimJpegError err;
+  din.err = jpeg_std_error(&err.mgr);
+  err.mgr.error_exit = onJpegError;
+  if (setjmp(err.jump)) {
+    jpeg_destroy_decompress(&din);
+    return false;
+  }
+  jpeg_create_decompress(&din);
+  jpeg_mem_src(&din, src.data(), (unsigned long)src.size());
+  jpeg_read_header(&din, TRUE);
+  din.out_color_space = JCS_RGB;
+  jpeg_start_decompress(&din);
+  const int srcW = (int)din.output_width;
+  const int srcH = (int)din.output_height;
+  std::vector<uint8_t> rgb((size_t)srcW * srcH * 3);
+  while (din.output_scanline < din.output_height) {
+    JSAMPROW row = &rgb[(size_t)din.output_scanline * srcW * 3];
+    jpeg_read_scanlines(&din, &row, 1);
+  }
+  jpeg_finish_decompress(&din);
+  jpeg_destroy_decompress(&din);
+
+  const RawWindow &w = rawWindow;
+  const int x0 = w.offX * srcW / kModeW[w.mode];
+  const int y0 = w.offY * srcH / kModeH[w.mode];
+  const int cw = std::max(1, w.width * srcW / kModeW[w.mode]);
+  const int ch = std::max(1, w.height * srcH / kModeH[w.mode]);
+  std::vector<uint8_t> scaled((size_t)w.outW * w.outH * 3);
+  for (int y = 0; y < w.outH; y++) {
+    int sy = std::min(srcH - 1, y0 + y * ch / w.outH);
+    for (int x = 0; x < w.outW; x++) {
+      int sx = std::min(srcW - 1, x0 + x * cw / w.outW);
+      memcpy(&scaled[((size_t)y * w.outW + x) * 3], &rgb[((size_t)sy * srcW + sx) * 3], 3);
+    }
+  }
+
+  jpeg_compress_struct cin;
+  cin.err = jpeg_std_error(&err.mgr);
+  err.mgr.error_exit = onJpegError;
+  unsigned char *mem = nullptr;
+  unsigned long memLen = 0;
+  if (setjmp(err.jump)) {
+    jpeg_destroy_compress(&cin);
+    free(mem);
+    return false;
+  }
+  jpeg_create_compress(&cin);
+  jpeg_mem_dest(&cin, &mem, &memLen);
+  cin.image_width = (JDIMENSION)w.outW;
+  cin.image_height = (JDIMENSION)w.outH;
+  cin.input_components = 3;
+  cin.in_color_space = JCS_RGB;
+  jpeg_set_defaults(&cin);
+  // Calidad de esp32-camera: 0-63, menor es mejor
+  jpeg_set_quality(&cin, std::max(10, 100 - 2 * quality), TRUE);
+  jpeg_start_compress(&cin, TRUE);
+  while (cin.next_scanline < cin.image_height) {
+    JSAMPROW row = &scaled[(size_t)cin.next_scanline * w.outW * 3];
+    jpeg_write_scanlines(&cin, &row, 1);
+  }
+  jpeg_finish_compress(&cin);
+  jpeg_destroy_compress(&cin);
+  out->assign(mem, mem + memLen);
+  free(mem);
+  return true;
+}
+
+static sensor_t fakeSensor = {};
+
+static bool endsWithJpg(const std::string &name) {
+  std::string lower = name;
+  std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+  return lower.size() > 4 &&
+         (lower.rfind(".jpg") == lower.size() - 4 || lower.rfind(".jpeg") == lower.size() - 5);
+}
+
+esp_err_t esp_camera_init(const camera_config_t *config) {
+  const char *dir = getenv("HIPOTRACK_FRAMES_DIR");
+  if (!dir) dir = "../runs/detect/val";
+
+  frameFiles.clear();
+  DIR *d = opendir(dir);
+  if (!d) {
+    fprintf(stderr, "[native] No se pudo abrir HIPOTRACK_FRAMES_DIR=%s\n", dir);
+    return ESP_FAIL;
+  }
+  while (struct dirent *e = readdir(d)) {
+    if (endsWithJpg(e->d_name)) frameFiles.push_back(std::string(dir) + "/" + e->d_name);
+  }
+  closedir(d);
+  std::sort(frameFiles.begin(), frameFiles.end());
+  if (frameFiles.empty()) {
+    fprintf(stderr, "[native] %s no contiene JPEG\n", dir);
+    return ESP_FAIL;
+  }
+
+  activeConfig = *config;
+  rawWindow.active = false;
+  fakeSensor.id.PID = OV2640_PID;
+  fakeSensor.status.framesize = config->frame_size;
+  fakeSensor.status.quality = (uint8_t)config->jpeg_quality;
+  fakeSensor.pixformat = config->pixel_format;
+  fakeSensor.set_pixformat = setPixformat;
+  fakeSensor.set_framesize = setFramesize;
+  fakeSensor.set_quality = setQuality;
+  fakeSensor.set_brightness = fakeSensor.set_contrast = fakeSensor.set_saturation = setInt;
+  fakeSensor.set_special_effect = fakeSensor.set_whitebal = fakeSensor.set_awb_gain = setInt;
+  fakeSensor.set_wb_mode = fakeSensor.set_exposure_ctrl = fakeSensor.set_aec2 = setInt;
+  fakeSensor.set_gain_ctrl = fakeSensor.set_agc_gain = setInt;
+  fakeSensor.set_gainceiling = setGainceiling;
+  fakeSensor.set_bpc = fakeSensor.set_wpc = fakeSensor.set_raw_gma = setInt;
+  fakeSensor.set_lenc = fakeSensor.set_hmirror = fakeSensor.set_vflip = setInt;
+  fakeSensor.set_dcw = fakeSensor.set_colorbar = setInt;
+  fakeSensor.set_res_raw = setResRaw;
+
+  initialized = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_camera_deinit() {
+  initialized = false;
+  return ESP_OK;
+}
+
+camera_fb_t *esp_camera_fb_get() {
+  if (!initialized) return nullptr;
+  // Igual que el driver real: sin buffers libres no hay frame
+  if (framesOut >= (activeConfig.fb_count ? activeConfig.fb_count : 1)) return nullptr;
+
+  // Tiempo de captura simulado del sensor (HIPOTRACK_CAPTURE_MS, por defecto 40 ms)
+  const char *captureMs = getenv("HIPOTRACK_CAPTURE_MS");
+  delay(captureMs ? strtoul(captureMs, nullptr, 10) : 40);
+
+  const std::string &path = frameFiles[nextFrame++ % frameFiles.size()];
+  FILE *f = fopen(path.c_str(), "rb");
+  if (!f) return nullptr;
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  std::vector<uint8_t> data(size > 0 ? (size_t)size : 1);
+  data.resize(fread(data.data(), 1, data.size(), f));
+  fclose(f);
+  if (rawWindow.active && fakeSensor.pixformat == PIXFORMAT_JPEG) {
+    std::vector<uint8_t> cropped;
+    if (applyRawWindow(data, fakeSensor.status.quality, &cropped)) data.swap(cropped);
+  }
+
+  camera_fb_t *fb = (camera_fb_t *)calloc(1, sizeof(camera_fb_t));
+  fb->buf = (uint8_t *)malloc(data.size() ? data.size() : 1);
+  memcpy(fb->buf, data.data(), data.size());
+  fb->len = data.size();
+  fb->format = fakeSensor.pixformat;
+  gettimeofday(&fb->timestamp, nullptr);
+
+  framesOut++;
+  return fb;
+}
+
+void esp_camera_fb_return(camera_fb_t *fb) {
+  if (!fb) return;
+  free(fb->buf);
+  free(fb);
+  if (framesOut > 0) framesOut--;
+}
+
+sensor_t *esp_camera_sensor_get() { return initialized ? &fakeSensor : nullptr; }
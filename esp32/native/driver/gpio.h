@@ -0,0 +1,20 @@
+/**
+ * Números de GPIO de ESP-IDF para el entorno `native`
+ */
+
+#ifndef NATIVE_DRIVER_GPIO_H
+#define NATIVE_DRIVER_GPIO_H
+
+typedef enum {
+  GPIO_NUM_NC = -1,
+  GPIO_NUM_0 = 0,
+  GPIO_NUM_2 = 2,
+  GPIO_NUM_4 = 4,
+  GPIO_NUM_12 = 12,
+  GPIO_NUM_13 = 13,
+  GPIO_NUM_14 = 14,
+  GPIO_NUM_15 = 15,
+  GPIO_NUM_16 = 16,
+} gpio_num_t;
+
+#endif // NATIVE_DRIVER_GPIO_H
@@ -0,0 +1,131 @@
+/**
+ * Cámara falsa para el entorno `native`
+ *
+ * `esp_camera_fb_get()` devuelve, en bucle, los JPEG de un directorio
+ * (variable de entorno HIPOTRACK_FRAMES_DIR, por defecto `../runs/detect/val`).
+ * Las llamadas al sensor solo registran el último valor aplicado, salvo
+ * set_res_raw(), que recorta y reescala los JPEG reproducidos como la ventana
+ * del OV2640 (hasta el siguiente set_framesize()).
+ */
+
+#ifndef NATIVE_ESP_CAMERA_H
+#define NATIVE_ESP_CAMERA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+#include "esp_err.h"
+
+typedef enum { LEDC_CHANNEL_0 = 0 } ledc_channel_t;
+typedef enum { LEDC_TIMER_0 = 0 } ledc_timer_t;
+
+typedef enum {
+  PIXFORMAT_RGB565,
+  PIXFORMAT_YUV422,
+  PIXFORMAT_YUV420,
+  PIXFORMAT_GRAYSCALE,
+  PIXFORMAT_JPEG,
+} pixformat_t;
+
+typedef enum {
+  FRAMESIZE_96X96,
+  FRAMESIZE_QQVGA,
+  FRAMESIZE_QCIF,
+  FRAMESIZE_HQVGA,
+  FRAMESIZE_240X240,
+  FRAMESIZE_QVGA,
+  FRAMESIZE_CIF,
+  FRAMESIZE_HVGA,
+  FRAMESIZE_VGA,
+  FRAMESIZE_SVGA,
+  FRAMESIZE_XGA,
+  FRAMESIZE_HD,
+  FRAMESIZE_SXGA,
+  FRAMESIZE_UXGA,
+  FRAMESIZE_INVALID
+} framesize_t;
+
+typedef enum { CAMERA_GRAB_WHEN_EMPTY, CAMERA_GRAB_LATEST } camera_grab_mode_t;
+typedef enum { CAMERA_FB_IN_PSRAM, CAMERA_FB_IN_DRAM } camera_fb_location_t;
+typedef enum { GAINCEILING_2X } gainceiling_t;
+
+typedef struct {
+  uint8_t *buf;
+  size_t len;
+  size_t width;
+  size_t height;
+  pixformat_t format;
+  struct timeval timestamp;
+} camera_fb_t;
+
+typedef struct {
+  int pin_pwdn, pin_reset, pin_xclk;
+  int pin_sscb_sda, pin_sscb_scl;
+  int pin_d7, pin_d6, pin_d5, pin_d4, pin_d3, pin_d2, pin_d1, pin_d0;
+  int pin_vsync, pin_href, pin_pclk;
+  int xclk_freq_hz;
+  ledc_timer_t ledc_timer;
+  ledc_channel_t ledc_channel;
+  pixformat_t pixel_format;
+  framesize_t frame_size;
+  int jpeg_quality;
+  size_t fb_count;
+  camera_fb_location_t fb_location;
+  camera_grab_mode_t grab_mode;
+} camera_config_t;
+
+typedef struct {
+  framesize_t framesize;
+  uint8_t quality;
+} camera_status_t;
+
+typedef enum { OV2640_PID = 0x26 } camera_pid_t;
+
+typedef struct {
+  uint8_t MIDH;
+  uint8_t MIDL;
+  uint16_t PID;
+  uint8_t VER;
+} sensor_id_t;
+
+typedef struct _sensor sensor_t;
+struct _sensor {
+  sensor_id_t id;
+  camera_status_t status;
+  pixformat_t pixformat;
+  int (*set_pixformat)(sensor_t *, pixformat_t);
+  int (*set_framesize)(sensor_t *, framesize_t);
+  int (*set_quality)(sensor_t *, int);
+  int (*set_brightness)(sensor_t *, int);
+  int (*set_contrast)(sensor_t *, int);
+  int (*set_saturation)(sensor_t *, int);
+  int (*set_special_effect)(sensor_t *, int);
+  int (*set_whitebal)(sensor_t *, int);
+  int (*set_awb_gain)(sensor_t *, int);
+  int (*set_wb_mode)(sensor_t *, int);
+  int (*set_exposure_ctrl)(sensor_t *, int);
+  int (*set_aec2)(sensor_t *, int);
+  int (*set_gain_ctrl)(sensor_t *, int);
+  int (*set_agc_gain)(sensor_t *, int);
+  int (*set_gainceiling)(sensor_t *, gainceiling_t);
+  int (*set_bpc)(sensor_t *, int);
+  int (*set_wpc)(sensor_t *, int);
+  int (*set_raw_gma)(sensor_t *, int);
+  int (*set_lenc)(sensor_t *, int);
+  int (*set_hmirror)(sensor_t *, int);
+  int (*set_vflip)(sensor_t *, int);
+  int (*set_dcw)(sensor_t *, int);
+  int (*set_colorbar)(sensor_t *, int);
+  int (*set_res_raw)(sensor_t *, int startX, int startY, int endX, int endY, int offsetX,
+                     int offsetY, int totalX, int totalY, int outputX, int outputY,
+                     bool scale, bool binning);
+};
+
+esp_err_t esp_camera_init(const camera_config_t *config);
+esp_err_t esp_camera_deinit();
+camera_fb_t *esp_camera_fb_get();
+void esp_camera_fb_return(camera_fb_t *fb);
+sensor_t *esp_camera_sensor_get();
+
+#endif // NATIVE_ESP_CAMERA_H
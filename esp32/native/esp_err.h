@@ -0,0 +1,12 @@
+/**
+ * Códigos de error de ESP-IDF para el entorno `native`
+ */
+
+#ifndef NATIVE_ESP_ERR_H
+#define NATIVE_ESP_ERR_H
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+#endif // NATIVE_ESP_ERR_H
@@ -0,0 +1,42 @@
+/**
+ * Shim de esp_sleep para el entorno `native`
+ *
+ *  - Light sleep: el hilo duerme el tiempo pedido; millis() sigue contando,
+ *    como en la ESP32.
+ *  - Deep sleep: se guarda la sección RTC_DATA_ATTR / RTC_NOINIT_ATTR en un
+ *    fichero temporal, se duerme y el proceso se vuelve a ejecutar a sí mismo
+ *    (como el reinicio al despertar). Al arrancar se restaura esa sección y
+ *    esp_sleep_get_wakeup_cause() devuelve ESP_SLEEP_WAKEUP_TIMER.
+ *  - ext0: el sueño termina antes si el pin armado (ver HIPOTRACK_GPIO_EVENTS
+ *    en Arduino.h) llega al nivel pedido; la causa es ESP_SLEEP_WAKEUP_EXT0.
+ */
+
+#ifndef NATIVE_ESP_SLEEP_H
+#define NATIVE_ESP_SLEEP_H
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+typedef enum {
+  ESP_SLEEP_WAKEUP_UNDEFINED = 0,
+  ESP_SLEEP_WAKEUP_ALL = 1,
+  ESP_SLEEP_WAKEUP_EXT0 = 2,
+  ESP_SLEEP_WAKEUP_EXT1 = 3,
+  ESP_SLEEP_WAKEUP_TIMER = 4,
+  ESP_SLEEP_WAKEUP_TOUCHPAD = 5,
+  ESP_SLEEP_WAKEUP_ULP = 6,
+  ESP_SLEEP_WAKEUP_GPIO = 7,
+  ESP_SLEEP_WAKEUP_UART = 8,
+} esp_sleep_source_t;
+typedef esp_sleep_source_t esp_sleep_wakeup_cause_t;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level);
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source);
+esp_err_t esp_light_sleep_start();
+void esp_deep_sleep_start() __attribute__((noreturn));
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause();
+
+#endif // NATIVE_ESP_SLEEP_H
@@ -0,0 +1,29 @@
+/**
+ * Subconjunto de FreeRTOS sobre std::thread para el entorno `native`
+ *
+ * Solo cubre tareas, colas y semáforos tal y como los usa `src/`.
+ * La afinidad de núcleo (xTaskCreatePinnedToCore) se ignora en el host.
+ */
+
+#ifndef NATIVE_FREERTOS_H
+#define NATIVE_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS 1
+#define configTICK_RATE_HZ 1000
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskIDLE_PRIORITY 0
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+#endif // NATIVE_FREERTOS_H
@@ -0,0 +1,16 @@
+#ifndef NATIVE_FREERTOS_QUEUE_H
+#define NATIVE_FREERTOS_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct NativeQueue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+BaseType_t xQueueReset(QueueHandle_t queue);
+#define xQueueSendToBack xQueueSend
+
+#endif // NATIVE_FREERTOS_QUEUE_H
@@ -0,0 +1,16 @@
+#ifndef NATIVE_FREERTOS_SEMPHR_H
+#define NATIVE_FREERTOS_SEMPHR_H
+
+#include "queue.h"
+
+// Semáforos y mutex como colas de un elemento, igual que en FreeRTOS
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+#define vSemaphoreDelete vQueueDelete
+
+#endif // NATIVE_FREERTOS_SEMPHR_H
@@ -0,0 +1,19 @@
+#ifndef NATIVE_FREERTOS_TASK_H
+#define NATIVE_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct NativeTask *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+                                   void *param, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t coreId);
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *param,
+                       UBaseType_t priority, TaskHandle_t *handle);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+BaseType_t xPortGetCoreID();
+
+#endif // NATIVE_FREERTOS_TASK_H
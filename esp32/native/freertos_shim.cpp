@@ -0,0 +1,135 @@
+/**
+ * Tareas, colas y semáforos de FreeRTOS sobre la biblioteca estándar (host)
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Arduino.h"
+
+struct NativeTask {
+  std::thread thread;
+};
+
+struct NativeQueue {
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::deque<std::vector<uint8_t>> items;
+  size_t length;
+  size_t itemSize;
+};
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *, uint32_t, void *param,
+                                   UBaseType_t, TaskHandle_t *handle, BaseType_t) {
+  NativeTask *task = new NativeTask();
+  task->thread = std::thread(fn, param);
+  task->thread.detach();
+  if (handle) *handle = task;
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *param,
+                       UBaseType_t priority, TaskHandle_t *handle) {
+  return xTaskCreatePinnedToCore(fn, name, stackDepth, param, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  // Solo se soporta que una tarea se elimine a sí misma
+  if (task == NULL) pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks) { delay(ticks); }
+TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+BaseType_t xPortGetCoreID() { return 0; }
+
+// ============================================================================
+// COLAS
+// ============================================================================
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  NativeQueue *q = new NativeQueue();
+  q->length = length;
+  q->itemSize = itemSize;
+  return q;
+}
+
+void vQueueDelete(QueueHandle_t queue) { delete queue; }
+
+static bool waitFor(std::unique_lock<std::mutex> &lock, NativeQueue *q, TickType_t ticks,
+                    bool (*ready)(NativeQueue *)) {
+  if (ticks == portMAX_DELAY) {
+    q->changed.wait(lock, [q, ready] { return ready(q); });
+    return true;
+  }
+  return q->changed.wait_for(lock, std::chrono::milliseconds(ticks), [q, ready] { return ready(q); });
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(q->mutex);
+  if (!waitFor(lock, q, ticks, [](NativeQueue *x) { return x->items.size() < x->length; })) {
+    return pdFALSE;
+  }
+  const uint8_t *p = (const uint8_t *)item;
+  q->items.emplace_back(p, p + q->itemSize);
+  q->changed.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(q->mutex);
+  if (!waitFor(lock, q, ticks, [](NativeQueue *x) { return !x->items.empty(); })) {
+    return pdFALSE;
+  }
+  if (item && q->itemSize) memcpy(item, q->items.front().data(), q->itemSize);
+  q->items.pop_front();
+  q->changed.notify_all();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+  std::lock_guard<std::mutex> lock(q->mutex);
+  return (UBaseType_t)q->items.size();
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+  std::lock_guard<std::mutex> lock(q->mutex);
+  q->items.clear();
+  q->changed.notify_all();
+  return pdPASS;
+}
+
+// ============================================================================
+// SEMÁFOROS
+// ============================================================================
+
+SemaphoreHandle_t xSemaphoreCreateBinary() { return xQueueCreate(1, 0); }
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  SemaphoreHandle_t m = xQueueCreate(1, 0);
+  xSemaphoreGive(m);
+  return m;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount) {
+  SemaphoreHandle_t s = xQueueCreate(maxCount, 0);
+  for (UBaseType_t i = 0; i < initialCount; i++) xSemaphoreGive(s);
+  return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+  return xQueueReceive(sem, NULL, ticks);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) { return xQueueSend(sem, NULL, 0); }
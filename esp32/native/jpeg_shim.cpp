@@ -0,0 +1,63 @@
+/**
+ * esp_jpg_decode() sobre libjpeg (entorno `native`)
+ */
+
+#include "esp_jpg_decode.h"
+
+#include <setjmp.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include <jpeglib.h>
+
+struct ShimError {
+  jpeg_error_mgr mgr;
+  jmp_buf jump;
+};
+
+// libjpeg termina el proceso ante un error si no se intercepta
+static void onError(j_common_ptr cinfo) {
+  longjmp(reinterpret_cast<ShimError *>(cinfo->err)->jump, 1);
+}
+
+esp_err_t esp_jpg_decode(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jpg_writer_cb writer,
+                         void *arg) {
+  std::vector<uint8_t> src(len);
+  if (reader(arg, 0, src.data(), len) != len) return ESP_FAIL;
+
+  jpeg_decompress_struct cinfo;
+  ShimError err;
+  cinfo.err = jpeg_std_error(&err.mgr);
+  err.mgr.error_exit = onError;
+  std::vector<uint8_t> row;
+  if (setjmp(err.jump)) {
+    jpeg_destroy_decompress(&cinfo);
+    return ESP_FAIL;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, src.data(), (unsigned long)len);
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.out_color_space = JCS_RGB;
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = 1u << scale;
+  jpeg_start_decompress(&cinfo);
+
+  bool ok = writer(arg, 0, 0, (uint16_t)cinfo.output_width, (uint16_t)cinfo.output_height, NULL);
+  row.resize((size_t)cinfo.output_width * 3);
+  while (ok && cinfo.output_scanline < cinfo.output_height) {
+    uint16_t y = (uint16_t)cinfo.output_scanline;
+    JSAMPROW rows[1] = {row.data()};
+    jpeg_read_scanlines(&cinfo, rows, 1);
+    ok = writer(arg, 0, y, (uint16_t)cinfo.output_width, 1, row.data());
+  }
+  if (ok) {
+    writer(arg, (uint16_t)cinfo.output_width, (uint16_t)cinfo.output_height, 0, 0, NULL);
+    jpeg_finish_decompress(&cinfo);
+  } else {
+    jpeg_abort_decompress(&cinfo);
+  }
+  jpeg_destroy_decompress(&cinfo);
+  return ok ? ESP_OK : ESP_FAIL;
+}
@@ -0,0 +1,57 @@
+/**
+ * Implementación del shim de Preferences sobre ficheros del host
+ */
+
+#include "Preferences.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+
+static std::string nvsRoot() {
+  const char *dir = getenv("HIPOTRACK_NVS_DIR");
+  return dir ? dir : "nvs";
+}
+
+std::string Preferences::path(const char *key) const {
+  return nvsRoot() + "/" + ns_ + "." + key;
+}
+
+bool Preferences::begin(const char *name, bool readOnly) {
+  ::mkdir(nvsRoot().c_str(), 0755);
+  ns_ = name;
+  readOnly_ = readOnly;
+  open_ = true;
+  return true;
+}
+
+void Preferences::end() {
+  open_ = false;
+}
+
+bool Preferences::remove(const char *key) {
+  return open_ && !readOnly_ && ::remove(path(key).c_str()) == 0;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len) {
+  if (!open_ || readOnly_) return 0;
+  FILE *fp = fopen(path(key).c_str(), "wb");
+  if (!fp) return 0;
+  size_t n = fwrite(value, 1, len, fp);
+  fclose(fp);
+  return n;
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+  struct stat st;
+  return open_ && stat(path(key).c_str(), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+  size_t len = getBytesLength(key);
+  if (len == 0 || len > maxLen) return 0;
+  FILE *fp = fopen(path(key).c_str(), "rb");
+  if (!fp) return 0;
+  size_t n = fread(buf, 1, len, fp);
+  fclose(fp);
+  return n;
+}
@@ -0,0 +1,151 @@
+/**
+ * Implementación de los shims FS / SD_MMC sobre el sistema de ficheros del host
+ */
+
+#include "SD_MMC.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+SDMMCFS SD_MMC;
+
+namespace fs {
+
+class FileImpl {
+ public:
+  ~FileImpl() { close(); }
+  void close() {
+    if (fp) fclose(fp);
+    if (dir) closedir(dir);
+    fp = NULL;
+    dir = NULL;
+  }
+
+  FILE *fp = NULL;
+  DIR *dir = NULL;
+  std::string hostPath;  // Ruta en el host
+  std::string path;      // Ruta dentro de la tarjeta
+  std::string name;      // Nombre sin directorio (como el core 2.x)
+};
+
+File::operator bool() const { return impl_ && (impl_->fp || impl_->dir); }
+
+size_t File::write(const uint8_t *buf, size_t size) {
+  return impl_ && impl_->fp ? fwrite(buf, 1, size, impl_->fp) : 0;
+}
+
+size_t File::read(uint8_t *buf, size_t size) {
+  return impl_ && impl_->fp ? fread(buf, 1, size, impl_->fp) : 0;
+}
+
+int File::available() {
+  if (!impl_ || !impl_->fp) return 0;
+  long pos = ftell(impl_->fp);
+  return (int)(size() - (size_t)pos);
+}
+
+size_t File::size() const {
+  if (!impl_) return 0;
+  struct stat st;
+  if (impl_->fp) fflush(impl_->fp);
+  return stat(impl_->hostPath.c_str(), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+bool File::seek(uint32_t pos) { return impl_ && impl_->fp && fseek(impl_->fp, pos, SEEK_SET) == 0; }
+
+void File::flush() {
+  if (impl_ && impl_->fp) fflush(impl_->fp);
+}
+
+void File::close() {
+  if (impl_) impl_->close();
+}
+
+const char *File::name() const { return impl_ ? impl_->name.c_str() : ""; }
+
+bool File::isDirectory() const { return impl_ && impl_->dir; }
+
+File File::openNextFile() {
+  if (!impl_ || !impl_->dir) return File();
+  struct dirent *e;
+  while ((e = readdir(impl_->dir)) != NULL) {
+    if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+    std::string child = impl_->path + "/" + e->d_name;
+    std::string hostChild = impl_->hostPath + "/" + e->d_name;
+    auto impl = std::make_shared<FileImpl>();
+    impl->path = child;
+    impl->hostPath = hostChild;
+    impl->name = e->d_name;
+    struct stat st;
+    if (stat(hostChild.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+      impl->dir = opendir(hostChild.c_str());
+    } else {
+      impl->fp = fopen(hostChild.c_str(), "rb");
+    }
+    return File(impl);
+  }
+  return File();
+}
+
+std::string FS::hostPath(const char *path) const { return root_ + (path[0] == '/' ? "" : "/") + path; }
+
+File FS::open(const char *path, const char *mode) {
+  auto impl = std::make_shared<FileImpl>();
+  impl->path = path;
+  impl->hostPath = hostPath(path);
+  const char *slash = strrchr(path, '/');
+  impl->name = slash ? slash + 1 : path;
+
+  struct stat st;
+  if (stat(impl->hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+    impl->dir = opendir(impl->hostPath.c_str());
+  } else {
+    std::string m = std::string(mode) + "b";
+    impl->fp = fopen(impl->hostPath.c_str(), m.c_str());
+  }
+  return File(impl);
+}
+
+bool FS::exists(const char *path) {
+  struct stat st;
+  return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char *path) { return unlink(hostPath(path).c_str()) == 0; }
+bool FS::rename(const char *from, const char *to) {
+  return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+bool FS::mkdir(const char *path) { return ::mkdir(hostPath(path).c_str(), 0755) == 0; }
+bool FS::rmdir(const char *path) { return ::rmdir(hostPath(path).c_str()) == 0; }
+
+}  // namespace fs
+
+bool SDMMCFS::begin(const char *, bool) {
+  const char *dir = getenv("HIPOTRACK_SD_DIR");
+  root_ = dir ? dir : "sdcard";
+  ::mkdir(root_.c_str(), 0755);
+  struct stat st;
+  mounted_ = stat(root_.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+  return mounted_;
+}
+
+void SDMMCFS::end() { mounted_ = false; }
+
+sdcard_type_t SDMMCFS::cardType() { return mounted_ ? CARD_SDHC : CARD_NONE; }
+
+uint64_t SDMMCFS::cardSize() { return totalBytes(); }
+
+uint64_t SDMMCFS::totalBytes() {
+  struct statvfs vfs;
+  if (!mounted_ || statvfs(root_.c_str(), &vfs) != 0) return 0;
+  return (uint64_t)vfs.f_blocks * vfs.f_frsize;
+}
+
+uint64_t SDMMCFS::usedBytes() {
+  struct statvfs vfs;
+  if (!mounted_ || statvfs(root_.c_str(), &vfs) != 0) return 0;
+  return (uint64_t)(vfs.f_blocks - vfs.f_bfree) * vfs.f_frsize;
+}
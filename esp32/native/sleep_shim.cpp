@@ -0,0 +1,104 @@
+/**
+ * Implementación del shim de esp_sleep (ver esp_sleep.h)
+ */
+
+#include "esp_sleep.h"
+
+#include "Arduino.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+// Límites de la sección "hipotrack_rtc" (los genera el enlazador; débiles por si está vacía)
+extern char __start_hipotrack_rtc[] __attribute__((weak));
+extern char __stop_hipotrack_rtc[] __attribute__((weak));
+
+static uint64_t timerWakeupUs = 0;
+static int ext0Pin = -1;
+static int ext0Level = 1;
+static esp_sleep_wakeup_cause_t wakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+
+static size_t rtcSize() {
+  return __start_hipotrack_rtc ? (size_t)(__stop_hipotrack_rtc - __start_hipotrack_rtc) : 0;
+}
+
+// Antes de main(): si este proceso viene de un deep sleep simulado, recuperar la RAM RTC
+__attribute__((constructor)) static void restoreRtcMemory() {
+  const char *cause = getenv("HIPOTRACK_WAKE_CAUSE");
+  const char *file = getenv("HIPOTRACK_RTC_FILE");
+  if (cause) wakeupCause = (esp_sleep_wakeup_cause_t)atoi(cause);
+  if (file) {
+    FILE *fp = fopen(file, "rb");
+    if (fp) {
+      if (fread(__start_hipotrack_rtc, 1, rtcSize(), fp) != rtcSize()) {
+        fprintf(stderr, "[SLEEP] RAM RTC incompleta en %s\n", file);
+      }
+      fclose(fp);
+    }
+    unlink(file);
+  }
+  // Un reinicio posterior (ESP.restart, otro arranque) ya no es un despertar
+  unsetenv("HIPOTRACK_WAKE_CAUSE");
+  unsetenv("HIPOTRACK_RTC_FILE");
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us) {
+  timerWakeupUs = time_in_us;
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level) {
+  ext0Pin = gpio_num;
+  ext0Level = level;
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source) {
+  if (source == ESP_SLEEP_WAKEUP_EXT0 || source == ESP_SLEEP_WAKEUP_ALL) ext0Pin = -1;
+  if (source == ESP_SLEEP_WAKEUP_TIMER || source == ESP_SLEEP_WAKEUP_ALL) timerWakeupUs = 0;
+  return ESP_OK;
+}
+
+// Duerme hasta el temporizador o hasta que el pin de ext0 alcance su nivel
+static esp_sleep_wakeup_cause_t sleepUntilWakeup() {
+  auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(timerWakeupUs);
+  while (std::chrono::steady_clock::now() < end) {
+    if (ext0Pin >= 0 && digitalRead((uint8_t)ext0Pin) == ext0Level) return ESP_SLEEP_WAKEUP_EXT0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return ESP_SLEEP_WAKEUP_TIMER;
+}
+
+esp_err_t esp_light_sleep_start() {
+  wakeupCause = sleepUntilWakeup();
+  return ESP_OK;
+}
+
+void esp_deep_sleep_start() {
+  fflush(stdout);
+  char file[64];
+  snprintf(file, sizeof(file), "/tmp/hipotrack_rtc_%d.bin", (int)getpid());
+  FILE *fp = fopen(file, "wb");
+  if (fp) {
+    fwrite(__start_hipotrack_rtc, 1, rtcSize(), fp);
+    fclose(fp);
+  }
+
+  esp_sleep_wakeup_cause_t wake = sleepUntilWakeup();
+
+  char cause[8];
+  snprintf(cause, sizeof(cause), "%d", (int)wake);
+  setenv("HIPOTRACK_WAKE_CAUSE", cause, 1);
+  setenv("HIPOTRACK_RTC_FILE", file, 1);
+  execl("/proc/self/exe", "firmware", (char *)NULL);
+  perror("[SLEEP] execl");
+  exit(1);
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+  return wakeupCause;
+}
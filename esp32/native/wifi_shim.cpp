@@ -0,0 +1,282 @@
+/**
+ * WiFiClient sobre sockets POSIX para el entorno `native`
+ */
+
+#include "WiFi.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+WiFiClass WiFi;
+
+// ============================================================================
+// RED SIMULADA
+// ============================================================================
+
+enum { STA_IDLE, STA_CONNECTING, STA_CONNECTED };
+static std::atomic<int> staState(STA_IDLE);
+static std::atomic<unsigned> attemptId(0);
+static std::mutex handlersMutex;
+static std::vector<std::pair<WiFiEventFuncCb, arduino_event_id_t>> handlers;
+
+static unsigned long envMs(const char *name, unsigned long def) {
+  const char *v = getenv(name);
+  return v ? strtoul(v, NULL, 10) : def;
+}
+
+// Cortes [inicio, fin) en ms desde el arranque
+static const std::vector<std::pair<unsigned long, unsigned long>> &outages() {
+  static std::vector<std::pair<unsigned long, unsigned long>> list;
+  static std::once_flag parsed;
+  std::call_once(parsed, [] {
+    const char *v = getenv("HIPOTRACK_WIFI_OUTAGES");
+    while (v && *v) {
+      char *end;
+      unsigned long start = strtoul(v, &end, 10);
+      unsigned long dur = *end == '+' ? strtoul(end + 1, &end, 10) : 0;
+      list.push_back({start, start + dur});
+      v = *end == ',' ? end + 1 : NULL;
+    }
+  });
+  return list;
+}
+
+bool WiFiClass::linkDown() {
+  unsigned long now = millis();
+  for (const auto &o : outages()) {
+    if (now >= o.first && now < o.second) return true;
+  }
+  return false;
+}
+
+// Los eventos llegan desde otro hilo, como desde la tarea de eventos de la ESP32
+static void emit(arduino_event_id_t event, uint8_t reason = 0) {
+  arduino_event_info_t info = {};
+  info.wifi_sta_disconnected.reason = reason;
+  std::vector<std::pair<WiFiEventFuncCb, arduino_event_id_t>> copy;
+  {
+    std::lock_guard<std::mutex> lock(handlersMutex);
+    copy = handlers;
+  }
+  for (const auto &h : copy) {
+    if (h.second == ARDUINO_EVENT_MAX || h.second == event) h.first(event, info);
+  }
+}
+
+// Vigila los cortes mientras hay conexión
+static void startLinkMonitor() {
+  static std::once_flag started;
+  std::call_once(started, [] {
+    std::thread([] {
+      for (;;) {
+        delay(50);
+        int expected = STA_CONNECTED;
+        if (WiFi.linkDown() && staState.compare_exchange_strong(expected, STA_IDLE)) {
+          emit(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_BEACON_TIMEOUT);
+        }
+      }
+    }).detach();
+  });
+}
+
+static uint8_t apBssid[6] = {0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56};
+
+static int32_t apChannel() {
+  return (int32_t)envMs("HIPOTRACK_WIFI_CHANNEL", 6);
+}
+
+wl_status_t WiFiClass::begin(const char *, const char *, int32_t channel, const uint8_t *bssid,
+                             bool) {
+  startLinkMonitor();
+  if (staState == STA_CONNECTED) return WL_CONNECTED;
+
+  // Con BSSID y canal no hay escaneo; si ya no coinciden el AP "no aparece"
+  bool direct = channel > 0 && bssid;
+  bool wrongAp = direct && (channel != apChannel() || memcmp(bssid, apBssid, 6) != 0);
+  unsigned long connectMs = direct ? envMs("HIPOTRACK_WIFI_FAST_CONNECT_MS", 40)
+                                   : envMs("HIPOTRACK_WIFI_CONNECT_MS", 200);
+
+  staState = STA_CONNECTING;
+  unsigned id = ++attemptId;
+  std::thread([id, wrongAp, connectMs] {
+    delay(connectMs);
+    if (attemptId != id) return;  // Cancelado por disconnect() / otro begin()
+    if (WiFi.linkDown() || wrongAp) {
+      staState = STA_IDLE;
+      emit(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_NO_AP_FOUND);
+      return;
+    }
+    staState = STA_CONNECTED;
+    emit(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+    emit(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  }).detach();
+  return WL_DISCONNECTED;
+}
+
+bool WiFiClass::config(IPAddress, IPAddress, IPAddress, IPAddress) {
+  return true;
+}
+
+uint8_t *WiFiClass::BSSID() {
+  return isConnected() ? apBssid : NULL;
+}
+
+int32_t WiFiClass::channel() {
+  return isConnected() ? apChannel() : 0;
+}
+
+bool WiFiClass::reconnect() {
+  begin(NULL, NULL);
+  return true;
+}
+
+bool WiFiClass::disconnect(bool) {
+  int was = staState.exchange(STA_IDLE);
+  ++attemptId;
+  if (was == STA_CONNECTED) emit(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_ASSOC_LEAVE);
+  return true;
+}
+
+wl_status_t WiFiClass::status() {
+  return staState == STA_CONNECTED ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb cb, arduino_event_id_t event) {
+  std::lock_guard<std::mutex> lock(handlersMutex);
+  handlers.push_back({cb, event});
+  return handlers.size();
+}
+
+// ============================================================================
+// WIFICLIENT
+// ============================================================================
+
+String IPAddress::toString() const {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+  return String(buf);
+}
+
+int WiFiClient::connect(const char *host, uint16_t port, int32_t timeoutMs) {
+  stop();
+  if (!WiFi.isConnected()) return 0;
+
+  char portStr[8];
+  snprintf(portStr, sizeof(portStr), "%u", port);
+  struct addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo *res = nullptr;
+  if (getaddrinfo(host, portStr, &hints, &res) != 0 || !res) return 0;
+
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if (fd < 0) {
+    freeaddrinfo(res);
+    return 0;
+  }
+
+  // Conexión no bloqueante con timeout, como lwip en la ESP32
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  int rc = ::connect(fd, res->ai_addr, res->ai_addrlen);
+  freeaddrinfo(res);
+  if (rc < 0 && errno != EINPROGRESS) {
+    close(fd);
+    return 0;
+  }
+  if (rc < 0) {
+    struct pollfd pfd = {fd, POLLOUT, 0};
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (poll(&pfd, 1, timeoutMs) <= 0 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 ||
+        err != 0) {
+      close(fd);
+      return 0;
+    }
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+
+  fd_ = fd;
+  return 1;
+}
+
+size_t WiFiClient::write(const uint8_t *buf, size_t size) {
+  if (fd_ < 0) return 0;
+  if (WiFi.linkDown()) {
+    // Sin enlace el socket acaba muriendo por timeout; aquí se corta ya
+    stop();
+    return 0;
+  }
+  size_t sent = 0;
+  while (sent < size) {
+    ssize_t n = ::send(fd_, buf + sent, size - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) continue;
+      stop();
+      break;
+    }
+    sent += (size_t)n;
+  }
+  return sent;
+}
+
+int WiFiClient::available() {
+  if (fd_ < 0) return 0;
+  int n = 0;
+  if (ioctl(fd_, FIONREAD, &n) < 0) return 0;
+  return n;
+}
+
+int WiFiClient::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t size) {
+  if (fd_ < 0 || available() <= 0) return -1;
+  ssize_t n = ::recv(fd_, buf, size, 0);
+  return n > 0 ? (int)n : -1;
+}
+
+void WiFiClient::stop() {
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+uint8_t WiFiClient::connected() {
+  if (fd_ < 0) return 0;
+  if (available() > 0) return 1;
+  // Un recv de 0 bytes con MSG_PEEK indica que el servidor cerró
+  uint8_t c;
+  ssize_t n = ::recv(fd_, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n == 0) {
+    stop();
+    return 0;
+  }
+  if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+    stop();
+    return 0;
+  }
+  return 1;
+}
+
+void WiFiClient::setNoDelay(bool nodelay) {
+  if (fd_ < 0) return;
+  int flag = nodelay ? 1 : 0;
+  setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
@@ -0,0 +1,45 @@
+/**
+ * Implementación de los tiempos de arranque (ver boot_timing.h)
+ */
+
+#include "boot_timing.h"
+#include "config.h"
+
+static const char *const kPhaseNames[BOOT_PHASE_COUNT] = {
+    "setupStart", "wifiStart", "cameraReady", "setupDone", "wifiConnected", "firstPoll",
+};
+
+static uint32_t phaseMs[BOOT_PHASE_COUNT];
+static bool marked[BOOT_PHASE_COUNT];
+
+void bootMark(BootPhase phase) {
+  if (marked[phase]) return;
+  phaseMs[phase] = millis();
+  marked[phase] = true;
+}
+
+uint32_t bootPhaseMs(BootPhase phase) {
+  return marked[phase] ? phaseMs[phase] : 0;
+}
+
+size_t bootTimingToJson(char *out, size_t cap) {
+  size_t n = 0;
+  for (int p = 0; p < BOOT_PHASE_COUNT; p++) {
+    int w = snprintf(out + n, cap - n, "%s\"%sMs\":%u", p ? "," : "{", kPhaseNames[p],
+                     (unsigned)bootPhaseMs((BootPhase)p));
+    if (w < 0 || (size_t)w >= cap - n) return 0;
+    n += w;
+  }
+  if (n + 1 >= cap) return 0;
+  out[n++] = '}';
+  out[n] = '\0';
+  return n;
+}
+
+void bootTimingPrint() {
+  DEBUG_PRINTLN("[BOOT] Tiempos de arranque (ms desde el inicio de la aplicación):");
+  for (int p = 0; p < BOOT_PHASE_COUNT; p++) {
+    if (!marked[p]) continue;
+    DEBUG_PRINTF("[BOOT]   %-14s %6u\n", kPhaseNames[p], (unsigned)phaseMs[p]);
+  }
+}
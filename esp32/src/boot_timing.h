@@ -0,0 +1,37 @@
+/**
+ * Tiempos de arranque por fase (proyecto TPI2)
+ *
+ * Cada fase guarda millis() la primera vez que se marca. Con FAST_BOOT la
+ * asociación WiFi arranca antes que la cámara y corre en paralelo con ella, así
+ * que BOOT_WIFI_CONNECTED puede quedar antes o después de BOOT_CAMERA_READY.
+ * El primer informe a /status tras la primera consulta de control incluye
+ * estos tiempos ("boot").
+ */
+
+#ifndef BOOT_TIMING_H
+#define BOOT_TIMING_H
+
+#include <Arduino.h>
+
+enum BootPhase {
+  BOOT_SETUP_START,     // Entrada en setup() (antes: ROM, bootloader, test de PSRAM)
+  BOOT_WIFI_START,      // WiFi.begin() lanzado
+  BOOT_CAMERA_READY,    // esp_camera_init() terminado
+  BOOT_SETUP_DONE,      // Fin de setup()
+  BOOT_WIFI_CONNECTED,  // IP obtenida
+  BOOT_FIRST_POLL,      // Respuesta de la primera consulta de control
+  BOOT_PHASE_COUNT
+};
+
+// Registra la fase (solo la primera vez)
+void bootMark(BootPhase phase);
+
+// millis() de la fase, 0 si aún no se ha marcado
+uint32_t bootPhaseMs(BootPhase phase);
+
+// Escribe {"setupStartMs":..,...,"firstPollMs":..} en out. Devuelve la longitud (0 si no cabe).
+size_t bootTimingToJson(char *out, size_t cap);
+
+void bootTimingPrint();
+
+#endif // BOOT_TIMING_H
@@ -0,0 +1,141 @@
+/**
+ * Implementación de la ráfaga de fotos (ver burst.h)
+ */
+
+#include "burst.h"
+#include "config.h"
+#include "frame_ring.h"
+#include "metrics.h"
+#include "esp_camera.h"
+
+static FrameRing ring;  // Se reserva con la primera ráfaga y se conserva
+static BurstStats stats;
+
+int burstCapture(int count, uint32_t intervalMs) {
+  if (count <= 0) return 0;
+  if (count > BURST_MAX_COUNT) count = BURST_MAX_COUNT;
+  if (!ring.capacity() && !ring.begin(BURST_BUFFER_BYTES)) {
+    DEBUG_PRINTLN("[BURST] Sin memoria para el anillo de la ráfaga");
+    return 0;
+  }
+  // Restos de una ráfaga anterior sin subir: se pierden
+  stats.framesDropped += ring.count();
+  ring.clear();
+
+  stats.bursts++;
+  stats.lastRequested = count;
+  stats.lastCaptured = 0;
+  stats.lastBytes = 0;
+  stats.lastMaxGapMs = 0;
+
+  unsigned long first = 0, prev = 0;
+  uint32_t sumGap = 0;
+  for (int i = 0; i < count; i++) {
+    // Con intervalo, cada disparo sale intervalMs después del anterior
+    if (i > 0 && intervalMs > 0) {
+      long wait = (long)(prev + intervalMs - millis());
+      if (wait > 0) delay(wait);
+    }
+
+    unsigned long shot = millis();
+    METRIC_START(t0);
+    camera_fb_t *fb = esp_camera_fb_get();
+    METRIC_STOP(METRIC_CAPTURE, t0);
+    if (!fb) {
+      stats.framesDropped++;
+      continue;
+    }
+    METRIC_ADD(METRIC_BYTES_CAPTURED, fb->len);
+
+    // Copia a PSRAM y el buffer vuelve al driver enseguida: el sensor no espera.
+    // Sin sitio, la ráfaga se corta aquí en vez de expulsar sus primeros frames.
+    bool ok = ring.fits(fb->len) && ring.push(fb->buf, fb->len, shot);
+    size_t len = fb->len;
+    esp_camera_fb_return(fb);
+    if (!ok) {
+      stats.framesDropped += count - i;
+      DEBUG_PRINTF("[BURST] Anillo lleno tras %u frames\n", (unsigned)stats.lastCaptured);
+      break;
+    }
+
+    if (stats.lastCaptured == 0) {
+      first = shot;
+    } else {
+      uint32_t gap = shot - prev;
+      sumGap += gap;
+      if (gap > stats.lastMaxGapMs) stats.lastMaxGapMs = gap;
+    }
+    prev = shot;
+    stats.lastCaptured++;
+    stats.lastBytes += len;
+  }
+
+  stats.framesCaptured += stats.lastCaptured;
+  stats.lastCaptureMs = stats.lastCaptured ? millis() - first : 0;
+  stats.lastAvgGapMs = stats.lastCaptured > 1 ? sumGap / (stats.lastCaptured - 1) : 0;
+  DEBUG_PRINTF("[BURST] %u/%u frames en %u ms (%u KB, entre disparos media %u ms, máx %u ms)\n",
+               (unsigned)stats.lastCaptured, (unsigned)count, (unsigned)stats.lastCaptureMs,
+               (unsigned)(stats.lastBytes / 1024), (unsigned)stats.lastAvgGapMs,
+               (unsigned)stats.lastMaxGapMs);
+  return stats.lastCaptured;
+}
+
+int burstUpload(BurstUploadFn upload, BurstSpillFn spill) {
+  unsigned long t0 = millis();
+  int sent = 0;
+  bool failed = false;
+  const uint8_t *data;
+  size_t len;
+  uint32_t shotMs;
+  while (ring.peek(&data, &len, &shotMs)) {
+    if (!failed && upload && upload(data, len, millis() - shotMs)) {
+      stats.framesUploaded++;
+      sent++;
+    } else {
+      // Tras el primer fallo no se insiste: el resto a la cola offline
+      failed = true;
+      if (spill && spill(data, len)) {
+        stats.framesSpilled++;
+      } else {
+        stats.framesDropped++;
+      }
+    }
+    ring.pop();
+  }
+  stats.lastUploadMs = millis() - t0;
+  DEBUG_PRINTF("[BURST] %d frames subidos en %u ms%s\n", sent, (unsigned)stats.lastUploadMs,
+               failed ? " (el resto, a la cola offline)" : "");
+  return sent;
+}
+
+size_t burstPending() {
+  return ring.count();
+}
+
+const BurstStats &burstStats() {
+  return stats;
+}
+
+size_t burstToJson(char *out, size_t cap) {
+  int n = snprintf(out, cap,
+                   "{\"bursts\":%u,\"framesCaptured\":%u,\"framesUploaded\":%u,"
+                   "\"framesSpilled\":%u,\"framesDropped\":%u,\"lastRequested\":%u,"
+                   "\"lastCaptured\":%u,\"lastCaptureMs\":%u,\"lastAvgGapMs\":%u,"
+                   "\"lastMaxGapMs\":%u,\"lastUploadMs\":%u,\"lastBytes\":%u}",
+                   (unsigned)stats.bursts, (unsigned)stats.framesCaptured,
+                   (unsigned)stats.framesUploaded, (unsigned)stats.framesSpilled,
+                   (unsigned)stats.framesDropped, (unsigned)stats.lastRequested,
+                   (unsigned)stats.lastCaptured, (unsigned)stats.lastCaptureMs,
+                   (unsigned)stats.lastAvgGapMs, (unsigned)stats.lastMaxGapMs,
+                   (unsigned)stats.lastUploadMs, (unsigned)stats.lastBytes);
+  return (n > 0 && (size_t)n < cap) ? (size_t)n : 0;
+}
+
+void burstPrintStats() {
+  if (stats.bursts == 0) return;
+  DEBUG_PRINTF("[BURST] Ráfagas: %u, frames capturados %u, subidos %u, a la cola %u, "
+               "perdidos %u\n",
+               (unsigned)stats.bursts, (unsigned)stats.framesCaptured,
+               (unsigned)stats.framesUploaded, (unsigned)stats.framesSpilled,
+               (unsigned)stats.framesDropped);
+}
@@ -0,0 +1,62 @@
+/**
+ * Ráfaga de fotos con subida diferida (proyecto TPI2)
+ *
+ * captureAndSendPhoto() toma un frame y se bloquea en la subida, así que entre
+ * dos fotos manda la red. Con la acción "burst" (count, intervalMs) del canal
+ * de control:
+ *  1. burstCapture() toma count frames a resolución de captura seguidos, al
+ *     ritmo del sensor (o cada intervalMs), y los copia a un anillo en PSRAM
+ *     (frame_ring.h, BURST_BUFFER_BYTES). Ningún envío entre disparo y disparo.
+ *  2. burstUpload() los sube después, el más antiguo primero, por la conexión
+ *     persistente; si una subida falla, los que quedan van al vertedero
+ *     indicado (la cola offline).
+ *
+ * Cada ráfaga deja sus tiempos: duración de la captura, intervalo medio y
+ * máximo entre disparos y duración de la subida.
+ */
+
+#ifndef BURST_H
+#define BURST_H
+
+#include <Arduino.h>
+
+// Sube un frame de la ráfaga; ageMs es el tiempo desde su captura
+typedef bool (*BurstUploadFn)(const uint8_t *data, size_t len, uint32_t ageMs);
+
+// Guarda un frame que no se pudo subir (p. ej. offlineQueuePush)
+typedef bool (*BurstSpillFn)(const uint8_t *data, size_t len);
+
+struct BurstStats {
+  uint32_t bursts;
+  uint32_t framesCaptured;
+  uint32_t framesUploaded;
+  uint32_t framesSpilled;   // A la cola offline tras un fallo de subida
+  uint32_t framesDropped;   // Sin frame del sensor o sin sitio en el anillo
+  // Última ráfaga
+  uint32_t lastRequested;
+  uint32_t lastCaptured;
+  uint32_t lastCaptureMs;   // Del primer disparo al último frame guardado
+  uint32_t lastAvgGapMs;    // Entre disparos consecutivos
+  uint32_t lastMaxGapMs;
+  uint32_t lastUploadMs;
+  uint32_t lastBytes;
+};
+
+// Captura hasta count frames (ya con la cámara en resolución de captura).
+// Devuelve cuántos quedaron guardados.
+int burstCapture(int count, uint32_t intervalMs);
+
+// Sube los frames guardados y vacía el anillo (upload NULL: todos a spill).
+// Devuelve cuántos se subieron.
+int burstUpload(BurstUploadFn upload, BurstSpillFn spill);
+
+size_t burstPending();
+
+const BurstStats &burstStats();
+
+// Escribe {"bursts":..,"lastAvgGapMs":..,...} en out. Devuelve la longitud (0 si no cabe).
+size_t burstToJson(char *out, size_t cap);
+
+void burstPrintStats();
+
+#endif // BURST_H
@@ -16,8 +16,21 @@
 #define WIFI_SSID "LUGARPEN"
 #define WIFI_PASSWORD "Chelu2025"
 
-// Tiempo máximo de espera para conectar a WiFi (milisegundos)
-#define WIFI_TIMEOUT 60000
+// Tiempo máximo de cada intento de conexión a WiFi (milisegundos)
+#define WIFI_TIMEOUT 20000
+
+// Espera entre intentos fallidos: se duplica desde MIN hasta MAX (milisegundos)
+#define WIFI_BACKOFF_MIN 1000
+#define WIFI_BACKOFF_MAX 60000
+
+// Conexión rápida: reutilizar BSSID, canal e IP de la última conexión buena
+// (guardados en RTC y NVS) antes de escanear. Con WIFI_FAST_STATIC_IP 1 la IP de
+// la última concesión se fija sin DHCP aunque haya caducado: activarlo solo con
+// la IP reservada en el router, o puede chocar con la de otro equipo.
+#define WIFI_FAST_CONNECT 1
+#define WIFI_FAST_CONNECT_TIMEOUT 3000
+#define WIFI_FAST_STATIC_IP 0
+#define WIFI_NVS_NAMESPACE "wifi"
 
 // ============================================================================
 // CONFIGURACIÓN DEL SERVIDOR FLASK (RASPBERRY / BACKEND)
@@ -28,10 +41,15 @@
 // - Linux: ip addr show o hostname -I
 // - Windows: ipconfig
 // - Mac: ifconfig
+// Se puede redefinir con build_flags (p. ej. el entorno native apunta a 127.0.0.1)
+#ifndef SERVER_IP
 #define SERVER_IP "192.168.1.6"
+#endif
 
 // Puerto del servidor Flask
+#ifndef SERVER_PORT
 #define SERVER_PORT 3001
+#endif
 
 // Macro auxiliar para convertir número a string
 #define STR_HELPER(x) #x
@@ -40,7 +58,9 @@
 // ID de la cámara en el backend (debe coincidir con el ID que ves en el frontend)
 // EJEMPLO: "cam-01", "esp32-01", etc.
 // TODO: REEMPLAZAR por el ID real de tu cámara
+#ifndef CAMERA_ID
 #define CAMERA_ID "1764782851247"
+#endif
 
 // ¿Usar HTTPS? (normalmente false en entorno local/LAN)
 #define USE_HTTPS false
@@ -57,7 +77,9 @@
 // Token de autenticación compartido con el backend (opcional).
 // Debe coincidir con la variable de entorno CAMERA_API_TOKEN que uses al arrancar server.js.
 // Si no usas autenticación, deja la cadena vacía "".
+#ifndef CAMERA_API_TOKEN
 #define CAMERA_API_TOKEN "tu_token_secreto_compartido"
+#endif
 
 // URLs completas de endpoints que espera server.js (API TPI2, mismo esquema que Raspberry)
 // Control de acciones (foto / streaming)
@@ -72,6 +94,23 @@
 // POST /api/cameras/:cameraId/live-frame (multipart/form-data, campo "image")
 #define SERVER_URL_STREAM            BASE_HTTP_URL "/api/cameras/" CAMERA_ID "/live-frame"
 
+// Alargar el streaming en curso (JSON: {"seconds": N}); la cámara lo pide con un
+// hipopótamo a la vista (DETECT_FEEDBACK)
+// POST /api/cameras/:cameraId/extend-stream
+#define SERVER_URL_EXTEND_STREAM     BASE_HTTP_URL "/api/cameras/" CAMERA_ID "/extend-stream"
+
+// Estado de la cámara y métricas de latencia (JSON)
+// POST /api/cameras/:cameraId/status
+#define SERVER_URL_STATUS            BASE_HTTP_URL "/api/cameras/" CAMERA_ID "/status"
+
+// Streaming por WebSocket (mismo canal que la Raspberry), ruta relativa a BASE_HTTP_URL
+// ws://<host>/ws/camera-stream?cameraId=<CAMERA_ID>  (mensajes binarios JPEG)
+#define SERVER_WS_STREAM_PATH        "/ws/camera-stream?cameraId=" CAMERA_ID
+
+// Muestras de energía (JSON: voltage, current, watts, cpuTemp)
+// POST /api/cameras/:cameraId/energy
+#define SERVER_URL_ENERGY            BASE_HTTP_URL "/api/cameras/" CAMERA_ID "/energy"
+
 // No hay un endpoint equivalente a STREAMING_STATUS en la API TPI2; esta macro queda sin uso.
 #define SERVER_URL_STREAMING_STATUS  BASE_HTTP_URL "/api/streaming-status"
 
@@ -103,16 +142,343 @@
 // Intervalo para verificar si debe capturar foto (milisegundos)
 #define CAPTURE_CHECK_INTERVAL 1000  // 1 segundo
 
+// Long-poll del canal de control: la petición a take-photo-or-video queda abierta
+// hasta que haya una acción o pasen estos segundos (0 = sondeo clásico cada
+// CAPTURE_CHECK_INTERVAL). Debe ser menor que MAX_CONTROL_WAIT_SECONDS del servidor.
+#define CONTROL_LONG_POLL_SECONDS 25
+
+// Si el servidor no soporta long-poll se vuelve al sondeo y se reintenta pasado este tiempo
+#define CONTROL_LONG_POLL_RETRY_INTERVAL 600000  // 10 minutos
+
+// Durante un streaming el control sigue activo (foto, parar, otra duración) por
+// una segunda conexión; cada long-poll queda abierto como mucho estos segundos
+#define STREAM_CONTROL_WAIT_SECONDS 5
+
 // Intervalo para verificar si debe hacer streaming (milisegundos)
 #define STREAMING_CHECK_INTERVAL 5000  // 5 segundos
 
-// Delay entre frames de streaming (milisegundos)
+// Periodo entre frames de streaming (milisegundos)
+// La captura y la subida van en paralelo, así que es el periodo real de captura.
 // Valores más bajos = más FPS pero más carga de red
 #define STREAMING_FRAME_DELAY 100  // ~10 FPS
 
+// Frames que pueden esperar subida; si la red no da abasto se descarta el más antiguo.
+// Nunca menos que STREAM_BATCH_MAX (ver STREAM_QUEUE_DEPTH).
+#define STREAM_QUEUE_LENGTH 2
+
+// Núcleos de las tareas de streaming (la pila WiFi corre en el núcleo 0)
+#define STREAM_CAPTURE_CORE 1
+#define STREAM_UPLOAD_CORE  0
+
+// Pila y prioridad de las tareas de captura / subida
+#define STREAM_TASK_STACK    8192
+#define STREAM_TASK_PRIORITY 2
+
+// Transporte de los frames de streaming
+//  STREAM_TRANSPORT_HTTP: un POST multipart por frame a SERVER_URL_STREAM
+//  STREAM_TRANSPORT_WS:   mensajes binarios sobre un único WebSocket
+// El backend puede elegir otro por sesión con "transport": "http" | "ws"
+#define STREAM_TRANSPORT_HTTP 0
+#define STREAM_TRANSPORT_WS   1
+#define STREAM_TRANSPORT STREAM_TRANSPORT_HTTP
+
+// Máximo de frames por petición en el transporte HTTP (1 = un frame por POST)
+// El tamaño real del lote sigue a la espera de respuesta medida dividida por
+// el periodo entre frames: en enlaces con mucha latencia se pagan menos esperas.
+#define STREAM_BATCH_MAX 4
+
+// Profundidad real de la cola de streaming: un lote entero tiene que caber
+#define STREAM_QUEUE_DEPTH \
+  (STREAM_QUEUE_LENGTH > STREAM_BATCH_MAX ? STREAM_QUEUE_LENGTH : STREAM_BATCH_MAX)
+
+// Frames que pueden existir a la vez (fb_count de la cámara): un lote en
+// subida, la cola llena y uno llenándose en el driver
+#define STREAM_FRAMES_IN_FLIGHT (STREAM_BATCH_MAX + STREAM_QUEUE_DEPTH + 1)
+
+// Supresión de frames repetidos (1 = activa): antes de encolar un frame se
+// compara con el último enviado usando solo el JPEG (tamaño y coeficientes DC,
+// ver jpeg_dc.h). Si la escena no ha cambiado el frame no se sube.
+#define STREAM_DEDUP 1
+
+// Aunque la escena siga igual, se envía un frame cada tanto (milisegundos)
+#define STREAM_DEDUP_KEEPALIVE_MS 2000
+
+// Diferencia de brillo medio (0-255) para que una celda de la firma cuente
+// como cambiada, y celdas cambiadas (de 16x12) que aún se consideran ruido
+#define STREAM_DEDUP_CELL_DIFF         6
+#define STREAM_DEDUP_MAX_CHANGED_CELLS 2
+
+// Variación de tamaño del JPEG (%) que aún se considera la misma escena
+#define STREAM_DEDUP_SIZE_PCT 8
+
+// Región de interés (1 = activa): si el servidor detecta animales, la respuesta
+// de control trae la zona donde están y el sensor (OV2640) se recorta a ella,
+// con la misma resolución de salida: más detalle del animal por los mismos bytes
+#define STREAM_ROI 1
+
+// Sin respuesta de control que la confirme, la región caduca pasado su "ttlMs"
+// más esta holgura (milisegundos) y se vuelve al campo completo
+#define STREAM_ROI_GRACE_MS (STREAM_CONTROL_WAIT_SECONDS * 1000 + 2000)
+
+// Realimentación de detecciones (1 = activa): las respuestas de /photo y
+// /live-frame traen "hippoCount" y el streaming cambia de modo (detect_feedback.h)
+#define DETECT_FEEDBACK 1
+
+// Modo activo: hipopótamo visto hace menos de esto (milisegundos). Periodo entre
+// frames y pasos de calidad JPEG que se mejoran mientras dura
+#define DETECT_ACTIVE_HOLD_MS       10000
+#define DETECT_ACTIVE_FRAME_DELAY   66  // ~15 FPS
+#define DETECT_ACTIVE_QUALITY_BOOST 4
+
+// Modo reposo: sin hipopótamos en este tiempo (milisegundos), un frame cada
+// DETECT_IDLE_FRAME_DELAY
+#define DETECT_IDLE_AFTER_MS    30000
+#define DETECT_IDLE_FRAME_DELAY 1000
+
+// Con un animal a la vista, a falta de la mitad de esto para terminar, el
+// streaming se alarga estos segundos (y lo pide al servidor), hasta el máximo
+#define DETECT_EXTEND_SECONDS     15
+#define DETECT_EXTEND_MAX_SECONDS 120
+
+// Cada cuánto se imprimen los contadores del streaming (milisegundos)
+#define STREAM_STATS_INTERVAL 5000
+
+// Control adaptativo del streaming (1 = activo, 0 = parámetros fijos de arriba)
+// Mide tiempo de subida y bytes por frame y ajusta calidad JPEG, resolución y
+// periodo entre frames para no superar la latencia / tasa objetivo.
+#define STREAM_ADAPTIVE 1
+
+// Tiempo de subida por frame que se intenta mantener (milisegundos)
+#define STREAM_ADAPT_TARGET_MS 150
+
+// Tasa máxima de subida en kbit/s (0 = sin límite, solo manda la latencia)
+#define STREAM_ADAPT_MAX_KBPS 0
+
+// Frames medidos entre decisiones (tras cada cambio se descarta la ventana)
+#define STREAM_ADAPT_WINDOW 8
+
+// Rango de calidad JPEG que puede usar el controlador y paso entre niveles
+#define STREAM_ADAPT_QUALITY_BEST  12
+#define STREAM_ADAPT_QUALITY_WORST 40
+#define STREAM_ADAPT_QUALITY_STEP  4
+
+// Rango de resolución (ver escalera en stream_adapt.cpp)
+#define STREAM_ADAPT_MIN_FRAMESIZE FRAMESIZE_QQVGA
+#define STREAM_ADAPT_MAX_FRAMESIZE FRAMESIZE_VGA
+
+// Periodo máximo entre frames cuando la red es muy lenta (milisegundos)
+#define STREAM_ADAPT_MAX_PERIOD 2000
+
 // Timeout para peticiones HTTP (milisegundos)
 #define HTTP_TIMEOUT 5000
 
+// Cada cuánto se imprime el resumen de la conexión HTTP persistente
+// (reutilización del socket y latencia por petición) en milisegundos
+#define HTTP_STATS_INTERVAL 60000
+
+// ============================================================================
+// MÉTRICAS DE LATENCIA
+// ============================================================================
+
+// Histogramas por etapa (captura, multipart, conexión, envío, respuesta) y
+// contadores de bytes en RAM, enviados a SERVER_URL_STATUS.
+// 0 = las macros METRIC_* desaparecen del código (coste nulo).
+#define ENABLE_METRICS 1
+
+// Cada cuánto se envían (y reinician) las métricas (milisegundos)
+#define METRICS_REPORT_INTERVAL 60000
+
+// ============================================================================
+// COLA OFFLINE (STORE-AND-FORWARD)
+// ============================================================================
+
+// Las fotos que no se pueden enviar (sin WiFi o error del servidor) se guardan
+// y se reenvían al volver la conectividad, de la más antigua a la más nueva.
+//  OFFLINE_STORAGE_PSRAM: anillo en PSRAM, rápido pero se pierde al reiniciar
+//  OFFLINE_STORAGE_SD:    ficheros en la microSD (SD_MMC en modo 1 bit, así
+//                         GPIO 4 sigue libre para el flash); sobrevive a reinicios
+#define OFFLINE_STORAGE_NONE  0
+#define OFFLINE_STORAGE_PSRAM 1
+#define OFFLINE_STORAGE_SD    2
+#define OFFLINE_QUEUE_STORAGE OFFLINE_STORAGE_PSRAM
+
+// Límites de la cola: al superarlos se expulsa la foto más antigua
+#define OFFLINE_QUEUE_BYTES     (1536 * 1024)        // Anillo en PSRAM
+#define OFFLINE_SD_MAX_BYTES    (64UL * 1024 * 1024) // Espacio máximo en la SD
+#define OFFLINE_QUEUE_MAX_ITEMS 64
+
+// Carpeta de la cola en la SD
+#define OFFLINE_SD_DIR "/queue"
+
+// Vaciado: pocas fotos por ciclo para no retrasar el canal de control
+#define OFFLINE_DRAIN_BATCH     3      // Fotos por ciclo
+#define OFFLINE_DRAIN_BUDGET_MS 3000   // Tiempo máximo por ciclo
+#define OFFLINE_DRAIN_INTERVAL  2000   // Entre ciclos con éxito
+#define OFFLINE_DRAIN_BACKOFF   30000  // Tras un fallo de subida
+
+// ============================================================================
+// BAJO CONSUMO
+// ============================================================================
+
+// 1 = un ciclo de control cada LOW_POWER_POLL_INTERVAL y a dormir entre medias
+// (para unidades a batería). Sin long-poll: la radio no se queda esperando.
+#ifndef LOW_POWER_MODE
+#define LOW_POWER_MODE 0
+#endif
+
+// Periodo entre consultas de control en bajo consumo (milisegundos)
+#define LOW_POWER_POLL_INTERVAL 30000
+
+// Tipo de sueño según lo que falta hasta la siguiente consulta (milisegundos):
+// por debajo de LIGHT_SLEEP_MIN solo se espera; por debajo de DEEP_SLEEP_MIN,
+// light sleep; a partir de ahí, deep sleep (reconectar cuesta ~1 s de radio)
+#define LOW_POWER_LIGHT_SLEEP_MIN_MS 1000
+#define LOW_POWER_DEEP_SLEEP_MIN_MS  15000
+
+// Sin WiFi tras este tiempo despierto, dormir igualmente y reintentar en el siguiente ciclo
+#define LOW_POWER_MAX_AWAKE_MS 20000
+
+// Estimación de energía (la placa no mide corriente): tensión de alimentación y
+// consumo típico de una ESP32-CAM AI-Thinker en cada estado (el regulador y la
+// PSRAM ponen el suelo en deep sleep, no el chip)
+#define ENERGY_SUPPLY_VOLTAGE         5.0
+#define ENERGY_CURRENT_ACTIVE_MA      180.0
+#define ENERGY_CURRENT_LIGHT_SLEEP_MA 8.0
+#define ENERGY_CURRENT_DEEP_SLEEP_MA  6.0
+
+// Cada cuánto se envía una muestra a SERVER_URL_ENERGY (milisegundos, contando
+// el tiempo dormido; 0 = no se envían)
+#define ENERGY_REPORT_INTERVAL 300000
+
+// Tras un envío fallido, espera antes de reintentar en el mismo despertar (milisegundos)
+#define ENERGY_REPORT_RETRY 60000
+
+// ============================================================================
+// SENSOR PIR
+// ============================================================================
+
+// 1 = un PIR en PIR_PIN dispara una foto. Despierto, por interrupción; en
+// light / deep sleep despierta al chip (ext0), que captura antes de conectar.
+#ifndef PIR_ENABLED
+#define PIR_ENABLED 0
+#endif
+
+// Tiene que ser un GPIO RTC para ext0. GPIO 13 queda libre con la SD en modo 1 bit.
+#define PIR_PIN          GPIO_NUM_13
+#define PIR_ACTIVE_LEVEL 1
+
+// Tras un disparo se ignoran los siguientes durante este tiempo (milisegundos)
+#define PIR_COOLDOWN_MS 10000
+
+// Tiempo máximo con la foto en memoria esperando WiFi; después pasa a la cola offline
+#define PIR_UPLOAD_WAIT_MS 10000
+
+// ============================================================================
+// PRE-ROLL (LO QUE PASÓ ANTES DEL DISPARO)
+// ============================================================================
+
+// 1 = la cámara guarda sin parar los últimos PREROLL_SECONDS en baja resolución
+// y los sube antes de la foto / streaming / disparo del PIR. Necesita la cámara
+// encendida: no se usa con LOW_POWER_MODE.
+#ifndef PREROLL_ENABLED
+#define PREROLL_ENABLED 0
+#endif
+
+// Ventana y ritmo de captura (milisegundos entre frames)
+#define PREROLL_SECONDS        5
+#define PREROLL_FRAME_INTERVAL 500
+
+// Memoria máxima del anillo en PSRAM: al llenarse se expulsan los frames más antiguos
+// (un frame QVGA con calidad 20 ocupa unos 8-12 KB)
+#define PREROLL_BUDGET_BYTES (256 * 1024)
+
+// Resolución y calidad de los frames del pre-roll
+#define PREROLL_FRAME_SIZE   FRAMESIZE_QVGA
+#define PREROLL_JPEG_QUALITY 20
+
+// Tarea de captura: por debajo de las de streaming, en el núcleo de la captura
+// (con MOTION_DETECT_ENABLED también decodifica los frames para el detector)
+#define PREROLL_TASK_STACK    (MOTION_DETECT_ENABLED ? 4096 : 3072)
+#define PREROLL_TASK_PRIORITY 1
+
+// ============================================================================
+// RÁFAGA DE FOTOS
+// ============================================================================
+
+// Acción "burst" del servidor: count fotos seguidas a resolución de captura,
+// guardadas en PSRAM y subidas al terminar
+#define BURST_DEFAULT_COUNT 5
+#define BURST_MAX_COUNT     20
+
+// Memoria del anillo de la ráfaga (se reserva con la primera); si se llena, la ráfaga se corta
+#define BURST_BUFFER_BYTES (1024 * 1024)
+
+// ============================================================================
+// DETECCIÓN DE MOVIMIENTO EN LA CÁMARA
+// ============================================================================
+
+// 1 = la propia cámara busca movimiento (sin PIR ni servidor): compara frames
+// diminutos en gris con un fondo aprendido y, al ver movimiento, hace una foto
+// o un streaming corto. Con PREROLL_ENABLED analiza los frames del pre-roll en
+// vez de reconfigurar el sensor. Necesita la cámara encendida: no se usa con
+// LOW_POWER_MODE.
+#ifndef MOTION_DETECT_ENABLED
+#define MOTION_DETECT_ENABLED 0
+#endif
+
+// Frames analizados (sin pre-roll): cada cuánto y en qué resolución / calidad
+#define MOTION_CHECK_INTERVAL 500
+#define MOTION_FRAME_SIZE     FRAMESIZE_96X96
+#define MOTION_JPEG_QUALITY   12
+
+// Rejilla en gris del detector y tamaño de bloque (tiene que dividir a ambos)
+#define MOTION_GRID_WIDTH  96
+#define MOTION_GRID_HEIGHT 96
+#define MOTION_BLOCK_SIZE  8
+
+// Sensibilidad (ajustar con `pio run -e bench_motion`):
+//  - un bloque cambia si su diferencia media con el fondo supera MOTION_BLOCK_THRESHOLD (0-255)
+//  - hay movimiento con MOTION_MIN_BLOCKS bloques cambiados
+//  - con más de MOTION_MAX_CHANGED_PCT % de bloques cambiados es un cambio de luz
+#define MOTION_BLOCK_THRESHOLD 12
+#define MOTION_MIN_BLOCKS      3
+#define MOTION_MAX_CHANGED_PCT 60
+
+// El fondo absorbe 1/2^MOTION_LEARN_SHIFT de cada frame; los primeros
+// MOTION_WARMUP_FRAMES (y los que siguen a un cambio de modo del sensor) solo lo construyen
+#define MOTION_LEARN_SHIFT   4
+#define MOTION_WARMUP_FRAMES 4
+
+// Tras un disparo se ignora el movimiento durante este tiempo (milisegundos)
+#define MOTION_COOLDOWN_MS 10000
+
+// Qué hace un disparo: 0 = una foto (como el PIR), N > 0 = streaming de N segundos
+#define MOTION_STREAM_SECONDS 0
+
+// Tarea de análisis, junto a la del pre-roll
+#define MOTION_TASK_STACK    4096
+#define MOTION_TASK_PRIORITY 1
+
+// ============================================================================
+// CLASIFICADOR EN LA CÁMARA (TINYML)
+// ============================================================================
+
+// 1 = las fotos del PIR y del detector de movimiento pasan antes por el
+// clasificador int8 de tinyml_model_data.h (yolo/export_tinyml.py) y las
+// negativas no se suben. Sin modelo exportado no descarta nada.
+#ifndef TINYML_GATE
+#define TINYML_GATE 1
+#endif
+
+// Umbrales sobre la probabilidad de hipopótamo (0-100; ajustar con
+// `pio run -e bench_tinyml`): por debajo de NEGATIVE no se sube, desde
+// POSITIVE es positiva y entre medias dudosa (se sube)
+#define TINYML_NEGATIVE_BELOW_PCT 20
+#define TINYML_POSITIVE_FROM_PCT  60
+
+// Uno de cada N negativos se sube igualmente para medir los que se pierden (0 = ninguno)
+#define TINYML_AUDIT_EVERY 10
+
 // ============================================================================
 // CONFIGURACIÓN DE DEBUG
 // ============================================================================
@@ -120,16 +486,29 @@
 // Habilitar mensajes de debug en Serial Monitor
 #define DEBUG_MODE true
 
-// Macros para imprimir mensajes de debug
-#if DEBUG_MODE
-  #define DEBUG_PRINT(x) Serial.print(x)
-  #define DEBUG_PRINTLN(x) Serial.println(x)
-  #define DEBUG_PRINTF(x, ...) Serial.printf(x, __VA_ARGS__)
-#else
-  #define DEBUG_PRINT(x)
-  #define DEBUG_PRINTLN(x)
-  #define DEBUG_PRINTF(x, ...)
-#endif
+// Nivel de log: los mensajes de niveles superiores no se compilan.
+// DEBUG_PRINT / DEBUG_PRINTLN / DEBUG_PRINTF son nivel INFO; el detalle por
+// petición / frame es nivel DEBUG (en campo basta con LOG_LEVEL_INFO).
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+
+// Log asíncrono: los mensajes van a un anillo en RAM y una tarea de baja
+// prioridad los escribe en Serial (0 = Serial directo, bloqueante)
+#define LOG_ASYNC 1
+
+// Huecos del anillo y tamaño máximo de cada uno (LOG_RING_SLOTS * LOG_LINE_MAX de RAM)
+#define LOG_RING_SLOTS 64
+#define LOG_LINE_MAX   160
+
+// Tarea que vacía el anillo: por debajo de las de streaming, en el núcleo de la app
+#define LOG_TASK_STACK     3072
+#define LOG_TASK_PRIORITY  1
+#define LOG_TASK_CORE      1
+#define LOG_FLUSH_INTERVAL 20  // ms de espera con el anillo vacío
 
 // ============================================================================
 // CONFIGURACIÓN DE LED / FLASH
@@ -141,6 +520,23 @@
 // Usar flash al capturar foto
 #define USE_FLASH false
 
+// Parpadeos de estado en una tarea aparte (no bloquean setup / loop)
+#define STATUS_LED_QUEUE_LENGTH 4
+#define STATUS_LED_TASK_STACK   1536
+
+// ============================================================================
+// ARRANQUE
+// ============================================================================
+
+// 1 = arranque rápido: sin la espera de 1 s tras Serial.begin y con la
+// asociación WiFi en paralelo a la inicialización de la cámara.
+// (Si la placa se reinicia por brownout al arrancar, la fuente no aguanta el
+// pico de WiFi + cámara a la vez: probar con 0.)
+#define FAST_BOOT 1
+
+// Macros DEBUG_* y LOG_* (necesitan la configuración de arriba)
+#include "logger.h"
+
 #endif // CONFIG_H
 
 
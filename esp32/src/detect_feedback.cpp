@@ -0,0 +1,119 @@
+/**
+ * Implementación de la realimentación de detecciones (ver detect_feedback.h)
+ */
+
+#include "detect_feedback.h"
+#include "config.h"
+
+static const char *const kModeNames[] = {"normal", "activo", "reposo"};
+
+// Escritos por cualquier tarea (palabras de 32 bits)
+static volatile uint32_t lastHippoMs = 0;
+static volatile uint32_t lastResultMs = 0;
+static volatile bool haveHippo = false;
+static volatile bool haveResult = false;
+
+// Solo la tarea de subida
+static uint32_t streamStartMs = 0;
+static uint32_t modeSinceMs = 0;
+static volatile DetectMode mode = DETECT_MODE_NORMAL;
+
+static DetectFeedbackStats stats;
+
+// Cierra el tiempo del modo actual y pasa a next
+static void enterMode(DetectMode next, uint32_t now) {
+  uint32_t spent = now - modeSinceMs;
+  if (mode == DETECT_MODE_ACTIVE) stats.activeMs += spent;
+  if (mode == DETECT_MODE_IDLE) stats.idleMs += spent;
+  modeSinceMs = now;
+  mode = next;
+}
+
+void detectFeedbackStreamStart() {
+  streamStartMs = millis();
+  modeSinceMs = streamStartMs;
+  mode = DETECT_MODE_NORMAL;
+}
+
+void detectFeedbackStreamStop() {
+  enterMode(DETECT_MODE_NORMAL, millis());
+}
+
+void detectFeedbackRecord(int hippos) {
+  if (hippos < 0) return;
+  uint32_t now = millis();
+  stats.results++;
+  lastResultMs = now;
+  haveResult = true;
+  if (hippos > 0) {
+    stats.withHippos++;
+    lastHippoMs = now;
+    haveHippo = true;
+  }
+}
+
+DetectMode detectFeedbackUpdate() {
+  uint32_t now = millis();
+
+  // Referencia del reposo: el último hipopótamo o, si fue antes, el inicio
+  uint32_t since = streamStartMs;
+  if (haveHippo && (int32_t)(lastHippoMs - streamStartMs) > 0) since = lastHippoMs;
+
+  DetectMode next = DETECT_MODE_NORMAL;
+  if (haveHippo && now - lastHippoMs < DETECT_ACTIVE_HOLD_MS) {
+    next = DETECT_MODE_ACTIVE;
+  } else if (haveResult && (int32_t)(lastResultMs - streamStartMs) > 0 &&
+             now - since >= DETECT_IDLE_AFTER_MS) {
+    next = DETECT_MODE_IDLE;
+  }
+  if (next == mode) return mode;
+
+  if (next == DETECT_MODE_ACTIVE) stats.toActive++;
+  if (next == DETECT_MODE_NORMAL) stats.toNormal++;
+  if (next == DETECT_MODE_IDLE) stats.toIdle++;
+  DEBUG_PRINTF("[DETECT] Modo %s -> %s tras %u ms\n", kModeNames[mode], kModeNames[next],
+               (unsigned)(now - modeSinceMs));
+  enterMode(next, now);
+  return mode;
+}
+
+DetectMode detectFeedbackMode() {
+  return mode;
+}
+
+void detectFeedbackRecordIdleFrame(size_t bytes, float framesAvoided) {
+  if (framesAvoided > 0) stats.bytesSavedIdle += (uint64_t)(bytes * framesAvoided);
+}
+
+void detectFeedbackRecordExtension(uint32_t seconds) {
+  stats.extensions++;
+  stats.extendedSeconds += seconds;
+}
+
+const DetectFeedbackStats &detectFeedbackStats() {
+  return stats;
+}
+
+size_t detectFeedbackToJson(char *out, size_t cap) {
+  int n = snprintf(out, cap,
+                   "{\"results\":%u,\"withHippos\":%u,\"mode\":\"%s\",\"toActive\":%u,"
+                   "\"toNormal\":%u,\"toIdle\":%u,\"activeMs\":%u,\"idleMs\":%u,"
+                   "\"extensions\":%u,\"extendedSeconds\":%u,\"bytesSavedIdle\":%llu}",
+                   (unsigned)stats.results, (unsigned)stats.withHippos, kModeNames[mode],
+                   (unsigned)stats.toActive, (unsigned)stats.toNormal, (unsigned)stats.toIdle,
+                   (unsigned)stats.activeMs, (unsigned)stats.idleMs, (unsigned)stats.extensions,
+                   (unsigned)stats.extendedSeconds, (unsigned long long)stats.bytesSavedIdle);
+  return (n > 0 && (size_t)n < cap) ? (size_t)n : 0;
+}
+
+void detectFeedbackPrintStats() {
+  if (stats.results == 0) return;
+  DEBUG_PRINTF("[DETECT] %u respuestas, %u con hipopótamos; modo %s; transiciones: %u a activo, "
+               "%u a normal, %u a reposo\n",
+               (unsigned)stats.results, (unsigned)stats.withHippos, kModeNames[mode],
+               (unsigned)stats.toActive, (unsigned)stats.toNormal, (unsigned)stats.toIdle);
+  DEBUG_PRINTF("[DETECT] %u ms activo, %u ms en reposo (~%u KB sin subir), %u alargues (+%u s)\n",
+               (unsigned)stats.activeMs, (unsigned)stats.idleMs,
+               (unsigned)(stats.bytesSavedIdle / 1024), (unsigned)stats.extensions,
+               (unsigned)stats.extendedSeconds);
+}
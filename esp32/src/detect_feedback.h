@@ -0,0 +1,76 @@
+/**
+ * Realimentación de las detecciones del servidor (proyecto TPI2)
+ *
+ * server.js pasa cada foto y cada frame en vivo por la inferencia de
+ * hipopótamos y pone "hippoCount" al principio de la respuesta. Con
+ * DETECT_FEEDBACK el firmware lo lee y el streaming cambia de modo:
+ *
+ *  - ACTIVO: hubo un hipopótamo hace menos de DETECT_ACTIVE_HOLD_MS. El control
+ *    adaptativo baja el periodo a DETECT_ACTIVE_FRAME_DELAY y mejora la calidad
+ *    DETECT_ACTIVE_QUALITY_BOOST; si el streaming va a terminar, se alarga.
+ *  - NORMAL: los parámetros de siempre.
+ *  - REPOSO: DETECT_IDLE_AFTER_MS sin hipopótamos (con el servidor respondiendo
+ *    detecciones): un frame cada DETECT_IDLE_FRAME_DELAY.
+ *
+ * Sin respuestas con "hippoCount" (servidor antiguo, WebSocket) no se sale de
+ * NORMAL. Se cuentan las transiciones, el tiempo en cada modo y una estimación
+ * de los bytes que no se subieron gracias al reposo.
+ *
+ * detectFeedbackRecord() se puede llamar desde cualquier tarea; el modo solo
+ * lo recalcula la tarea de subida del streaming (detectFeedbackUpdate()).
+ */
+
+#ifndef DETECT_FEEDBACK_H
+#define DETECT_FEEDBACK_H
+
+#include <Arduino.h>
+
+enum DetectMode {
+  DETECT_MODE_NORMAL = 0,
+  DETECT_MODE_ACTIVE,
+  DETECT_MODE_IDLE,
+};
+
+struct DetectFeedbackStats {
+  uint32_t results;          // Respuestas con "hippoCount"
+  uint32_t withHippos;       // ... con al menos un hipopótamo
+  uint32_t toActive;         // Transiciones a cada modo
+  uint32_t toNormal;
+  uint32_t toIdle;
+  uint32_t activeMs;         // Tiempo en cada modo durante los streamings
+  uint32_t idleMs;
+  uint32_t extensions;       // Streamings alargados con un animal a la vista
+  uint32_t extendedSeconds;
+  uint64_t bytesSavedIdle;   // Estimación: frames que el reposo no capturó
+};
+
+// Empieza un streaming: el reposo se cuenta desde ahora (o desde el último
+// hipopótamo, si es posterior) y el modo vuelve a calcularse
+void detectFeedbackStreamStart();
+
+// Fin del streaming: cierra el tiempo del modo actual y vuelve a NORMAL
+void detectFeedbackStreamStop();
+
+// Resumen de una subida: hipopótamos vistos (negativo = la respuesta no lo traía)
+void detectFeedbackRecord(int hippos);
+
+// Recalcula el modo y cuenta la transición si cambió (tarea de subida)
+DetectMode detectFeedbackUpdate();
+
+// Último modo calculado (cualquier tarea)
+DetectMode detectFeedbackMode();
+
+// Frame subido en reposo: framesAvoided frames que no se capturaron por cada uno
+void detectFeedbackRecordIdleFrame(size_t bytes, float framesAvoided);
+
+void detectFeedbackRecordExtension(uint32_t seconds);
+
+const DetectFeedbackStats &detectFeedbackStats();
+
+// Escribe {"results":..,"withHippos":..,"toActive":..,...} en out.
+// Devuelve la longitud (0 si no cabe).
+size_t detectFeedbackToJson(char *out, size_t cap);
+
+void detectFeedbackPrintStats();
+
+#endif // DETECT_FEEDBACK_H
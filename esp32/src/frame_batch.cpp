@@ -0,0 +1,52 @@
+/**
+ * Implementación del lote de frames (ver frame_batch.h)
+ */
+
+#include "frame_batch.h"
+
+static const size_t HEADER_LEN = 8;
+static const size_t FRAME_HEADER_LEN = 12;
+
+static void putU32(uint8_t *out, uint32_t v) {
+  out[0] = (uint8_t)v;
+  out[1] = (uint8_t)(v >> 8);
+  out[2] = (uint8_t)(v >> 16);
+  out[3] = (uint8_t)(v >> 24);
+}
+
+// Escribe un tramo completo, reintentando escrituras parciales
+static bool writeAll(FrameBatchWriteFn write, void *ctx, const uint8_t *data, size_t len) {
+  while (len > 0) {
+    size_t written = write(ctx, data, len);
+    if (written == 0) return false;
+    data += written;
+    len -= written;
+  }
+  return true;
+}
+
+size_t frameBatchBodyLength(const FrameBatchItem *items, size_t count) {
+  if (count == 0 || count > FRAME_BATCH_MAX_FRAMES) return 0;
+  size_t total = HEADER_LEN;
+  for (size_t i = 0; i < count; i++) total += FRAME_HEADER_LEN + items[i].len;
+  return total;
+}
+
+bool frameBatchWrite(const FrameBatchItem *items, size_t count, FrameBatchWriteFn write,
+                     void *ctx) {
+  if (count == 0 || count > FRAME_BATCH_MAX_FRAMES) return false;
+
+  uint8_t header[HEADER_LEN] = {'H', 'T', 'F', 'B', FRAME_BATCH_VERSION, (uint8_t)count, 0, 0};
+  if (!writeAll(write, ctx, header, sizeof(header))) return false;
+
+  for (size_t i = 0; i < count; i++) {
+    uint8_t frameHeader[FRAME_HEADER_LEN];
+    putU32(frameHeader, items[i].seq);
+    putU32(frameHeader + 4, items[i].ageMs);
+    putU32(frameHeader + 8, (uint32_t)items[i].len);
+    if (!writeAll(write, ctx, frameHeader, sizeof(frameHeader))) return false;
+    // El JPEG sale directamente del frame buffer de la cámara
+    if (!writeAll(write, ctx, items[i].data, items[i].len)) return false;
+  }
+  return true;
+}
@@ -0,0 +1,44 @@
+/**
+ * Lote de frames en un solo cuerpo HTTP (proyecto TPI2)
+ *
+ * Con un frame por petición, cada frame QVGA paga sus cabeceras, su sobre
+ * multipart y, sobre todo, una espera de respuesta completa; en 4G eso pesa
+ * más que el propio JPEG. Este formato junta varios frames en un cuerpo con
+ * prefijo de longitud (Content-Type FRAME_BATCH_CONTENT_TYPE):
+ *
+ *   cabecera: "HTFB" | versión (1 byte) | n.º de frames (1 byte) | 2 bytes a 0
+ *   por frame: seq (u32 LE) | antigüedad en ms al enviar (u32 LE) |
+ *              longitud (u32 LE) | JPEG
+ *
+ * Igual que multipart.h, solo se generan las cabeceras (en la pila) y los JPEG
+ * salen tal cual de los frame buffers. Sin dependencias de Arduino.
+ */
+
+#ifndef FRAME_BATCH_H
+#define FRAME_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FRAME_BATCH_CONTENT_TYPE "application/vnd.hipotrack.frames"
+#define FRAME_BATCH_VERSION      1
+#define FRAME_BATCH_MAX_FRAMES   255
+
+struct FrameBatchItem {
+  const uint8_t *data;
+  size_t len;
+  uint32_t seq;      // Número de frame dentro del streaming
+  uint32_t ageMs;    // Tiempo desde la captura hasta el envío
+};
+
+// Mismo contrato que MultipartWriteFn: bytes aceptados, 0 = error
+typedef size_t (*FrameBatchWriteFn)(void *ctx, const uint8_t *data, size_t len);
+
+// Longitud total del cuerpo (para Content-Length); 0 si count no es válido
+size_t frameBatchBodyLength(const FrameBatchItem *items, size_t count);
+
+// Escribe el lote en el sumidero. Devuelve false si deja de aceptar datos.
+bool frameBatchWrite(const FrameBatchItem *items, size_t count, FrameBatchWriteFn write,
+                     void *ctx);
+
+#endif // FRAME_BATCH_H
@@ -0,0 +1,149 @@
+/**
+ * Implementación del anillo de frames (ver frame_ring.h)
+ */
+
+#include "frame_ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP32
+#include <esp32-hal-psram.h>
+#endif
+
+// len de una cabecera que indica "el siguiente registro está al principio"
+static const uint32_t WRAP_MARK = 0xFFFFFFFF;
+
+FrameRing::FrameRing()
+    : buf_(NULL), cap_(0), head_(0), tail_(0), count_(0), used_(0), evicted_(0) {}
+
+FrameRing::~FrameRing() {
+  end();
+}
+
+bool FrameRing::begin(size_t capacityBytes) {
+  end();
+  capacityBytes &= ~(size_t)3;
+
+#ifdef ESP32
+  buf_ = (uint8_t *)(psramFound() ? ps_malloc(capacityBytes) : malloc(capacityBytes));
+#else
+  buf_ = (uint8_t *)malloc(capacityBytes);
+#endif
+  if (!buf_) return false;
+
+  cap_ = capacityBytes;
+  evicted_ = 0;
+  clear();
+  return true;
+}
+
+void FrameRing::end() {
+  free(buf_);
+  buf_ = NULL;
+  cap_ = 0;
+  clear();
+}
+
+void FrameRing::clear() {
+  head_ = tail_ = 0;
+  count_ = 0;
+  used_ = 0;
+}
+
+// Cabecera + datos, alineado a 4 bytes para que las cabeceras queden alineadas
+size_t FrameRing::recordSize(size_t len) {
+  return (sizeof(Header) + len + 3) & ~(size_t)3;
+}
+
+size_t FrameRing::maxFrameLen() const {
+  return cap_ > sizeof(Header) ? cap_ - sizeof(Header) : 0;
+}
+
+// Si head_ apunta a una marca de vuelta (o no cabe una cabecera) salta al principio
+void FrameRing::skipWrap() {
+  if (count_ == 0) return;
+  if (cap_ - head_ < sizeof(Header)) {
+    head_ = 0;
+    return;
+  }
+  Header h;
+  memcpy(&h, buf_ + head_, sizeof(h));
+  if (h.len == WRAP_MARK) head_ = 0;
+}
+
+bool FrameRing::push(const uint8_t *data, size_t len, uint32_t meta) {
+  size_t need = recordSize(len);
+  if (!buf_ || need > cap_) return false;
+
+  for (;;) {
+    if (count_ == 0) {
+      head_ = tail_ = 0;
+      break;
+    }
+    if (tail_ > head_) {
+      // Datos en [head_, tail_): hueco al final y, si no basta, al principio
+      if (cap_ - tail_ >= need) break;
+      if (head_ >= need) {
+        if (cap_ - tail_ >= sizeof(Header)) {
+          Header mark = {WRAP_MARK, 0};
+          memcpy(buf_ + tail_, &mark, sizeof(mark));
+        }
+        tail_ = 0;
+        break;
+      }
+    } else if (head_ - tail_ >= need) {
+      // Vuelta dada: el único hueco es [tail_, head_)
+      break;
+    }
+
+    // Sin sitio: se expulsa el frame más antiguo
+    pop();
+    evicted_++;
+  }
+
+  Header h = {(uint32_t)len, meta};
+  memcpy(buf_ + tail_, &h, sizeof(h));
+  if (len) memcpy(buf_ + tail_ + sizeof(h), data, len);
+  tail_ += need;
+  count_++;
+  used_ += need;
+  return true;
+}
+
+bool FrameRing::fits(size_t len) const {
+  size_t need = recordSize(len);
+  if (!buf_ || need > cap_) return false;
+  if (count_ == 0) return true;
+  if (tail_ > head_) return cap_ - tail_ >= need || head_ >= need;
+  return head_ - tail_ >= need;
+}
+
+bool FrameRing::peek(const uint8_t **data, size_t *len, uint32_t *meta) {
+  if (count_ == 0) return false;
+
+  Header h;
+  memcpy(&h, buf_ + head_, sizeof(h));
+  if (data) *data = buf_ + head_ + sizeof(h);
+  if (len) *len = h.len;
+  if (meta) *meta = h.meta;
+  return true;
+}
+
+bool FrameRing::pop() {
+  if (count_ == 0) return false;
+
+  Header h;
+  memcpy(&h, buf_ + head_, sizeof(h));
+  size_t size = recordSize(h.len);
+  head_ += size;
+  used_ -= size;
+  count_--;
+
+  if (count_ == 0) {
+    head_ = tail_ = 0;
+  } else {
+    skipWrap();
+  }
+  return true;
+}
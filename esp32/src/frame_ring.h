@@ -0,0 +1,67 @@
+/**
+ * Anillo de frames JPEG en un único bloque de memoria (proyecto TPI2)
+ *
+ * Guarda frames de longitud variable uno detrás de otro (cabecera + datos)
+ * en un buffer reservado una sola vez, preferentemente en PSRAM:
+ *  - push() copia el frame y, si no cabe, expulsa los más antiguos.
+ *  - peek() devuelve el más antiguo sin copiarlo; pop() lo descarta.
+ *
+ * Un frame nunca se parte en dos: si no cabe al final del buffer se deja una
+ * marca y se escribe desde el principio, así peek() siempre entrega un
+ * puntero a datos contiguos que se pueden enviar tal cual.
+ *
+ * No tiene dependencias del firmware; no es seguro entre tareas.
+ */
+
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class FrameRing {
+ public:
+  FrameRing();
+  ~FrameRing();
+
+  // Reserva el buffer (PSRAM si hay). Devuelve false si no hay memoria.
+  bool begin(size_t capacityBytes);
+  void end();
+
+  // Copia un frame con un dato asociado (p. ej. instante de captura).
+  // Devuelve false si el frame no cabe ni con el anillo vacío.
+  bool push(const uint8_t *data, size_t len, uint32_t meta);
+
+  // ¿Cabe un frame de len bytes sin expulsar ninguno?
+  bool fits(size_t len) const;
+
+  // Frame más antiguo, válido hasta el siguiente push() / pop()
+  bool peek(const uint8_t **data, size_t *len, uint32_t *meta);
+  bool pop();
+  void clear();
+
+  size_t count() const { return count_; }
+  size_t bytesUsed() const { return used_; }
+  size_t capacity() const { return cap_; }
+  size_t maxFrameLen() const;
+  uint32_t evicted() const { return evicted_; }
+
+ private:
+  struct Header {
+    uint32_t len;
+    uint32_t meta;
+  };
+
+  static size_t recordSize(size_t len);
+  void skipWrap();
+
+  uint8_t *buf_;
+  size_t cap_;
+  size_t head_;   // Registro más antiguo
+  size_t tail_;   // Siguiente posición de escritura
+  size_t count_;
+  size_t used_;   // Bytes ocupados por registros (sin contar huecos de vuelta)
+  uint32_t evicted_;
+};
+
+#endif // FRAME_RING_H
@@ -0,0 +1,255 @@
+/**
+ * Implementación de la conexión HTTP persistente (ver http_conn.h)
+ */
+
+#include "http_conn.h"
+
+HttpConnection backend(SERVER_IP, SERVER_PORT);
+HttpConnection streamControl(SERVER_IP, SERVER_PORT);
+
+HttpConnection::HttpConnection(const char *host, uint16_t port)
+    : host_(host), port_(port) {
+  memset(&stats_, 0, sizeof(stats_));
+#if USE_HTTPS
+  client_.setInsecure();  // Igual que HTTPClient sin CA configurada
+#endif
+}
+
+void HttpConnection::close() {
+  client_.stop();
+}
+
+bool HttpConnection::ensureConnected(bool *reused) {
+  if (client_.connected()) {
+    // Descartar restos de una respuesta anterior antes de reutilizar el socket
+    while (client_.available() > 0) client_.read();
+    *reused = true;
+    return true;
+  }
+
+  *reused = false;
+  client_.stop();
+  METRIC_START(t0);
+  if (!client_.connect(host_, port_, HTTP_TIMEOUT)) {
+    LOG_ERROR("[HTTP] Error al conectar con el servidor\n");
+    return false;
+  }
+  METRIC_STOP(METRIC_CONNECT, t0);
+  client_.setNoDelay(true);
+  stats_.connects++;
+  return true;
+}
+
+bool HttpConnection::writeRequest(const HttpRequest &req) {
+  // Cabeceras en un buffer de pila (sin String en el camino caliente)
+  char headers[512];
+  int n = snprintf(headers, sizeof(headers),
+                   "%s %s HTTP/1.1\r\n"
+                   "Host: %s:%u\r\n"
+                   "Connection: keep-alive\r\n",
+                   req.method, req.path, host_, (unsigned)port_);
+
+  if (strlen(CAMERA_API_TOKEN) > 0 && n > 0 && (size_t)n < sizeof(headers)) {
+    n += snprintf(headers + n, sizeof(headers) - n, "X-Api-Key: %s\r\n", CAMERA_API_TOKEN);
+  }
+  if (req.contentType && n > 0 && (size_t)n < sizeof(headers)) {
+    n += snprintf(headers + n, sizeof(headers) - n, "Content-Type: %s\r\n", req.contentType);
+  }
+  if (n > 0 && (size_t)n < sizeof(headers)) {
+    n += snprintf(headers + n, sizeof(headers) - n, "Content-Length: %u\r\n\r\n",
+                  (unsigned)req.contentLength);
+  }
+  if (n <= 0 || (size_t)n >= sizeof(headers)) return false;
+
+  METRIC_START(t0);
+  if (client_.write((const uint8_t *)headers, n) != (size_t)n) return false;
+  if (req.writeBody && !req.writeBody(client_, req.bodyCtx)) return false;
+  METRIC_STOP(METRIC_HTTP_SEND, t0);
+  stats_.bytesSent += n + req.contentLength;
+  METRIC_ADD(METRIC_BYTES_SENT, n + req.contentLength);
+  return true;
+}
+
+bool HttpConnection::readLine(char *line, size_t cap, unsigned long deadline) {
+  size_t n = 0;
+  while ((long)(deadline - millis()) > 0) {
+    if (!client_.available()) {
+      if (!client_.connected()) break;
+      delay(1);
+      continue;
+    }
+    int c = client_.read();
+    if (c < 0) continue;
+    stats_.bytesReceived++;
+    if (c == '\n') {
+      line[n] = '\0';
+      return true;
+    }
+    if (c != '\r' && n < cap - 1) line[n++] = (char)c;
+  }
+  line[n] = '\0';
+  return false;
+}
+
+int HttpConnection::readResponse(HttpResponse *resp, unsigned long timeoutMs,
+                                 bool (*abortWait)()) {
+  unsigned long deadline = millis() + timeoutMs;
+  char line[128];
+
+  // Long-poll: mientras el servidor no contesta, el llamante puede abandonarlo
+  if (abortWait) {
+    while (!client_.available() && client_.connected() && (long)(deadline - millis()) > 0) {
+      if (abortWait()) {
+        client_.stop();
+        return HTTP_ABORTED;
+      }
+      delay(1);
+    }
+  }
+
+  // Línea de estado: "HTTP/1.1 201 Created"
+  if (!readLine(line, sizeof(line), deadline)) return -1;
+  const char *sp = strchr(line, ' ');
+  if (strncmp(line, "HTTP/", 5) != 0 || !sp) return -1;
+  int code = atoi(sp + 1);
+
+  // Cabeceras: solo interesan la longitud/codificación y si el servidor cierra
+  long contentLength = -1;
+  bool chunked = false;
+  bool keepAlive = true;
+  while (readLine(line, sizeof(line), deadline) && line[0] != '\0') {
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      contentLength = atol(line + 15);
+    } else if (strncasecmp(line, "Connection:", 11) == 0 && strcasestr(line + 11, "close")) {
+      keepAlive = false;
+    } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 && strcasestr(line + 18, "chunked")) {
+      chunked = true;
+    }
+  }
+
+  // Cuerpo: se guarda lo que quepa en el buffer del llamante y se descarta el resto
+  size_t stored = 0;
+  bool complete;
+  if (chunked) {
+    complete = false;
+    while (readLine(line, sizeof(line), deadline)) {
+      long chunkLen = strtol(line, NULL, 16);
+      if (chunkLen <= 0) {
+        // Último trozo: queda la línea vacía (sin trailers)
+        complete = readLine(line, sizeof(line), deadline);
+        break;
+      }
+      if (!readBody(resp, &stored, chunkLen, deadline)) break;
+      if (!readLine(line, sizeof(line), deadline)) break;  // CRLF tras cada trozo
+    }
+  } else if (contentLength >= 0) {
+    complete = readBody(resp, &stored, contentLength, deadline);
+  } else {
+    // Sin longitud conocida el cuerpo termina cuando el servidor cierra
+    readBody(resp, &stored, -1, deadline);
+    complete = false;
+  }
+  if (resp && resp->body && resp->bodyCap > 0) resp->body[stored] = '\0';
+  if (resp) resp->bodyLen = stored;
+
+  if (!keepAlive || !complete) client_.stop();
+  return code;
+}
+
+bool HttpConnection::readBody(HttpResponse *resp, size_t *stored, long len, unsigned long deadline) {
+  while (len != 0 && (long)(deadline - millis()) > 0) {
+    if (!client_.available()) {
+      if (!client_.connected()) break;
+      delay(1);
+      continue;
+    }
+    int c = client_.read();
+    if (c < 0) continue;
+    stats_.bytesReceived++;
+    if (resp && resp->body && *stored + 1 < resp->bodyCap) resp->body[(*stored)++] = (char)c;
+    if (len > 0) len--;
+  }
+  return len == 0;
+}
+
+int HttpConnection::send(const HttpRequest &req, HttpResponse *resp) {
+  unsigned long start = millis();
+#if ENABLE_METRICS
+  uint64_t received0 = stats_.bytesReceived;
+#endif
+  METRIC_START(t0);
+  int code = -1;
+
+  if (resp) {
+    resp->code = -1;
+    resp->bodyLen = 0;
+  }
+
+  // Un socket reutilizado puede estar cerrado por el servidor sin que lo
+  // sepamos todavía: en ese caso se reconecta y se reintenta una sola vez.
+  // Solo si la petición no llegó a procesarse: falló la escritura o el
+  // servidor cerró sin mandar ni un byte. Tras un timeout no se reintenta:
+  // un POST /photo lento (inferencia YOLO) se guardaría dos veces.
+  for (int attempt = 0; attempt < 2; attempt++) {
+    bool reused = false;
+    if (!ensureConnected(&reused)) break;
+
+    bool closedUnanswered = true;
+    if (writeRequest(req)) {
+      uint64_t before = stats_.bytesReceived;
+      METRIC_START(t1);
+      unsigned long w0 = millis();
+      code = readResponse(resp, req.timeoutMs, req.abortWait);
+      stats_.lastWaitMs = millis() - w0;
+      METRIC_STOP(METRIC_HTTP_RESPONSE, t1);
+      closedUnanswered = stats_.bytesReceived == before && !client_.connected();
+    }
+    if (code > 0 || code == HTTP_ABORTED) {
+      if (reused) stats_.reused++;
+      break;
+    }
+
+    client_.stop();
+    if (!reused || !closedUnanswered) break;
+    stats_.retries++;
+    DEBUG_PRINTLN("[HTTP] Socket reutilizado cerrado por el servidor, reconectando...");
+  }
+
+  METRIC_STOP(METRIC_HTTP_TOTAL, t0);
+  METRIC_ADD(METRIC_BYTES_RECEIVED, stats_.bytesReceived - received0);
+
+  uint32_t latency = millis() - start;
+  stats_.requests++;
+  if (code <= 0 && code != HTTP_ABORTED) stats_.failures++;
+  recordLatency(latency);
+
+  if (resp) resp->code = code;
+  LOG_DEBUG("[HTTP] %s %s -> %d (%u ms, reutilización %.0f%%)\n", req.method, req.path, code,
+            (unsigned)latency, reuseRatio() * 100.0f);
+  return code;
+}
+
+void HttpConnection::recordLatency(uint32_t ms) {
+  stats_.lastLatencyMs = ms;
+  stats_.totalLatencyMs += ms;
+  if (stats_.requests == 1 || ms < stats_.minLatencyMs) stats_.minLatencyMs = ms;
+  if (ms > stats_.maxLatencyMs) stats_.maxLatencyMs = ms;
+}
+
+float HttpConnection::reuseRatio() const {
+  return stats_.requests ? (float)stats_.reused / (float)stats_.requests : 0.0f;
+}
+
+uint32_t HttpConnection::avgLatencyMs() const {
+  return stats_.requests ? (uint32_t)(stats_.totalLatencyMs / stats_.requests) : 0;
+}
+
+void HttpConnection::printStats() const {
+  DEBUG_PRINTF("[HTTP] Peticiones: %u, reutilizadas: %u (%.0f%%), conexiones: %u, "
+               "reintentos: %u, fallos: %u\n",
+               (unsigned)stats_.requests, (unsigned)stats_.reused, reuseRatio() * 100.0f,
+               (unsigned)stats_.connects, (unsigned)stats_.retries, (unsigned)stats_.failures);
+  DEBUG_PRINTF("[HTTP] Latencia por petición: última %u ms, media %u ms, min %u ms, max %u ms\n",
+               (unsigned)stats_.lastLatencyMs, (unsigned)avgLatencyMs(),
+               (unsigned)stats_.minLatencyMs, (unsigned)stats_.maxLatencyMs);
+}
@@ -0,0 +1,111 @@
+/**
+ * Conexión HTTP persistente (keep-alive) hacia BASE_HTTP_URL (proyecto TPI2)
+ *
+ * Todas las peticiones al backend (control, fotos, frames) comparten un único
+ * socket HTTP/1.1; solo durante un streaming el control usa un segundo socket.
+ * Si el servidor lo ha cerrado (timeout de inactividad, reinicio, cambio de
+ * red) se reconecta de forma transparente y la petición se reintenta una vez
+ * (nunca tras un timeout: la petición podría estar procesándose).
+ *
+ * Además lleva estadísticas de reutilización y latencia por petición para
+ * medir el ahorro de handshakes TCP/TLS en enlaces 4G.
+ */
+
+#ifndef HTTP_CONN_H
+#define HTTP_CONN_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "config.h"
+#include "metrics.h"
+
+#if USE_HTTPS
+#include <WiFiClientSecure.h>
+#endif
+
+// Escribe el cuerpo de la petición en el socket. Devuelve false si falla.
+typedef bool (*HttpBodyWriter)(Client &client, void *ctx);
+
+struct HttpRequest {
+  const char *method;          // "GET", "POST"...
+  const char *path;            // Ruta absoluta, p.ej. "/api/cameras/1/photo"
+  const char *contentType;     // NULL si no hay cuerpo
+  size_t contentLength;
+  HttpBodyWriter writeBody;    // NULL si no hay cuerpo
+  void *bodyCtx;
+  unsigned long timeoutMs;     // Tiempo máximo de espera de la respuesta
+  bool (*abortWait)();         // true: dejar de esperar la respuesta (NULL si nunca)
+};
+
+// send() cuando abortWait cortó la espera (el socket queda cerrado)
+#define HTTP_ABORTED -2
+
+struct HttpResponse {
+  int code;                    // Código HTTP, o -1 si no hubo respuesta
+  char *body;                  // Buffer del llamante (puede ser NULL)
+  size_t bodyCap;
+  size_t bodyLen;              // Bytes guardados en `body` (se termina en '\0')
+};
+
+struct HttpStats {
+  uint32_t requests;           // Peticiones completadas (con o sin éxito)
+  uint32_t reused;             // Peticiones que reutilizaron un socket abierto
+  uint32_t connects;           // Conexiones TCP/TLS abiertas
+  uint32_t retries;            // Reintentos tras encontrar el socket cerrado
+  uint32_t failures;           // Peticiones sin respuesta HTTP
+  uint64_t bytesSent;          // Cabeceras + cuerpos enviados
+  uint64_t bytesReceived;      // Respuestas completas recibidas
+  uint32_t lastLatencyMs;
+  uint32_t lastWaitMs;          // Del fin del cuerpo a la respuesta (≈ RTT + servidor)
+  uint32_t minLatencyMs;
+  uint32_t maxLatencyMs;
+  uint64_t totalLatencyMs;
+};
+
+class HttpConnection {
+ public:
+  HttpConnection(const char *host, uint16_t port);
+
+  // Envía la petición y lee la respuesta completa. Devuelve el código HTTP, -1
+  // o HTTP_ABORTED.
+  int send(const HttpRequest &req, HttpResponse *resp);
+
+  // Cierra el socket (se reabrirá en la siguiente petición)
+  void close();
+
+  const HttpStats &stats() const { return stats_; }
+  float reuseRatio() const;
+  uint32_t avgLatencyMs() const;
+  void printStats() const;
+
+ private:
+  bool ensureConnected(bool *reused);
+  bool writeRequest(const HttpRequest &req);
+  int readResponse(HttpResponse *resp, unsigned long timeoutMs, bool (*abortWait)());
+  bool readLine(char *line, size_t cap, unsigned long deadline);
+  bool readBody(HttpResponse *resp, size_t *stored, long len, unsigned long deadline);
+  void recordLatency(uint32_t ms);
+
+  const char *host_;
+  uint16_t port_;
+#if USE_HTTPS
+  WiFiClientSecure client_;
+#else
+  WiFiClient client_;
+#endif
+  HttpStats stats_;
+};
+
+// Conexión compartida con el backend (SERVER_IP:SERVER_PORT)
+extern HttpConnection backend;
+
+// Segunda conexión al mismo backend para el canal de control (y las fotos que
+// pide) mientras la tarea de subida del streaming ocupa `backend`
+extern HttpConnection streamControl;
+
+// Ruta de un endpoint: todos los SERVER_URL_* empiezan por BASE_HTTP_URL
+inline const char *urlPath(const char *url) {
+  return url + (sizeof(BASE_HTTP_URL) - 1);
+}
+
+#endif // HTTP_CONN_H
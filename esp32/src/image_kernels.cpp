@@ -0,0 +1,260 @@
+/**
+ * Implementación de los kernels de píxeles (ver image_kernels.h)
+ *
+ * El camino SWAR supone little-endian (ESP32, ESP32-S3, x86 y ARM del host).
+ */
+
+#include "image_kernels.h"
+
+#include <string.h>
+
+const char *imgKernelsPath() {
+  return IMG_KERNELS_VECTOR ? "vector" : "escalar";
+}
+
+// ============================================================================
+// SWAR: 4 PÍXELES POR PALABRA
+// ============================================================================
+
+#if IMG_KERNELS_VECTOR
+
+#define LANES_LO 0x00FF00FFu   // Bytes pares: dos carriles de 16 bits
+
+static inline bool aligned4(const void *p) {
+  return ((uintptr_t)p & 3) == 0;
+}
+
+// Palabra alineada (memcpy con la alineación conocida: un solo l32i)
+static inline uint32_t load32(const void *p) {
+  uint32_t w;
+  memcpy(&w, __builtin_assume_aligned(p, 4), sizeof(w));
+  return w;
+}
+
+static inline void store32(void *p, uint32_t w) {
+  memcpy(__builtin_assume_aligned(p, 4), &w, sizeof(w));
+}
+
+// |a - b| en dos carriles de 16 bits con valores 0-255
+static inline uint32_t absDiffLanes(uint32_t a, uint32_t b) {
+  uint32_t v = (a | 0x01000100u) - b;                      // 256 + a - b: sin préstamo entre carriles
+  uint32_t lt = ((v >> 8) & 0x00010001u) ^ 0x00010001u;    // 1 donde a < b
+  return ((v & LANES_LO) ^ (lt * 0xFFu)) + lt;             // a < b: 256 - v = b - a
+}
+
+// Suma de los dos carriles
+static inline uint32_t foldLanes(uint32_t acc) {
+  return (acc & 0xFFFFu) + (acc >> 16);
+}
+
+#endif // IMG_KERNELS_VECTOR
+
+// ============================================================================
+// REDUCCIÓN Y CONVERSIÓN
+// ============================================================================
+
+bool imgBoxDownscale(const uint8_t *src, uint16_t srcW, uint16_t srcH, size_t srcStride,
+                     uint8_t *dst, uint16_t dstW, uint16_t dstH, uint32_t *rowSums) {
+  if (dstW == 0 || dstH == 0 || dstW > srcW || dstH > srcH) return false;
+
+  // La celda i recoge los píxeles [ceil(i * src / dst), ceil((i + 1) * src / dst))
+  uint32_t y0 = 0;
+  for (uint16_t dy = 0; dy < dstH; dy++) {
+    uint32_t y1 = ((uint32_t)(dy + 1) * srcH + dstH - 1) / dstH;
+    memset(rowSums, 0, (size_t)dstW * sizeof(uint32_t));
+    for (uint32_t y = y0; y < y1; y++) {
+      const uint8_t *row = src + (size_t)y * srcStride;
+      uint32_t x0 = 0;
+      for (uint16_t dx = 0; dx < dstW; dx++) {
+        uint32_t x1 = ((uint32_t)(dx + 1) * srcW + dstW - 1) / dstW;
+        uint32_t sum = 0;
+        for (uint32_t x = x0; x < x1; x++) sum += row[x];
+        rowSums[dx] += sum;
+        x0 = x1;
+      }
+    }
+
+    uint32_t rows = y1 - y0;
+    uint8_t *out = dst + (size_t)dy * dstW;
+    uint32_t x0 = 0;
+    for (uint16_t dx = 0; dx < dstW; dx++) {
+      uint32_t x1 = ((uint32_t)(dx + 1) * srcW + dstW - 1) / dstW;
+      uint32_t n = rows * (x1 - x0);
+      out[dx] = (uint8_t)((rowSums[dx] + n / 2) / n);
+      x0 = x1;
+    }
+    y0 = y1;
+  }
+  return true;
+}
+
+void imgYuyvToGray(const uint8_t *yuyv, uint8_t *gray, size_t pixels) {
+  size_t i = 0;
+#if IMG_KERNELS_VECTOR
+  // Dos palabras Y0 U Y1 V | Y2 U Y3 V -> una palabra Y0 Y1 Y2 Y3
+  if (aligned4(yuyv) && aligned4(gray)) {
+    for (; i + 4 <= pixels; i += 4) {
+      uint32_t w0 = load32(yuyv + 2 * i);
+      uint32_t w1 = load32(yuyv + 2 * i + 4);
+      store32(gray + i, (w0 & 0xFFu) | ((w0 >> 8) & 0xFF00u) | ((w1 & 0xFFu) << 16) |
+                            ((w1 << 8) & 0xFF000000u));
+    }
+  }
+#endif
+  for (; i < pixels; i++) gray[i] = yuyv[2 * i];
+}
+
+void imgRgb888ToGray(const uint8_t *rgb, uint8_t *gray, size_t pixels) {
+  for (size_t i = 0; i < pixels; i++, rgb += 3) {
+    gray[i] = (uint8_t)((77 * rgb[0] + 150 * rgb[1] + 29 * rgb[2]) >> 8);
+  }
+}
+
+// ============================================================================
+// DIFERENCIAS Y SUMAS
+// ============================================================================
+
+void imgAbsDiff(const uint8_t *a, const uint8_t *b, uint8_t *out, size_t count) {
+  size_t i = 0;
+#if IMG_KERNELS_VECTOR
+  if (aligned4(a) && aligned4(b) && aligned4(out)) {
+    for (; i + 4 <= count; i += 4) {
+      uint32_t wa = load32(a + i);
+      uint32_t wb = load32(b + i);
+      uint32_t even = absDiffLanes(wa & LANES_LO, wb & LANES_LO);
+      uint32_t odd = absDiffLanes((wa >> 8) & LANES_LO, (wb >> 8) & LANES_LO);
+      store32(out + i, even | (odd << 8));
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    int d = (int)a[i] - b[i];
+    out[i] = (uint8_t)(d < 0 ? -d : d);
+  }
+}
+
+uint32_t imgAbsDiffSum(const uint8_t *a, const uint8_t *b, size_t count) {
+  uint32_t total = 0;
+  size_t i = 0;
+#if IMG_KERNELS_VECTOR
+  if (aligned4(a) && aligned4(b)) {
+    // Cada palabra suma hasta 510 por carril: se vacían cada 128 palabras
+    while (i + 4 <= count) {
+      size_t end = i + 4 * 128 < count ? i + 4 * 128 : count;
+      uint32_t acc = 0;
+      for (; i + 4 <= end; i += 4) {
+        uint32_t wa = load32(a + i);
+        uint32_t wb = load32(b + i);
+        acc += absDiffLanes(wa & LANES_LO, wb & LANES_LO);
+        acc += absDiffLanes((wa >> 8) & LANES_LO, (wb >> 8) & LANES_LO);
+      }
+      total += foldLanes(acc);
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    int d = (int)a[i] - b[i];
+    total += (uint32_t)(d < 0 ? -d : d);
+  }
+  return total;
+}
+
+// Suma de count píxeles seguidos
+static inline uint32_t rowSum(const uint8_t *px, uint8_t count) {
+  uint32_t sum = 0;
+  uint8_t i = 0;
+#if IMG_KERNELS_VECTOR
+  // Un bloque (<= 255 píxeles) no desborda los carriles de 16 bits
+  if (aligned4(px)) {
+    uint32_t acc = 0;
+    for (; i + 4 <= count; i += 4) {
+      uint32_t w = load32(px + i);
+      acc += (w & LANES_LO) + ((w >> 8) & LANES_LO);
+    }
+    sum = foldLanes(acc);
+  }
+#endif
+  for (; i < count; i++) sum += px[i];
+  return sum;
+}
+
+void imgBlockSums(const uint8_t *img, uint16_t w, uint16_t h, size_t stride, uint8_t block,
+                  uint32_t *sums) {
+  const int cols = w / block;
+  const int rows = h / block;
+  memset(sums, 0, (size_t)cols * rows * sizeof(uint32_t));
+  for (int y = 0; y < rows * block; y++) {
+    const uint8_t *row = img + (size_t)y * stride;
+    uint32_t *out = sums + (size_t)(y / block) * cols;
+    for (int bx = 0; bx < cols; bx++) out[bx] += rowSum(row + bx * block, block);
+  }
+}
+
+void imgHistogram(const uint8_t *img, uint16_t w, uint16_t h, size_t stride, uint32_t *hist) {
+  for (uint16_t y = 0; y < h; y++) {
+    const uint8_t *row = img + (size_t)y * stride;
+    uint16_t x = 0;
+    for (; x + 4 <= w; x += 4) {
+      hist[row[x]]++;
+      hist[row[x + 1]]++;
+      hist[row[x + 2]]++;
+      hist[row[x + 3]]++;
+    }
+    for (; x < w; x++) hist[row[x]]++;
+  }
+}
+
+// ============================================================================
+// FONDO EN PUNTO FIJO 8.8
+// ============================================================================
+
+// Suma de |gray - (bg >> 8)| de count píxeles seguidos
+static inline uint32_t rowSadQ8(const uint8_t *gray, const uint16_t *bg, uint8_t count) {
+  uint32_t sum = 0;
+  uint8_t i = 0;
+#if IMG_KERNELS_VECTOR
+  if (aligned4(gray) && aligned4(bg)) {
+    uint32_t acc = 0;
+    for (; i + 4 <= count; i += 4) {
+      uint32_t g = load32(gray + i);
+      // Parte entera de dos fondos por palabra, cada una en su carril
+      uint32_t b01 = (load32(bg + i) >> 8) & LANES_LO;
+      uint32_t b23 = (load32(bg + i + 2) >> 8) & LANES_LO;
+      uint32_t g01 = (g & 0xFFu) | ((g & 0xFF00u) << 8);
+      uint32_t g23 = ((g >> 16) & 0xFFu) | ((g >> 8) & 0x00FF0000u);
+      acc += absDiffLanes(g01, b01) + absDiffLanes(g23, b23);
+    }
+    sum = foldLanes(acc);
+  }
+#endif
+  for (; i < count; i++) {
+    int d = (int)gray[i] - (bg[i] >> 8);
+    sum += (uint32_t)(d < 0 ? -d : d);
+  }
+  return sum;
+}
+
+void imgBlockSadQ8(const uint8_t *gray, const uint16_t *bg, uint16_t w, uint16_t h,
+                   uint8_t block, uint32_t *sums) {
+  const int cols = w / block;
+  const int rows = h / block;
+  memset(sums, 0, (size_t)cols * rows * sizeof(uint32_t));
+  for (int y = 0; y < rows * block; y++) {
+    size_t row = (size_t)y * w;
+    uint32_t *out = sums + (size_t)(y / block) * cols;
+    for (int bx = 0; bx < cols; bx++) {
+      out[bx] += rowSadQ8(gray + row + bx * block, bg + row + bx * block, block);
+    }
+  }
+}
+
+void imgBlendQ8(uint16_t *bg, const uint8_t *gray, size_t count, uint8_t shift) {
+  if (shift == 0) {
+    for (size_t i = 0; i < count; i++) bg[i] = (uint16_t)(gray[i] << 8);
+    return;
+  }
+  for (size_t i = 0; i < count; i++) {
+    int b = bg[i];
+    bg[i] = (uint16_t)(b + (((int)(gray[i] << 8) - b) >> shift));
+  }
+}
@@ -0,0 +1,76 @@
+/**
+ * Kernels de píxeles para el análisis en la cámara (proyecto TPI2)
+ *
+ * Operaciones sobre imágenes en gris de 8 bits (y YUYV / RGB888 de entrada)
+ * que comparten el detector de movimiento y cualquier análisis futuro:
+ *  - reducción por cajas (media de cada celda, tamaño de salida arbitrario)
+ *  - YUYV y RGB888 a gris
+ *  - diferencia absoluta, suma de diferencias y sumas por bloque
+ *  - histograma
+ *  - fondo en punto fijo 8.8: diferencia con su parte entera y media móvil
+ *
+ * Todo se recorre por filas, en el orden de la memoria: en el ESP32 las
+ * imágenes suelen estar en PSRAM y cada fallo de caché es una línea de 32 B.
+ * Las imágenes llevan "stride" (bytes entre filas) para trabajar sobre
+ * recortes sin copiarlos.
+ *
+ * Dos caminos elegidos al compilar con IMG_KERNELS_VECTOR:
+ *  - 0: C portable, un píxel cada vez.
+ *  - 1 (por defecto): SWAR, 4 píxeles por palabra de 32 bits en las
+ *    diferencias, sumas y conversión YUYV. Sirve en el ESP32 (sin
+ *    instrucciones SIMD) y en el ESP32-S3; las partes que no ganan nada
+ *    (histograma, reducción) son iguales en los dos.
+ * Las palabras solo se leen alineadas (el Xtensa no admite accesos
+ * desalineados): si los punteros no lo permiten se usa el camino portable.
+ *
+ * Sin dependencias del firmware (se compila igual en el banco de pruebas).
+ */
+
+#ifndef IMAGE_KERNELS_H
+#define IMAGE_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef IMG_KERNELS_VECTOR
+#define IMG_KERNELS_VECTOR 1
+#endif
+
+// Nombre del camino compilado ("vector" o "escalar")
+const char *imgKernelsPath();
+
+// Reduce src (srcW x srcH) a dst (dstW x dstH) con la media de cada celda; el
+// píxel p va a la celda floor(p * dst / src), como en motion_jpeg.h.
+// rowSums: dstW uint32_t de trabajo. Devuelve false si dst es más grande que src.
+bool imgBoxDownscale(const uint8_t *src, uint16_t srcW, uint16_t srcH, size_t srcStride,
+                     uint8_t *dst, uint16_t dstW, uint16_t dstH, uint32_t *rowSums);
+
+// YUV 4:2:2 (Y0 U Y1 V, PIXFORMAT_YUV422 de esp32-camera) a gris: el canal Y
+void imgYuyvToGray(const uint8_t *yuyv, uint8_t *gray, size_t pixels);
+
+// RGB888 a gris con los pesos de BT.601 (77, 150, 29) / 256
+void imgRgb888ToGray(const uint8_t *rgb, uint8_t *gray, size_t pixels);
+
+// out[i] = |a[i] - b[i]|
+void imgAbsDiff(const uint8_t *a, const uint8_t *b, uint8_t *out, size_t count);
+
+// Suma de |a[i] - b[i]|
+uint32_t imgAbsDiffSum(const uint8_t *a, const uint8_t *b, size_t count);
+
+// Suma de los píxeles de cada bloque de block x block (w y h múltiplos de block).
+// sums: (w / block) x (h / block), por filas de bloques.
+void imgBlockSums(const uint8_t *img, uint16_t w, uint16_t h, size_t stride, uint8_t block,
+                  uint32_t *sums);
+
+// Histograma de 256 niveles (se suma a lo que ya tenga hist)
+void imgHistogram(const uint8_t *img, uint16_t w, uint16_t h, size_t stride, uint32_t *hist);
+
+// Suma de |gray - (bg >> 8)| de cada bloque, con bg en punto fijo 8.8
+// (las dos imágenes de w x h sin stride). sums como en imgBlockSums.
+void imgBlockSadQ8(const uint8_t *gray, const uint16_t *bg, uint16_t w, uint16_t h,
+                   uint8_t block, uint32_t *sums);
+
+// bg += ((gray << 8) - bg) >> shift; con shift 0, bg = gray << 8
+void imgBlendQ8(uint16_t *bg, const uint8_t *gray, size_t count, uint8_t shift);
+
+#endif // IMAGE_KERNELS_H
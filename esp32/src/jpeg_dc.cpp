@@ -0,0 +1,334 @@
+/**
+ * Implementación de la firma DC de un JPEG (ver jpeg_dc.h)
+ *
+ * Decodificador Huffman mínimo de JPEG baseline (ITU T.81, anexo F): tablas
+ * con búsqueda directa de 8 bits y recorrido por longitudes para los códigos
+ * más largos. Las tablas son estáticas (~4 KB): no es reentrante.
+ */
+
+#include "jpeg_dc.h"
+
+#include <string.h>
+
+// ============================================================================
+// TABLAS HUFFMAN
+// ============================================================================
+
+struct HuffTable {
+  uint16_t lookup[256];   // (longitud << 8) | símbolo para códigos de hasta 8 bits; 0 = más largo
+  int32_t maxCode[17];    // Mayor código de cada longitud (-1 si no hay)
+  int32_t valOffset[17];  // Índice en symbols = código + valOffset
+  uint8_t symbols[256];
+  bool present;
+};
+
+struct Component {
+  uint8_t id;
+  uint8_t h;
+  uint8_t v;
+  uint8_t tq;
+  uint8_t td;
+  uint8_t ta;
+  int pred;
+};
+
+static HuffTable dcTables[2];
+static HuffTable acTables[2];
+
+static bool buildTable(HuffTable *t, const uint8_t *counts, const uint8_t *symbols, size_t total) {
+  if (total > sizeof(t->symbols)) return false;
+  memcpy(t->symbols, symbols, total);
+  memset(t->lookup, 0, sizeof(t->lookup));
+
+  int32_t code = 0;
+  int32_t k = 0;
+  for (int len = 1; len <= 16; len++) {
+    t->valOffset[len] = k - code;
+    for (int i = 0; i < counts[len - 1]; i++, code++, k++) {
+      if (len <= 8) {
+        int first = code << (8 - len);
+        int last = (code + 1) << (8 - len);
+        for (int j = first; j < last && j < 256; j++) {
+          t->lookup[j] = (uint16_t)((len << 8) | symbols[k]);
+        }
+      }
+    }
+    t->maxCode[len] = counts[len - 1] ? code - 1 : -1;
+    code <<= 1;
+  }
+  t->present = true;
+  return true;
+}
+
+// ============================================================================
+// LECTURA DE BITS
+// ============================================================================
+
+struct BitReader {
+  const uint8_t *p;
+  const uint8_t *end;
+  uint32_t acc;           // Bits pendientes, alineados a la izquierda
+  int bits;
+  bool marker;            // Se llegó a un marcador: a partir de ahí, ceros
+};
+
+static void fill(BitReader *r) {
+  while (r->bits <= 24) {
+    uint32_t b = 0;
+    if (!r->marker && r->p < r->end) {
+      b = *r->p++;
+      if (b == 0xFF) {
+        // 0xFF 0x00 es un 0xFF de datos; cualquier otro, un marcador
+        if (r->p < r->end && *r->p == 0x00) {
+          r->p++;
+        } else {
+          r->marker = true;
+          r->p--;
+          b = 0;
+        }
+      }
+    }
+    r->acc |= b << (24 - r->bits);
+    r->bits += 8;
+  }
+}
+
+static inline uint32_t peekBits(BitReader *r, int n) {
+  return r->acc >> (32 - n);
+}
+
+static inline void skipBits(BitReader *r, int n) {
+  r->acc <<= n;
+  r->bits -= n;
+}
+
+// Valor con signo de s bits (F.2.2.1, EXTEND)
+static int receiveExtend(BitReader *r, int s) {
+  if (s == 0) return 0;
+  fill(r);
+  int v = (int)peekBits(r, s);
+  skipBits(r, s);
+  return v < (1 << (s - 1)) ? v - (1 << s) + 1 : v;
+}
+
+static int decodeSymbol(BitReader *r, const HuffTable *t) {
+  fill(r);
+  uint16_t e = t->lookup[r->acc >> 24];
+  if (e) {
+    skipBits(r, e >> 8);
+    return e & 0xFF;
+  }
+  for (int len = 9; len <= 16; len++) {
+    int32_t code = (int32_t)peekBits(r, len);
+    if (code <= t->maxCode[len]) {
+      skipBits(r, len);
+      return t->symbols[code + t->valOffset[len]];
+    }
+  }
+  return -1;
+}
+
+// Salta al marcador RSTn tras un intervalo de reinicio
+static bool restart(BitReader *r) {
+  r->acc = 0;
+  r->bits = 0;
+  if (r->p + 1 < r->end && r->p[0] == 0xFF && r->p[1] >= 0xD0 && r->p[1] <= 0xD7) {
+    r->p += 2;
+    r->marker = false;
+    return true;
+  }
+  return false;
+}
+
+// ============================================================================
+// FIRMA
+// ============================================================================
+
+static inline uint16_t readU16(const uint8_t *p) {
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+bool jpegDcSignature(const uint8_t *jpeg, size_t len, JpegDcSignature *out) {
+  if (len < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) return false;
+
+  uint16_t quantDc[4] = {0, 0, 0, 0};  // Paso de cuantización del DC de cada tabla
+  Component comps[4];
+  int nComps = 0;
+  uint16_t width = 0, height = 0;
+  uint16_t restartInterval = 0;
+  dcTables[0].present = dcTables[1].present = false;
+  acTables[0].present = acTables[1].present = false;
+
+  // Cabeceras hasta SOS
+  size_t i = 2;
+  const uint8_t *scan = NULL;
+  int scanComps = 0;
+  while (i + 4 <= len) {
+    if (jpeg[i] != 0xFF) return false;
+    uint8_t marker = jpeg[i + 1];
+    if (marker == 0xFF) {
+      i++;
+      continue;
+    }
+    size_t segLen = readU16(jpeg + i + 2);
+    const uint8_t *seg = jpeg + i + 4;
+    size_t segEnd = i + 2 + segLen;
+    if (segLen < 2 || segEnd > len) return false;
+
+    if (marker == 0xDB) {  // DQT
+      const uint8_t *q = seg;
+      while (q < jpeg + segEnd) {
+        int precision = q[0] >> 4;
+        int id = q[0] & 0x0F;
+        if (id > 3) return false;
+        // El primer valor de la tabla (orden zigzag) es el del DC
+        quantDc[id] = precision ? readU16(q + 1) : q[1];
+        q += 1 + (precision ? 128 : 64);
+      }
+    } else if (marker == 0xC0 || marker == 0xC1) {  // SOF baseline / secuencial extendido
+      height = readU16(seg + 1);
+      width = readU16(seg + 3);
+      nComps = seg[5];
+      if (seg[0] != 8 || nComps < 1 || nComps > 4 || width == 0 || height == 0) return false;
+      for (int c = 0; c < nComps; c++) {
+        const uint8_t *cp = seg + 6 + c * 3;
+        comps[c].id = cp[0];
+        comps[c].h = cp[1] >> 4;
+        comps[c].v = cp[1] & 0x0F;
+        comps[c].tq = cp[2] & 0x03;
+        comps[c].pred = 0;
+        if (comps[c].h < 1 || comps[c].h > 4 || comps[c].v < 1 || comps[c].v > 4) return false;
+      }
+    } else if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 &&
+               marker != 0xCC) {
+      return false;  // Progresivo, sin pérdidas o aritmético
+    } else if (marker == 0xC4) {  // DHT
+      const uint8_t *h = seg;
+      while (h + 17 <= jpeg + segEnd) {
+        int tc = h[0] >> 4;
+        int th = h[0] & 0x0F;
+        if (tc > 1 || th > 1) return false;
+        size_t total = 0;
+        for (int k = 0; k < 16; k++) total += h[1 + k];
+        if (h + 17 + total > jpeg + segEnd) return false;
+        if (!buildTable(tc ? &acTables[th] : &dcTables[th], h + 1, h + 17, total)) return false;
+        h += 17 + total;
+      }
+    } else if (marker == 0xDD) {  // DRI
+      restartInterval = readU16(seg);
+    } else if (marker == 0xDA) {  // SOS
+      scanComps = seg[0];
+      if (nComps == 0 || scanComps != nComps) return false;  // Solo un barrido entrelazado
+      for (int s = 0; s < scanComps; s++) {
+        uint8_t id = seg[1 + s * 2];
+        uint8_t tables = seg[2 + s * 2];
+        int c = 0;
+        while (c < nComps && comps[c].id != id) c++;
+        if (c == nComps) return false;
+        comps[c].td = tables >> 4;
+        comps[c].ta = tables & 0x0F;
+        if (comps[c].td > 1 || comps[c].ta > 1 || !dcTables[comps[c].td].present ||
+            !acTables[comps[c].ta].present) {
+          return false;
+        }
+      }
+      scan = jpeg + segEnd;
+      break;
+    }
+    i = segEnd;
+  }
+  if (!scan) return false;
+
+  // Geometría de las MCU (con una sola componente, una MCU = un bloque)
+  int hMax = 1, vMax = 1;
+  if (nComps == 1) {
+    comps[0].h = comps[0].v = 1;
+  }
+  for (int c = 0; c < nComps; c++) {
+    if (comps[c].h > hMax) hMax = comps[c].h;
+    if (comps[c].v > vMax) vMax = comps[c].v;
+  }
+  const int mcusX = (width + 8 * hMax - 1) / (8 * hMax);
+  const int mcusY = (height + 8 * vMax - 1) / (8 * vMax);
+  const int lumaCols = mcusX * comps[0].h;
+  const int lumaRows = mcusY * comps[0].v;
+  const int32_t q0 = quantDc[comps[0].tq] ? quantDc[comps[0].tq] : 1;
+
+  int32_t sums[JPEG_DC_GRID_H][JPEG_DC_GRID_W];
+  uint16_t counts[JPEG_DC_GRID_H][JPEG_DC_GRID_W];
+  memset(sums, 0, sizeof(sums));
+  memset(counts, 0, sizeof(counts));
+
+  BitReader r = {scan, jpeg + len, 0, 0, false};
+  int untilRestart = restartInterval;
+  for (int my = 0; my < mcusY; my++) {
+    for (int mx = 0; mx < mcusX; mx++) {
+      if (restartInterval && untilRestart == 0) {
+        if (!restart(&r)) return false;
+        for (int c = 0; c < nComps; c++) comps[c].pred = 0;
+        untilRestart = restartInterval;
+      }
+      untilRestart--;
+
+      for (int c = 0; c < nComps; c++) {
+        Component &comp = comps[c];
+        const HuffTable *dc = &dcTables[comp.td];
+        const HuffTable *ac = &acTables[comp.ta];
+        for (int by = 0; by < comp.v; by++) {
+          for (int bx = 0; bx < comp.h; bx++) {
+            int s = decodeSymbol(&r, dc);
+            if (s < 0 || s > 11) return false;
+            comp.pred += receiveExtend(&r, s);
+
+            // Los AC solo se saltan: tamaño de cada uno y carreras de ceros
+            for (int k = 1; k < 64;) {
+              int rs = decodeSymbol(&r, ac);
+              if (rs < 0) return false;
+              int run = rs >> 4;
+              int size = rs & 0x0F;
+              if (size == 0) {
+                if (run != 15) break;  // EOB
+                k += 16;
+                continue;
+              }
+              fill(&r);
+              skipBits(&r, size);
+              k += run + 1;
+            }
+
+            if (c == 0) {
+              int col = mx * comp.h + bx;
+              int row = my * comp.v + by;
+              int gx = col * JPEG_DC_GRID_W / lumaCols;
+              int gy = row * JPEG_DC_GRID_H / lumaRows;
+              sums[gy][gx] += comp.pred * q0;
+              counts[gy][gx]++;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // DC descuantizado = 8 x (media del bloque - 128)
+  for (int gy = 0; gy < JPEG_DC_GRID_H; gy++) {
+    for (int gx = 0; gx < JPEG_DC_GRID_W; gx++) {
+      int level = counts[gy][gx] ? sums[gy][gx] / (8 * counts[gy][gx]) + 128 : 0;
+      out->level[gy][gx] = (uint8_t)(level < 0 ? 0 : (level > 255 ? 255 : level));
+    }
+  }
+  out->width = width;
+  out->height = height;
+  return true;
+}
+
+uint16_t jpegDcChangedCells(const JpegDcSignature &a, const JpegDcSignature &b, uint8_t cellDiff) {
+  uint16_t changed = 0;
+  for (int gy = 0; gy < JPEG_DC_GRID_H; gy++) {
+    for (int gx = 0; gx < JPEG_DC_GRID_W; gx++) {
+      int d = (int)a.level[gy][gx] - b.level[gy][gx];
+      if (d > (int)cellDiff || -d > (int)cellDiff) changed++;
+    }
+  }
+  return changed;
+}
@@ -0,0 +1,38 @@
+/**
+ * Firma de escena de un JPEG a partir de sus coeficientes DC (proyecto TPI2)
+ *
+ * El coeficiente DC de cada bloque 8x8 es su brillo medio. Para saber si un
+ * frame se parece al anterior basta con esos valores, así que este módulo
+ * recorre el código Huffman del JPEG (baseline) sin decodificarlo del todo:
+ *  - del DC de cada bloque de luminancia se saca su nivel medio (0-255, con
+ *    la tabla de cuantización, así que no depende de la calidad JPEG);
+ *  - los coeficientes AC solo se saltan (sin descuantizar ni IDCT);
+ *  - los niveles se promedian en una rejilla fija de JPEG_DC_GRID_W x
+ *    JPEG_DC_GRID_H celdas, la misma para cualquier resolución.
+ *
+ * No depende de Arduino. Las tablas Huffman son estáticas (~4 KB de RAM) y
+ * en la pila usa ~1 KB, así que solo debe llamarse desde una tarea a la vez.
+ */
+
+#ifndef JPEG_DC_H
+#define JPEG_DC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define JPEG_DC_GRID_W 16
+#define JPEG_DC_GRID_H 12
+
+struct JpegDcSignature {
+  uint8_t level[JPEG_DC_GRID_H][JPEG_DC_GRID_W];  // Brillo medio de cada celda
+  uint16_t width;
+  uint16_t height;
+};
+
+// Calcula la firma. Devuelve false si el JPEG no es baseline o está dañado.
+bool jpegDcSignature(const uint8_t *jpeg, size_t len, JpegDcSignature *out);
+
+// Celdas cuyo brillo medio difiere en más de cellDiff entre dos firmas
+uint16_t jpegDcChangedCells(const JpegDcSignature &a, const JpegDcSignature &b, uint8_t cellDiff);
+
+#endif // JPEG_DC_H
@@ -0,0 +1,159 @@
+/**
+ * Implementación del log asíncrono (ver logger.h)
+ */
+
+#include "logger.h"
+
+#include <atomic>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct LogSlot {
+  std::atomic<uint32_t> seq;  // Posición + 1 del mensaje guardado (listo para leer)
+  uint16_t len;
+  char text[LOG_LINE_MAX];
+};
+
+static LogSlot slots[LOG_RING_SLOTS];
+static std::atomic<uint32_t> head(0);     // Siguiente posición a reservar (productores)
+static std::atomic<uint32_t> tail(0);     // Siguiente posición a escribir (tarea de log)
+static std::atomic<uint32_t> dropped(0);
+static volatile bool asyncActive = false;
+
+// ============================================================================
+// ANILLO
+// ============================================================================
+
+static void enqueue(const char *data, size_t len) {
+  uint32_t pos = head.load(std::memory_order_relaxed);
+  do {
+    if (pos - tail.load(std::memory_order_acquire) >= LOG_RING_SLOTS) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  } while (!head.compare_exchange_weak(pos, pos + 1, std::memory_order_acq_rel,
+                                       std::memory_order_relaxed));
+
+  LogSlot &slot = slots[pos % LOG_RING_SLOTS];
+  memcpy(slot.text, data, len);
+  slot.len = (uint16_t)len;
+  slot.seq.store(pos + 1, std::memory_order_release);
+}
+
+#if LOG_ASYNC
+
+// Escribe en Serial todo lo que esté listo, en orden. Solo desde la tarea de log.
+static bool drain() {
+  bool wrote = false;
+  for (;;) {
+    uint32_t pos = tail.load(std::memory_order_relaxed);
+    LogSlot &slot = slots[pos % LOG_RING_SLOTS];
+    if (slot.seq.load(std::memory_order_acquire) != pos + 1) break;
+    Serial.write((const uint8_t *)slot.text, slot.len);
+    tail.store(pos + 1, std::memory_order_release);
+    wrote = true;
+  }
+  return wrote;
+}
+
+static void logTask(void *) {
+  uint32_t reportedDrops = 0;
+  for (;;) {
+    if (!drain()) vTaskDelay(pdMS_TO_TICKS(LOG_FLUSH_INTERVAL));
+
+    uint32_t d = dropped.load(std::memory_order_relaxed);
+    if (d != reportedDrops) {
+      Serial.printf("[LOG] %u mensajes descartados (anillo lleno)\n", (unsigned)(d - reportedDrops));
+      reportedDrops = d;
+    }
+  }
+}
+
+#endif // LOG_ASYNC
+
+// ============================================================================
+// API
+// ============================================================================
+
+void logBegin() {
+#if LOG_ASYNC
+  if (asyncActive) return;
+  if (xTaskCreatePinnedToCore(logTask, "log", LOG_TASK_STACK, NULL, LOG_TASK_PRIORITY, NULL,
+                              LOG_TASK_CORE) == pdPASS) {
+    asyncActive = true;
+  }
+#endif
+}
+
+void logFlush(unsigned long timeoutMs) {
+  unsigned long start = millis();
+  while (asyncActive && tail.load() != head.load() && millis() - start < timeoutMs) {
+    delay(1);
+  }
+  Serial.flush();
+}
+
+uint32_t logDropped() {
+  return dropped.load(std::memory_order_relaxed);
+}
+
+void logWrite(const char *data, size_t len) {
+  if (!asyncActive) {
+    Serial.write((const uint8_t *)data, len);
+    return;
+  }
+  // Los mensajes largos ocupan varios huecos consecutivos
+  while (len > 0) {
+    size_t n = len < LOG_LINE_MAX ? len : LOG_LINE_MAX;
+    enqueue(data, n);
+    data += n;
+    len -= n;
+  }
+}
+
+void logPrint(const char *s) {
+  logWrite(s, strlen(s));
+}
+
+void logPrint(const String &s) {
+  logWrite(s.c_str(), s.length());
+}
+
+void logPrintln() {
+  logWrite("\r\n", 2);
+}
+
+void logPrintln(const char *s) {
+  // Una sola entrada en el anillo para que la línea no se mezcle con otras tareas
+  char buf[LOG_LINE_MAX];
+  size_t len = strlen(s);
+  if (len + 2 <= sizeof(buf)) {
+    memcpy(buf, s, len);
+    buf[len++] = '\r';
+    buf[len++] = '\n';
+    logWrite(buf, len);
+  } else {
+    logWrite(s, len);
+    logPrintln();
+  }
+}
+
+void logPrintln(const String &s) {
+  logPrintln(s.c_str());
+}
+
+void logPrintf(const char *fmt, ...) {
+  char buf[LOG_LINE_MAX * 2];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (n <= 0) return;
+  if ((size_t)n >= sizeof(buf)) {
+    // Truncado: se conserva el salto de línea final
+    n = sizeof(buf) - 1;
+    buf[n - 1] = '\n';
+  }
+  logWrite(buf, n);
+}
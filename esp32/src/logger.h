@@ -0,0 +1,78 @@
+/**
+ * Log asíncrono con niveles (proyecto TPI2)
+ *
+ * Imprimir a 115200 baudios bloquea ~87 us por carácter: una línea de 100
+ * caracteres son casi 9 ms de UART dentro del camino de captura / subida.
+ * Ahora los mensajes se copian a un anillo en RAM y una tarea de baja
+ * prioridad los escribe en Serial cuando la CPU está libre.
+ *
+ *  - Niveles en tiempo de compilación (LOG_LEVEL): los niveles desactivados
+ *    no generan código ni evalúan sus argumentos (quedan en un `if (0)`).
+ *  - El texto se formatea en quien llama (vsnprintf en pila, microsegundos);
+ *    lo que se difiere es la escritura en la UART.
+ *  - Anillo de LOG_RING_SLOTS huecos sin bloqueos: cada productor reserva un
+ *    hueco con compare-and-swap, así que se puede registrar desde cualquier
+ *    tarea o núcleo. Si el anillo está lleno el mensaje se descarta y se
+ *    cuenta (logDropped), nunca se espera.
+ *  - Antes de logBegin() (o con LOG_ASYNC 0) se escribe directamente en Serial.
+ *
+ * DEBUG_PRINT / DEBUG_PRINTLN / DEBUG_PRINTF siguen existiendo como nivel INFO.
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Arranca la tarea que vacía el anillo (llamar tras Serial.begin)
+void logBegin();
+
+// Espera a que se escriba todo lo pendiente (antes de reiniciar / dormir)
+void logFlush(unsigned long timeoutMs = 500);
+
+// Mensajes descartados por anillo lleno
+uint32_t logDropped();
+
+void logWrite(const char *data, size_t len);
+void logPrint(const char *s);
+void logPrint(const String &s);
+void logPrintln();
+void logPrintln(const char *s);
+void logPrintln(const String &s);
+void logPrintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Nivel desactivado: el compilador comprueba el formato y elimina la llamada
+#define LOG_DISCARD(fmt, ...) do { if (0) logPrintf(fmt, ##__VA_ARGS__); } while (0)
+
+#if DEBUG_MODE && LOG_LEVEL >= LOG_LEVEL_ERROR
+  #define LOG_ERROR(fmt, ...) logPrintf(fmt, ##__VA_ARGS__)
+#else
+  #define LOG_ERROR(fmt, ...) LOG_DISCARD(fmt, ##__VA_ARGS__)
+#endif
+
+#if DEBUG_MODE && LOG_LEVEL >= LOG_LEVEL_WARN
+  #define LOG_WARN(fmt, ...) logPrintf(fmt, ##__VA_ARGS__)
+#else
+  #define LOG_WARN(fmt, ...) LOG_DISCARD(fmt, ##__VA_ARGS__)
+#endif
+
+#if DEBUG_MODE && LOG_LEVEL >= LOG_LEVEL_INFO
+  #define LOG_INFO(fmt, ...) logPrintf(fmt, ##__VA_ARGS__)
+  #define DEBUG_PRINT(x) logPrint(x)
+  #define DEBUG_PRINTLN(x) logPrintln(x)
+  #define DEBUG_PRINTF(x, ...) logPrintf(x, __VA_ARGS__)
+#else
+  #define LOG_INFO(fmt, ...) LOG_DISCARD(fmt, ##__VA_ARGS__)
+  #define DEBUG_PRINT(x) do { if (0) logPrint(x); } while (0)
+  #define DEBUG_PRINTLN(x) do { if (0) logPrintln(x); } while (0)
+  #define DEBUG_PRINTF(x, ...) LOG_DISCARD(x, __VA_ARGS__)
+#endif
+
+#if DEBUG_MODE && LOG_LEVEL >= LOG_LEVEL_DEBUG
+  #define LOG_DEBUG(fmt, ...) logPrintf(fmt, ##__VA_ARGS__)
+#else
+  #define LOG_DEBUG(fmt, ...) LOG_DISCARD(fmt, ##__VA_ARGS__)
+#endif
+
+#endif // LOGGER_H
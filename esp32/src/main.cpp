@@ -13,11 +13,29 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include "esp_camera.h"
 #include "config.h"
+#include "boot_timing.h"
+#include "burst.h"
 #include "camera_pins.h"
+#include "detect_feedback.h"
+#include "frame_batch.h"
+#include "http_conn.h"
+#include "metrics.h"
+#include "motion_trigger.h"
+#include "multipart.h"
+#include "offline_queue.h"
+#include "pir.h"
+#include "power.h"
+#include "preroll.h"
+#include "status_led.h"
+#include "stream_adapt.h"
+#include "stream_pipeline.h"
+#include "stream_roi.h"
+#include "tinyml_gate.h"
+#include "wifi_manager.h"
+#include "ws_stream.h"
 
 // ============================================================================
 // VARIABLES GLOBALES
@@ -30,20 +48,114 @@ bool streamingActive = false;
 unsigned long lastCaptureCheck = 0;
 unsigned long lastStreamingCheck = 0;
 unsigned long lastStreamFrame = 0;
+unsigned long lastHttpStatsReport = 0;
+unsigned long nextOfflineDrain = 0;
+unsigned long lastMetricsReport = 0;
+unsigned long nextEnergyReport = 0;
+
+// Ciclo de bajo consumo: una consulta de control por ciclo y a dormir
+unsigned long cycleStart = 0;
+bool controlDoneThisCycle = false;
+bool bootReportPending = false;  // Tiempos de arranque pendientes de enviar a /status
+bool quietReconnect = false;  // La red se soltó para dormir: sin LED ni resumen al volver
+
+// Foto del PIR (o del detector de movimiento) esperando red (se captura antes de conectar)
+camera_fb_t *motionFb = NULL;
+unsigned long motionTriggerMs = 0;
+unsigned long motionCaptureMs = 0;
+bool motionFromPir = true;
+TinymlVerdict motionVerdict = TINYML_UNKNOWN;
+
+// Ruta de los frames del streaming en curso (?motion=<ms> si lo disparó el detector)
+char streamPath[128] = "";
+
+// Instante de la acción cuyo pre-roll se está subiendo (agrupa sus frames en el servidor)
+unsigned long prerollEventMs = 0;
+
+// Estado del long-poll de control
+bool longPollSupported = CONTROL_LONG_POLL_SECONDS > 0;
+unsigned long longPollRetryAt = 0;
+bool lastControlOk = false;
+
+// Contexto del escritor de cuerpo multipart (ver writeMultipartBody)
+struct MultipartUpload {
+  const MultipartEnvelope *env;
+  const uint8_t *data;
+  size_t len;
+};
+
+// Contexto del escritor de un lote de frames (ver writeFrameBatchBody)
+struct FrameBatchUpload {
+  const FrameBatchItem *items;
+  size_t count;
+};
+
+// Contexto del escritor de cuerpo desde un buffer en memoria (ver writeBufferBody)
+struct BufferBody {
+  const char *data;
+  size_t len;
+};
+
+// Respuesta de take-photo-or-video (ver fetchControl)
+struct ControlAction {
+  String action;            // "none", "photo", "burst", "stream" o "stop"
+  int streamDuration;
+  int transport;
+  int burstCount;
+  uint32_t burstInterval;
+  bool hasRoi;              // Solo con streaming=1: región de interés vigente
+  StreamRoi roi;
+  uint32_t roiTtlMs;
+};
 
 // ============================================================================
 // DECLARACIÓN DE FUNCIONES
 // ============================================================================
 
 bool initCamera();
-bool connectWiFi();
-void checkControl();
+bool ensureCamera();
+bool checkControl();
+int fetchControl(HttpConnection &conn, int waitSeconds, bool streaming, ControlAction *out,
+                 bool (*abortWait)() = NULL);
+bool longPollActive();
+bool localTriggerPending();
 void captureAndSendPhoto();
-void streamForDuration(int durationSeconds);
+void captureBurst(int count, uint32_t intervalMs);
+bool uploadBurstFrame(const uint8_t *data, size_t len, uint32_t ageMs);
+void captureMotionPhoto(unsigned long triggerMs, bool fromPir = true);
+void handleCameraMotion(unsigned long triggerMs);
+void flushMotionPhoto(bool force);
+void cameraAcquire();
+void cameraRelease();
+void uploadPreroll();
+bool uploadPrerollFrame(const uint8_t *data, size_t len, uint32_t ageMs);
+void streamForDuration(int durationSeconds, int transport = STREAM_TRANSPORT,
+                       unsigned long motionEventMs = 0);
+bool pollStreamControl(int waitSeconds, unsigned long &endTime, bool &ok);
+void captureStreamPhoto(unsigned long requestedMs);
 void sendStreamFrame();
-bool sendImageToServer(camera_fb_t *fb, const char* endpoint);
+bool uploadStreamFrame(const StreamFrame &frame);
+bool uploadStreamFrameWs(const StreamFrame &frame);
+bool uploadStreamBatch(const StreamFrame *frames, size_t count);
+const char *streamFramePath(const StreamRoi &window, char *buf, size_t cap);
+bool requestStreamExtension(uint32_t seconds);
+bool sendImageToServer(camera_fb_t *fb, const char* endpoint, int *hippos = NULL);
+bool sendJpegToServer(const uint8_t *data, size_t len, const char *path,
+                      HttpConnection &conn = backend, int *hippos = NULL);
+int responseHippoCount(const HttpResponse &resp);
+bool uploadQueuedPhoto(const uint8_t *data, size_t len, long ageMs);
+bool uploadPhoto(const uint8_t *data, size_t len, long ageMs, const char *trigger,
+                 HttpConnection &conn = backend, int *hippos = NULL);
+size_t clientWrite(void *ctx, const uint8_t *data, size_t len);
+bool writeMultipartBody(Client &client, void *ctx);
+bool writeFrameBatchBody(Client &client, void *ctx);
+bool writeBufferBody(Client &client, void *ctx);
+bool reportStatus();
+bool reportEnergy();
+void lowPowerSleep();
 void printStatus();
-void blinkLED(int times, int delayMs);
+bool appendJson(char *out, size_t cap, size_t &n, const char *s);
+bool appendWritten(size_t &n, size_t written);
 
 // ============================================================================
 // SETUP - INICIALIZACIÓN
@@ -52,7 +164,36 @@ void blinkLED(int times, int delayMs);
 void setup() {
   // Inicializar Serial para debug
   Serial.begin(115200);
+  bootMark(BOOT_SETUP_START);
+  powerBegin();
+
+  if (powerWokeFromDeepSleep()) {
+    // Despertar de deep sleep: directo a la red y al control. La cámara se
+    // inicializa solo si el PIR despertó al chip o el servidor la pide.
+    logBegin();
+    pinMode(LED_FLASH_PIN, OUTPUT);
+    digitalWrite(LED_FLASH_PIN, LOW);
+    pirBegin();
+    // Despertar por el PIR: la foto antes que nada, el WiFi después
+    unsigned long triggerMs;
+    if (pirTakeTrigger(&triggerMs)) captureMotionPhoto(triggerMs);
+    DEBUG_PRINTF("\n[POWER] Despertar %u, reloj %llu ms\n", (unsigned)powerWakeCount(),
+                 (unsigned long long)powerClockMs());
+    offlineQueueBegin();
+    quietReconnect = true;
+    wifiManagerBegin();
+    bootMark(BOOT_WIFI_START);
+    bootMark(BOOT_SETUP_DONE);
+    return;
+  }
+
+#if !FAST_BOOT
+  // Margen para abrir el monitor serie
   delay(1000);
+#endif
+  // A partir de aquí los mensajes se escriben desde la tarea de log
+  logBegin();
+  bootReportPending = true;
 
   DEBUG_PRINTLN("\n\n" + String('=', 60));
   DEBUG_PRINTLN("ESP32-CAM Cámara Trampa - TPI2");
@@ -62,14 +203,30 @@ void setup() {
   pinMode(LED_FLASH_PIN, OUTPUT);
   digitalWrite(LED_FLASH_PIN, LOW);
 
-  // Indicar inicio con LED
-  blinkLED(3, 200);
+  // Indicar inicio con LED (sin esperar a que termine)
+  statusLedBegin();
+  statusLedBlink(3, 200);
+
+#if FAST_BOOT
+  // La asociación WiFi avanza en su propia tarea mientras se inicializa la cámara
+  DEBUG_PRINTLN("\n[1/2] Conectando a WiFi en segundo plano...");
+  wifiManagerBegin();
+  bootMark(BOOT_WIFI_START);
+#endif
 
   // Inicializar cámara
-  DEBUG_PRINTLN("\n[1/2] Inicializando cámara...");
+  DEBUG_PRINTLN(FAST_BOOT ? "\n[2/2] Inicializando cámara..." : "\n[1/2] Inicializando cámara...");
   if (initCamera()) {
+    bootMark(BOOT_CAMERA_READY);
     DEBUG_PRINTLN("✓ Cámara inicializada correctamente");
     cameraInitialized = true;
+    // Cola para fotos que no se puedan enviar (necesita la PSRAM / SD ya listas)
+    offlineQueueBegin();
+    pirBegin();
+    // Últimos segundos en baja resolución, para subirlos antes de cada acción
+    prerollBegin();
+    // Movimiento visto por la propia cámara (con pre-roll, sobre sus frames)
+    motionTriggerBegin();
   } else {
     DEBUG_PRINTLN("✗ Error al inicializar cámara");
     DEBUG_PRINTLN("REINICIANDO EN 5 SEGUNDOS...");
@@ -77,24 +234,16 @@ void setup() {
     ESP.restart();
   }
 
-  // Conectar a WiFi
+#if !FAST_BOOT
+  // Conectar a WiFi en segundo plano: loop() arranca sin esperar a la red
   DEBUG_PRINTLN("\n[2/2] Conectando a WiFi...");
-  if (connectWiFi()) {
-    DEBUG_PRINTLN("✓ Conectado a WiFi");
-    wifiConnected = true;
-    blinkLED(5, 100);
-  } else {
-    DEBUG_PRINTLN("✗ Error al conectar a WiFi");
-    DEBUG_PRINTLN("REINICIANDO EN 5 SEGUNDOS...");
-    delay(5000);
-    ESP.restart();
-  }
+  wifiManagerBegin();
+  bootMark(BOOT_WIFI_START);
+#endif
 
-  // Mostrar información
-  DEBUG_PRINTLN("\n" + String('=', 60));
-  printStatus();
-  DEBUG_PRINTLN(String('=', 60));
-  DEBUG_PRINTLN("\nESP32-CAM lista y operando...\n");
+  bootMark(BOOT_SETUP_DONE);
+  DEBUG_PRINTF("\nESP32-CAM lista y operando (setup en %u ms)...\n",
+               (unsigned)(bootPhaseMs(BOOT_SETUP_DONE) - bootPhaseMs(BOOT_SETUP_START)));
 }
 
 // ============================================================================
@@ -102,32 +251,159 @@ void setup() {
 // ============================================================================
 
 void loop() {
-  // Verificar conexión WiFi
-  if (WiFi.status() != WL_CONNECTED) {
-    DEBUG_PRINTLN("WiFi desconectado. Reconectando...");
-    wifiConnected = false;
-    connectWiFi();
+  // WiFi: la reconexión avanza en segundo plano, nunca bloquea el bucle
+  wifiManagerLoop();
+  bool online = wifiManagerConnected();
+  if (online != wifiConnected) {
+    wifiConnected = online;
+    if (online) {
+      // Socket previo al corte: inservible. Vaciar la cola cuanto antes.
+      backend.close();
+      lastControlOk = false;
+      nextOfflineDrain = millis();
+      // Primera consulta de control sin esperar CAPTURE_CHECK_INTERVAL
+      lastCaptureCheck = millis() - CAPTURE_CHECK_INTERVAL;
+      bootMark(BOOT_WIFI_CONNECTED);
+      if (!quietReconnect) {
+        statusLedBlink(5, 100);
+        DEBUG_PRINTLN("\n" + String('=', 60));
+        printStatus();
+        DEBUG_PRINTLN(String('=', 60));
+      }
+      quietReconnect = false;
+    } else if (!quietReconnect) {
+      DEBUG_PRINTLN("WiFi desconectado. Reconectando en segundo plano...");
+    }
+  }
+
+  // Disparo del PIR: la foto primero; se sube en cuanto hay red
+  unsigned long triggerMs;
+  if (!motionFb && pirTakeTrigger(&triggerMs)) captureMotionPhoto(triggerMs);
+  // Movimiento visto por la cámara: foto como la del PIR o streaming corto
+  if (!motionFb && motionTriggerTake(&triggerMs)) handleCameraMotion(triggerMs);
+  if (motionFb) flushMotionPhoto(false);
+
+  // Resumen periódico de reutilización de conexión y latencia HTTP
+  if (millis() - lastHttpStatsReport >= HTTP_STATS_INTERVAL) {
+    lastHttpStatsReport = millis();
+    backend.printStats();
+    wifiManagerPrintStats();
+    offlineQueuePrintStats();
+    powerPrintStats();
+    pirPrintStats();
+    motionTriggerPrintStats();
+    tinymlGatePrintStats();
+    prerollPrintStats();
+    burstPrintStats();
+  }
+
+  // Todo lo que sigue necesita red
+  if (!wifiConnected) {
+#if LOW_POWER_MODE
+    // Sin red: no gastar batería esperando, se reintenta en el siguiente ciclo
+    if (millis() - cycleStart >= LOW_POWER_MAX_AWAKE_MS) lowPowerSleep();
+#endif
+    delay(10);
     return;
   }
 
-  // Consultar al backend qué acción debe realizar esta cámara (foto / streaming)
-  if (millis() - lastCaptureCheck >= CAPTURE_CHECK_INTERVAL) {
+  // Consultar al backend qué acción debe realizar esta cámara (foto / streaming).
+  // En long-poll la siguiente petición sale en cuanto vuelve la anterior;
+  // tras un error (o en sondeo clásico) se espera CAPTURE_CHECK_INTERVAL.
+  // En bajo consumo, una consulta por ciclo en cuanto hay red.
+#if LOW_POWER_MODE
+  bool controlDue = !controlDoneThisCycle;
+#else
+  unsigned long controlInterval = (longPollActive() && lastControlOk) ? 0 : CAPTURE_CHECK_INTERVAL;
+  bool controlDue = millis() - lastCaptureCheck >= controlInterval;
+#endif
+  if (controlDue) {
     lastCaptureCheck = millis();
     DEBUG_PRINTLN("\n--- Ciclo de control ---");
     DEBUG_PRINTLN("Consultando acciones al backend...");
-    checkControl();
+    lastControlOk = checkControl();
+    controlDoneThisCycle = true;
+
+    // Primera consulta tras un arranque en frío: informe de arranque inmediato
+    if (bootReportPending && lastControlOk) {
+      bootTimingPrint();
+      lastMetricsReport = millis();
+      reportStatus();
+    }
+  }
+
+  // Reenviar fotos de la cola offline, por tandas para no retrasar el control
+  if (offlineQueueCount() > 0 && (long)(millis() - nextOfflineDrain) >= 0) {
+    int sent = offlineQueueDrain(uploadQueuedPhoto, OFFLINE_DRAIN_BATCH, OFFLINE_DRAIN_BUDGET_MS);
+    nextOfflineDrain = millis() + (sent < 0 ? OFFLINE_DRAIN_BACKOFF : OFFLINE_DRAIN_INTERVAL);
+  }
+
+  // Estado periódico (WiFi, PIR, histogramas de latencia) hacia /status
+  if (millis() - lastMetricsReport >= METRICS_REPORT_INTERVAL) {
+    lastMetricsReport = millis();
+    reportStatus();
+  }
+
+  // Consumo estimado hacia /energy (el intervalo cuenta también el tiempo dormido)
+  if (powerEnergyReportDue() && (long)(millis() - nextEnergyReport) >= 0) {
+    if (!reportEnergy()) nextEnergyReport = millis() + ENERGY_REPORT_RETRY;
   }
 
+#if LOW_POWER_MODE
+  // Ciclo terminado (la cola offline espera a su siguiente tanda): a dormir
+  bool drainDue = offlineQueueCount() > 0 && (long)(millis() - nextOfflineDrain) >= 0;
+  if (controlDoneThisCycle && !drainDue && !motionFb) {
+    lowPowerSleep();
+    return;
+  }
+#endif
+
   // Pequeño delay para no saturar el CPU
   delay(10);
 }
 
+// ============================================================================
+// BAJO CONSUMO
+// ============================================================================
+
+// Duerme lo que queda hasta la siguiente consulta de control. En deep sleep no
+// vuelve: el siguiente ciclo empieza en setup().
+void lowPowerSleep() {
+  // Disparo llegado mientras se cerraba el ciclo: atenderlo en vez de dormir
+  unsigned long triggerMs;
+  if (!motionFb && pirTakeTrigger(&triggerMs)) {
+    captureMotionPhoto(triggerMs);
+    if (motionFb) return;
+  }
+  // Una foto del PIR sin subir no sobrevive al sueño: a la cola offline
+  if (motionFb) flushMotionPhoto(true);
+
+  unsigned long awake = millis() - cycleStart;
+  uint32_t ms = awake < LOW_POWER_POLL_INTERVAL ? LOW_POWER_POLL_INTERVAL - awake : 0;
+  // La cola offline en PSRAM no sobrevive al deep sleep
+  bool keepRam = OFFLINE_QUEUE_STORAGE == OFFLINE_STORAGE_PSRAM && offlineQueueCount() > 0;
+  PowerSleepMode mode = powerSleepModeFor(ms, keepRam);
+
+  if (mode != POWER_SLEEP_NONE) {
+    backend.close();
+    quietReconnect = true;
+    wifiManagerSuspend();
+  }
+  // En light sleep el pin conserva su nivel: un parpadeo a medias dejaría el flash encendido
+  statusLedOff();
+  powerSleep(mode, ms);
+  if (mode == POWER_SLEEP_LIGHT) wifiManagerResume();
+
+  controlDoneThisCycle = false;
+  cycleStart = millis();
+}
+
 // ============================================================================
 // INICIALIZACIÓN DE CÁMARA
 // ============================================================================
 
 bool initCamera() {
-  camera_config_t config;
+  camera_config_t config = {};
 
   // Configuración de pines
   config.ledc_channel = LEDC_CHANNEL_0;
@@ -156,12 +432,14 @@ bool initCamera() {
     DEBUG_PRINTLN("  PSRAM encontrada");
     config.frame_size = FRAME_SIZE_CAPTURE;
     config.jpeg_quality = JPEG_QUALITY_CAPTURE;
-    config.fb_count = 2;
+    config.fb_count = STREAM_FRAMES_IN_FLIGHT;
+    config.grab_mode = CAMERA_GRAB_LATEST;
   } else {
     DEBUG_PRINTLN("  PSRAM no encontrada - usando configuración reducida");
     config.frame_size = FRAMESIZE_SVGA;
     config.jpeg_quality = 12;
     config.fb_count = 1;
+    config.grab_mode = CAMERA_GRAB_WHEN_EMPTY;
   }
 
   // Inicializar cámara
@@ -201,89 +479,141 @@ bool initCamera() {
   return true;
 }
 
-// ============================================================================
-// CONEXIÓN WIFI
-// ============================================================================
-
-bool connectWiFi() {
-  DEBUG_PRINTLN("  Iniciando conexión WiFi...");
-  DEBUG_PRINTLN("  SSID: " + String(WIFI_SSID));
-
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-
-  unsigned long startTime = millis();
-
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    DEBUG_PRINT(".");
-
-    if (millis() - startTime > WIFI_TIMEOUT) {
-      DEBUG_PRINTLN("\n  Timeout al conectar a WiFi");
-      return false;
-    }
+// Al despertar de deep sleep setup() no inicializa la cámara: se hace aquí la
+// primera vez que una acción la necesita
+bool ensureCamera() {
+  if (!cameraInitialized) {
+    cameraInitialized = initCamera();
+    if (!cameraInitialized) DEBUG_PRINTLN("✗ Error al inicializar cámara");
   }
-
-  DEBUG_PRINTLN();
-  DEBUG_PRINTLN("  WiFi conectado correctamente");
-  DEBUG_PRINTLN("  IP asignada: " + WiFi.localIP().toString());
-  return true;
+  return cameraInitialized;
 }
 
 // ============================================================================
 // CONTROL DESDE BACKEND (FOTO / STREAMING)
 // ============================================================================
 
-void checkControl() {
-  if (!wifiConnected || !cameraInitialized) return;
+// Long-poll activo salvo que el servidor no lo soporte (se reintenta cada cierto tiempo)
+bool longPollActive() {
+  if (CONTROL_LONG_POLL_SECONDS <= 0 || LOW_POWER_MODE) return false;
+  if (!longPollSupported && (long)(millis() - longPollRetryAt) >= 0) {
+    longPollSupported = true;
+  }
+  return longPollSupported;
+}
 
-  DEBUG_PRINTLN("[CONTROL] Preparando petición de control...");
-  DEBUG_PRINTLN("[CONTROL] URL: " + String(SERVER_URL_CAPTURE));
-  DEBUG_PRINTLN("[CONTROL] CAMERA_ID: " + String(CAMERA_ID));
+// Disparo local esperando a loop(): corta el long-poll para hacer la foto ya
+bool localTriggerPending() {
+  return !motionFb && (pirTriggerPending() || motionTriggerPending());
+}
 
-  HTTPClient http;
-  http.begin(SERVER_URL_CAPTURE);  // GET /api/camera/:cameraId/take-photo-or-video
-  http.setTimeout(HTTP_TIMEOUT);
+// Devuelve true si el servidor respondió a la petición de control (o se cortó
+// el long-poll por un disparo: la siguiente consulta sale sin esperar)
+bool checkControl() {
+  if (!wifiConnected) return false;
+
+  ControlAction act;
+  int httpCode = fetchControl(backend, longPollActive() ? CONTROL_LONG_POLL_SECONDS : 0, false, &act,
+                              localTriggerPending);
+  if (httpCode == HTTP_ABORTED) {
+    DEBUG_PRINTLN("Long-poll cortado por un disparo local");
+    return true;
+  }
 
-  // Añadir cabecera de autenticación si se ha configurado un token
-  if (String(CAMERA_API_TOKEN).length() > 0) {
-    DEBUG_PRINTLN("[CONTROL] Usando token de autenticación (X-Api-Key)...");
-    http.addHeader("X-Api-Key", CAMERA_API_TOKEN);
-  } else {
-    DEBUG_PRINTLN("[CONTROL] Sin token de autenticación (CAMERA_API_TOKEN vacío)");
+  if (act.action == "photo") {
+    DEBUG_PRINTLN("\n>>> ACCIÓN RECIBIDA: FOTO <<<");
+    if (ensureCamera()) captureAndSendPhoto();
+  } else if (act.action == "burst") {
+    DEBUG_PRINTLN("\n>>> ACCIÓN RECIBIDA: RÁFAGA <<<");
+    if (ensureCamera()) captureBurst(act.burstCount, act.burstInterval);
+  } else if (act.action == "stream" && act.streamDuration > 0) {
+    DEBUG_PRINTLN("\n>>> ACCIÓN RECIBIDA: STREAMING <<<");
+    if (ensureCamera()) streamForDuration(act.streamDuration, act.transport);
   }
 
-  int httpCode = http.GET();
+  return httpCode == 200;
+}
+
+// GET /api/camera/:cameraId/take-photo-or-video[?wait=N][&streaming=1] por conn.
+// waitSeconds > 0: long-poll. Con streaming=1 el servidor no repite el streaming
+// en curso (solo avisa si cambia su duración) y puede responder "stop".
+// Con streaming=1 también trae la región de interés vigente ("roi"; si falta,
+// campo completo). abortWait: ver HttpRequest. Devuelve el código HTTP; sin
+// respuesta válida, out->action es "none".
+int fetchControl(HttpConnection &conn, int waitSeconds, bool streaming, ControlAction *out,
+                 bool (*abortWait)()) {
+  out->action = "none";
+  out->streamDuration = 0;
+  out->transport = STREAM_TRANSPORT;
+  out->burstCount = BURST_DEFAULT_COUNT;
+  out->burstInterval = 0;
+  out->hasRoi = false;
+  out->roiTtlMs = 0;
+
+  LOG_DEBUG("[CONTROL] Preparando petición de control...\n");
+  LOG_DEBUG("[CONTROL] URL: %s\n", SERVER_URL_CAPTURE);
+  LOG_DEBUG("[CONTROL] CAMERA_ID: %s\n", CAMERA_ID);
+
+  char path[160];
+  int n = snprintf(path, sizeof(path), "%s", urlPath(SERVER_URL_CAPTURE));
+  char sep = '?';
+  if (waitSeconds > 0) {
+    n += snprintf(path + n, sizeof(path) - n, "%cwait=%d", sep, waitSeconds);
+    sep = '&';
+  }
+  if (streaming) snprintf(path + n, sizeof(path) - n, "%cstreaming=1", sep);
+  unsigned long timeout = HTTP_TIMEOUT + (unsigned long)waitSeconds * 1000UL;
 
-  DEBUG_PRINTF("Control: HTTP %d\n", httpCode);
+  char payload[384];
+  HttpRequest req = {"GET", path, NULL, 0, NULL, NULL, timeout, abortWait};
+  HttpResponse resp = {-1, payload, sizeof(payload), 0};
+  int httpCode = conn.send(req, &resp);
+
+  LOG_DEBUG("Control: HTTP %d\n", httpCode);
 
   if (httpCode == 200) {
-    String payload = http.getString();
-    DEBUG_PRINTLN("[CONTROL] Respuesta JSON: " + payload);
+    bootMark(BOOT_FIRST_POLL);
+    LOG_DEBUG("[CONTROL] Respuesta JSON: %s\n", payload);
 
     // Parsear JSON
-    StaticJsonDocument<256> doc;
-    DeserializationError error = deserializeJson(doc, payload);
+    StaticJsonDocument<384> doc;
+    DeserializationError error = deserializeJson(doc, payload, resp.bodyLen);
 
     if (!error) {
-      String action = doc["action"] | "none";
-      int streamDuration = doc["streamDurationSeconds"] | 0;
-
-      DEBUG_PRINTLN("[CONTROL] Acción: " + action + ", streamDurationSeconds=" + String(streamDuration));
-
-      if (action == "photo") {
-        DEBUG_PRINTLN("\n>>> ACCIÓN RECIBIDA: FOTO <<<");
-        captureAndSendPhoto();
-      } else if (action == "stream" && streamDuration > 0) {
-        DEBUG_PRINTLN("\n>>> ACCIÓN RECIBIDA: STREAMING <<<");
-        streamForDuration(streamDuration);
+      out->action = doc["action"] | "none";
+      out->streamDuration = doc["streamDurationSeconds"] | 0;
+      out->burstCount = doc["count"] | BURST_DEFAULT_COUNT;
+      out->burstInterval = doc["intervalMs"] | 0;
+
+      // Un servidor sin long-poll ignora ?wait y no devuelve "longPoll"
+      if (waitSeconds > 0 && !(doc["longPoll"] | false)) {
+        DEBUG_PRINTLN("[CONTROL] El servidor no soporta long-poll, volviendo al sondeo");
+        longPollSupported = false;
+        longPollRetryAt = millis() + CONTROL_LONG_POLL_RETRY_INTERVAL;
+      }
+      String transportName = doc["transport"] | "";
+      if (transportName == "ws") out->transport = STREAM_TRANSPORT_WS;
+      else if (transportName == "http") out->transport = STREAM_TRANSPORT_HTTP;
+
+      // {"x":..,"y":..,"w":..,"h":.. en milésimas del campo completo, "ttlMs":..}
+      JsonObject roi = doc["roi"];
+      if (!roi.isNull() && (roi["w"] | 0) > 0 && (roi["h"] | 0) > 0) {
+        out->hasRoi = true;
+        out->roi.x = roi["x"] | 0;
+        out->roi.y = roi["y"] | 0;
+        out->roi.w = roi["w"] | 0;
+        out->roi.h = roi["h"] | 0;
+        out->roiTtlMs = roi["ttlMs"] | 0;
       }
+
+      LOG_DEBUG("[CONTROL] Acción: %s, streamDurationSeconds=%d\n", out->action.c_str(),
+                out->streamDuration);
     }
   } else if (httpCode > 0) {
     DEBUG_PRINTF("Error en checkControl: HTTP %d\n", httpCode);
   }
 
-  http.end();
+  return httpCode;
 }
 
 // ============================================================================
@@ -294,6 +624,8 @@ void captureAndSendPhoto() {
   DEBUG_PRINTLN("[PHOTO] Iniciando flujo de captura y envío de foto");
   DEBUG_PRINTLN("[PHOTO] Capturando foto...");
 
+  cameraAcquire();
+
   // Encender flash si está habilitado
   if (USE_FLASH) {
     digitalWrite(LED_FLASH_PIN, HIGH);
@@ -301,7 +633,9 @@ void captureAndSendPhoto() {
   }
 
   // Capturar imagen
+  METRIC_START(t0);
   camera_fb_t *fb = esp_camera_fb_get();
+  METRIC_STOP(METRIC_CAPTURE, t0);
 
   // Apagar flash
   if (USE_FLASH) {
@@ -310,25 +644,213 @@ void captureAndSendPhoto() {
 
   if (!fb) {
     DEBUG_PRINTLN("[PHOTO] ✗ Error al capturar imagen (fb nulo)");
+    cameraRelease();
     return;
   }
 
-  DEBUG_PRINTF("[PHOTO] ✓ Foto capturada: %d bytes\n", fb->len);
-  DEBUG_PRINTF("[PHOTO] Endpoint de subida: %s\n", SERVER_URL_UPLOAD);
-  DEBUG_PRINTLN("[PHOTO] Enviando al servidor...");
+  DEBUG_PRINTF("[PHOTO] ✓ Foto capturada: %u bytes\n", (unsigned)fb->len);
+  METRIC_ADD(METRIC_BYTES_CAPTURED, fb->len);
 
-  // Enviar al servidor
-  bool success = sendImageToServer(fb, SERVER_URL_UPLOAD);
+  // Lo que pasó antes de la petición va por delante de la foto
+  uploadPreroll();
+
+  // Sin WiFi la foto va directamente a la cola offline
+  bool success = false;
+  if (wifiConnected) {
+    DEBUG_PRINTF("[PHOTO] Endpoint de subida: %s\n", SERVER_URL_UPLOAD);
+    DEBUG_PRINTLN("[PHOTO] Enviando al servidor...");
+    int hippos = -1;
+    success = sendImageToServer(fb, SERVER_URL_UPLOAD, &hippos);
+    detectFeedbackRecord(hippos);
+  }
 
   if (success) {
     DEBUG_PRINTLN("[PHOTO] ✓ Foto enviada exitosamente");
-    blinkLED(2, 100);
+    statusLedBlink(2, 100);
   } else {
-    DEBUG_PRINTLN("[PHOTO] ✗ Error al enviar foto (HTTP != 200)");
+    DEBUG_PRINTLN("[PHOTO] ✗ Error al enviar foto, se guarda para reenviarla");
+    offlineQueuePush(fb->buf, fb->len);
+    // El servidor acaba de fallar: no reintentar en el mismo ciclo
+    nextOfflineDrain = millis() + OFFLINE_DRAIN_BACKOFF;
   }
 
   // Liberar buffer
   esp_camera_fb_return(fb);
+  cameraRelease();
+}
+
+// ============================================================================
+// RÁFAGA DE FOTOS
+// ============================================================================
+
+// Primero todos los disparos (a PSRAM), después las subidas por la conexión persistente
+void captureBurst(int count, uint32_t intervalMs) {
+  DEBUG_PRINTF("[BURST] %d fotos, intervalo %u ms\n", count, (unsigned)intervalMs);
+  cameraAcquire();
+  if (USE_FLASH) {
+    digitalWrite(LED_FLASH_PIN, HIGH);
+    delay(100);
+  }
+  int captured = burstCapture(count, intervalMs);
+  if (USE_FLASH) {
+    digitalWrite(LED_FLASH_PIN, LOW);
+  }
+  uploadPreroll();
+  cameraRelease();
+  if (captured == 0) return;
+
+  // Sin WiFi, o tras un fallo, lo que queda va a la cola offline
+  int sent = burstUpload(wifiConnected ? uploadBurstFrame : NULL, offlineQueuePush);
+  if (sent == captured) {
+    statusLedBlink(2, 100);
+  } else {
+    nextOfflineDrain = millis() + OFFLINE_DRAIN_BACKOFF;
+  }
+}
+
+bool uploadBurstFrame(const uint8_t *data, size_t len, uint32_t ageMs) {
+  return uploadPhoto(data, len, (long)ageMs, "burst");
+}
+
+// ============================================================================
+// FOTO POR MOVIMIENTO (PIR / DETECTOR DE LA CÁMARA)
+// ============================================================================
+
+// Disparo del detector de movimiento: streaming corto si está configurado y hay
+// red; si no, la misma foto que con el PIR
+void handleCameraMotion(unsigned long triggerMs) {
+  if (MOTION_STREAM_SECONDS > 0 && wifiConnected) {
+    DEBUG_PRINTF("[MOTION] Streaming de %d s por movimiento\n", MOTION_STREAM_SECONDS);
+    streamForDuration(MOTION_STREAM_SECONDS, STREAM_TRANSPORT_HTTP, triggerMs);
+    return;
+  }
+  captureMotionPhoto(triggerMs, false);
+}
+
+// Captura y se queda con el frame: el animal puede irse antes de que haya WiFi
+void captureMotionPhoto(unsigned long triggerMs, bool fromPir) {
+  const char *tag = fromPir ? "[PIR]" : "[MOTION]";
+  if (!ensureCamera()) return;
+  // El pre-roll se congela hasta subir la foto (flushMotionPhoto)
+  cameraAcquire();
+
+  if (USE_FLASH) {
+    digitalWrite(LED_FLASH_PIN, HIGH);
+    delay(100);
+  }
+  METRIC_START(t0);
+  camera_fb_t *fb = esp_camera_fb_get();
+  METRIC_STOP(METRIC_CAPTURE, t0);
+  if (USE_FLASH) {
+    digitalWrite(LED_FLASH_PIN, LOW);
+  }
+
+  if (!fb) {
+    DEBUG_PRINTF("%s ✗ Error al capturar imagen (fb nulo)\n", tag);
+    cameraRelease();
+    return;
+  }
+  METRIC_ADD(METRIC_BYTES_CAPTURED, fb->len);
+
+  // Las fotos sin hipopótamo según el clasificador no se suben ni se encolan
+  uint8_t probability;
+  motionVerdict = tinymlGateClassify(fb->buf, fb->len, &probability);
+  if (!tinymlGateKeep(motionVerdict)) {
+    DEBUG_PRINTF("%s Foto descartada por el clasificador (%u%% hipopótamo)\n", tag, probability);
+    esp_camera_fb_return(fb);
+    prerollClear();
+    cameraRelease();
+    return;
+  }
+  motionFb = fb;
+  motionTriggerMs = triggerMs;
+  motionCaptureMs = millis();
+  motionFromPir = fromPir;
+  if (fromPir) pirRecordCapture(motionCaptureMs - triggerMs);
+  DEBUG_PRINTF("%s ✓ Foto capturada: %u bytes a los %lu ms del disparo\n", tag,
+               (unsigned)fb->len, motionCaptureMs - triggerMs);
+}
+
+// Sube la foto del PIR / detector en cuanto hay red. Si la subida falla, o no
+// hay red tras PIR_UPLOAD_WAIT_MS (o force), va a la cola offline.
+void flushMotionPhoto(bool force) {
+  const char *tag = motionFromPir ? "[PIR]" : "[MOTION]";
+  if (wifiConnected) {
+    uploadPreroll();
+    long ageMs = (long)(millis() - motionCaptureMs);
+    int hippos = -1;
+    bool sent = uploadPhoto(motionFb->buf, motionFb->len, ageMs,
+                            motionFromPir ? "motion" : "vision", backend, &hippos);
+    detectFeedbackRecord(hippos);
+    tinymlGateRecordServer(motionVerdict, hippos);
+    if (sent) {
+      uint32_t total = millis() - motionTriggerMs;
+      if (motionFromPir) pirRecordUpload(total);
+      DEBUG_PRINTF("%s ✓ Foto subida a los %u ms del disparo\n", tag, (unsigned)total);
+    } else {
+      DEBUG_PRINTF("%s ✗ Error al subir, se guarda en la cola offline\n", tag);
+      offlineQueuePush(motionFb->buf, motionFb->len);
+    }
+  } else if (force || millis() - motionCaptureMs >= PIR_UPLOAD_WAIT_MS) {
+    DEBUG_PRINTF("%s Sin WiFi, la foto pasa a la cola offline\n", tag);
+    offlineQueuePush(motionFb->buf, motionFb->len);
+    prerollClear();
+  } else {
+    return;
+  }
+  esp_camera_fb_return(motionFb);
+  motionFb = NULL;
+  cameraRelease();
+}
+
+// ============================================================================
+// PRE-ROLL
+// ============================================================================
+
+// Las tareas del pre-roll y del detector de movimiento dejan el sensor en baja
+// resolución: se pausan y se vuelve a la de captura, descartando el frame que
+// ya estaba en el buffer
+void cameraAcquire() {
+  // Un parpadeo del LED de estado (el flash) no debe salir en la foto
+  statusLedOff();
+  bool wasCapturing = prerollCapturing() || motionTriggerCapturing();
+  motionTriggerPause();
+  prerollPause();
+  if (!wasCapturing) return;
+
+  sensor_t *s = esp_camera_sensor_get();
+  if (s != NULL) {
+    s->set_framesize(s, FRAME_SIZE_CAPTURE);
+    s->set_quality(s, JPEG_QUALITY_CAPTURE);
+  }
+  camera_fb_t *stale = esp_camera_fb_get();
+  if (stale) esp_camera_fb_return(stale);
+}
+
+void cameraRelease() {
+  prerollResume();
+  motionTriggerResume();
+}
+
+// Sube el pre-roll (con la captura ya en pausa); sin red se descarta
+void uploadPreroll() {
+  if (prerollCount() == 0) return;
+  if (!wifiConnected) {
+    prerollClear();
+    return;
+  }
+  prerollEventMs = millis();
+  int sent = prerollFlush(uploadPrerollFrame);
+  DEBUG_PRINTF("[PREROLL] %d frames anteriores a la acción subidos en %lu ms\n", sent,
+               millis() - prerollEventMs);
+}
+
+// Como un frame en vivo, fechado con su antigüedad; ?preroll agrupa los de una misma acción
+bool uploadPrerollFrame(const uint8_t *data, size_t len, uint32_t ageMs) {
+  char path[192];
+  snprintf(path, sizeof(path), "%s?capturedAgeMs=%u&preroll=%lu", urlPath(SERVER_URL_STREAM),
+           (unsigned)ageMs, prerollEventMs);
+  return sendJpegToServer(data, len, path);
 }
 
 // ============================================================================
@@ -339,33 +861,100 @@ void sendStreamFrame() {
   if (!wifiConnected || !cameraInitialized) return;
 
   // Capturar frame
+  METRIC_START(t0);
   camera_fb_t *fb = esp_camera_fb_get();
+  METRIC_STOP(METRIC_CAPTURE, t0);
 
   if (!fb) {
     DEBUG_PRINTLN("Error al capturar frame de streaming");
     return;
   }
+  METRIC_ADD(METRIC_BYTES_CAPTURED, fb->len);
 
   // Enviar al servidor
-  sendImageToServer(fb, SERVER_URL_STREAM);
+  sendJpegToServer(fb->buf, fb->len, streamPath);
 
   // Liberar buffer
   esp_camera_fb_return(fb);
 }
 
+// streamPath y, con región de interés, ?roi=x,y,w,h (milésimas del campo
+// completo): el servidor sitúa con ella las detecciones del frame recortado
+const char *streamFramePath(const StreamRoi &window, char *buf, size_t cap) {
+  if (streamRoiIsFull(window)) return streamPath;
+  snprintf(buf, cap, "%s%croi=%u,%u,%u,%u", streamPath, strchr(streamPath, '?') ? '&' : '?',
+           window.x, window.y, window.w, window.h);
+  return buf;
+}
+
+// Funciones de subida de la tubería de streaming (una por transporte)
+bool uploadStreamFrame(const StreamFrame &frame) {
+  char path[sizeof(streamPath) + 32];
+  int hippos = -1;
+  bool ok = sendJpegToServer(frame.fb->buf, frame.fb->len,
+                             streamFramePath(frame.window, path, sizeof(path)), backend, &hippos);
+  streamAdaptRecordRtt(backend.stats().lastWaitMs);
+  detectFeedbackRecord(hippos);
+  return ok;
+}
+
+// Varios frames en un POST (frame_batch.h), cada uno con su número y su antigüedad
+bool uploadStreamBatch(const StreamFrame *frames, size_t count) {
+  FrameBatchItem items[STREAM_BATCH_MAX];
+  if (count > STREAM_BATCH_MAX) count = STREAM_BATCH_MAX;
+  uint32_t now = millis();
+  for (size_t i = 0; i < count; i++) {
+    items[i] = {frames[i].fb->buf, frames[i].fb->len, frames[i].seq,
+                now - frames[i].capturedMs};
+  }
+
+  // La tubería no mezcla ventanas del sensor en un lote
+  char path[sizeof(streamPath) + 32];
+  FrameBatchUpload batch = {items, count};
+  HttpRequest req = {"POST", streamFramePath(frames[0].window, path, sizeof(path)),
+                     FRAME_BATCH_CONTENT_TYPE, frameBatchBodyLength(items, count),
+                     writeFrameBatchBody, &batch, HTTP_TIMEOUT, NULL};
+  char reply[96];
+  HttpResponse resp = {-1, reply, sizeof(reply), 0};
+  int httpCode = backend.send(req, &resp);
+  streamAdaptRecordRtt(backend.stats().lastWaitMs);
+
+  bool success = (httpCode >= 200 && httpCode < 300);
+  // La inferencia del servidor va sobre el frame más reciente del lote
+  if (success) detectFeedbackRecord(responseHippoCount(resp));
+  if (!success) LOG_ERROR("[HTTP] Lote de %u frames rechazado: %d\n", (unsigned)count, httpCode);
+  return success;
+}
+
+bool uploadStreamFrameWs(const StreamFrame &frame) {
+  return wsStream.sendBinary(frame.fb->buf, frame.fb->len);
+}
+
 // ============================================================================
 // STREAMING DURANTE UN INTERVALO FIJO (similar a Raspberry)
 // ============================================================================
 
-void streamForDuration(int durationSeconds) {
+void streamForDuration(int durationSeconds, int transport, unsigned long motionEventMs) {
   if (durationSeconds <= 0) return;
   if (!wifiConnected || !cameraInitialized) return;
 
+  // Sin sesión pedida por el servidor, ?motion agrupa los frames de este disparo
+  if (motionEventMs > 0) {
+    snprintf(streamPath, sizeof(streamPath), "%s?motion=%lu", urlPath(SERVER_URL_STREAM),
+             motionEventMs);
+  } else {
+    snprintf(streamPath, sizeof(streamPath), "%s", urlPath(SERVER_URL_STREAM));
+  }
+
   unsigned long durationMs = (unsigned long)durationSeconds * 1000UL;
   unsigned long endTime = millis() + durationMs;
 
   DEBUG_PRINTF("Iniciando streaming durante %d segundos\n", durationSeconds);
 
+  // El pre-roll va por HTTP antes que los frames en vivo (también con WebSocket)
+  cameraAcquire();
+  uploadPreroll();
+
   // Ajustar configuración de cámara para streaming
   sensor_t *s = esp_camera_sensor_get();
   if (s != NULL) {
@@ -373,97 +962,437 @@ void streamForDuration(int durationSeconds) {
     s->set_quality(s, JPEG_QUALITY_STREAM);
   }
 
+  // Transporte: WebSocket si se pidió y el handshake funciona; si no, HTTP
+  if (transport == STREAM_TRANSPORT_WS && !wsStream.connect()) {
+    DEBUG_PRINTLN("WebSocket no disponible, se usa HTTP para este streaming");
+    transport = STREAM_TRANSPORT_HTTP;
+  }
+  StreamUploadFn upload =
+      transport == STREAM_TRANSPORT_WS ? uploadStreamFrameWs : uploadStreamFrame;
+
+  // Contadores de bytes antes de empezar, para calcular el overhead por frame
+  HttpStats http0 = backend.stats();
+  WsStats ws0 = wsStream.stats();
+
+  // Lotes solo por HTTP: el WebSocket no paga una espera de respuesta por frame
+  StreamBatchUploadFn uploadBatch =
+      transport == STREAM_TRANSPORT_HTTP ? uploadStreamBatch : NULL;
+
+  // Captura y subida corren en sus tareas; este bucle atiende el canal de
+  // control por streamControl (foto, parar, otra duración) e informa del progreso
+#if DETECT_FEEDBACK
+  detectFeedbackStreamStart();
+  uint32_t extendedSeconds = 0;
+#endif
+  bool pipelined = streamPipelineStart(upload, uploadBatch);
+  if (!pipelined) {
+    // Sin memoria para las tareas: frames en este mismo bucle, como antes
+    DEBUG_PRINTLN("No se pudo iniciar la tubería de streaming, usando modo secuencial");
+  }
+  unsigned long lastStats = millis();
+  unsigned long lastControl = millis();
+  bool controlOk = true;
   while ((long)(endTime - millis()) > 0) {
-    sendStreamFrame();
-    delay(STREAMING_FRAME_DELAY);
+    if (!pipelined) sendStreamFrame();
+
+    // Con long-poll la consulta queda abierta (hasta STREAM_CONTROL_WAIT_SECONDS
+    // y sin pasar del final) y vuelve en cuanto hay una acción; sin long-poll,
+    // tras un error o en modo secuencial, se sondea cada CAPTURE_CHECK_INTERVAL
+    long remainingMs = (long)(endTime - millis());
+    int wait = 0;
+    if (pipelined && controlOk && longPollActive()) {
+      wait = (int)min((long)STREAM_CONTROL_WAIT_SECONDS, remainingMs / 1000);
+    }
+    if (wait > 0 || millis() - lastControl >= CAPTURE_CHECK_INTERVAL) {
+      lastControl = millis();
+      if (!pollStreamControl(wait, endTime, controlOk)) break;
+    }
+
+#if DETECT_FEEDBACK
+    // Con un animal a la vista el streaming no se corta: se alarga aquí y se
+    // avisa al servidor para que la sesión y el vídeo sigan al mismo final
+    if (detectFeedbackMode() == DETECT_MODE_ACTIVE &&
+        (long)(endTime - millis()) < DETECT_EXTEND_SECONDS * 1000L / 2 &&
+        extendedSeconds + DETECT_EXTEND_SECONDS <= DETECT_EXTEND_MAX_SECONDS) {
+      endTime += DETECT_EXTEND_SECONDS * 1000UL;
+      extendedSeconds += DETECT_EXTEND_SECONDS;
+      detectFeedbackRecordExtension(DETECT_EXTEND_SECONDS);
+      DEBUG_PRINTF("[DETECT] Hipopótamo a la vista: streaming alargado %d s (total +%u s)\n",
+                   DETECT_EXTEND_SECONDS, (unsigned)extendedSeconds);
+      requestStreamExtension(DETECT_EXTEND_SECONDS);
+    }
+#endif
+
+    if (millis() - lastStats >= STREAM_STATS_INTERVAL) {
+      lastStats = millis();
+      if (pipelined) streamPipelinePrintStats();
+    }
+    delay(pipelined ? 50 : STREAMING_FRAME_DELAY);
   }
 
+  if (pipelined) {
+    streamPipelineStop();
+#if DETECT_FEEDBACK
+    detectFeedbackStreamStop();
+#endif
+    streamPipelinePrintStats();
+
+    // Bytes en la red que no son JPEG, por frame enviado
+    const StreamStats &st = streamPipelineStats();
+    uint64_t overhead;
+    if (transport == STREAM_TRANSPORT_WS) {
+      overhead = wsStream.stats().overheadBytes - ws0.overheadBytes;
+    } else {
+      uint64_t wire = (backend.stats().bytesSent - http0.bytesSent) +
+                      (backend.stats().bytesReceived - http0.bytesReceived);
+      overhead = wire > st.bytesSent ? wire - st.bytesSent : 0;
+    }
+    DEBUG_PRINTF("[STREAM] Transporte %s: %u bytes de overhead por frame\n",
+                 transport == STREAM_TRANSPORT_WS ? "WebSocket" : "HTTP",
+                 st.sent ? (unsigned)(overhead / st.sent) : 0);
+  }
+
+  if (transport == STREAM_TRANSPORT_WS) wsStream.close();
+  streamControl.close();
+
   // Restaurar configuración para captura
   s = esp_camera_sensor_get();
   if (s != NULL) {
     s->set_framesize(s, FRAME_SIZE_CAPTURE);
     s->set_quality(s, JPEG_QUALITY_CAPTURE);
   }
+  cameraRelease();
 
   DEBUG_PRINTLN("Streaming finalizado");
 }
 
-// ============================================================================
-// ENVIAR IMAGEN AL SERVIDOR (multipart/form-data)
-// ============================================================================
-
-bool sendImageToServer(camera_fb_t *fb, const char* endpoint) {
-  if (!fb) return false;
+// Pide al servidor que alargue el streaming en curso (POST extend-stream por
+// streamControl). Un 409 (streaming por movimiento, sin sesión pedida desde el
+// servidor) no es un error: el alargue local sigue valiendo.
+bool requestStreamExtension(uint32_t seconds) {
+  char json[32];
+  int n = snprintf(json, sizeof(json), "{\"seconds\":%u}", (unsigned)seconds);
+  BufferBody body = {json, (size_t)n};
+  HttpRequest req = {"POST", urlPath(SERVER_URL_EXTEND_STREAM), "application/json", (size_t)n,
+                     writeBufferBody, &body, HTTP_TIMEOUT, NULL};
+  int httpCode = streamControl.send(req, NULL);
+  if (httpCode != 409 && (httpCode < 200 || httpCode >= 300)) {
+    LOG_WARN("[DETECT] El servidor no aceptó el alargue: HTTP %d\n", httpCode);
+    return false;
+  }
+  return httpCode != 409;
+}
 
-  HTTPClient http;
+// Una consulta de control en mitad del streaming. Devuelve false si el servidor
+// pidió pararlo; si pidió otra duración, endTime pasa a contar desde ahora.
+bool pollStreamControl(int waitSeconds, unsigned long &endTime, bool &ok) {
+  ControlAction act;
+  ok = fetchControl(streamControl, waitSeconds, true, &act) == 200;
+#if STREAM_ROI
+  // Cada respuesta confirma la región o la retira; sin respuestas caduca sola
+  if (ok) streamRoiRequest(act.hasRoi ? &act.roi : NULL, act.roiTtlMs);
+#endif
+
+  if (act.action == "stop") {
+    DEBUG_PRINTLN("\n>>> ACCIÓN RECIBIDA: PARAR STREAMING <<<");
+    return false;
+  }
+  if (act.action == "photo") {
+    DEBUG_PRINTLN("\n>>> ACCIÓN RECIBIDA: FOTO (durante el streaming) <<<");
+    captureStreamPhoto(millis());
+  } else if (act.action == "stream" && act.streamDuration > 0) {
+    endTime = millis() + (unsigned long)act.streamDuration * 1000UL;
+    DEBUG_PRINTF("[STREAM] Nueva duración pedida: quedan %d s\n", act.streamDuration);
+  }
+  return true;
+}
 
-  DEBUG_PRINTLN("[HTTP] Preparando envío de imagen...");
-  DEBUG_PRINTLN("[HTTP] Endpoint: " + String(endpoint));
+// Foto pedida durante el streaming: va antes que los frames. La captura se
+// pausa, el sensor hace un frame a resolución de captura y la foto sube por
+// streamControl mientras la tarea de subida termina lo que ya estaba en cola.
+// Después el streaming sigue con sus ajustes. requestedMs: llegada de la acción.
+void captureStreamPhoto(unsigned long requestedMs) {
+  streamPipelinePause();
+  unsigned long pausedMs = millis();
 
-  http.begin(endpoint);
-  http.setTimeout(HTTP_TIMEOUT);
+  sensor_t *s = esp_camera_sensor_get();
+  if (s != NULL) {
+    s->set_framesize(s, FRAME_SIZE_CAPTURE);
+    s->set_quality(s, JPEG_QUALITY_CAPTURE);
+  }
+  camera_fb_t *stale = esp_camera_fb_get();
+  if (stale) esp_camera_fb_return(stale);
 
-  // Añadir cabecera de autenticación si se ha configurado un token
-  if (String(CAMERA_API_TOKEN).length() > 0) {
-    DEBUG_PRINTLN("[HTTP] Añadiendo cabecera X-Api-Key");
-    http.addHeader("X-Api-Key", CAMERA_API_TOKEN);
+  if (USE_FLASH) {
+    digitalWrite(LED_FLASH_PIN, HIGH);
+    delay(100);
+  }
+  METRIC_START(t0);
+  camera_fb_t *fb = esp_camera_fb_get();
+  METRIC_STOP(METRIC_CAPTURE, t0);
+  if (USE_FLASH) {
+    digitalWrite(LED_FLASH_PIN, LOW);
+  }
+  unsigned long capturedMs = millis();
+
+  bool success = false;
+  size_t photoLen = fb ? fb->len : 0;
+  if (fb) {
+    METRIC_ADD(METRIC_BYTES_CAPTURED, fb->len);
+    int hippos = -1;
+    success = uploadPhoto(fb->buf, fb->len, -1, NULL, streamControl, &hippos);
+    detectFeedbackRecord(hippos);
+    if (!success) {
+      DEBUG_PRINTLN("[PHOTO] ✗ Error al enviar foto, se guarda para reenviarla");
+      offlineQueuePush(fb->buf, fb->len);
+      nextOfflineDrain = millis() + OFFLINE_DRAIN_BACKOFF;
+    }
   } else {
-    DEBUG_PRINTLN("[HTTP] Sin cabecera X-Api-Key (TOKEN vacío)");
+    DEBUG_PRINTLN("[PHOTO] ✗ Error al capturar imagen (fb nulo)");
   }
+  unsigned long doneMs = millis();
 
-  // Crear boundary para multipart/form-data
-  String boundary = "ESP32CAM-" + String(random(1000, 9999));
-  String contentType = "multipart/form-data; boundary=" + boundary;
-
-  // Construir el cuerpo de la petición
-  String head = "--" + boundary + "\r\n";
-  head += "Content-Disposition: form-data; name=\"image\"; filename=\"esp32cam.jpg\"\r\n";
-  head += "Content-Type: image/jpeg\r\n\r\n";
+  // Ajustes del streaming: en la tubería los vuelve a aplicar la tarea de captura
+  if (streamPipelineRunning()) {
+    streamAdaptInvalidate();
+  } else if (s != NULL) {
+    s->set_framesize(s, FRAME_SIZE_STREAM);
+    s->set_quality(s, JPEG_QUALITY_STREAM);
+  }
+  if (fb) esp_camera_fb_return(fb);
+  streamPipelineResume();
+
+  if (photoLen == 0) return;
+  streamPipelineRecordPhoto(doneMs - requestedMs);
+  DEBUG_PRINTF("[PHOTO] %s %u bytes en %lu ms (pausa %lu, captura %lu, subida %lu)\n",
+               success ? "✓ Foto enviada:" : "✗ Foto en cola:", (unsigned)photoLen,
+               doneMs - requestedMs, pausedMs - requestedMs, capturedMs - pausedMs,
+               doneMs - capturedMs);
+}
 
-  String tail = "\r\n--" + boundary + "--\r\n";
+// ============================================================================
+// ENVIAR IMAGEN AL SERVIDOR (multipart/form-data)
+// ============================================================================
 
-  uint32_t totalLen = head.length() + fb->len + tail.length();
+bool sendImageToServer(camera_fb_t *fb, const char* endpoint, int *hippos) {
+  if (!fb) return false;
+  return sendJpegToServer(fb->buf, fb->len, urlPath(endpoint), backend, hippos);
+}
 
-  DEBUG_PRINTF("[HTTP] Tamaño total del cuerpo: %u bytes\n", totalLen);
+// Foto de la cola offline: el servidor usa capturedAgeMs para fechar la captura
+bool uploadQueuedPhoto(const uint8_t *data, size_t len, long ageMs) {
+  return uploadPhoto(data, len, ageMs, NULL);
+}
 
-  http.addHeader("Content-Type", contentType);
-  http.addHeader("Content-Length", String(totalLen));
+// Foto con antigüedad (ageMs < 0: recién tomada) y origen opcional (?trigger=motion)
+bool uploadPhoto(const uint8_t *data, size_t len, long ageMs, const char *trigger,
+                 HttpConnection &conn, int *hippos) {
+  char path[192];
+  int n = snprintf(path, sizeof(path), "%s", urlPath(SERVER_URL_UPLOAD));
+  char sep = '?';
+  if (ageMs >= 0) {
+    n += snprintf(path + n, sizeof(path) - n, "%ccapturedAgeMs=%ld", sep, ageMs);
+    sep = '&';
+  }
+  if (trigger) snprintf(path + n, sizeof(path) - n, "%ctrigger=%s", sep, trigger);
+  return sendJpegToServer(data, len, path, conn, hippos);
+}
 
-  // Crear buffer completo
-  uint8_t *fbBuf = (uint8_t *)malloc(totalLen);
-  if (!fbBuf) {
-    DEBUG_PRINTLN("Error al asignar memoria para envío");
-    http.end();
+// hippos (opcional): "hippoCount" de la respuesta, -1 si no lo trae
+bool sendJpegToServer(const uint8_t *data, size_t len, const char *path, HttpConnection &conn,
+                      int *hippos) {
+  LOG_DEBUG("[HTTP] Preparando envío de imagen...\n");
+  LOG_DEBUG("[HTTP] Ruta: %s\n", path);
+
+  // Sobre multipart: solo cabecera y cola, el JPEG no se copia
+  METRIC_START(t0);
+  MultipartEnvelope env;
+  if (!multipartInit(&env, (uint32_t)random(1000, 9999), "image", "esp32cam.jpg")) {
+    LOG_ERROR("[HTTP] Error al preparar el sobre multipart\n");
     return false;
   }
 
-  // Copiar datos al buffer
-  memcpy(fbBuf, head.c_str(), head.length());
-  memcpy(fbBuf + head.length(), fb->buf, fb->len);
-  memcpy(fbBuf + head.length() + fb->len, tail.c_str(), tail.length());
+  size_t totalLen = multipartBodyLength(&env, len);
+  char contentType[96];
+  multipartContentType(&env, contentType, sizeof(contentType));
+  METRIC_STOP(METRIC_MULTIPART, t0);
 
-  // Enviar petición
-  int httpCode = http.POST(fbBuf, totalLen);
+  LOG_DEBUG("[HTTP] Tamaño total del cuerpo: %u bytes\n", (unsigned)totalLen);
 
-  DEBUG_PRINTF("[HTTP] Respuesta HTTP code: %d\n", httpCode);
+  // Cabeceras y reconexión las gestiona la conexión persistente;
+  // el cuerpo sale del buffer del JPEG sin copias intermedias
+  HttpRequest req = {"POST", path, contentType, totalLen,
+                     writeMultipartBody, NULL, HTTP_TIMEOUT, NULL};
+  MultipartUpload upload = {&env, data, len};
+  req.bodyCtx = &upload;
 
-  // Liberar buffer
-  free(fbBuf);
+  // Solo interesa el principio del cuerpo (ver responseHippoCount)
+  char reply[96];
+  HttpResponse resp = {-1, reply, sizeof(reply), 0};
+  int httpCode = conn.send(req, hippos ? &resp : NULL);
+  if (hippos) *hippos = httpCode >= 200 && httpCode < 300 ? responseHippoCount(resp) : -1;
+
+  LOG_DEBUG("[HTTP] Respuesta HTTP code: %d\n", httpCode);
 
   // Consideramos éxito cualquier 2xx (201 Created en fotos, 200 OK en streaming, etc.)
   bool success = (httpCode >= 200 && httpCode < 300);
 
   if (!success && httpCode > 0) {
-    DEBUG_PRINTF("[HTTP] Error HTTP (esperado 2xx): %d\n", httpCode);
+    LOG_ERROR("[HTTP] Error HTTP (esperado 2xx): %d\n", httpCode);
   } else if (success) {
-    DEBUG_PRINTLN("[HTTP] Petición completada con éxito (2xx)");
+    LOG_DEBUG("[HTTP] Petición completada con éxito (2xx)\n");
   }
 
-  http.end();
-
   return success;
 }
 
+// Resumen de detección de una subida: server.js pone "hippoCount" al principio
+// de la respuesta de /photo y /live-frame, así que basta con los primeros bytes
+// aunque el resto del JSON no quepa en el buffer. -1 si no viene.
+int responseHippoCount(const HttpResponse &resp) {
+  if (!resp.body || resp.bodyLen == 0) return -1;
+  const char *key = strstr(resp.body, "\"hippoCount\":");
+  if (!key) return -1;
+  const char *p = key + strlen("\"hippoCount\":");
+  while (*p == ' ') p++;
+  if (*p < '0' || *p > '9') return -1;
+  return atoi(p);
+}
+
+// Sumidero multipart sobre el socket: WiFiClient::write envía desde el puntero recibido
+size_t clientWrite(void *ctx, const uint8_t *data, size_t len) {
+  return static_cast<Client *>(ctx)->write(data, len);
+}
+
+// Escritor de cuerpo para HttpConnection: cabecera multipart, JPEG y cola
+bool writeMultipartBody(Client &client, void *ctx) {
+  MultipartUpload *upload = static_cast<MultipartUpload *>(ctx);
+  return multipartWrite(upload->env, upload->data, upload->len, clientWrite, &client);
+}
+
+// Escritor de cuerpo para HttpConnection: lote de frames directamente desde los frame buffers
+bool writeFrameBatchBody(Client &client, void *ctx) {
+  FrameBatchUpload *batch = static_cast<FrameBatchUpload *>(ctx);
+  return frameBatchWrite(batch->items, batch->count, clientWrite, &client);
+}
+
+// Escritor de cuerpo para HttpConnection: buffer en memoria (JSON)
+bool writeBufferBody(Client &client, void *ctx) {
+  BufferBody *body = static_cast<BufferBody *>(ctx);
+  return client.write((const uint8_t *)body->data, body->len) == body->len;
+}
+
+// ============================================================================
+// ESTADO Y MÉTRICAS
+// ============================================================================
+
+// Añade s a out[n..]; false si no cabe
+bool appendJson(char *out, size_t cap, size_t &n, const char *s) {
+  size_t len = strlen(s);
+  if (n + len >= cap) return false;
+  memcpy(out + n, s, len);
+  n += len;
+  return true;
+}
+
+// Suma lo escrito por un xxxToJson(); false si no cupo (devolvió 0)
+bool appendWritten(size_t &n, size_t written) {
+  n += written;
+  return written > 0;
+}
+
+// Envía el estado a /status: WiFi, PIR, ráfagas, tiempos de arranque (solo el primero
+// tras un arranque en frío) y métricas. Devuelve true si el servidor lo aceptó.
+bool reportStatus() {
+#if ENABLE_METRICS
+  metricsPrint();
+#endif
+  if (!wifiConnected) return false;
+
+  // {"status":"online","type":"ESP32-CAM","wifi":{...}[,"pir":{...}][,"motionDetect":{...}][,"tinyml":{...}][,"stream":{...}][,"detect":{...}][,"burst":{...}][,"boot":{...}][,"metrics":{...}]}
+  static char json[2048];
+  const size_t cap = sizeof(json) - 1;
+  size_t n = 0;
+  bool ok = appendJson(json, cap, n, "{\"status\":\"online\",\"type\":\"ESP32-CAM\",\"wifi\":") &&
+            appendWritten(n, wifiManagerToJson(json + n, cap - n));
+#if PIR_ENABLED
+  ok = ok && appendJson(json, cap, n, ",\"pir\":") && appendWritten(n, pirToJson(json + n, cap - n));
+#endif
+#if MOTION_DETECT_ENABLED
+  ok = ok && appendJson(json, cap, n, ",\"motionDetect\":") &&
+       appendWritten(n, motionTriggerToJson(json + n, cap - n));
+#endif
+  if (tinymlGateStats().frames > 0) {
+    ok = ok && appendJson(json, cap, n, ",\"tinyml\":") &&
+         appendWritten(n, tinymlGateToJson(json + n, cap - n));
+  }
+  if (streamPipelineStats().endMs) {
+    ok = ok && appendJson(json, cap, n, ",\"stream\":") &&
+         appendWritten(n, streamPipelineToJson(json + n, cap - n));
+  }
+#if DETECT_FEEDBACK
+  if (detectFeedbackStats().results > 0) {
+    ok = ok && appendJson(json, cap, n, ",\"detect\":") &&
+         appendWritten(n, detectFeedbackToJson(json + n, cap - n));
+  }
+#endif
+  if (burstStats().bursts > 0) {
+    ok = ok && appendJson(json, cap, n, ",\"burst\":") &&
+         appendWritten(n, burstToJson(json + n, cap - n));
+  }
+  if (bootReportPending) {
+    ok = ok && appendJson(json, cap, n, ",\"boot\":") &&
+         appendWritten(n, bootTimingToJson(json + n, cap - n));
+  }
+#if ENABLE_METRICS
+  ok = ok && appendJson(json, cap, n, ",\"metrics\":") &&
+       appendWritten(n, metricsToJson(json + n, cap - n));
+#endif
+  if (!ok) {
+    DEBUG_PRINTLN("[STATUS] Informe demasiado grande, se descarta");
+#if ENABLE_METRICS
+    metricsReset();
+#endif
+    return false;
+  }
+  json[n++] = '}';
+
+  BufferBody body = {json, n};
+  HttpRequest req = {"POST", urlPath(SERVER_URL_STATUS), "application/json", n,
+                     writeBufferBody, &body, HTTP_TIMEOUT, NULL};
+  int httpCode = backend.send(req, NULL);
+  // Si falla se acumula hasta el siguiente intento
+  if (httpCode < 200 || httpCode >= 300) return false;
+#if ENABLE_METRICS
+  metricsReset();
+#endif
+  bootReportPending = false;
+  return true;
+}
+
+// ============================================================================
+// ENERGÍA
+// ============================================================================
+
+// Devuelve true si el servidor aceptó la muestra (y se empieza un intervalo nuevo)
+bool reportEnergy() {
+  char json[256];
+  size_t n = powerEnergyToJson(json, sizeof(json));
+  if (n == 0) return false;
+  powerPrintStats();
+
+  BufferBody body = {json, n};
+  HttpRequest req = {"POST", urlPath(SERVER_URL_ENERGY), "application/json", n,
+                     writeBufferBody, &body, HTTP_TIMEOUT, NULL};
+  int httpCode = backend.send(req, NULL);
+  if (httpCode < 200 || httpCode >= 300) {
+    LOG_WARN("[POWER] Error al enviar la muestra de energía: HTTP %d\n", httpCode);
+    return false;
+  }
+  powerEnergyReset();
+  return true;
+}
+
 // ============================================================================
 // UTILIDADES
 // ============================================================================
@@ -472,21 +1401,18 @@ void printStatus() {
   DEBUG_PRINTLN("Estado del sistema:");
   DEBUG_PRINTLN("  WiFi SSID: " + String(WIFI_SSID));
   DEBUG_PRINTLN("  IP Local: " + WiFi.localIP().toString());
+  const WifiStats &wifi = wifiManagerStats();
+  DEBUG_PRINTF("  Conexión WiFi a los %u ms del arranque (%u intentos, %u directos, %u reconexiones)\n",
+               (unsigned)wifi.wakeToConnectMs, (unsigned)wifi.attempts,
+               (unsigned)wifi.fastConnects, (unsigned)wifi.reconnects);
   DEBUG_PRINTLN("  Servidor: " + String(SERVER_IP) + ":" + String(SERVER_PORT));
   DEBUG_PRINTLN("  Resolución captura: " + String(FRAME_SIZE_CAPTURE));
   DEBUG_PRINTLN("  Resolución streaming: " + String(FRAME_SIZE_STREAM));
   DEBUG_PRINTLN("  Calidad JPEG captura: " + String(JPEG_QUALITY_CAPTURE));
   DEBUG_PRINTLN("  Calidad JPEG streaming: " + String(JPEG_QUALITY_STREAM));
   DEBUG_PRINTLN("  Memoria libre: " + String(ESP.getFreeHeap() / 1024) + " KB");
+  DEBUG_PRINTLN("  Fotos en cola offline: " + String((unsigned)offlineQueueCount()));
+  DEBUG_PRINTF("  Reutilización de conexión HTTP: %.0f%% (%u peticiones, media %u ms)\n",
+               backend.reuseRatio() * 100.0f, (unsigned)backend.stats().requests,
+               (unsigned)backend.avgLatencyMs());
 }
-
-void blinkLED(int times, int delayMs) {
-  for (int i = 0; i < times; i++) {
-    digitalWrite(LED_FLASH_PIN, HIGH);
-    delay(delayMs);
-    digitalWrite(LED_FLASH_PIN, LOW);
-    delay(delayMs);
-  }
-}
-
-
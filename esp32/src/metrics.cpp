@@ -0,0 +1,158 @@
+/**
+ * Implementación de las métricas de latencia (ver metrics.h)
+ */
+
+#include "metrics.h"
+
+#if ENABLE_METRICS
+
+#include <atomic>
+
+// Límite superior de cada bucket en microsegundos; el último bucket es el resto
+static const uint32_t kBucketEdgesUs[] = {
+    100,    200,    500,     1000,    2000,    5000,    10000,  20000,
+    50000,  100000, 200000,  500000,  1000000, 2000000, 5000000,
+};
+static const int kEdges = sizeof(kBucketEdgesUs) / sizeof(kBucketEdgesUs[0]);
+static const int kBuckets = kEdges + 1;
+
+static const char *const kStageNames[METRIC_STAGE_COUNT] = {
+    "capture", "multipart", "connect", "httpSend", "httpResponse", "httpTotal", "wsSend",
+};
+static const char *const kCounterNames[METRIC_COUNTER_COUNT] = {
+    "captured", "sent", "received",
+};
+
+// Lo escriben varias tareas a la vez: cada campo se actualiza de forma atómica
+struct StageHistogram {
+  std::atomic<uint32_t> count;
+  std::atomic<uint64_t> sumUs;
+  std::atomic<uint32_t> maxUs;
+  std::atomic<uint32_t> buckets[kBuckets];
+};
+
+// Copia para leer y formatear
+struct StageSnapshot {
+  uint32_t count;
+  uint64_t sumUs;
+  uint32_t maxUs;
+  uint32_t buckets[kBuckets];
+};
+
+static StageHistogram stages[METRIC_STAGE_COUNT];
+static std::atomic<uint64_t> counters[METRIC_COUNTER_COUNT];
+static unsigned long intervalStart = 0;
+
+void metricsRecord(MetricStage stage, uint32_t us) {
+  StageHistogram &h = stages[stage];
+  int b = 0;
+  while (b < kEdges && us > kBucketEdgesUs[b]) b++;
+  h.buckets[b].fetch_add(1, std::memory_order_relaxed);
+  h.count.fetch_add(1, std::memory_order_relaxed);
+  h.sumUs.fetch_add(us, std::memory_order_relaxed);
+  uint32_t max = h.maxUs.load(std::memory_order_relaxed);
+  while (us > max && !h.maxUs.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+  }
+}
+
+void metricsAdd(MetricCounter counter, uint32_t n) {
+  counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+static void snapshot(int stage, StageSnapshot *out) {
+  const StageHistogram &h = stages[stage];
+  out->count = h.count.load(std::memory_order_relaxed);
+  out->sumUs = h.sumUs.load(std::memory_order_relaxed);
+  out->maxUs = h.maxUs.load(std::memory_order_relaxed);
+  for (int b = 0; b < kBuckets; b++) out->buckets[b] = h.buckets[b].load(std::memory_order_relaxed);
+}
+
+// Percentil aproximado: límite superior del bucket donde cae (máximo si es el último)
+static uint32_t percentileUs(const StageSnapshot &h, uint32_t pct) {
+  if (h.count == 0) return 0;
+  uint32_t target = (h.count * pct + 99) / 100;
+  uint32_t seen = 0;
+  for (int b = 0; b < kEdges; b++) {
+    seen += h.buckets[b];
+    if (seen >= target) return min(kBucketEdgesUs[b], h.maxUs);
+  }
+  return h.maxUs;
+}
+
+void metricsReset() {
+  for (int s = 0; s < METRIC_STAGE_COUNT; s++) {
+    StageHistogram &h = stages[s];
+    h.count.store(0, std::memory_order_relaxed);
+    h.sumUs.store(0, std::memory_order_relaxed);
+    h.maxUs.store(0, std::memory_order_relaxed);
+    for (int b = 0; b < kBuckets; b++) h.buckets[b].store(0, std::memory_order_relaxed);
+  }
+  for (int c = 0; c < METRIC_COUNTER_COUNT; c++) counters[c].store(0, std::memory_order_relaxed);
+  intervalStart = millis();
+}
+
+// snprintf acumulativo: deja de escribir (y marca error) en cuanto no cabe
+static bool append(char *out, size_t cap, size_t *n, const char *fmt, ...) {
+  if (*n >= cap) return false;
+  va_list args;
+  va_start(args, fmt);
+  int w = vsnprintf(out + *n, cap - *n, fmt, args);
+  va_end(args);
+  if (w < 0 || (size_t)w >= cap - *n) {
+    *n = cap;
+    return false;
+  }
+  *n += w;
+  return true;
+}
+
+size_t metricsToJson(char *out, size_t cap) {
+  size_t n = 0;
+  append(out, cap, &n, "{\"intervalMs\":%lu,\"bucketsUs\":[", millis() - intervalStart);
+  for (int b = 0; b < kEdges; b++) {
+    append(out, cap, &n, b ? ",%lu" : "%lu", (unsigned long)kBucketEdgesUs[b]);
+  }
+  append(out, cap, &n, "],\"stages\":{");
+
+  bool first = true;
+  for (int s = 0; s < METRIC_STAGE_COUNT; s++) {
+    StageSnapshot h;
+    snapshot(s, &h);
+    if (h.count == 0) continue;
+    append(out, cap, &n,
+           "%s\"%s\":{\"count\":%lu,\"sumUs\":%llu,\"maxUs\":%lu,\"p50Us\":%lu,\"p95Us\":%lu,"
+           "\"buckets\":[",
+           first ? "" : ",", kStageNames[s], (unsigned long)h.count,
+           (unsigned long long)h.sumUs, (unsigned long)h.maxUs,
+           (unsigned long)percentileUs(h, 50), (unsigned long)percentileUs(h, 95));
+    for (int b = 0; b < kBuckets; b++) {
+      append(out, cap, &n, b ? ",%lu" : "%lu", (unsigned long)h.buckets[b]);
+    }
+    append(out, cap, &n, "]}");
+    first = false;
+  }
+
+  append(out, cap, &n, "},\"bytes\":{");
+  for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+    append(out, cap, &n, "%s\"%s\":%llu", c ? "," : "", kCounterNames[c],
+           (unsigned long long)counters[c].load(std::memory_order_relaxed));
+  }
+  return append(out, cap, &n, "}}") ? n : 0;
+}
+
+void metricsPrint() {
+  for (int s = 0; s < METRIC_STAGE_COUNT; s++) {
+    StageSnapshot h;
+    snapshot(s, &h);
+    if (h.count == 0) continue;
+    DEBUG_PRINTF("[METRICS] %-12s n=%-5lu media %7.1f ms  p50 %7.1f ms  p95 %7.1f ms  max %7.1f ms\n",
+                 kStageNames[s], (unsigned long)h.count, h.sumUs / 1000.0 / h.count,
+                 percentileUs(h, 50) / 1000.0, percentileUs(h, 95) / 1000.0, h.maxUs / 1000.0);
+  }
+  DEBUG_PRINTF("[METRICS] Bytes: capturados %llu, enviados %llu, recibidos %llu\n",
+               (unsigned long long)counters[METRIC_BYTES_CAPTURED].load(),
+               (unsigned long long)counters[METRIC_BYTES_SENT].load(),
+               (unsigned long long)counters[METRIC_BYTES_RECEIVED].load());
+}
+
+#endif // ENABLE_METRICS
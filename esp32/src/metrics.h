@@ -0,0 +1,65 @@
+/**
+ * Métricas de latencia por etapa del camino captura -> subida (proyecto TPI2)
+ *
+ * Histograma de buckets fijos (100 us .. 5 s, escala 1-2-5) por etapa más
+ * contadores de bytes, todo en RAM estática. Se envían periódicamente a
+ * /api/cameras/:id/status y se ponen a cero tras cada informe.
+ *
+ * Varias tareas escriben a la vez (durante un streaming la subida usa
+ * `backend` mientras el control usa `streamControl`): cada contador se
+ * actualiza de forma atómica, sin bloqueos. El informe lee campo a campo y
+ * puede ver un instante ligeramente incoherente, lo que es aceptable para
+ * métricas.
+ *
+ * Con ENABLE_METRICS 0 las macros METRIC_* no generan código.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+enum MetricStage {
+  METRIC_CAPTURE,        // esp_camera_fb_get()
+  METRIC_MULTIPART,      // Preparar el sobre multipart
+  METRIC_CONNECT,        // Conexión TCP (solo cuando no se reutiliza el socket)
+  METRIC_HTTP_SEND,      // Cabeceras + cuerpo
+  METRIC_HTTP_RESPONSE,  // Desde el fin del envío hasta leer la respuesta completa
+  METRIC_HTTP_TOTAL,     // Petición completa, reintentos incluidos
+  METRIC_WS_SEND,        // Frame WebSocket
+  METRIC_STAGE_COUNT
+};
+
+enum MetricCounter {
+  METRIC_BYTES_CAPTURED,
+  METRIC_BYTES_SENT,
+  METRIC_BYTES_RECEIVED,
+  METRIC_COUNTER_COUNT
+};
+
+#if ENABLE_METRICS
+
+void metricsRecord(MetricStage stage, uint32_t us);
+void metricsAdd(MetricCounter counter, uint32_t n);
+
+// Escribe {"intervalMs":..,"bucketsUs":[..],"stages":{..},"bytes":{..}} en out.
+// Devuelve la longitud, o 0 si no cabe.
+size_t metricsToJson(char *out, size_t cap);
+
+void metricsReset();
+void metricsPrint();
+
+#define METRIC_START(t)        uint32_t t = micros()
+#define METRIC_STOP(stage, t)  metricsRecord(stage, micros() - (t))
+#define METRIC_ADD(counter, n) metricsAdd(counter, n)
+
+#else
+
+#define METRIC_START(t)
+#define METRIC_STOP(stage, t)
+#define METRIC_ADD(counter, n)
+
+#endif
+
+#endif // METRICS_H
@@ -0,0 +1,111 @@
+/**
+ * Implementación del detector de movimiento (ver motion_detect.h)
+ */
+
+#include "motion_detect.h"
+#include "image_kernels.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+MotionDetector::MotionDetector() : background_(NULL), blockSums_(NULL), warmup_(0) {
+  memset(&params_, 0, sizeof(params_));
+}
+
+MotionDetector::~MotionDetector() {
+  end();
+}
+
+bool MotionDetector::begin(const MotionParams &params) {
+  end();
+  if (params.width == 0 || params.height == 0 || params.blockSize == 0 ||
+      params.width % params.blockSize != 0 || params.height % params.blockSize != 0 ||
+      params.minBlocks == 0 || params.learnShift > 8) {
+    return false;
+  }
+  background_ = (uint16_t *)malloc((size_t)params.width * params.height * sizeof(uint16_t));
+  blockSums_ = (uint32_t *)malloc((size_t)(params.width / params.blockSize) *
+                                  (params.height / params.blockSize) * sizeof(uint32_t));
+  if (!background_ || !blockSums_) {
+    end();
+    return false;
+  }
+  params_ = params;
+  reset();
+  return true;
+}
+
+void MotionDetector::end() {
+  free(background_);
+  free(blockSums_);
+  background_ = NULL;
+  blockSums_ = NULL;
+}
+
+void MotionDetector::reset() {
+  warmup_ = 0;
+}
+
+// Fondo += (frame - fondo) / 2^learnShift; el primer frame lo fija tal cual
+void MotionDetector::learn(const uint8_t *gray) {
+  imgBlendQ8(background_, gray, (size_t)params_.width * params_.height,
+             warmup_ == 0 ? 0 : params_.learnShift);
+}
+
+void MotionDetector::learnBlock(const uint8_t *gray, int bx, int by, int shift) {
+  const int bs = params_.blockSize;
+  for (int y = 0; y < bs; y++) {
+    size_t row = (size_t)(by * bs + y) * params_.width + bx * bs;
+    imgBlendQ8(background_ + row, gray + row, bs, (uint8_t)shift);
+  }
+}
+
+MotionResult MotionDetector::process(const uint8_t *gray) {
+  MotionResult r;
+  memset(&r, 0, sizeof(r));
+  if (!background_) return r;
+
+  const int bs = params_.blockSize;
+  const int cols = params_.width / bs;
+  const int rows = params_.height / bs;
+  r.totalBlocks = (uint16_t)(cols * rows);
+
+  if (warmup_ < params_.warmupFrames || warmup_ == 0) {
+    learn(gray);
+    warmup_++;
+    r.warmingUp = true;
+    return r;
+  }
+
+  // Suma de |frame - fondo| por bloque; cabe en 32 bits hasta bloques de 4096 píxeles.
+  // Después cada bloque se incorpora al fondo: los que cambiaron, 4
+  // veces más despacio, para que un animal que pasa no deje su silueta en el
+  // fondo (y un falso disparo al irse), aunque uno que se queda acaba absorbido.
+  const uint32_t limit = (uint32_t)params_.blockThreshold * bs * bs;
+  const int slowShift = params_.learnShift + 2 > 15 ? 15 : params_.learnShift + 2;
+  imgBlockSadQ8(gray, background_, params_.width, params_.height, (uint8_t)bs, blockSums_);
+  uint32_t maxSum = 0;
+  for (int by = 0; by < rows; by++) {
+    for (int bx = 0; bx < cols; bx++) {
+      uint32_t sum = blockSums_[by * cols + bx];
+      bool changed = sum > limit;
+      if (changed) r.changedBlocks++;
+      if (sum > maxSum) maxSum = sum;
+      learnBlock(gray, bx, by, changed ? slowShift : params_.learnShift);
+    }
+  }
+  r.maxBlockDiff = (uint8_t)(maxSum / (uint32_t)(bs * bs));
+
+  if (params_.maxChangedPct > 0 &&
+      r.changedBlocks * 100u > (uint32_t)params_.maxChangedPct * r.totalBlocks) {
+    // Cambio global: el fondo anterior ya no sirve
+    r.lightingChange = true;
+    warmup_ = 0;
+    learn(gray);
+    warmup_ = 1;
+    return r;
+  }
+
+  r.motion = r.changedBlocks >= params_.minBlocks;
+  return r;
+}
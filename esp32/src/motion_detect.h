@@ -0,0 +1,74 @@
+/**
+ * Detector de movimiento por diferencia con el fondo (proyecto TPI2)
+ *
+ * Trabaja sobre una rejilla en gris de width x height píxeles (la cámara la
+ * obtiene de un JPEG diminuto, ver motion_jpeg.h):
+ *  - Mantiene un fondo que se acerca a cada frame nuevo en 1/2^learnShift
+ *    (punto fijo 8.8, sin coma flotante); 4 veces más despacio en los
+ *    bloques con cambios.
+ *  - Divide la rejilla en bloques de blockSize x blockSize y calcula en cada
+ *    uno la diferencia media con el fondo. Un bloque cambia si supera
+ *    blockThreshold.
+ *  - Hay movimiento con minBlocks bloques cambiados o más. Si cambia más de
+ *    maxChangedPct % de la imagen se trata como un cambio de luz (nube, AE
+ *    del sensor): no dispara y el fondo se reinicia con ese frame.
+ *  - Los primeros warmupFrames frames solo construyen el fondo.
+ *
+ * No tiene dependencias del firmware (se compila igual en el banco de pruebas
+ * del host); no es seguro entre tareas.
+ */
+
+#ifndef MOTION_DETECT_H
+#define MOTION_DETECT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct MotionParams {
+  uint16_t width;
+  uint16_t height;
+  uint8_t blockSize;        // Divide a width y height
+  uint8_t blockThreshold;   // Diferencia media por píxel (0-255)
+  uint16_t minBlocks;
+  uint8_t maxChangedPct;    // 0 = sin filtro de cambios de luz
+  uint8_t learnShift;       // Velocidad del fondo: 1/2^learnShift por frame
+  uint8_t warmupFrames;
+};
+
+struct MotionResult {
+  bool motion;
+  bool lightingChange;      // Demasiados bloques cambiados: fondo reiniciado
+  bool warmingUp;
+  uint16_t changedBlocks;
+  uint16_t totalBlocks;
+  uint8_t maxBlockDiff;     // Mayor diferencia media de un bloque
+};
+
+class MotionDetector {
+ public:
+  MotionDetector();
+  ~MotionDetector();
+
+  // Reserva el fondo. Devuelve false si los parámetros no valen o no hay memoria.
+  bool begin(const MotionParams &params);
+  void end();
+
+  // Olvida el fondo: los próximos frames vuelven a ser de calentamiento
+  void reset();
+
+  // Analiza un frame de width x height bytes y lo incorpora al fondo
+  MotionResult process(const uint8_t *gray);
+
+  const MotionParams &params() const { return params_; }
+
+ private:
+  void learn(const uint8_t *gray);
+  void learnBlock(const uint8_t *gray, int bx, int by, int shift);
+
+  MotionParams params_;
+  uint16_t *background_;    // 8.8: píxel << 8
+  uint32_t *blockSums_;     // |frame - fondo| de cada bloque
+  uint8_t warmup_;
+};
+
+#endif // MOTION_DETECT_H
@@ -0,0 +1,115 @@
+/**
+ * Implementación de la conversión JPEG -> rejilla en gris (ver motion_jpeg.h)
+ */
+
+#include "motion_jpeg.h"
+#include "esp_jpg_decode.h"
+#include "image_kernels.h"
+
+#include <string.h>
+
+struct GrayGrid {
+  const uint8_t *jpeg;
+  size_t len;
+  uint16_t *sums;
+  uint16_t width;
+  uint16_t height;
+  uint16_t srcWidth;      // Tamaño ya decodificado (con la escala aplicada)
+  uint16_t srcHeight;
+};
+
+bool motionJpegSize(const uint8_t *jpeg, size_t len, uint16_t *width, uint16_t *height) {
+  if (len < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) return false;
+  size_t i = 2;
+  while (i + 9 < len) {
+    if (jpeg[i] != 0xFF) {
+      i++;
+      continue;
+    }
+    uint8_t marker = jpeg[i + 1];
+    // Relleno y marcadores sin longitud
+    if (marker == 0xFF || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+      i++;
+      continue;
+    }
+    // SOF0..SOF15, salvo DHT (C4), JPG (C8) y DAC (CC)
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+      *height = (uint16_t)((jpeg[i + 5] << 8) | jpeg[i + 6]);
+      *width = (uint16_t)((jpeg[i + 7] << 8) | jpeg[i + 8]);
+      return *width > 0 && *height > 0;
+    }
+    if (marker == 0xDA) return false;  // Datos de imagen sin SOF antes
+    i += 2 + ((jpeg[i + 2] << 8) | jpeg[i + 3]);
+  }
+  return false;
+}
+
+static size_t readJpeg(void *arg, size_t index, uint8_t *buf, size_t len) {
+  GrayGrid *g = static_cast<GrayGrid *>(arg);
+  if (index >= g->len) return 0;
+  if (len > g->len - index) len = g->len - index;
+  if (buf) memcpy(buf, g->jpeg + index, len);
+  return len;
+}
+
+// Recibe bloques RGB888 del decodificador y los suma, en gris, a su celda
+static bool writeGray(void *arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data) {
+  GrayGrid *g = static_cast<GrayGrid *>(arg);
+  if (!data) {
+    // Inicio (x = y = 0, w x h = imagen completa) o fin de la decodificación
+    if (x == 0 && y == 0) {
+      g->srcWidth = w;
+      g->srcHeight = h;
+      memset(g->sums, 0, (size_t)g->width * g->height * sizeof(uint16_t));
+    }
+    return true;
+  }
+  if (g->srcWidth < g->width || g->srcHeight < g->height) return false;
+
+  // Gris por tramos de fila (image_kernels) y cada píxel a su celda
+  const uint16_t chunk = 64;
+  uint8_t gray[chunk];
+  for (uint16_t iy = 0; iy < h; iy++) {
+    uint16_t *row = g->sums + (size_t)((y + iy) * g->height / g->srcHeight) * g->width;
+    const uint8_t *px = data + (size_t)iy * w * 3;
+    for (uint16_t ix = 0; ix < w; ix += chunk) {
+      uint16_t n = w - ix < chunk ? w - ix : chunk;
+      imgRgb888ToGray(px + (size_t)ix * 3, gray, n);
+      for (uint16_t i = 0; i < n; i++) row[(x + ix + i) * g->width / g->srcWidth] += gray[i];
+    }
+  }
+  return true;
+}
+
+// Píxeles de origen que caen en la celda i de n (reparto de floor(p * n / src))
+static uint32_t cellSpan(uint32_t i, uint32_t n, uint32_t src) {
+  return (uint32_t)(((i + 1) * src + n - 1) / n - (i * src + n - 1) / n);
+}
+
+bool motionJpegToGray(const uint8_t *jpeg, size_t len, uint8_t *gray, uint16_t width,
+                      uint16_t height, uint16_t *scratch) {
+  uint16_t w, h;
+  if (!motionJpegSize(jpeg, len, &w, &h)) return false;
+
+  // La escala más agresiva que no deja la imagen por debajo de la rejilla
+  int scale = JPG_SCALE_8X;
+  while (scale > JPG_SCALE_NONE && ((w >> scale) < width || (h >> scale) < height)) scale--;
+  if ((w >> scale) < width || (h >> scale) < height) return false;
+  // Las sumas por celda son de 16 bits: como mucho 257 píxeles por celda
+  uint32_t perCell = (uint32_t)((w >> scale) / width + 1) * ((h >> scale) / height + 1);
+  if (perCell > 257) return false;
+
+  GrayGrid g = {jpeg, len, scratch, width, height, 0, 0};
+  if (esp_jpg_decode(len, (jpg_scale_t)scale, readJpeg, writeGray, &g) != ESP_OK) return false;
+  if (g.srcWidth < width || g.srcHeight < height) return false;
+
+  for (uint16_t cy = 0; cy < height; cy++) {
+    uint32_t rowsIn = cellSpan(cy, height, g.srcHeight);
+    for (uint16_t cx = 0; cx < width; cx++) {
+      uint32_t n = rowsIn * cellSpan(cx, width, g.srcWidth);
+      size_t i = (size_t)cy * width + cx;
+      gray[i] = n ? (uint8_t)(scratch[i] / n) : 0;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,31 @@
+/**
+ * JPEG -> rejilla en gris para el detector de movimiento (proyecto TPI2)
+ *
+ * El sensor sigue en modo JPEG (los frame buffers se reservaron para JPEG);
+ * para el detector basta un frame diminuto (FRAMESIZE_96X96) que se
+ * decodifica con el decodificador de esp32-camera (esp_jpg_decode) y se
+ * reduce a la rejilla promediando píxeles, sin buffer RGB intermedio:
+ *  - La escala del decodificador (1, 1/2, 1/4, 1/8) se elige para que la
+ *    imagen decodificada no quede más pequeña que la rejilla.
+ *  - Cada bloque RGB888 que entrega el decodificador se suma, ya en gris, a
+ *    su celda; al terminar se divide por los píxeles de cada celda.
+ *
+ * En el host, native/ implementa esp_jpg_decode con libjpeg.
+ */
+
+#ifndef MOTION_JPEG_H
+#define MOTION_JPEG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Ancho y alto del JPEG (marcador SOF). Devuelve false si no lo encuentra.
+bool motionJpegSize(const uint8_t *jpeg, size_t len, uint16_t *width, uint16_t *height);
+
+// Decodifica el JPEG a gray (width x height bytes). scratch: width x height
+// uint16_t de trabajo del llamante. Devuelve false si el JPEG no es válido o
+// es más pequeño que la rejilla.
+bool motionJpegToGray(const uint8_t *jpeg, size_t len, uint8_t *gray, uint16_t width,
+                      uint16_t height, uint16_t *scratch);
+
+#endif // MOTION_JPEG_H
@@ -0,0 +1,229 @@
+/**
+ * Implementación del disparo por movimiento de la cámara (ver motion_trigger.h)
+ */
+
+#include "motion_trigger.h"
+#include "config.h"
+#include "motion_detect.h"
+#include "motion_jpeg.h"
+#include "preroll.h"
+#include "esp_camera.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+static MotionDetector detector;
+static SemaphoreHandle_t lock = NULL; // Protege cámara, detector y pauseDepth
+static int pauseDepth = 0;
+static bool applyMode = false;        // Volver a MOTION_FRAME_SIZE antes de capturar
+static bool ownTask = false;
+static bool started = false;
+static volatile bool resetPending = false;
+static volatile bool triggerPending = false;
+static volatile unsigned long triggerAt = 0;
+static MotionTriggerStats stats;
+
+#if MOTION_DETECT_ENABLED && !LOW_POWER_MODE
+
+// ============================================================================
+// ANÁLISIS
+// ============================================================================
+
+static uint8_t *gray = NULL;          // Rejilla del frame actual
+static uint16_t *scratch = NULL;      // Sumas por celda de motion_jpeg
+static unsigned long lastTriggerMs = 0;
+
+// Un JPEG (de la tarea propia o del pre-roll): gris, detector y disparo
+static void analyze(const uint8_t *jpeg, size_t len) {
+  if (resetPending) {
+    resetPending = false;
+    detector.reset();
+  }
+
+  unsigned long t0 = micros();
+  if (!motionJpegToGray(jpeg, len, gray, MOTION_GRID_WIDTH, MOTION_GRID_HEIGHT, scratch)) {
+    stats.errors++;
+    return;
+  }
+  unsigned long t1 = micros();
+  MotionResult r = detector.process(gray);
+  unsigned long t2 = micros();
+
+  stats.frames++;
+  stats.sumDecodeUs += t1 - t0;
+  stats.sumDetectUs += t2 - t1;
+  if (t2 - t0 > stats.maxFrameUs) stats.maxFrameUs = t2 - t0;
+  if (r.warmingUp) return;
+  stats.lastChangedBlocks = r.changedBlocks;
+  stats.lastMaxBlockDiff = r.maxBlockDiff;
+  if (r.lightingChange) stats.lightingChanges++;
+  if (!r.motion) return;
+
+  unsigned long now = millis();
+  if (stats.triggers > 0 && now - lastTriggerMs < MOTION_COOLDOWN_MS) {
+    stats.suppressed++;
+    return;
+  }
+  lastTriggerMs = now;
+  stats.triggers++;
+  triggerAt = now;
+  triggerPending = true;
+  LOG_INFO("[MOTION] Movimiento: %u/%u bloques cambiados (máx %u)\n", (unsigned)r.changedBlocks,
+           (unsigned)r.totalBlocks, (unsigned)r.maxBlockDiff);
+}
+
+// Frames del pre-roll (su tarea tiene el lock del pre-roll, no hace falta el nuestro)
+static void onPrerollFrame(const uint8_t *data, size_t len) {
+  if (pauseDepth == 0) analyze(data, len);
+}
+
+static void setMotionMode() {
+  sensor_t *s = esp_camera_sensor_get();
+  if (s != NULL) {
+    s->set_framesize(s, MOTION_FRAME_SIZE);
+    s->set_quality(s, MOTION_JPEG_QUALITY);
+  }
+  // El frame que ya estaba en el buffer es de la resolución anterior
+  camera_fb_t *stale = esp_camera_fb_get();
+  if (stale) esp_camera_fb_return(stale);
+}
+
+static void motionTask(void *) {
+  TickType_t lastWake = xTaskGetTickCount();
+  for (;;) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (pauseDepth == 0) {
+      if (applyMode) {
+        setMotionMode();
+        applyMode = false;
+      }
+      camera_fb_t *fb = esp_camera_fb_get();
+      if (fb) {
+        analyze(fb->buf, fb->len);
+        esp_camera_fb_return(fb);
+      } else {
+        stats.errors++;
+      }
+    }
+    xSemaphoreGive(lock);
+
+    TickType_t now = xTaskGetTickCount();
+    TickType_t period = pdMS_TO_TICKS(MOTION_CHECK_INTERVAL);
+    if (now - lastWake < period) vTaskDelay(period - (now - lastWake));
+    lastWake = xTaskGetTickCount();
+  }
+}
+
+static void *allocBuffer(size_t size) {
+  return psramFound() ? ps_malloc(size) : malloc(size);
+}
+
+#endif // MOTION_DETECT_ENABLED && !LOW_POWER_MODE
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+
+bool motionTriggerBegin() {
+#if MOTION_DETECT_ENABLED && !LOW_POWER_MODE
+  if (started) return true;
+  const MotionParams params = {MOTION_GRID_WIDTH,      MOTION_GRID_HEIGHT, MOTION_BLOCK_SIZE,
+                               MOTION_BLOCK_THRESHOLD, MOTION_MIN_BLOCKS,  MOTION_MAX_CHANGED_PCT,
+                               MOTION_LEARN_SHIFT,     MOTION_WARMUP_FRAMES};
+  const size_t cells = (size_t)MOTION_GRID_WIDTH * MOTION_GRID_HEIGHT;
+  gray = (uint8_t *)allocBuffer(cells);
+  scratch = (uint16_t *)allocBuffer(cells * sizeof(uint16_t));
+  lock = xSemaphoreCreateMutex();
+  if (!gray || !scratch || !lock || !detector.begin(params)) {
+    DEBUG_PRINTLN("[MOTION] Sin memoria para el detector");
+    free(gray);
+    free(scratch);
+    gray = NULL;
+    scratch = NULL;
+    return false;
+  }
+
+  // Con pre-roll se analizan sus frames; sin él, una tarea propia
+  ownTask = !prerollCapturing();
+  if (!ownTask) {
+    prerollSetFrameHook(onPrerollFrame);
+  } else {
+    applyMode = true;
+    if (xTaskCreatePinnedToCore(motionTask, "motion", MOTION_TASK_STACK, NULL,
+                                MOTION_TASK_PRIORITY, NULL, STREAM_CAPTURE_CORE) != pdPASS) {
+      detector.end();
+      return false;
+    }
+  }
+  started = true;
+  DEBUG_PRINTF("[MOTION] Detector activo (%s, rejilla %dx%d, bloques de %d)\n",
+               ownTask ? "frames propios" : "frames del pre-roll", MOTION_GRID_WIDTH,
+               MOTION_GRID_HEIGHT, MOTION_BLOCK_SIZE);
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool motionTriggerCapturing() {
+  return started && ownTask && pauseDepth == 0;
+}
+
+void motionTriggerPause() {
+  if (!started) return;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  pauseDepth++;
+  xSemaphoreGive(lock);
+}
+
+void motionTriggerResume() {
+  if (!started) return;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (pauseDepth > 0 && --pauseDepth == 0) {
+    applyMode = ownTask;
+    resetPending = true;
+  }
+  xSemaphoreGive(lock);
+}
+
+bool motionTriggerTake(unsigned long *triggerMs) {
+  if (!triggerPending) return false;
+  *triggerMs = triggerAt;
+  triggerPending = false;
+  return true;
+}
+
+bool motionTriggerPending() {
+  return triggerPending;
+}
+
+const MotionTriggerStats &motionTriggerStats() {
+  return stats;
+}
+
+size_t motionTriggerToJson(char *out, size_t cap) {
+  uint32_t n = stats.frames ? stats.frames : 1;
+  int len = snprintf(out, cap,
+                     "{\"frames\":%u,\"triggers\":%u,\"suppressed\":%u,\"lightingChanges\":%u,"
+                     "\"errors\":%u,\"lastChangedBlocks\":%u,\"lastMaxBlockDiff\":%u,"
+                     "\"avgDecodeUs\":%u,\"avgDetectUs\":%u,\"maxFrameUs\":%u}",
+                     (unsigned)stats.frames, (unsigned)stats.triggers, (unsigned)stats.suppressed,
+                     (unsigned)stats.lightingChanges, (unsigned)stats.errors,
+                     (unsigned)stats.lastChangedBlocks, (unsigned)stats.lastMaxBlockDiff,
+                     (unsigned)(stats.sumDecodeUs / n), (unsigned)(stats.sumDetectUs / n),
+                     (unsigned)stats.maxFrameUs);
+  return (len > 0 && (size_t)len < cap) ? (size_t)len : 0;
+}
+
+void motionTriggerPrintStats() {
+  if (!started) return;
+  uint32_t n = stats.frames ? stats.frames : 1;
+  DEBUG_PRINTF("[MOTION] Frames: %u, disparos: %u (ignorados %u), cambios de luz: %u, "
+               "errores: %u\n",
+               (unsigned)stats.frames, (unsigned)stats.triggers, (unsigned)stats.suppressed,
+               (unsigned)stats.lightingChanges, (unsigned)stats.errors);
+  DEBUG_PRINTF("[MOTION] Por frame: decodificar %u us, detectar %u us (peor %u us)\n",
+               (unsigned)(stats.sumDecodeUs / n), (unsigned)(stats.sumDetectUs / n),
+               (unsigned)stats.maxFrameUs);
+}
@@ -0,0 +1,62 @@
+/**
+ * Disparo por movimiento visto por la propia cámara (proyecto TPI2)
+ *
+ * Sin PIR, la cámara solo capturaba cuando el servidor lo pedía. Con
+ * MOTION_DETECT_ENABLED una tarea toma cada MOTION_CHECK_INTERVAL un JPEG
+ * diminuto (MOTION_FRAME_SIZE), lo pasa a una rejilla en gris (motion_jpeg.h)
+ * y lo compara con el fondo (motion_detect.h). Con movimiento deja un
+ * disparo pendiente que loop() recoge con motionTriggerTake(), igual que el
+ * del PIR.
+ *
+ * Con el pre-roll activo no hay tarea propia: se analizan los frames que ya
+ * captura el pre-roll, sin tocar el sensor.
+ *
+ * main pausa el análisis mientras usa la cámara (cameraAcquire); al reanudar,
+ * el fondo se reconstruye porque la exposición pudo cambiar entretanto.
+ */
+
+#ifndef MOTION_TRIGGER_H
+#define MOTION_TRIGGER_H
+
+#include <Arduino.h>
+
+struct MotionTriggerStats {
+  uint32_t frames;            // Frames analizados
+  uint32_t triggers;
+  uint32_t suppressed;        // Movimiento durante el enfriamiento
+  uint32_t lightingChanges;
+  uint32_t errors;            // Sin frame o JPEG no decodificable
+  uint32_t lastChangedBlocks;
+  uint32_t lastMaxBlockDiff;
+  uint64_t sumDecodeUs;
+  uint64_t sumDetectUs;
+  uint32_t maxFrameUs;        // Decodificación + detección, el peor frame
+};
+
+// Reserva memoria y arranca el análisis (cámara inicializada, después de prerollBegin).
+// Devuelve false si está desactivado o no hay memoria.
+bool motionTriggerBegin();
+
+// ¿La tarea propia tiene ahora el sensor (en MOTION_FRAME_SIZE)?
+bool motionTriggerCapturing();
+
+// Detiene el análisis (admite anidamiento) y espera a que suelte la cámara
+void motionTriggerPause();
+
+// Deshace una pausa; con la última, vuelve al modo del detector y rehace el fondo
+void motionTriggerResume();
+
+// Si hay un disparo pendiente, lo consume y devuelve true; *triggerMs = millis() del frame
+bool motionTriggerTake(unsigned long *triggerMs);
+
+// ¿Hay un disparo pendiente? No lo consume (sirve para cortar el long-poll)
+bool motionTriggerPending();
+
+const MotionTriggerStats &motionTriggerStats();
+
+// Escribe {"frames":..,"triggers":..,...} en out. Devuelve la longitud (0 si no cabe).
+size_t motionTriggerToJson(char *out, size_t cap);
+
+void motionTriggerPrintStats();
+
+#endif // MOTION_TRIGGER_H
@@ -0,0 +1,59 @@
+/**
+ * Implementación del sobre multipart/form-data sin copias (ver multipart.h)
+ */
+
+#include "multipart.h"
+
+#include <stdio.h>
+#include <string.h>
+
+bool multipartInit(MultipartEnvelope *env, uint32_t nonce,
+                   const char *fieldName, const char *fileName) {
+  if (!env || !fieldName || !fileName) return false;
+
+  int n = snprintf(env->boundary, sizeof(env->boundary), "ESP32CAM-%lu", (unsigned long)nonce);
+  if (n <= 0 || (size_t)n >= sizeof(env->boundary)) return false;
+
+  n = snprintf(env->head, sizeof(env->head),
+               "--%s\r\n"
+               "Content-Disposition: form-data; name=\"%s\"; filename=\"%s\"\r\n"
+               "Content-Type: image/jpeg\r\n\r\n",
+               env->boundary, fieldName, fileName);
+  if (n <= 0 || (size_t)n >= sizeof(env->head)) return false;
+  env->headLen = (size_t)n;
+
+  n = snprintf(env->tail, sizeof(env->tail), "\r\n--%s--\r\n", env->boundary);
+  if (n <= 0 || (size_t)n >= sizeof(env->tail)) return false;
+  env->tailLen = (size_t)n;
+
+  return true;
+}
+
+size_t multipartBodyLength(const MultipartEnvelope *env, size_t payloadLen) {
+  return env->headLen + payloadLen + env->tailLen;
+}
+
+size_t multipartContentType(const MultipartEnvelope *env, char *out, size_t cap) {
+  int n = snprintf(out, cap, "multipart/form-data; boundary=%s", env->boundary);
+  if (n <= 0 || (size_t)n >= cap) return 0;
+  return (size_t)n;
+}
+
+// Escribe un tramo completo, reintentando escrituras parciales
+static bool writeAll(MultipartWriteFn write, void *ctx, const uint8_t *data, size_t len) {
+  while (len > 0) {
+    size_t written = write(ctx, data, len);
+    if (written == 0) return false;
+    data += written;
+    len -= written;
+  }
+  return true;
+}
+
+bool multipartWrite(const MultipartEnvelope *env, const uint8_t *payload, size_t payloadLen,
+                    MultipartWriteFn write, void *ctx) {
+  if (!writeAll(write, ctx, (const uint8_t *)env->head, env->headLen)) return false;
+  // El JPEG sale directamente del frame buffer de la cámara
+  if (!writeAll(write, ctx, payload, payloadLen)) return false;
+  return writeAll(write, ctx, (const uint8_t *)env->tail, env->tailLen);
+}
@@ -0,0 +1,53 @@
+/**
+ * Sobre multipart/form-data para subir imágenes JPEG (proyecto TPI2)
+ *
+ * En lugar de copiar el JPEG completo a un buffer intermedio junto con la
+ * cabecera y la cola multipart, este módulo solo prepara esas dos piezas
+ * (unos pocos cientos de bytes, en la pila) y escribe el cuerpo en tres
+ * tramos sobre un "sumidero": cabecera, datos del frame tal cual, y cola.
+ *
+ * No depende de Arduino para poder compilarse también en el host
+ * (ver `bench/upload_bench.cpp`).
+ */
+
+#ifndef MULTIPART_H
+#define MULTIPART_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Tamaños máximos de las piezas del sobre (incluyen el terminador '\0')
+#define MULTIPART_BOUNDARY_MAX 40
+#define MULTIPART_HEAD_MAX     256
+#define MULTIPART_TAIL_MAX     (MULTIPART_BOUNDARY_MAX + 8)
+
+struct MultipartEnvelope {
+  char boundary[MULTIPART_BOUNDARY_MAX];
+  char head[MULTIPART_HEAD_MAX];
+  char tail[MULTIPART_TAIL_MAX];
+  size_t headLen;
+  size_t tailLen;
+};
+
+// Función de escritura del sumidero (socket, contador, etc.).
+// Devuelve cuántos bytes aceptó; un valor menor que `len` se reintenta,
+// y 0 se interpreta como error.
+typedef size_t (*MultipartWriteFn)(void *ctx, const uint8_t *data, size_t len);
+
+// Prepara la cabecera y la cola de una única parte de fichero.
+// `nonce` diferencia el boundary entre peticiones.
+bool multipartInit(MultipartEnvelope *env, uint32_t nonce,
+                   const char *fieldName, const char *fileName);
+
+// Longitud total del cuerpo (para la cabecera Content-Length)
+size_t multipartBodyLength(const MultipartEnvelope *env, size_t payloadLen);
+
+// Escribe "multipart/form-data; boundary=..." en `out`. Devuelve la longitud.
+size_t multipartContentType(const MultipartEnvelope *env, char *out, size_t cap);
+
+// Escribe cabecera + payload + cola en el sumidero sin copias intermedias.
+// Devuelve false si el sumidero deja de aceptar datos.
+bool multipartWrite(const MultipartEnvelope *env, const uint8_t *payload, size_t payloadLen,
+                    MultipartWriteFn write, void *ctx);
+
+#endif // MULTIPART_H
@@ -0,0 +1,343 @@
+/**
+ * Implementación de la cola offline (ver offline_queue.h)
+ */
+
+#include "offline_queue.h"
+#include "config.h"
+
+#if OFFLINE_QUEUE_STORAGE == OFFLINE_STORAGE_PSRAM
+#include "frame_ring.h"
+#elif OFFLINE_QUEUE_STORAGE == OFFLINE_STORAGE_SD
+#include "FS.h"
+#include "SD_MMC.h"
+#endif
+
+static bool ready = false;
+
+static struct {
+  uint32_t queued;
+  uint32_t sent;
+  uint32_t evicted;
+  uint32_t rejected;   // No cabían o error de almacenamiento
+  uint32_t corrupt;    // Entradas ilegibles descartadas
+} stats;
+
+// Resultado de leer la entrada más antigua
+enum PeekResult {
+  PEEK_OK,
+  PEEK_CORRUPT,        // Ilegible: se descarta
+  PEEK_RETRY,          // Sin memoria o fallo de la SD: se reintenta en la siguiente tanda
+};
+
+#if OFFLINE_QUEUE_STORAGE == OFFLINE_STORAGE_PSRAM
+
+// ============================================================================
+// ALMACENAMIENTO EN PSRAM
+// ============================================================================
+
+static FrameRing ring;
+
+static bool storeBegin() {
+  return ring.begin(OFFLINE_QUEUE_BYTES);
+}
+
+static size_t storeCount() {
+  return ring.count();
+}
+
+static void storePop() {
+  ring.pop();
+}
+
+static bool storePush(const uint8_t *data, size_t len) {
+  if (len > ring.maxFrameLen()) return false;
+  while (ring.count() >= OFFLINE_QUEUE_MAX_ITEMS) {
+    ring.pop();
+    stats.evicted++;
+  }
+  uint32_t before = ring.evicted();
+  bool ok = ring.push(data, len, millis());
+  stats.evicted += ring.evicted() - before;
+  return ok;
+}
+
+// Sin copia: los datos apuntan dentro del anillo
+static PeekResult storePeek(const uint8_t **data, size_t *len, long *ageMs, uint8_t **owned) {
+  uint32_t capturedMs;
+  *owned = NULL;
+  if (!ring.peek(data, len, &capturedMs)) return PEEK_CORRUPT;
+  *ageMs = (long)(millis() - capturedMs);
+  return PEEK_OK;
+}
+
+static void storePrintUsage() {
+  DEBUG_PRINTF("[QUEUE] PSRAM: %u KB de %u KB\n", (unsigned)(ring.bytesUsed() / 1024),
+               (unsigned)(ring.capacity() / 1024));
+}
+
+#elif OFFLINE_QUEUE_STORAGE == OFFLINE_STORAGE_SD
+
+// ============================================================================
+// ALMACENAMIENTO EN MICROSD
+// ============================================================================
+
+// Cada foto es un fichero OFFLINE_SD_DIR/<secuencia>.jpg con esta cabecera
+// delante del JPEG. El identificador de arranque permite saber si el instante
+// de captura (millis) es de este arranque o de uno anterior.
+struct SdHeader {
+  uint32_t magic;
+  uint32_t bootTag;
+  uint32_t capturedMs;
+};
+static const uint32_t SD_MAGIC = 0x31305148;  // "HQ01"
+
+static uint32_t bootTag;
+static uint32_t headSeq;   // Fichero más antiguo (puede haber huecos hasta nextSeq)
+static uint32_t nextSeq;
+static size_t sdCount;
+static uint64_t sdBytes;
+
+static void sdPath(char *out, size_t cap, uint32_t seq) {
+  snprintf(out, cap, OFFLINE_SD_DIR "/%08lu.jpg", (unsigned long)seq);
+}
+
+static bool storeBegin() {
+  // Modo 1 bit: no usa GPIO 4 (flash) ni GPIO 12 / 13
+  if (!SD_MMC.begin("/sdcard", true) || SD_MMC.cardType() == CARD_NONE) {
+    DEBUG_PRINTLN("[QUEUE] No hay tarjeta microSD");
+    return false;
+  }
+  if (!SD_MMC.exists(OFFLINE_SD_DIR) && !SD_MMC.mkdir(OFFLINE_SD_DIR)) return false;
+
+  bootTag = (uint32_t)random(1, 0x7FFFFFFF);
+  sdCount = 0;
+  sdBytes = 0;
+
+  // Recuperar la cola que quedó de arranques anteriores
+  uint32_t minSeq = UINT32_MAX;
+  uint32_t maxSeq = 0;
+  File root = SD_MMC.open(OFFLINE_SD_DIR);
+  File f = root.openNextFile();
+  while (f) {
+    const char *name = f.name();
+    const char *slash = strrchr(name, '/');
+    uint32_t seq = strtoul(slash ? slash + 1 : name, NULL, 10);
+    if (seq < minSeq) minSeq = seq;
+    if (seq > maxSeq) maxSeq = seq;
+    sdCount++;
+    sdBytes += f.size();
+    f.close();
+    f = root.openNextFile();
+  }
+  root.close();
+
+  headSeq = sdCount ? minSeq : 0;
+  nextSeq = sdCount ? maxSeq + 1 : 0;
+  if (sdCount) {
+    DEBUG_PRINTF("[QUEUE] %u fotos pendientes en la SD\n", (unsigned)sdCount);
+  }
+  return true;
+}
+
+static size_t storeCount() {
+  return sdCount;
+}
+
+// Avanza headSeq hasta el primer fichero que exista
+static bool sdFindHead(char *path, size_t cap) {
+  while (sdCount > 0 && headSeq < nextSeq) {
+    sdPath(path, cap, headSeq);
+    if (SD_MMC.exists(path)) return true;
+    headSeq++;
+  }
+  sdCount = 0;
+  sdBytes = 0;
+  return false;
+}
+
+static void storePop() {
+  char path[40];
+  if (!sdFindHead(path, sizeof(path))) return;
+
+  File f = SD_MMC.open(path, FILE_READ);
+  size_t size = f ? f.size() : 0;
+  if (f) f.close();
+  SD_MMC.remove(path);
+
+  headSeq++;
+  sdCount--;
+  sdBytes = sdBytes > size ? sdBytes - size : 0;
+}
+
+static bool storePush(const uint8_t *data, size_t len) {
+  size_t size = sizeof(SdHeader) + len;
+  if (size > OFFLINE_SD_MAX_BYTES) return false;
+  while (sdCount > 0 && (sdCount >= OFFLINE_QUEUE_MAX_ITEMS || sdBytes + size > OFFLINE_SD_MAX_BYTES)) {
+    storePop();
+    stats.evicted++;
+  }
+
+  char path[40];
+  sdPath(path, sizeof(path), nextSeq);
+  File f = SD_MMC.open(path, FILE_WRITE);
+  if (!f) return false;
+
+  SdHeader h = {SD_MAGIC, bootTag, (uint32_t)millis()};
+  bool ok = f.write((const uint8_t *)&h, sizeof(h)) == sizeof(h) && f.write(data, len) == len;
+  f.close();
+  if (!ok) {
+    SD_MMC.remove(path);
+    return false;
+  }
+
+  if (sdCount == 0) headSeq = nextSeq;
+  nextSeq++;
+  sdCount++;
+  sdBytes += size;
+  return true;
+}
+
+// El JPEG se lee a un buffer temporal que el llamador libera (owned). Solo
+// una entrada demasiado corta o sin SD_MAGIC es corrupta; no poder abrirla,
+// reservar el buffer o leerla entera se reintenta más tarde.
+static PeekResult storePeek(const uint8_t **data, size_t *len, long *ageMs, uint8_t **owned) {
+  *owned = NULL;
+  char path[40];
+  if (!sdFindHead(path, sizeof(path))) return PEEK_RETRY;
+
+  File f = SD_MMC.open(path, FILE_READ);
+  if (!f) return PEEK_RETRY;
+
+  SdHeader h;
+  size_t size = f.size();
+  if (size <= sizeof(h)) {
+    f.close();
+    return PEEK_CORRUPT;
+  }
+  if (f.read((uint8_t *)&h, sizeof(h)) != sizeof(h)) {
+    f.close();
+    return PEEK_RETRY;
+  }
+  if (h.magic != SD_MAGIC) {
+    f.close();
+    return PEEK_CORRUPT;
+  }
+
+  size -= sizeof(h);
+  uint8_t *buf = (uint8_t *)(psramFound() ? ps_malloc(size) : malloc(size));
+  bool ok = buf != NULL && f.read(buf, size) == size;
+  f.close();
+  if (!ok) {
+    free(buf);
+    return PEEK_RETRY;
+  }
+
+  *data = buf;
+  *len = size;
+  *ageMs = h.bootTag == bootTag ? (long)(millis() - h.capturedMs) : -1;
+  *owned = buf;
+  return PEEK_OK;
+}
+
+static void storePrintUsage() {
+  DEBUG_PRINTF("[QUEUE] SD: %u KB de %u KB\n", (unsigned)(sdBytes / 1024),
+               (unsigned)(OFFLINE_SD_MAX_BYTES / 1024));
+}
+
+#else
+
+// ============================================================================
+// SIN ALMACENAMIENTO
+// ============================================================================
+
+static bool storeBegin() { return false; }
+static size_t storeCount() { return 0; }
+static void storePop() {}
+static bool storePush(const uint8_t *, size_t) { return false; }
+static PeekResult storePeek(const uint8_t **, size_t *, long *, uint8_t **owned) {
+  *owned = NULL;
+  return PEEK_RETRY;
+}
+static void storePrintUsage() {}
+
+#endif
+
+// ============================================================================
+// API
+// ============================================================================
+
+bool offlineQueueBegin() {
+  memset(&stats, 0, sizeof(stats));
+  ready = storeBegin();
+  if (!ready && OFFLINE_QUEUE_STORAGE != OFFLINE_STORAGE_NONE) {
+    DEBUG_PRINTLN("[QUEUE] Cola offline no disponible");
+  }
+  return ready;
+}
+
+bool offlineQueuePush(const uint8_t *data, size_t len) {
+  if (!ready || !data || len == 0) return false;
+
+  if (!storePush(data, len)) {
+    stats.rejected++;
+    DEBUG_PRINTF("[QUEUE] ✗ No se pudo guardar la foto (%u bytes)\n", (unsigned)len);
+    return false;
+  }
+  stats.queued++;
+  DEBUG_PRINTF("[QUEUE] Foto guardada para reenvío (%u en cola)\n", (unsigned)storeCount());
+  return true;
+}
+
+size_t offlineQueueCount() {
+  return ready ? storeCount() : 0;
+}
+
+int offlineQueueDrain(OfflineUploadFn upload, int maxItems, unsigned long budgetMs) {
+  if (!ready || !upload) return 0;
+
+  unsigned long start = millis();
+  int sent = 0;
+  while (sent < maxItems && storeCount() > 0 && millis() - start < budgetMs) {
+    const uint8_t *data = NULL;
+    size_t len = 0;
+    long ageMs = -1;
+    uint8_t *owned = NULL;
+    PeekResult peek = storePeek(&data, &len, &ageMs, &owned);
+    if (peek == PEEK_CORRUPT) {
+      // Entrada ilegible: se descarta para no bloquear la cola
+      storePop();
+      stats.corrupt++;
+      continue;
+    }
+    if (peek == PEEK_RETRY) {
+      // Falta de memoria o fallo pasajero de la SD: la foto sigue en cola
+      DEBUG_PRINTF("[QUEUE] No se pudo leer la foto más antigua, %u siguen en cola\n",
+                   (unsigned)storeCount());
+      return -1;
+    }
+
+    bool ok = upload(data, len, ageMs);
+    free(owned);
+    if (!ok) {
+      DEBUG_PRINTF("[QUEUE] Reenvío fallido, %u fotos siguen en cola\n", (unsigned)storeCount());
+      return -1;
+    }
+    storePop();
+    stats.sent++;
+    sent++;
+  }
+
+  if (sent > 0) {
+    DEBUG_PRINTF("[QUEUE] %d fotos reenviadas, %u en cola\n", sent, (unsigned)storeCount());
+  }
+  return sent;
+}
+
+void offlineQueuePrintStats() {
+  if (!ready) return;
+  DEBUG_PRINTF("[QUEUE] En cola: %u, guardadas: %u, reenviadas: %u, expulsadas: %u, "
+               "rechazadas: %u, corruptas: %u\n",
+               (unsigned)storeCount(), (unsigned)stats.queued, (unsigned)stats.sent,
+               (unsigned)stats.evicted, (unsigned)stats.rejected, (unsigned)stats.corrupt);
+  storePrintUsage();
+}
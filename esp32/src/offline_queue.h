@@ -0,0 +1,37 @@
+/**
+ * Cola offline de fotos (store-and-forward) (proyecto TPI2)
+ *
+ * Antes, una foto que no se podía subir (WiFi caído o error del servidor) se
+ * perdía. Ahora se guarda en la cola y se reenvía más tarde:
+ *  - Tamaño acotado (OFFLINE_QUEUE_MAX_ITEMS y bytes); al llenarse se expulsa
+ *    la foto más antigua.
+ *  - Almacenamiento según OFFLINE_QUEUE_STORAGE: anillo en PSRAM
+ *    (frame_ring.h) o ficheros en la microSD, que sobreviven a un reinicio.
+ *  - El vaciado va por tandas (OFFLINE_DRAIN_BATCH, OFFLINE_DRAIN_BUDGET_MS)
+ *    para que el bucle principal siga atendiendo al canal de control.
+ */
+
+#ifndef OFFLINE_QUEUE_H
+#define OFFLINE_QUEUE_H
+
+#include <Arduino.h>
+
+// Sube una foto de la cola. ageMs es el tiempo desde la captura, o -1 si no se
+// conoce (fotos guardadas en la SD antes de un reinicio).
+typedef bool (*OfflineUploadFn)(const uint8_t *data, size_t len, long ageMs);
+
+// Prepara el almacenamiento. Devuelve false si no está disponible.
+bool offlineQueueBegin();
+
+// Copia una foto a la cola (instante de captura = ahora)
+bool offlineQueuePush(const uint8_t *data, size_t len);
+
+size_t offlineQueueCount();
+
+// Sube hasta maxItems fotos, las más antiguas primero, sin pasar de budgetMs.
+// Devuelve cuántas se enviaron, o -1 si una subida falló (la foto sigue en cola).
+int offlineQueueDrain(OfflineUploadFn upload, int maxItems, unsigned long budgetMs);
+
+void offlineQueuePrintStats();
+
+#endif // OFFLINE_QUEUE_H
@@ -0,0 +1,121 @@
+/**
+ * Implementación del disparo por PIR (ver pir.h)
+ */
+
+#include "pir.h"
+#include "config.h"
+#include "power.h"
+
+#include <driver/gpio.h>
+
+RTC_DATA_ATTR static PirStats stats;
+
+#if PIR_ENABLED
+
+RTC_DATA_ATTR static uint64_t lastTriggerClockMs;  // powerClockMs() del último disparo atendido
+
+static volatile bool edgePending = false;
+static volatile unsigned long edgeMs = 0;
+
+static void IRAM_ATTR onPirEdge() {
+  if (!edgePending) {
+    edgeMs = millis();
+    edgePending = true;
+  }
+}
+
+static bool coolingDown() {
+  return stats.triggers > 0 && powerClockMs() - lastTriggerClockMs < PIR_COOLDOWN_MS;
+}
+
+#endif // PIR_ENABLED
+
+void pirBegin() {
+#if PIR_ENABLED
+  pinMode(PIR_PIN, PIR_ACTIVE_LEVEL ? INPUT_PULLDOWN : INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(PIR_PIN), onPirEdge, PIR_ACTIVE_LEVEL ? RISING : FALLING);
+#endif
+}
+
+bool pirTakeTrigger(unsigned long *triggerMs) {
+#if PIR_ENABLED
+  // Un PIR que sigue activo cuenta como disparo (el flanco pudo llegar mientras
+  // se preparaba el sueño, cuando ext0 no se puede armar)
+  unsigned long at = 0;
+  bool wake = powerTakeMotionWake(&at);
+  bool active = digitalRead(PIR_PIN) == PIR_ACTIVE_LEVEL;
+  if (!wake && !edgePending && !active) return false;
+
+  // El despertar es el propio flanco: el que llegue después por interrupción es el mismo
+  if (!wake) at = edgePending ? edgeMs : millis();
+  edgePending = false;
+  if (coolingDown()) return false;
+
+  stats.triggers++;
+  if (wake) stats.wakeTriggers++;
+  lastTriggerClockMs = powerClockMs();
+  *triggerMs = at;
+  return true;
+#else
+  (void)triggerMs;
+  return false;
+#endif
+}
+
+bool pirTriggerPending() {
+#if PIR_ENABLED
+  return (edgePending || digitalRead(PIR_PIN) == PIR_ACTIVE_LEVEL) && !coolingDown();
+#else
+  return false;
+#endif
+}
+
+bool pirWakeAllowed() {
+#if PIR_ENABLED
+  return !coolingDown() && digitalRead(PIR_PIN) != PIR_ACTIVE_LEVEL;
+#else
+  return false;
+#endif
+}
+
+void pirRecordCapture(uint32_t sinceTriggerMs) {
+  stats.captured++;
+  stats.lastToCaptureMs = sinceTriggerMs;
+  stats.sumToCaptureMs += sinceTriggerMs;
+}
+
+void pirRecordUpload(uint32_t sinceTriggerMs) {
+  stats.uploaded++;
+  stats.lastToUploadMs = sinceTriggerMs;
+  stats.sumToUploadMs += sinceTriggerMs;
+  if (sinceTriggerMs > stats.maxToUploadMs) stats.maxToUploadMs = sinceTriggerMs;
+}
+
+const PirStats &pirStats() {
+  return stats;
+}
+
+size_t pirToJson(char *out, size_t cap) {
+  int n = snprintf(out, cap,
+                   "{\"triggers\":%u,\"wakeTriggers\":%u,\"captured\":%u,\"uploaded\":%u,"
+                   "\"lastToCaptureMs\":%u,\"lastToUploadMs\":%u,\"avgToCaptureMs\":%u,"
+                   "\"avgToUploadMs\":%u,\"maxToUploadMs\":%u}",
+                   (unsigned)stats.triggers, (unsigned)stats.wakeTriggers,
+                   (unsigned)stats.captured, (unsigned)stats.uploaded,
+                   (unsigned)stats.lastToCaptureMs, (unsigned)stats.lastToUploadMs,
+                   (unsigned)(stats.captured ? stats.sumToCaptureMs / stats.captured : 0),
+                   (unsigned)(stats.uploaded ? stats.sumToUploadMs / stats.uploaded : 0),
+                   (unsigned)stats.maxToUploadMs);
+  return (n > 0 && (size_t)n < cap) ? (size_t)n : 0;
+}
+
+void pirPrintStats() {
+  if (stats.triggers == 0) return;
+  DEBUG_PRINTF("[PIR] Disparos: %u (%u al despertar), capturadas %u, subidas %u; "
+               "media disparo->foto %u ms, disparo->subida %u ms (máx %u ms)\n",
+               (unsigned)stats.triggers, (unsigned)stats.wakeTriggers, (unsigned)stats.captured,
+               (unsigned)stats.uploaded,
+               (unsigned)(stats.captured ? stats.sumToCaptureMs / stats.captured : 0),
+               (unsigned)(stats.uploaded ? stats.sumToUploadMs / stats.uploaded : 0),
+               (unsigned)stats.maxToUploadMs);
+}
@@ -0,0 +1,61 @@
+/**
+ * Disparo por sensor PIR (proyecto TPI2)
+ *
+ * La salida del PIR va a PIR_PIN (un GPIO RTC, así puede despertar al chip):
+ *  - Despierto: una interrupción en el flanco marca el disparo.
+ *  - Dormido: powerSleep() arma ext0 sobre PIR_PIN; al despertar por ext0,
+ *    setup() inicializa solo la cámara, dispara y después levanta el WiFi.
+ *
+ * Latencias registradas (en RAM RTC, sobreviven al deep sleep):
+ *  - disparo -> foto capturada
+ *  - disparo -> foto subida
+ * Al despertar de deep sleep el "disparo" es el arranque de la aplicación
+ * (millis() = 0): el ROM y el bootloader corren antes y no se ven aquí.
+ *
+ * Un PIR que sigue activo al consultarlo también cuenta como disparo. Para no
+ * encadenar fotos, tras un disparo se ignoran los siguientes durante
+ * PIR_COOLDOWN_MS y no se arma ext0 con el pin todavía activo (despertaría al
+ * instante).
+ */
+
+#ifndef PIR_H
+#define PIR_H
+
+#include <Arduino.h>
+
+struct PirStats {
+  uint32_t triggers;          // Disparos atendidos (fuera del enfriamiento)
+  uint32_t wakeTriggers;      // ...de ellos, despertares de deep / light sleep
+  uint32_t captured;
+  uint32_t uploaded;
+  uint32_t lastToCaptureMs;
+  uint32_t lastToUploadMs;
+  uint64_t sumToCaptureMs;
+  uint64_t sumToUploadMs;
+  uint32_t maxToUploadMs;
+};
+
+// Configura el pin y la interrupción (cualquier arranque)
+void pirBegin();
+
+// Si hay un disparo pendiente, lo consume y devuelve true; *triggerMs = millis() del flanco
+bool pirTakeTrigger(unsigned long *triggerMs);
+
+// ¿Hay un disparo que pirTakeTrigger() atendería? No lo consume (sirve para
+// cortar una espera, p.ej. el long-poll de control)
+bool pirTriggerPending();
+
+// ¿Se puede armar el despertar por PIR para el próximo sueño?
+bool pirWakeAllowed();
+
+void pirRecordCapture(uint32_t sinceTriggerMs);
+void pirRecordUpload(uint32_t sinceTriggerMs);
+
+const PirStats &pirStats();
+
+// Escribe {"triggers":..,"avgToUploadMs":..,...} en out. Devuelve la longitud (0 si no cabe).
+size_t pirToJson(char *out, size_t cap);
+
+void pirPrintStats();
+
+#endif // PIR_H
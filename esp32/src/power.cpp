@@ -0,0 +1,190 @@
+/**
+ * Implementación del modo de bajo consumo (ver power.h)
+ */
+
+#include "power.h"
+#include "config.h"
+
+#include <driver/gpio.h>
+#include <esp_sleep.h>
+#include <sys/time.h>
+
+#include "pir.h"
+
+// Sobrevive al deep sleep; se pone a cero en cada arranque en frío
+struct PowerRtcState {
+  uint32_t wakeups;         // Despertares desde el arranque en frío
+  uint64_t clockBaseMs;     // powerClockMs() al empezar este despertar
+  uint64_t sleepStartRtcMs; // rtcNowMs() al entrar en deep sleep
+  // Acumulados desde el último informe de energía
+  uint64_t energyStartMs;   // powerClockMs() del último reset
+  uint64_t awakeMs;         // Despertares ya cerrados
+  uint64_t lightSleepMs;
+  uint64_t deepSleepMs;
+  uint32_t energyWakeups;
+};
+
+RTC_DATA_ATTR static PowerRtcState rtc;
+
+static bool wokeFromDeepSleep = false;
+static bool motionWake = false;
+static unsigned long motionWakeMs = 0;
+// Tiempo despierto de este arranque = millis() - awakeOffsetMs (el light sleep
+// cuenta en millis() pero no es tiempo despierto)
+static unsigned long awakeOffsetMs = 0;
+
+// El reloj del sistema lo mantiene el temporizador RTC también en deep sleep
+static uint64_t rtcNowMs() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (uint64_t)tv.tv_sec * 1000ULL + tv.tv_usec / 1000;
+}
+
+void powerBegin() {
+  esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+  wokeFromDeepSleep = cause != ESP_SLEEP_WAKEUP_UNDEFINED;
+  if (!wokeFromDeepSleep) {
+    memset(&rtc, 0, sizeof(rtc));
+    return;
+  }
+  uint64_t slept = rtcNowMs() - rtc.sleepStartRtcMs;
+  rtc.deepSleepMs += slept;
+  rtc.clockBaseMs += slept;
+  rtc.wakeups++;
+  rtc.energyWakeups++;
+  motionWake = cause == ESP_SLEEP_WAKEUP_EXT0;
+  motionWakeMs = 0;
+}
+
+bool powerWokeFromDeepSleep() {
+  return wokeFromDeepSleep;
+}
+
+uint32_t powerWakeCount() {
+  return rtc.wakeups;
+}
+
+bool powerTakeMotionWake(unsigned long *atMs) {
+  if (!motionWake) return false;
+  motionWake = false;
+  *atMs = motionWakeMs;
+  return true;
+}
+
+// Despertar por temporizador y, si procede, por el PIR
+static void armWakeup(uint32_t ms) {
+  esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000ULL);
+#if PIR_ENABLED
+  if (pirWakeAllowed()) {
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)PIR_PIN, PIR_ACTIVE_LEVEL);
+  } else {
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_EXT0);
+  }
+#endif
+}
+
+uint64_t powerClockMs() {
+  // millis() vuelve a 0 en cada despertar y sigue contando en light sleep
+  return rtc.clockBaseMs + millis();
+}
+
+PowerSleepMode powerSleepModeFor(uint32_t ms, bool keepRam) {
+  if (ms < LOW_POWER_LIGHT_SLEEP_MIN_MS) return POWER_SLEEP_NONE;
+  if (ms < LOW_POWER_DEEP_SLEEP_MIN_MS || keepRam) return POWER_SLEEP_LIGHT;
+  return POWER_SLEEP_DEEP;
+}
+
+void powerSleep(PowerSleepMode mode, uint32_t ms) {
+  switch (mode) {
+    case POWER_SLEEP_NONE:
+      delay(ms);
+      break;
+
+    case POWER_SLEEP_LIGHT: {
+      LOG_DEBUG("[POWER] Light sleep %u ms\n", (unsigned)ms);
+      logFlush();
+      armWakeup(ms);
+      unsigned long start = millis();
+      esp_light_sleep_start();
+      unsigned long slept = millis() - start;
+      awakeOffsetMs += slept;
+      rtc.lightSleepMs += slept;
+      if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0) {
+        motionWake = true;
+        motionWakeMs = millis();
+      }
+      break;
+    }
+
+    case POWER_SLEEP_DEEP: {
+      DEBUG_PRINTF("[POWER] Deep sleep %u ms (despertar %u)\n", (unsigned)ms,
+                   (unsigned)(rtc.wakeups + 1));
+      // El tiempo dormido se suma al despertar (powerBegin)
+      unsigned long now = millis();
+      rtc.awakeMs += now - awakeOffsetMs;
+      rtc.clockBaseMs += now;
+      logFlush();
+      armWakeup(ms);
+      rtc.sleepStartRtcMs = rtcNowMs();
+      esp_deep_sleep_start();
+      break;
+    }
+  }
+}
+
+// ============================================================================
+// ENERGÍA
+// ============================================================================
+
+void powerEnergySample(EnergySample *out) {
+  uint64_t awake = rtc.awakeMs + (millis() - awakeOffsetMs);
+  uint64_t total = awake + rtc.lightSleepMs + rtc.deepSleepMs;
+  if (total == 0) total = 1;
+
+  // Carga media en mA·ms / ms
+  double chargeMaMs = awake * ENERGY_CURRENT_ACTIVE_MA + rtc.lightSleepMs * ENERGY_CURRENT_LIGHT_SLEEP_MA +
+                      rtc.deepSleepMs * ENERGY_CURRENT_DEEP_SLEEP_MA;
+  double currentA = chargeMaMs / total / 1000.0;
+
+  out->voltage = ENERGY_SUPPLY_VOLTAGE;
+  out->current = (float)currentA;
+  out->watts = (float)(currentA * ENERGY_SUPPLY_VOLTAGE);
+  out->cpuTemp = temperatureRead();
+  out->dutyCycle = (float)awake / total;
+  out->awakeMs = (uint32_t)awake;
+  out->sleepMs = (uint32_t)(rtc.lightSleepMs + rtc.deepSleepMs);
+  out->wakeups = rtc.energyWakeups;
+}
+
+bool powerEnergyReportDue() {
+  return ENERGY_REPORT_INTERVAL > 0 && powerClockMs() - rtc.energyStartMs >= ENERGY_REPORT_INTERVAL;
+}
+
+size_t powerEnergyToJson(char *out, size_t cap) {
+  EnergySample s;
+  powerEnergySample(&s);
+  int n = snprintf(out, cap,
+                   "{\"voltage\":%.3f,\"current\":%.4f,\"watts\":%.4f,\"cpuTemp\":%.1f,"
+                   "\"dutyCycle\":%.4f,\"awakeMs\":%u,\"sleepMs\":%u,\"wakeups\":%u,"
+                   "\"estimated\":true}",
+                   s.voltage, s.current, s.watts, s.cpuTemp, s.dutyCycle, (unsigned)s.awakeMs,
+                   (unsigned)s.sleepMs, (unsigned)s.wakeups);
+  return (n > 0 && (size_t)n < cap) ? (size_t)n : 0;
+}
+
+void powerEnergyReset() {
+  rtc.energyStartMs = powerClockMs();
+  rtc.awakeMs = 0;
+  rtc.lightSleepMs = 0;
+  rtc.deepSleepMs = 0;
+  rtc.energyWakeups = 0;
+  awakeOffsetMs = millis();
+}
+
+void powerPrintStats() {
+  EnergySample s;
+  powerEnergySample(&s);
+  DEBUG_PRINTF("[POWER] Despierto %.1f%% (%u ms de %u ms), %u despertares, media %.1f mA / %.3f W (estimado)\n",
+               s.dutyCycle * 100.0f, (unsigned)s.awakeMs, (unsigned)(s.awakeMs + s.sleepMs),
+               (unsigned)s.wakeups, s.current * 1000.0f, s.watts);
+}
@@ -0,0 +1,77 @@
+/**
+ * Modo de bajo consumo y estimación de energía (proyecto TPI2)
+ *
+ * Con LOW_POWER_MODE el dispositivo no se queda en loop() con la radio
+ * encendida: hace un ciclo de control y duerme hasta el siguiente. El tipo de
+ * sueño depende de cuánto falta:
+ *  - menos de LOW_POWER_LIGHT_SLEEP_MIN_MS: espera normal (modem sleep del WiFi)
+ *  - menos de LOW_POWER_DEEP_SLEEP_MIN_MS:  light sleep (se conserva la RAM;
+ *    el WiFi se suelta y se reconecta con la caché de wifi_manager)
+ *  - a partir de ahí: deep sleep (la ESP32 se reinicia al despertar)
+ *
+ * Lo que tiene que sobrevivir al deep sleep vive en RAM RTC: número de
+ * despertares, tiempo total dormido y los acumulados de energía. El tiempo
+ * dormido se mide con el reloj RTC (gettimeofday), porque un despertar por el
+ * PIR (PIR_ENABLED) corta el sueño antes de tiempo.
+ *
+ * La placa no mide corriente: la energía se estima con el tiempo pasado en
+ * cada estado y las corrientes típicas de config.h (ENERGY_CURRENT_*).
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+
+enum PowerSleepMode {
+  POWER_SLEEP_NONE,
+  POWER_SLEEP_LIGHT,
+  POWER_SLEEP_DEEP,
+};
+
+struct EnergySample {
+  float voltage;    // V
+  float current;    // A (media del intervalo)
+  float watts;      // W (media del intervalo)
+  float cpuTemp;    // ºC
+  float dutyCycle;  // Fracción del intervalo despierto (0..1)
+  uint32_t awakeMs;
+  uint32_t sleepMs;  // Light + deep sleep
+  uint32_t wakeups;  // Despertares de deep sleep en el intervalo
+};
+
+// Al principio de setup(): causa del arranque y estado en RAM RTC
+void powerBegin();
+
+// ¿Este arranque es un despertar de deep sleep (y no un arranque en frío)?
+bool powerWokeFromDeepSleep();
+
+// Despertares de deep sleep desde el último arranque en frío
+uint32_t powerWakeCount();
+
+// Si el último despertar (deep o light sleep) fue por el PIR (ext0), lo consume
+// y devuelve true; *atMs = millis() del despertar (0 tras deep sleep)
+bool powerTakeMotionWake(unsigned long *atMs);
+
+// Tipo de sueño para dormir ms. keepRam descarta el deep sleep (p. ej. cola offline en PSRAM).
+PowerSleepMode powerSleepModeFor(uint32_t ms, bool keepRam);
+
+// Duerme ms en el modo indicado. POWER_SLEEP_DEEP no vuelve: reinicia en setup().
+void powerSleep(PowerSleepMode mode, uint32_t ms);
+
+// Milisegundos desde el arranque en frío, incluido el tiempo en deep sleep
+uint64_t powerClockMs();
+
+// Media desde el último powerEnergyReset()
+void powerEnergySample(EnergySample *out);
+
+// ¿Toca enviar la muestra de energía? (ENERGY_REPORT_INTERVAL, en el reloj de powerClockMs)
+bool powerEnergyReportDue();
+
+// Escribe la muestra en el formato de /api/cameras/:id/energy. Devuelve la longitud (0 si no cabe).
+size_t powerEnergyToJson(char *out, size_t cap);
+
+void powerEnergyReset();
+void powerPrintStats();
+
+#endif // POWER_H
@@ -0,0 +1,190 @@
+/**
+ * Implementación del pre-roll (ver preroll.h)
+ */
+
+#include "preroll.h"
+#include "config.h"
+#include "frame_ring.h"
+#include "esp_camera.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+static FrameRing ring;
+static SemaphoreHandle_t lock = NULL;  // Protege anillo, cámara y pauseDepth
+static int pauseDepth = 0;
+static bool applyMode = false;         // Volver a la resolución del pre-roll antes de capturar
+static bool started = false;
+static PrerollStats stats;
+static volatile PrerollFrameHook frameHook = NULL;
+
+// ============================================================================
+// TAREA DE CAPTURA
+// ============================================================================
+
+// Descarta los frames con más de PREROLL_SECONDS
+static void dropExpired() {
+  const uint8_t *data;
+  size_t len;
+  uint32_t capturedMs;
+  while (ring.peek(&data, &len, &capturedMs) &&
+         millis() - capturedMs > PREROLL_SECONDS * 1000UL) {
+    ring.pop();
+    stats.expired++;
+  }
+}
+
+#if PREROLL_ENABLED && !LOW_POWER_MODE
+
+static void setPrerollMode() {
+  sensor_t *s = esp_camera_sensor_get();
+  if (s != NULL) {
+    s->set_framesize(s, PREROLL_FRAME_SIZE);
+    s->set_quality(s, PREROLL_JPEG_QUALITY);
+  }
+  // El frame que ya estaba en el buffer es de la resolución anterior
+  camera_fb_t *stale = esp_camera_fb_get();
+  if (stale) esp_camera_fb_return(stale);
+}
+
+static void captureOne() {
+  camera_fb_t *fb = esp_camera_fb_get();
+  if (!fb) {
+    stats.captureErrors++;
+    return;
+  }
+  stats.captured++;
+  dropExpired();
+  uint32_t before = ring.evicted();
+  if (!ring.push(fb->buf, fb->len, millis())) stats.evicted++;  // Mayor que el anillo entero
+  stats.evicted += ring.evicted() - before;
+  PrerollFrameHook hook = frameHook;
+  if (hook) hook(fb->buf, fb->len);
+  esp_camera_fb_return(fb);
+}
+
+static void prerollTask(void *) {
+  TickType_t lastWake = xTaskGetTickCount();
+  for (;;) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (pauseDepth == 0) {
+      if (applyMode) {
+        setPrerollMode();
+        applyMode = false;
+      }
+      captureOne();
+    }
+    xSemaphoreGive(lock);
+
+    TickType_t now = xTaskGetTickCount();
+    TickType_t period = pdMS_TO_TICKS(PREROLL_FRAME_INTERVAL);
+    if (now - lastWake < period) vTaskDelay(period - (now - lastWake));
+    lastWake = xTaskGetTickCount();
+  }
+}
+
+#endif // PREROLL_ENABLED && !LOW_POWER_MODE
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+
+bool prerollBegin() {
+#if PREROLL_ENABLED && !LOW_POWER_MODE
+  if (started) return true;
+  if (!ring.begin(PREROLL_BUDGET_BYTES)) {
+    DEBUG_PRINTLN("[PREROLL] Sin memoria para el anillo");
+    return false;
+  }
+  lock = xSemaphoreCreateMutex();
+  if (!lock) {
+    ring.end();
+    return false;
+  }
+  applyMode = true;
+  if (xTaskCreatePinnedToCore(prerollTask, "preroll", PREROLL_TASK_STACK, NULL,
+                              PREROLL_TASK_PRIORITY, NULL, STREAM_CAPTURE_CORE) != pdPASS) {
+    ring.end();
+    return false;
+  }
+  started = true;
+  DEBUG_PRINTF("[PREROLL] Capturando %d s a %d ms por frame en %u KB\n", PREROLL_SECONDS,
+               PREROLL_FRAME_INTERVAL, (unsigned)(PREROLL_BUDGET_BYTES / 1024));
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool prerollCapturing() {
+  return started && pauseDepth == 0;
+}
+
+void prerollPause() {
+  if (!started) return;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  pauseDepth++;
+  xSemaphoreGive(lock);
+}
+
+void prerollResume() {
+  if (!started) return;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (pauseDepth > 0 && --pauseDepth == 0) applyMode = true;
+  xSemaphoreGive(lock);
+}
+
+int prerollFlush(PrerollUploadFn upload) {
+  if (!started || pauseDepth == 0) return 0;
+
+  // En pausa la tarea no toca el anillo: se sube directamente desde él
+  dropExpired();
+  stats.flushes++;
+  int sent = 0;
+  const uint8_t *data;
+  size_t len;
+  uint32_t capturedMs;
+  while (ring.peek(&data, &len, &capturedMs)) {
+    if (!upload(data, len, millis() - capturedMs)) {
+      // El pre-roll pierde interés enseguida: no se reintenta
+      stats.failed++;
+      break;
+    }
+    ring.pop();
+    stats.uploaded++;
+    sent++;
+  }
+  ring.clear();
+  return sent;
+}
+
+void prerollSetFrameHook(PrerollFrameHook hook) {
+  frameHook = hook;
+}
+
+void prerollClear() {
+  if (!started) return;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  ring.clear();
+  xSemaphoreGive(lock);
+}
+
+size_t prerollCount() {
+  return started ? ring.count() : 0;
+}
+
+const PrerollStats &prerollStats() {
+  return stats;
+}
+
+void prerollPrintStats() {
+  if (!started) return;
+  DEBUG_PRINTF("[PREROLL] %u frames (%u KB de %u KB), capturados: %u, expulsados: %u, "
+               "caducados: %u, errores: %u\n",
+               (unsigned)ring.count(), (unsigned)(ring.bytesUsed() / 1024),
+               (unsigned)(ring.capacity() / 1024), (unsigned)stats.captured,
+               (unsigned)stats.evicted, (unsigned)stats.expired, (unsigned)stats.captureErrors);
+  DEBUG_PRINTF("[PREROLL] Envíos: %u, frames subidos: %u, fallidos: %u\n", (unsigned)stats.flushes,
+               (unsigned)stats.uploaded, (unsigned)stats.failed);
+}
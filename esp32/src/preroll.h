@@ -0,0 +1,70 @@
+/**
+ * Pre-roll: los últimos segundos antes del disparo (proyecto TPI2)
+ *
+ * Una foto o un streaming pedidos por el servidor (o un disparo del PIR) solo
+ * veían lo que pasaba a partir de ese momento, a menudo cuando el animal ya se
+ * había ido. Con PREROLL_ENABLED una tarea captura sin parar frames JPEG en
+ * baja resolución (PREROLL_FRAME_SIZE) y los guarda en un anillo en PSRAM
+ * (frame_ring.h):
+ *  - La memoria la acota PREROLL_BUDGET_BYTES, no un número de frames: al
+ *    llenarse se expulsan los más antiguos.
+ *  - Los frames con más de PREROLL_SECONDS se descartan aunque quepan.
+ *
+ * Al llegar una acción, main pausa la tarea (la cámara queda libre para la
+ * foto / streaming a su resolución) y sube el pre-roll con prerollFlush()
+ * antes que los frames en vivo, cada uno con su antigüedad.
+ *
+ * Necesita la cámara encendida todo el tiempo: en LOW_POWER_MODE no arranca.
+ */
+
+#ifndef PREROLL_H
+#define PREROLL_H
+
+#include <Arduino.h>
+
+// Sube un frame del pre-roll; ageMs es el tiempo desde su captura
+typedef bool (*PrerollUploadFn)(const uint8_t *data, size_t len, uint32_t ageMs);
+
+// Recibe cada frame capturado, antes de devolverlo al driver (p. ej. el detector de movimiento)
+typedef void (*PrerollFrameHook)(const uint8_t *data, size_t len);
+
+struct PrerollStats {
+  uint32_t captured;
+  uint32_t evicted;        // Expulsados por falta de espacio (PREROLL_BUDGET_BYTES)
+  uint32_t expired;        // Descartados por antigüedad (PREROLL_SECONDS)
+  uint32_t captureErrors;
+  uint32_t flushes;
+  uint32_t uploaded;
+  uint32_t failed;         // Subidas fallidas (el resto de ese pre-roll se descarta)
+};
+
+// Reserva el anillo y arranca la tarea de captura (cámara ya inicializada).
+// Devuelve false si está desactivado o no hay memoria.
+bool prerollBegin();
+
+// ¿La tarea está capturando ahora mismo?
+bool prerollCapturing();
+
+// Detiene la captura (admite anidamiento) y espera a que suelte la cámara.
+// Mientras dure la pausa el anillo no cambia.
+void prerollPause();
+
+// Deshace una pausa; con la última, vuelve a la resolución del pre-roll y sigue capturando
+void prerollResume();
+
+// Sube los frames guardados, el más antiguo primero, y vacía el anillo.
+// Solo con la captura en pausa. Devuelve cuántos se subieron.
+int prerollFlush(PrerollUploadFn upload);
+
+// Registra quién más quiere ver los frames del pre-roll (NULL para quitarlo)
+void prerollSetFrameHook(PrerollFrameHook hook);
+
+// Descarta los frames guardados (p. ej. si no hay red para subirlos)
+void prerollClear();
+
+size_t prerollCount();
+
+const PrerollStats &prerollStats();
+void prerollPrintStats();
+
+#endif // PREROLL_H
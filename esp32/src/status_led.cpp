@@ -0,0 +1,80 @@
+/**
+ * Implementación del LED de estado (ver status_led.h)
+ */
+
+#include "status_led.h"
+#include "config.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+struct BlinkPattern {
+  uint16_t times;
+  uint16_t periodMs;
+  uint32_t generation;
+};
+
+static QueueHandle_t patterns = NULL;
+static SemaphoreHandle_t pinLock = NULL;  // Encender y cancelar no se cruzan
+static volatile uint32_t generation = 0;  // statusLedOff() invalida lo anterior
+
+// Enciende el LED salvo que el patrón se haya cancelado
+static bool ledOn(const BlinkPattern &p) {
+  if (!pinLock) {
+    digitalWrite(LED_FLASH_PIN, HIGH);
+    return true;
+  }
+  xSemaphoreTake(pinLock, portMAX_DELAY);
+  bool on = p.generation == generation;
+  if (on) digitalWrite(LED_FLASH_PIN, HIGH);
+  xSemaphoreGive(pinLock);
+  return on;
+}
+
+static void blink(const BlinkPattern &p) {
+  for (int i = 0; i < p.times; i++) {
+    if (!ledOn(p)) return;
+    delay(p.periodMs);
+    digitalWrite(LED_FLASH_PIN, LOW);
+    delay(p.periodMs);
+  }
+}
+
+static void ledTask(void *) {
+  BlinkPattern p;
+  for (;;) {
+    if (xQueueReceive(patterns, &p, portMAX_DELAY) == pdTRUE) blink(p);
+  }
+}
+
+void statusLedBegin() {
+  if (patterns) return;
+  if (!pinLock) pinLock = xSemaphoreCreateMutex();
+  if (!pinLock) return;
+  patterns = xQueueCreate(STATUS_LED_QUEUE_LENGTH, sizeof(BlinkPattern));
+  if (!patterns) return;
+  if (xTaskCreatePinnedToCore(ledTask, "status_led", STATUS_LED_TASK_STACK, NULL, 1, NULL,
+                              LOG_TASK_CORE) != pdPASS) {
+    vQueueDelete(patterns);
+    patterns = NULL;
+  }
+}
+
+void statusLedBlink(int times, int periodMs) {
+  BlinkPattern p = {(uint16_t)times, (uint16_t)periodMs, generation};
+  if (!patterns) {
+    blink(p);
+    return;
+  }
+  xQueueSend(patterns, &p, 0);
+}
+
+void statusLedOff() {
+  if (patterns) xQueueReset(patterns);
+  if (pinLock) xSemaphoreTake(pinLock, portMAX_DELAY);
+  generation = generation + 1;
+  digitalWrite(LED_FLASH_PIN, LOW);
+  if (pinLock) xSemaphoreGive(pinLock);
+}
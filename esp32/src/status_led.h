@@ -0,0 +1,27 @@
+/**
+ * LED de estado sin bloquear (proyecto TPI2)
+ *
+ * blinkLED() hacía delay() en el hilo que la llamaba: 1,6 s entre el arranque
+ * y la reconexión. Ahora los parpadeos se encolan y los ejecuta una tarea de
+ * baja prioridad; quien llama sigue al instante. El LED es el flash de la
+ * placa (LED_FLASH_PIN): antes de dormir (en light sleep el pin mantiene su
+ * nivel) y de capturar hay que apagarlo con statusLedOff().
+ */
+
+#ifndef STATUS_LED_H
+#define STATUS_LED_H
+
+#include <Arduino.h>
+
+// Crea la tarea del LED (antes, statusLedBlink parpadea en el hilo que llama)
+void statusLedBegin();
+
+// Encola `times` parpadeos de periodMs encendido + periodMs apagado. Si la cola
+// está llena el patrón se descarta: es solo una indicación.
+void statusLedBlink(int times, int periodMs);
+
+// Descarta los parpadeos pendientes, corta el que está en curso y deja el LED
+// apagado. Al volver, la tarea ya no lo enciende hasta el siguiente statusLedBlink.
+void statusLedOff();
+
+#endif // STATUS_LED_H
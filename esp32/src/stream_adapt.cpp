@@ -0,0 +1,256 @@
+/**
+ * Implementación del control adaptativo del streaming (ver stream_adapt.h)
+ */
+
+#include "stream_adapt.h"
+#include "detect_feedback.h"
+#include "config.h"
+
+// Escalera de resoluciones que puede recorrer el controlador
+static const framesize_t kLadder[] = {
+    FRAMESIZE_QQVGA, FRAMESIZE_HQVGA, FRAMESIZE_QVGA,
+    FRAMESIZE_CIF,   FRAMESIZE_HVGA,  FRAMESIZE_VGA,
+};
+static const char *const kLadderNames[] = {
+    "QQVGA", "HQVGA", "QVGA", "CIF", "HVGA", "VGA",
+};
+static const int kLadderSize = sizeof(kLadder) / sizeof(kLadder[0]);
+
+// Parámetros publicados: periodo (16 bits) | calidad << 16 | escalón << 24
+static volatile uint32_t published = 0;
+static uint32_t applied = 0xFFFFFFFF;
+
+// Estado del controlador (solo lo toca la tarea de subida)
+static int level;          // Índice en kLadder
+static int quality;
+static uint32_t periodMs;
+static int minLevel;
+static int maxLevel;
+
+// Ventana de medición
+static uint32_t winFrames;
+static uint32_t winFailures;
+static uint32_t winUploadMs;
+static uint64_t winBytes;
+static uint32_t skipFrames;
+
+// Espera de respuesta suavizada (media móvil exponencial, alfa 1/4); 0 = sin medir
+static uint32_t rttMs;
+
+static uint32_t stepsDown;
+static uint32_t stepsUp;
+
+// Modo de la realimentación de detecciones que sigue el controlador
+static DetectMode detectMode;
+// Periodo al entrar en reposo: cada frame en reposo sustituye a varios de estos
+static uint32_t idleFromPeriod;
+
+static int ladderIndex(framesize_t fs) {
+  // Primer escalón que no es menor que fs (la escalera está ordenada)
+  for (int i = 0; i < kLadderSize; i++) {
+    if (kLadder[i] >= fs) return i;
+  }
+  return kLadderSize - 1;
+}
+
+static void publish() {
+  published = (periodMs & 0xFFFF) | ((uint32_t)quality << 16) | ((uint32_t)level << 24);
+}
+
+static void resetWindow() {
+  winFrames = 0;
+  winFailures = 0;
+  winUploadMs = 0;
+  winBytes = 0;
+}
+
+void streamAdaptReset() {
+  minLevel = ladderIndex(STREAM_ADAPT_MIN_FRAMESIZE);
+  maxLevel = ladderIndex(STREAM_ADAPT_MAX_FRAMESIZE);
+  level = constrain(ladderIndex(FRAME_SIZE_STREAM), minLevel, maxLevel);
+  quality = constrain(JPEG_QUALITY_STREAM, STREAM_ADAPT_QUALITY_BEST, STREAM_ADAPT_QUALITY_WORST);
+  periodMs = STREAMING_FRAME_DELAY;
+  stepsDown = 0;
+  stepsUp = 0;
+  skipFrames = 0;
+  rttMs = 0;
+  detectMode = DETECT_MODE_NORMAL;
+  idleFromPeriod = STREAMING_FRAME_DELAY;
+  resetWindow();
+  applied = 0xFFFFFFFF;
+  publish();
+}
+
+// Menos bytes por frame: primero calidad, después resolución
+static bool stepDown() {
+  if (quality + STREAM_ADAPT_QUALITY_STEP <= STREAM_ADAPT_QUALITY_WORST) {
+    quality += STREAM_ADAPT_QUALITY_STEP;
+    return true;
+  }
+  if (level > minLevel) {
+    level--;
+    quality = JPEG_QUALITY_STREAM;
+    return true;
+  }
+  return false;
+}
+
+// Más bytes por frame: primero calidad, después resolución
+static bool stepUp() {
+  if (quality - STREAM_ADAPT_QUALITY_STEP >= STREAM_ADAPT_QUALITY_BEST) {
+    quality -= STREAM_ADAPT_QUALITY_STEP;
+    return true;
+  }
+  if (level < maxLevel) {
+    level++;
+    quality = JPEG_QUALITY_STREAM;
+    return true;
+  }
+  return false;
+}
+
+// Periodo mínimo entre frames según el modo de detección
+static uint32_t minPeriod() {
+  if (detectMode == DETECT_MODE_ACTIVE) return DETECT_ACTIVE_FRAME_DELAY;
+  if (detectMode == DETECT_MODE_IDLE) return DETECT_IDLE_FRAME_DELAY;
+  return STREAMING_FRAME_DELAY;
+}
+
+#if DETECT_FEEDBACK
+// Cambio de modo (detect_feedback.h): periodo y calidad se aplican en el
+// acto, sin esperar a que termine la ventana de medición
+static void followDetectMode(size_t bytes, bool ok) {
+  DetectMode mode = detectFeedbackUpdate();
+  if (mode == DETECT_MODE_IDLE && ok && idleFromPeriod > 0) {
+    detectFeedbackRecordIdleFrame(bytes, (float)periodMs / idleFromPeriod - 1.0f);
+  }
+  if (mode == detectMode) return;
+
+  if (mode == DETECT_MODE_ACTIVE) {
+    quality = max(quality - DETECT_ACTIVE_QUALITY_BOOST, STREAM_ADAPT_QUALITY_BEST);
+  } else if (detectMode == DETECT_MODE_ACTIVE) {
+    quality = min(quality + DETECT_ACTIVE_QUALITY_BOOST, STREAM_ADAPT_QUALITY_WORST);
+  }
+  if (mode == DETECT_MODE_IDLE) idleFromPeriod = periodMs;
+  detectMode = mode;
+  periodMs = minPeriod();
+
+  DEBUG_PRINTF("[ADAPT] Nuevo modo de detección -> %s q%d, periodo %u ms\n",
+               kLadderNames[level], quality, (unsigned)periodMs);
+  publish();
+  resetWindow();
+  skipFrames = STREAM_FRAMES_IN_FLIGHT - 1;
+}
+#endif
+
+void streamAdaptRecord(uint32_t uploadMs, size_t bytes, bool ok) {
+#if DETECT_FEEDBACK
+  followDetectMode(bytes, ok);
+#endif
+
+  // Frames capturados antes del último cambio todavía en vuelo
+  if (skipFrames > 0) {
+    skipFrames--;
+    return;
+  }
+
+  winFrames++;
+  winUploadMs += uploadMs;
+  if (ok) {
+    winBytes += bytes;
+  } else {
+    winFailures++;
+  }
+  if (winFrames < STREAM_ADAPT_WINDOW) return;
+
+  uint32_t okFrames = winFrames - winFailures;
+  uint32_t avgMs = winUploadMs / winFrames;
+  uint32_t avgBytes = okFrames ? (uint32_t)(winBytes / okFrames) : 0;
+  // Los frames salen al ritmo del más lento entre el periodo y la subida (bits/ms = kbit/s)
+  uint32_t interval = max(periodMs, avgMs);
+  uint32_t kbps = interval ? avgBytes * 8 / interval : 0;
+
+  bool over = winFailures > 0 || avgMs > STREAM_ADAPT_TARGET_MS * 5 / 4 ||
+              (STREAM_ADAPT_MAX_KBPS > 0 && kbps > STREAM_ADAPT_MAX_KBPS);
+  bool under = winFailures == 0 && avgMs < STREAM_ADAPT_TARGET_MS * 3 / 5 &&
+               (STREAM_ADAPT_MAX_KBPS == 0 || kbps < STREAM_ADAPT_MAX_KBPS * 3 / 5);
+
+  int oldLevel = level;
+  int oldQuality = quality;
+  uint32_t oldPeriod = periodMs;
+  const char *decision = "mantener";
+
+  if (STREAM_ADAPTIVE) {
+    if (over && stepDown()) {
+      decision = "bajar";
+      stepsDown++;
+    } else if (under && stepUp()) {
+      decision = "subir";
+      stepsUp++;
+    }
+    uint32_t floor = minPeriod();
+    periodMs = constrain(max(floor, avgMs), floor, max(floor, (uint32_t)STREAM_ADAPT_MAX_PERIOD));
+  }
+
+  bool changed = level != oldLevel || quality != oldQuality;
+  if (changed || periodMs != oldPeriod) {
+    DEBUG_PRINTF("[ADAPT] Subida %u ms (objetivo %d), %u B/frame, %u kbps, %u fallos -> %s: "
+                 "%s q%d, periodo %u ms\n",
+                 (unsigned)avgMs, STREAM_ADAPT_TARGET_MS, (unsigned)avgBytes, (unsigned)kbps,
+                 (unsigned)winFailures, decision, kLadderNames[level], quality,
+                 (unsigned)periodMs);
+    publish();
+  }
+
+  resetWindow();
+  if (changed) skipFrames = STREAM_FRAMES_IN_FLIGHT - 1;
+}
+
+void streamAdaptRecordRtt(uint32_t waitMs) {
+  rttMs = rttMs ? (rttMs * 3 + waitMs) / 4 : waitMs;
+}
+
+uint32_t streamAdaptBatchSize() {
+  uint32_t period = max((uint32_t)1, streamAdaptPeriodMs());
+  uint32_t n = (rttMs + period - 1) / period;
+  return constrain(n, (uint32_t)1, (uint32_t)STREAM_BATCH_MAX);
+}
+
+bool streamAdaptApply() {
+  uint32_t cur = published;
+  if (cur == applied) return false;
+
+  sensor_t *s = esp_camera_sensor_get();
+  if (s != NULL) {
+    int newLevel = (cur >> 24) & 0xFF;
+    int newQuality = (cur >> 16) & 0xFF;
+    if (applied == 0xFFFFFFFF || newLevel != (int)((applied >> 24) & 0xFF)) {
+      s->set_framesize(s, kLadder[newLevel]);
+    }
+    if (applied == 0xFFFFFFFF || newQuality != (int)((applied >> 16) & 0xFF)) {
+      s->set_quality(s, newQuality);
+    }
+  }
+  applied = cur;
+  return true;
+}
+
+void streamAdaptInvalidate() {
+  applied = 0xFFFFFFFF;
+}
+
+uint32_t streamAdaptPeriodMs() {
+  return published & 0xFFFF;
+}
+
+void streamAdaptPrintStats() {
+  if (STREAM_BATCH_MAX > 1) {
+    DEBUG_PRINTF("[ADAPT] Espera de respuesta %u ms -> %u frames por petición\n",
+                 (unsigned)rttMs, (unsigned)streamAdaptBatchSize());
+  }
+  if (!STREAM_ADAPTIVE) return;
+  uint32_t cur = published;
+  DEBUG_PRINTF("[ADAPT] Ajustes: %u a la baja, %u al alza; actual %s q%u, periodo %u ms\n",
+               (unsigned)stepsDown, (unsigned)stepsUp, kLadderNames[(cur >> 24) & 0xFF],
+               (unsigned)((cur >> 16) & 0xFF), (unsigned)(cur & 0xFFFF));
+}
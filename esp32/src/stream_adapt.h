@@ -0,0 +1,59 @@
+/**
+ * Control adaptativo de FPS / calidad del streaming (proyecto TPI2)
+ *
+ * Con FRAME_SIZE_STREAM, JPEG_QUALITY_STREAM y STREAMING_FRAME_DELAY fijos, en
+ * un enlace 4G débil los frames se acumulan detrás de subidas lentas y en un
+ * WiFi bueno sobra ancho de banda. Este controlador cierra el lazo:
+ *
+ *  - La tarea de subida informa del tiempo y bytes de cada frame.
+ *  - Cada STREAM_ADAPT_WINDOW frames se compara el tiempo medio de subida con
+ *    STREAM_ADAPT_TARGET_MS (y la tasa con STREAM_ADAPT_MAX_KBPS):
+ *      por encima -> peor calidad JPEG y, al agotarla, menor resolución;
+ *      holgado    -> mejor calidad y, al agotarla, mayor resolución.
+ *  - El periodo entre frames sigue al tiempo de subida, para que la captura
+ *    no produzca frames que solo se van a descartar.
+ *  - La tarea de captura aplica los cambios al sensor entre dos capturas.
+ *
+ * Con DETECT_FEEDBACK sigue además el modo de detección (detect_feedback.h):
+ * el periodo mínimo pasa a DETECT_ACTIVE_FRAME_DELAY con un animal a la vista
+ * (y la calidad mejora) o a DETECT_IDLE_FRAME_DELAY en reposo.
+ *
+ * Con STREAM_BATCH_MAX > 1 también fija cuántos frames van en cada petición:
+ * los que se capturan mientras se espera una respuesta (espera media ÷ periodo).
+ *
+ * Los parámetros se publican empaquetados en una palabra de 32 bits, así que
+ * las dos tareas se comunican sin bloqueos.
+ */
+
+#ifndef STREAM_ADAPT_H
+#define STREAM_ADAPT_H
+
+#include <Arduino.h>
+#include "esp_camera.h"
+
+// Vuelve a los parámetros de config.h y borra las mediciones
+void streamAdaptReset();
+
+// Resultado de subir un frame (tarea de subida)
+void streamAdaptRecord(uint32_t uploadMs, size_t bytes, bool ok);
+
+// Espera de respuesta de una petición (tarea de subida)
+void streamAdaptRecordRtt(uint32_t waitMs);
+
+// Frames por petición según la espera medida, entre 1 y STREAM_BATCH_MAX
+uint32_t streamAdaptBatchSize();
+
+// Aplica al sensor los cambios pendientes (tarea de captura).
+// Devuelve true si cambió algo.
+bool streamAdaptApply();
+
+// El sensor se usó con otros ajustes (con la captura en pausa): el siguiente
+// streamAdaptApply() vuelve a aplicar resolución y calidad actuales
+void streamAdaptInvalidate();
+
+// Periodo actual entre frames (milisegundos)
+uint32_t streamAdaptPeriodMs();
+
+void streamAdaptPrintStats();
+
+#endif // STREAM_ADAPT_H
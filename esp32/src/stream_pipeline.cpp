@@ -0,0 +1,362 @@
+/**
+ * Implementación del streaming en tubería (ver stream_pipeline.h)
+ */
+
+#include "stream_pipeline.h"
+#include "stream_adapt.h"
+#include "stream_roi.h"
+#include "detect_feedback.h"
+#include "jpeg_dc.h"
+#include "metrics.h"
+#include "config.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+static QueueHandle_t frameQueue = NULL;
+static SemaphoreHandle_t tasksDone = NULL;
+static SemaphoreHandle_t pauseAck = NULL;   // La captura ya soltó el sensor
+static SemaphoreHandle_t wakeCapture = NULL; // Corta la espera entre frames
+static StreamUploadFn uploadFrame = NULL;
+static StreamBatchUploadFn uploadBatch = NULL;
+static volatile bool running = false;
+static volatile bool pauseRequested = false;
+static StreamStats stats;
+
+// ============================================================================
+// FRAMES REPETIDOS
+// ============================================================================
+
+#if STREAM_DEDUP
+static JpegDcSignature lastSig;   // Firma del último frame encolado
+static size_t lastLen = 0;
+static uint32_t lastSentMs = 0;
+static bool haveLast = false;
+
+// true si el frame es igual al último encolado y aún no toca el de keep-alive.
+// Si no, pasa a ser la nueva referencia.
+static bool isRepeatedFrame(const camera_fb_t *fb, uint32_t now) {
+  JpegDcSignature sig;
+  if (fb->format != PIXFORMAT_JPEG || !jpegDcSignature(fb->buf, fb->len, &sig)) {
+    haveLast = false;  // Sin firma, se envía siempre
+    return false;
+  }
+
+  if (haveLast && now - lastSentMs < STREAM_DEDUP_KEEPALIVE_MS && sig.width == lastSig.width &&
+      sig.height == lastSig.height) {
+    size_t delta = fb->len > lastLen ? fb->len - lastLen : lastLen - fb->len;
+    if (delta * 100 <= lastLen * STREAM_DEDUP_SIZE_PCT &&
+        jpegDcChangedCells(sig, lastSig, STREAM_DEDUP_CELL_DIFF) <=
+            STREAM_DEDUP_MAX_CHANGED_CELLS) {
+      return true;
+    }
+  }
+
+  lastSig = sig;
+  lastLen = fb->len;
+  lastSentMs = now;
+  haveLast = true;
+  return false;
+}
+#endif
+
+// ============================================================================
+// TAREA DE CAPTURA
+// ============================================================================
+
+static void enqueueLatest(const StreamFrame &frame) {
+  // Cola llena: gana el frame más reciente
+  if (xQueueSend(frameQueue, &frame, 0) != pdTRUE) {
+    StreamFrame oldest;
+    if (xQueueReceive(frameQueue, &oldest, 0) == pdTRUE && oldest.fb) {
+      esp_camera_fb_return(oldest.fb);
+      stats.dropped++;
+    }
+    if (xQueueSend(frameQueue, &frame, 0) != pdTRUE) {
+      esp_camera_fb_return(frame.fb);
+      stats.dropped++;
+    }
+  }
+
+  uint32_t depth = uxQueueMessagesWaiting(frameQueue);
+  if (depth > stats.maxQueueDepth) stats.maxQueueDepth = depth;
+}
+
+static void captureTask(void *) {
+  TickType_t lastWake = xTaskGetTickCount();
+  uint32_t seq = 0;
+  bool dropStale = false;
+
+  while (running) {
+    // Pausa pedida desde fuera (foto en mitad del streaming): el sensor queda libre
+    if (pauseRequested) {
+      xSemaphoreGive(pauseAck);
+      while (pauseRequested && running) vTaskDelay(pdMS_TO_TICKS(5));
+      dropStale = true;
+      lastWake = xTaskGetTickCount();
+      continue;
+    }
+
+    // Cambios de resolución / calidad pedidos por el control adaptativo
+    // (tras uno, el tamaño de los JPEG ya no es comparable con el anterior)
+    bool changed = streamAdaptApply();
+#if STREAM_ROI
+    // Región de interés: set_framesize() borra la ventana, así que va después.
+    // El frame que el driver ya tenía es de la ventana anterior y se descarta.
+    if (streamRoiApply(changed)) {
+      changed = true;
+      dropStale = true;
+    }
+#endif
+    if (changed) {
+#if STREAM_DEDUP
+      haveLast = false;
+#endif
+    }
+
+    METRIC_START(t0);
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (!fb) {
+      stats.captureErrors++;
+      vTaskDelay(pdMS_TO_TICKS(10));
+      continue;
+    }
+    METRIC_STOP(METRIC_CAPTURE, t0);
+    // Tras una pausa el driver puede tener un frame con los ajustes de fuera
+    if (dropStale) {
+      dropStale = false;
+      esp_camera_fb_return(fb);
+      continue;
+    }
+    METRIC_ADD(METRIC_BYTES_CAPTURED, fb->len);
+    stats.captured++;
+#if STREAM_DEDUP
+    if (isRepeatedFrame(fb, millis())) {
+      stats.suppressed++;
+      stats.bytesSaved += fb->len;
+      esp_camera_fb_return(fb);
+      fb = NULL;
+    }
+#endif
+    if (fb) {
+      StreamFrame frame = {fb, seq++, (uint32_t)millis(), streamRoiWindow()};
+      enqueueLatest(frame);
+    }
+
+    // Ritmo de captura: STREAMING_FRAME_DELAY o el que fije el control adaptativo
+    TickType_t now = xTaskGetTickCount();
+    TickType_t period = pdMS_TO_TICKS(streamAdaptPeriodMs());
+    if (now - lastWake < period) {
+      xSemaphoreTake(wakeCapture, period - (now - lastWake));
+    }
+    lastWake = xTaskGetTickCount();
+  }
+
+  xSemaphoreGive(tasksDone);
+  vTaskDelete(NULL);
+}
+
+// ============================================================================
+// TAREA DE SUBIDA
+// ============================================================================
+
+static bool sameWindow(const StreamRoi &a, const StreamRoi &b) {
+  return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+static void uploadTask(void *) {
+  StreamFrame batch[STREAM_BATCH_MAX];
+  StreamFrame carry;         // Primer frame de otra ventana: abre el siguiente lote
+  bool haveCarry = false;
+
+  while (running) {
+    if (haveCarry) {
+      batch[0] = carry;
+      haveCarry = false;
+    } else if (xQueueReceive(frameQueue, &batch[0], pdMS_TO_TICKS(100)) != pdTRUE ||
+               !batch[0].fb) {
+      continue;
+    }
+
+    // Lote: lo que ya esté en cola y, como mucho, dos periodos de espera por
+    // cada frame que falte (sin función de lotes, siempre uno)
+    size_t count = 1;
+    size_t want = uploadBatch ? streamAdaptBatchSize() : 1;
+    StreamFrame next;
+    while (count < want && running &&
+           xQueueReceive(frameQueue, &next, pdMS_TO_TICKS(2 * streamAdaptPeriodMs())) == pdTRUE) {
+      if (!next.fb) continue;
+      if (!sameWindow(next.window, batch[0].window)) {
+        carry = next;
+        haveCarry = true;
+        break;
+      }
+      batch[count++] = next;
+    }
+
+    size_t len = 0;
+    for (size_t i = 0; i < count; i++) len += batch[i].fb->len;
+    unsigned long t0 = millis();
+    bool ok = count == 1 ? uploadFrame(batch[0]) : uploadBatch(batch, count);
+    uint32_t elapsed = millis() - t0;
+
+    // El control adaptativo sigue viendo tiempos por frame
+    for (size_t i = 0; i < count; i++) {
+      streamAdaptRecord(elapsed / count, batch[i].fb->len, ok);
+      esp_camera_fb_return(batch[i].fb);
+    }
+    if (ok) {
+      stats.sent += count;
+      stats.bytesSent += len;
+    } else {
+      stats.failed += count;
+    }
+    if (count > 1) stats.batches++;
+    if (count > stats.maxBatch) stats.maxBatch = count;
+  }
+  if (haveCarry) esp_camera_fb_return(carry.fb);
+
+  xSemaphoreGive(tasksDone);
+  vTaskDelete(NULL);
+}
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+
+bool streamPipelineStart(StreamUploadFn upload, StreamBatchUploadFn uploadBatchFn) {
+  if (running || !upload) return false;
+
+  // Con lotes la cola tiene que poder guardar uno entero mientras sube el anterior
+  if (!frameQueue) {
+    frameQueue = xQueueCreate(STREAM_QUEUE_DEPTH, sizeof(StreamFrame));
+  }
+  if (!tasksDone) tasksDone = xSemaphoreCreateCounting(2, 0);
+  if (!pauseAck) pauseAck = xSemaphoreCreateBinary();
+  if (!wakeCapture) wakeCapture = xSemaphoreCreateBinary();
+  if (!frameQueue || !tasksDone || !pauseAck || !wakeCapture) {
+    DEBUG_PRINTLN("[STREAM] Sin memoria para la cola de frames");
+    return false;
+  }
+
+  memset((void *)&stats, 0, sizeof(stats));
+  stats.startMs = millis();
+  pauseRequested = false;
+  xSemaphoreTake(pauseAck, 0);
+  xSemaphoreTake(wakeCapture, 0);
+  streamAdaptReset();
+  streamRoiReset();
+  uploadFrame = upload;
+  uploadBatch = STREAM_BATCH_MAX > 1 ? uploadBatchFn : NULL;
+  running = true;
+
+  if (xTaskCreatePinnedToCore(uploadTask, "stream_upload", STREAM_TASK_STACK, NULL,
+                              STREAM_TASK_PRIORITY, NULL, STREAM_UPLOAD_CORE) != pdPASS) {
+    running = false;
+    return false;
+  }
+  if (xTaskCreatePinnedToCore(captureTask, "stream_capture", STREAM_TASK_STACK, NULL,
+                              STREAM_TASK_PRIORITY, NULL, STREAM_CAPTURE_CORE) != pdPASS) {
+    running = false;
+    xSemaphoreTake(tasksDone, portMAX_DELAY);
+    return false;
+  }
+
+  DEBUG_PRINTF("[STREAM] Tubería iniciada (cola %d, captura núcleo %d, subida núcleo %d)\n",
+               STREAM_QUEUE_DEPTH, STREAM_CAPTURE_CORE, STREAM_UPLOAD_CORE);
+  return true;
+}
+
+void streamPipelineStop() {
+  if (!running) return;
+  running = false;
+  xSemaphoreGive(wakeCapture);
+
+  // Esperar a que ambas tareas terminen su iteración en curso
+  xSemaphoreTake(tasksDone, portMAX_DELAY);
+  xSemaphoreTake(tasksDone, portMAX_DELAY);
+
+  StreamFrame frame;
+  while (xQueueReceive(frameQueue, &frame, 0) == pdTRUE) {
+    if (frame.fb) esp_camera_fb_return(frame.fb);
+  }
+  stats.endMs = millis();
+}
+
+void streamPipelinePause() {
+  if (!running || pauseRequested) return;
+  uint32_t t0 = millis();
+  pauseRequested = true;
+  xSemaphoreGive(wakeCapture);
+  xSemaphoreTake(pauseAck, portMAX_DELAY);
+  stats.pauses++;
+  stats.lastPauseWaitMs = millis() - t0;
+}
+
+void streamPipelineResume() {
+  pauseRequested = false;
+}
+
+void streamPipelineRecordPhoto(uint32_t latencyMs) {
+  stats.photos++;
+  stats.lastPhotoMs = latencyMs;
+  if (latencyMs > stats.maxPhotoMs) stats.maxPhotoMs = latencyMs;
+}
+
+bool streamPipelineRunning() {
+  return running;
+}
+
+uint32_t streamPipelineQueueDepth() {
+  return frameQueue ? uxQueueMessagesWaiting(frameQueue) : 0;
+}
+
+const StreamStats &streamPipelineStats() {
+  return stats;
+}
+
+size_t streamPipelineToJson(char *out, size_t cap) {
+  unsigned long end = running ? millis() : stats.endMs;
+  int n = snprintf(out, cap,
+                   "{\"captured\":%u,\"sent\":%u,\"failed\":%u,\"dropped\":%u,"
+                   "\"suppressed\":%u,\"bytesSent\":%llu,\"bytesSaved\":%llu,"
+                   "\"photos\":%u,\"lastPhotoMs\":%u,\"maxPhotoMs\":%u,\"durationMs\":%lu}",
+                   (unsigned)stats.captured, (unsigned)stats.sent, (unsigned)stats.failed,
+                   (unsigned)stats.dropped, (unsigned)stats.suppressed,
+                   (unsigned long long)stats.bytesSent, (unsigned long long)stats.bytesSaved,
+                   (unsigned)stats.photos, (unsigned)stats.lastPhotoMs,
+                   (unsigned)stats.maxPhotoMs, end - stats.startMs);
+  return (n > 0 && (size_t)n < cap) ? (size_t)n : 0;
+}
+
+void streamPipelinePrintStats() {
+  unsigned long end = running ? millis() : stats.endMs;
+  unsigned long elapsed = end - stats.startMs;
+  float fps = elapsed ? stats.sent * 1000.0f / elapsed : 0.0f;
+
+  DEBUG_PRINTF("[STREAM] Capturados: %u, enviados: %u, fallidos: %u, descartados: %u, "
+               "errores de captura: %u\n",
+               (unsigned)stats.captured, (unsigned)stats.sent, (unsigned)stats.failed,
+               (unsigned)stats.dropped, (unsigned)stats.captureErrors);
+  DEBUG_PRINTF("[STREAM] Cola: %u (máx %u), %.1f FPS enviados, %u KB en %lu ms\n",
+               (unsigned)streamPipelineQueueDepth(), (unsigned)stats.maxQueueDepth, fps,
+               (unsigned)(stats.bytesSent / 1024), elapsed);
+  if (stats.suppressed > 0) {
+    DEBUG_PRINTF("[STREAM] Repetidos: %u frames sin subir, %u KB ahorrados\n",
+                 (unsigned)stats.suppressed, (unsigned)(stats.bytesSaved / 1024));
+  }
+  if (stats.photos > 0) {
+    DEBUG_PRINTF("[STREAM] Fotos durante el streaming: %u (última %u ms, máx %u ms desde la "
+                 "petición)\n",
+                 (unsigned)stats.photos, (unsigned)stats.lastPhotoMs, (unsigned)stats.maxPhotoMs);
+  }
+  if (stats.batches > 0) {
+    DEBUG_PRINTF("[STREAM] Lotes: %u peticiones con varios frames (máx %u por petición)\n",
+                 (unsigned)stats.batches, (unsigned)stats.maxBatch);
+  }
+  streamAdaptPrintStats();
+  streamRoiPrintStats();
+  detectFeedbackPrintStats();
+}
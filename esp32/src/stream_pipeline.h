@@ -0,0 +1,106 @@
+/**
+ * Motor de streaming en tubería (captura / subida en paralelo) (proyecto TPI2)
+ *
+ * Antes, cada frame era: capturar -> POST bloqueante -> delay, por lo que los
+ * FPS reales eran 1 / (captura + subida + STREAMING_FRAME_DELAY).
+ *
+ * Ahora hay dos tareas FreeRTOS:
+ *  - Captura (STREAM_CAPTURE_CORE): obtiene frames al ritmo de
+ *    STREAMING_FRAME_DELAY (o el adaptativo) y los deja en una cola acotada.
+ *  - Subida (STREAM_UPLOAD_CORE, el núcleo de la pila WiFi): vacía la cola
+ *    y envía cada frame con la función de subida indicada.
+ *
+ * Si la cola está llena gana el frame más reciente: se devuelve al driver el
+ * más antiguo y se cuenta como descartado.
+ *
+ * Con función de subida por lotes, la tarea de subida junta en una petición
+ * los frames que se acumulan mientras espera respuesta (hasta
+ * streamAdaptBatchSize()), cada uno con su número y su hora de captura.
+ *
+ * El periodo de captura y los parámetros del sensor los ajusta el control
+ * adaptativo (stream_adapt.h) según lo que tardan las subidas.
+ *
+ * Con STREAM_DEDUP, la tarea de captura no encola los frames iguales al último
+ * enviado (misma firma DC y tamaño parecido, ver jpeg_dc.h) salvo uno cada
+ * STREAM_DEDUP_KEEPALIVE_MS; se cuentan como suprimidos con los bytes ahorrados.
+ *
+ * Con STREAM_ROI, la tarea de captura aplica entre dos frames la región de
+ * interés pedida por el servidor (stream_roi.h) y cada frame lleva la ventana
+ * del sensor con la que se capturó; un lote nunca mezcla ventanas.
+ *
+ * streamPipelinePause() detiene solo la captura (la subida sigue vaciando la
+ * cola) para que el bucle principal use el sensor, p. ej. para una foto pedida
+ * en mitad del streaming; al reanudar se descarta el frame que quedó en el driver.
+ */
+
+#ifndef STREAM_PIPELINE_H
+#define STREAM_PIPELINE_H
+
+#include <Arduino.h>
+#include "esp_camera.h"
+#include "stream_roi.h"
+
+// Frame en cola con su número dentro del streaming, su hora de captura y la
+// ventana del sensor (campo completo salvo con región de interés)
+struct StreamFrame {
+  camera_fb_t *fb;
+  uint32_t seq;
+  uint32_t capturedMs;
+  StreamRoi window;
+};
+
+// Sube un frame; devuelve true si el servidor lo aceptó
+typedef bool (*StreamUploadFn)(const StreamFrame &frame);
+
+// Sube varios frames en una sola petición; true si el servidor aceptó el lote
+typedef bool (*StreamBatchUploadFn)(const StreamFrame *frames, size_t count);
+
+struct StreamStats {
+  volatile uint32_t captured;      // Frames obtenidos del sensor
+  volatile uint32_t sent;          // Frames aceptados por el servidor
+  volatile uint32_t failed;        // Frames cuya subida falló
+  volatile uint32_t dropped;       // Frames descartados por contrapresión
+  volatile uint32_t captureErrors; // esp_camera_fb_get() sin frame
+  volatile uint32_t suppressed;    // Frames repetidos que no se subieron
+  volatile uint32_t maxQueueDepth;
+  volatile uint32_t batches;       // Peticiones con más de un frame
+  volatile uint32_t maxBatch;
+  volatile uint64_t bytesSent;
+  volatile uint64_t bytesSaved;    // JPEG de los frames suprimidos
+  uint32_t pauses;                 // streamPipelinePause()
+  uint32_t lastPauseWaitMs;        // Hasta que la captura soltó el sensor
+  uint32_t photos;                 // Fotos tomadas en mitad del streaming
+  uint32_t lastPhotoMs;            // De la petición a la foto subida
+  uint32_t maxPhotoMs;
+  unsigned long startMs;
+  unsigned long endMs;
+};
+
+// Arranca las tareas de captura y subida (uploadBatch NULL: siempre de uno en
+// uno). Devuelve false si no hay memoria.
+bool streamPipelineStart(StreamUploadFn upload, StreamBatchUploadFn uploadBatch = NULL);
+
+// Detiene ambas tareas y devuelve al driver los frames aún en cola
+void streamPipelineStop();
+
+// Pausa la captura y espera a que suelte el sensor (sin efecto si no corre)
+void streamPipelinePause();
+void streamPipelineResume();
+
+// Latencia de una foto tomada durante el streaming, para las estadísticas
+void streamPipelineRecordPhoto(uint32_t latencyMs);
+
+bool streamPipelineRunning();
+
+// Frames esperando en la cola en este momento
+uint32_t streamPipelineQueueDepth();
+
+const StreamStats &streamPipelineStats();
+
+// Escribe {"captured":..,"sent":..,"suppressed":..,"bytesSaved":..,...} del
+// último streaming en out. Devuelve la longitud (0 si no cabe).
+size_t streamPipelineToJson(char *out, size_t cap);
+
+void streamPipelinePrintStats();
+
+#endif // STREAM_PIPELINE_H
@@ -0,0 +1,172 @@
+/**
+ * Implementación de la región de interés del streaming (ver stream_roi.h)
+ */
+
+#include "stream_roi.h"
+#include "stream_adapt.h"
+#include "config.h"
+
+// Campo completo del OV2640 en modo UXGA (píxeles)
+#define SENSOR_FULL_W 1600
+#define SENSOR_FULL_H 1200
+
+// Modos de set_window() en el OV2640 (primer argumento de set_res_raw)
+#define OV2640_WINDOW_MODE_UXGA 0
+#define OV2640_WINDOW_MODE_SVGA 1
+
+static const StreamRoi kFullView = {0, 0, 1000, 1000};
+
+// Región pedida: x | y | w | h, cada uno en unidades de 4 milésimas (0 = ninguna)
+static volatile uint32_t requested = 0;
+static volatile uint32_t deadlineMs = 0;
+static uint32_t applied = 0;
+
+// Estado de la tarea de captura
+static StreamRoi window = kFullView;
+static bool unsupportedLogged = false;
+
+static uint32_t windowsApplied;
+static uint32_t expired;
+
+static uint32_t pack(const StreamRoi &roi) {
+  uint32_t x = min(roi.x, (uint16_t)1000) / 4;
+  uint32_t y = min(roi.y, (uint16_t)1000) / 4;
+  uint32_t x2 = min((uint32_t)roi.x + roi.w, (uint32_t)1000);
+  uint32_t y2 = min((uint32_t)roi.y + roi.h, (uint32_t)1000);
+  uint32_t w = (x2 + 3) / 4 > x ? (x2 + 3) / 4 - x : 0;
+  uint32_t h = (y2 + 3) / 4 > y ? (y2 + 3) / 4 - y : 0;
+  if (w == 0 || h == 0) return 0;
+  return (x << 24) | (y << 16) | (w << 8) | h;
+}
+
+static StreamRoi unpack(uint32_t v) {
+  StreamRoi roi = {(uint16_t)(((v >> 24) & 0xFF) * 4), (uint16_t)(((v >> 16) & 0xFF) * 4),
+                   (uint16_t)(((v >> 8) & 0xFF) * 4), (uint16_t)((v & 0xFF) * 4)};
+  return roi;
+}
+
+// Tamaño de salida de las resoluciones de la escalera del control adaptativo
+static bool framesizeDims(framesize_t fs, int *w, int *h) {
+  switch (fs) {
+    case FRAMESIZE_QQVGA: *w = 160; *h = 120; return true;
+    case FRAMESIZE_HQVGA: *w = 240; *h = 176; return true;
+    case FRAMESIZE_QVGA:  *w = 320; *h = 240; return true;
+    case FRAMESIZE_CIF:   *w = 400; *h = 296; return true;
+    case FRAMESIZE_HVGA:  *w = 480; *h = 320; return true;
+    case FRAMESIZE_VGA:   *w = 640; *h = 480; return true;
+    default: return false;
+  }
+}
+
+bool streamRoiIsFull(const StreamRoi &roi) {
+  return roi.x == 0 && roi.y == 0 && roi.w >= 1000 && roi.h >= 1000;
+}
+
+void streamRoiReset() {
+  requested = 0;
+  applied = 0;
+  window = kFullView;
+  windowsApplied = 0;
+  expired = 0;
+}
+
+void streamRoiRequest(const StreamRoi *roi, uint32_t ttlMs) {
+  uint32_t v = roi && !streamRoiIsFull(*roi) ? pack(*roi) : 0;
+  // Primero el plazo: la tarea de captura nunca ve la región nueva con el plazo viejo
+  deadlineMs = millis() + ttlMs + STREAM_ROI_GRACE_MS;
+  requested = v;
+}
+
+// Programa la ventana del OV2640 para la región v. Devuelve false si no se pudo.
+static bool setWindow(sensor_t *s, uint32_t v) {
+  int outW, outH;
+  if (!framesizeDims(s->status.framesize, &outW, &outH)) return false;
+
+  // Región en píxeles UXGA, ampliada al aspecto de la salida y a no menos que ella
+  StreamRoi roi = unpack(v);
+  int w = roi.w * SENSOR_FULL_W / 1000;
+  int h = roi.h * SENSOR_FULL_H / 1000;
+  int cx = roi.x * SENSOR_FULL_W / 1000 + w / 2;
+  int cy = roi.y * SENSOR_FULL_H / 1000 + h / 2;
+  if (w * outH < h * outW) {
+    w = h * outW / outH;
+  } else {
+    h = w * outH / outW;
+  }
+  w = constrain(w, outW, SENSOR_FULL_W);
+  h = constrain(h, outH, SENSOR_FULL_H);
+
+  // SVGA (binning 2x) si la ventana no pierde detalle al reducirse a la salida
+  int scale = (w >= 2 * outW && h >= 2 * outH) ? 2 : 1;
+  int mode = scale == 2 ? OV2640_WINDOW_MODE_SVGA : OV2640_WINDOW_MODE_UXGA;
+  int modeW = SENSOR_FULL_W / scale;
+  int modeH = SENSOR_FULL_H / scale;
+
+  // Tamaños múltiplos de 4 y desplazamientos pares, dentro del campo del modo
+  int winW = max((w / scale) & ~3, outW);
+  int winH = max((h / scale) & ~3, outH);
+  int offX = constrain(cx / scale - winW / 2, 0, modeW - winW) & ~1;
+  int offY = constrain(cy / scale - winH / 2, 0, modeH - winH) & ~1;
+
+  if (s->set_res_raw(s, mode, 0, 0, 0, offX, offY, winW, winH, outW, outH, false, false) != 0) {
+    return false;
+  }
+
+  window.x = (uint16_t)(offX * 1000 / modeW);
+  window.y = (uint16_t)(offY * 1000 / modeH);
+  window.w = (uint16_t)(winW * 1000 / modeW);
+  window.h = (uint16_t)(winH * 1000 / modeH);
+  DEBUG_PRINTF("[ROI] Ventana %dx%d+%d+%d en modo %s -> salida %dx%d (campo %u,%u %ux%u)\n",
+               winW, winH, offX, offY, scale == 2 ? "SVGA" : "UXGA", outW, outH,
+               window.x, window.y, window.w, window.h);
+  return true;
+}
+
+bool streamRoiApply(bool sensorReset) {
+  uint32_t want = requested;
+  if (want && (int32_t)(millis() - deadlineMs) >= 0) {
+    if (applied == want) {
+      DEBUG_PRINTLN("[ROI] Región caducada, vuelta al campo completo");
+      expired++;
+    }
+    want = 0;
+  }
+  if (want == applied && !(sensorReset && want)) return false;
+
+  sensor_t *s = esp_camera_sensor_get();
+  if (s == NULL) return false;
+  if (want && s->id.PID != OV2640_PID) {
+    if (!unsupportedLogged) {
+      DEBUG_PRINTF("[ROI] Sensor 0x%02X sin ventana programable, se ignora la región\n",
+                   (unsigned)s->id.PID);
+      unsupportedLogged = true;
+    }
+    return false;
+  }
+
+  if (want && setWindow(s, want)) {
+    if (want != applied) windowsApplied++;
+  } else {
+    // set_framesize() restaura la ventana normal del sensor. Una región que
+    // no se pudo programar queda como aplicada para no reintentarla cada frame.
+    if (want) DEBUG_PRINTLN("[ROI] No se pudo programar la ventana, sigue el campo completo");
+    if (applied || want) {
+      streamAdaptInvalidate();
+      streamAdaptApply();
+    }
+    window = kFullView;
+  }
+  applied = want;
+  return true;
+}
+
+StreamRoi streamRoiWindow() {
+  return window;
+}
+
+void streamRoiPrintStats() {
+  if (windowsApplied == 0) return;
+  DEBUG_PRINTF("[ROI] Regiones aplicadas: %u, caducadas: %u; ventana actual %u,%u %ux%u\n",
+               (unsigned)windowsApplied, (unsigned)expired, window.x, window.y, window.w,
+               window.h);
+}
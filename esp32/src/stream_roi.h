@@ -0,0 +1,59 @@
+/**
+ * Región de interés del streaming pedida por el servidor (proyecto TPI2)
+ *
+ * El servidor pasa cada frame en vivo por la inferencia y sabe dónde están los
+ * hipopótamos. Con STREAM_ROI, la respuesta de control durante el streaming
+ * trae esa zona ("roi", en milésimas del campo completo) y la tarea de captura
+ * recorta el sensor a ella:
+ *
+ *  - En el OV2640, set_res_raw() de esp32-camera es set_window(): modo del
+ *    sensor (UXGA 1600x1200 o SVGA 800x600 con binning), desplazamiento y
+ *    tamaño de la ventana y tamaño de salida. El DSP solo reduce, así que la
+ *    ventana se amplía al aspecto y tamaño de la resolución actual del control
+ *    adaptativo (que sigue mandando en los bytes por frame).
+ *  - Si la ventana es al menos el doble que la salida se usa SVGA, que da el
+ *    doble de FPS que UXGA en el sensor sin perder detalle.
+ *  - Cada frame lleva la ventana con la que se capturó (streamRoiWindow()), para
+ *    que el servidor sitúe sus detecciones en el campo completo.
+ *
+ * La región caduca sola: si el servidor deja de mandarla (el animal salió) o
+ * no llega ninguna respuesta de control en "ttlMs" + STREAM_ROI_GRACE_MS,
+ * se vuelve a set_framesize(), que restaura el campo completo.
+ *
+ * Como en stream_adapt.h, la petición se publica en una palabra de 32 bits y
+ * solo la tarea de captura toca el sensor.
+ */
+
+#ifndef STREAM_ROI_H
+#define STREAM_ROI_H
+
+#include <Arduino.h>
+#include "esp_camera.h"
+
+// Rectángulo del campo completo del sensor, en milésimas (0-1000)
+struct StreamRoi {
+  uint16_t x;
+  uint16_t y;
+  uint16_t w;
+  uint16_t h;
+};
+
+// Sin región pendiente ni aplicada (al empezar cada streaming)
+void streamRoiReset();
+
+// Región pedida por el servidor (bucle principal); NULL vuelve al campo completo
+void streamRoiRequest(const StreamRoi *roi, uint32_t ttlMs);
+
+// Aplica al sensor la región pendiente o vuelve al campo completo si caducó
+// (tarea de captura). sensorReset: set_framesize() acaba de borrar la ventana.
+// Devuelve true si cambió la ventana.
+bool streamRoiApply(bool sensorReset);
+
+// Ventana con la que captura ahora el sensor ({0, 0, 1000, 1000} sin región)
+StreamRoi streamRoiWindow();
+
+bool streamRoiIsFull(const StreamRoi &roi);
+
+void streamRoiPrintStats();
+
+#endif // STREAM_ROI_H
@@ -0,0 +1,162 @@
+/**
+ * Implementación del filtro de fotos con el clasificador (ver tinyml_gate.h)
+ */
+
+#include "tinyml_gate.h"
+#include "config.h"
+#include "motion_jpeg.h"
+#include "tinyml_model.h"
+#include "tinyml_model_data.h"
+
+static const char *const kVerdictNames[] = {"desconocido", "negativo", "dudoso", "positivo"};
+
+static TinymlModel model;
+static bool available = false;
+static uint8_t *gray = NULL;          // Rejilla de entrada del modelo
+static uint16_t *scratch = NULL;      // Sumas por celda de motion_jpeg
+static int8_t *arena = NULL;          // Activaciones
+static TinymlGateStats stats;
+
+#if TINYML_GATE
+
+static bool started = false;
+
+static void *allocBuffer(size_t size) {
+  return psramFound() ? ps_malloc(size) : malloc(size);
+}
+
+#endif // TINYML_GATE
+
+bool tinymlGateBegin() {
+#if TINYML_GATE
+  if (started) return available;
+  started = true;
+  if (TINYML_MODEL_LEN == 0) {
+    DEBUG_PRINTLN("[TINYML] Sin modelo compilado (yolo/export_tinyml.py): se suben todas las fotos");
+    return false;
+  }
+  if (!model.begin(kTinymlModel, TINYML_MODEL_LEN)) {
+    DEBUG_PRINTLN("[TINYML] ✗ El modelo compilado no es válido");
+    return false;
+  }
+
+  const TinymlShape &in = model.input();
+  const size_t cells = (size_t)in.w * in.h;
+  gray = (uint8_t *)allocBuffer(cells);
+  scratch = (uint16_t *)allocBuffer(cells * sizeof(uint16_t));
+  arena = (int8_t *)allocBuffer(model.arenaBytes());
+  if (!gray || !scratch || !arena) {
+    DEBUG_PRINTLN("[TINYML] Sin memoria para el clasificador");
+    free(gray);
+    free(scratch);
+    free(arena);
+    gray = NULL;
+    scratch = NULL;
+    arena = NULL;
+    return false;
+  }
+  available = true;
+  DEBUG_PRINTF("[TINYML] Clasificador activo: entrada %ux%u, %u capas, %u KB de arena, %u MACs\n",
+               in.w, in.h, model.layerCount(), (unsigned)(model.arenaBytes() / 1024),
+               (unsigned)model.macs());
+  return true;
+#else
+  return false;
+#endif
+}
+
+TinymlVerdict tinymlGateClassify(const uint8_t *jpeg, size_t len, uint8_t *probabilityPct) {
+  if (probabilityPct) *probabilityPct = 0;
+  if (!tinymlGateBegin()) return TINYML_UNKNOWN;
+
+  const TinymlShape &in = model.input();
+  unsigned long t0 = micros();
+  if (!motionJpegToGray(jpeg, len, gray, in.w, in.h, scratch)) {
+    stats.errors++;
+    return TINYML_UNKNOWN;
+  }
+  unsigned long t1 = micros();
+  float probability;
+  model.run(gray, arena, &probability);
+  unsigned long t2 = micros();
+
+  stats.frames++;
+  stats.sumDecodeUs += t1 - t0;
+  stats.sumInferUs += t2 - t1;
+  if (t2 - t1 > stats.maxInferUs) stats.maxInferUs = t2 - t1;
+
+  uint8_t pct = (uint8_t)(probability * 100 + 0.5f);
+  if (probabilityPct) *probabilityPct = pct;
+  TinymlVerdict verdict = TINYML_UNCERTAIN;
+  if (pct < TINYML_NEGATIVE_BELOW_PCT) {
+    verdict = TINYML_NEGATIVE;
+    stats.negatives++;
+  } else if (pct >= TINYML_POSITIVE_FROM_PCT) {
+    verdict = TINYML_POSITIVE;
+    stats.positives++;
+  } else {
+    stats.uncertain++;
+  }
+  LOG_DEBUG("[TINYML] %s (%u%%): decodificar %lu us, inferencia %lu us\n",
+            kVerdictNames[verdict], pct, t1 - t0, t2 - t1);
+  return verdict;
+}
+
+bool tinymlGateKeep(TinymlVerdict verdict) {
+  if (verdict != TINYML_NEGATIVE) return true;
+  // Uno de cada TINYML_AUDIT_EVERY negativos sube igualmente
+  if (TINYML_AUDIT_EVERY > 0 && (stats.dropped + stats.audited) % TINYML_AUDIT_EVERY == 0) {
+    stats.audited++;
+    return true;
+  }
+  stats.dropped++;
+  return false;
+}
+
+void tinymlGateRecordServer(TinymlVerdict verdict, int hippos) {
+  if (hippos < 0 || verdict == TINYML_UNKNOWN || verdict == TINYML_UNCERTAIN) return;
+  bool server = hippos > 0;
+  if (server == (verdict == TINYML_POSITIVE)) {
+    stats.agree++;
+  } else {
+    stats.disagree++;
+    if (verdict == TINYML_NEGATIVE) stats.missed++;
+  }
+}
+
+const char *tinymlVerdictName(TinymlVerdict verdict) {
+  return kVerdictNames[verdict];
+}
+
+const TinymlGateStats &tinymlGateStats() {
+  return stats;
+}
+
+size_t tinymlGateToJson(char *out, size_t cap) {
+  uint32_t n = stats.frames ? stats.frames : 1;
+  int len = snprintf(out, cap,
+                     "{\"frames\":%u,\"negatives\":%u,\"uncertain\":%u,\"positives\":%u,"
+                     "\"dropped\":%u,\"audited\":%u,\"errors\":%u,\"agree\":%u,\"disagree\":%u,"
+                     "\"missed\":%u,\"avgDecodeUs\":%u,\"avgInferUs\":%u,\"maxInferUs\":%u}",
+                     (unsigned)stats.frames, (unsigned)stats.negatives, (unsigned)stats.uncertain,
+                     (unsigned)stats.positives, (unsigned)stats.dropped, (unsigned)stats.audited,
+                     (unsigned)stats.errors, (unsigned)stats.agree, (unsigned)stats.disagree,
+                     (unsigned)stats.missed, (unsigned)(stats.sumDecodeUs / n),
+                     (unsigned)(stats.sumInferUs / n), (unsigned)stats.maxInferUs);
+  return (len > 0 && (size_t)len < cap) ? (size_t)len : 0;
+}
+
+void tinymlGatePrintStats() {
+  if (!available) return;
+  uint32_t n = stats.frames ? stats.frames : 1;
+  DEBUG_PRINTF("[TINYML] Fotos: %u (%u negativas, %u dudosas, %u positivas), sin subir: %u, "
+               "auditadas: %u, errores: %u\n",
+               (unsigned)stats.frames, (unsigned)stats.negatives, (unsigned)stats.uncertain,
+               (unsigned)stats.positives, (unsigned)stats.dropped, (unsigned)stats.audited,
+               (unsigned)stats.errors);
+  DEBUG_PRINTF("[TINYML] Concordancia con el servidor: %u de %u (%u hipopótamos perdidos); "
+               "por foto: decodificar %u us, inferencia %u us (peor %u us)\n",
+               (unsigned)stats.agree, (unsigned)(stats.agree + stats.disagree),
+               (unsigned)stats.missed, (unsigned)(stats.sumDecodeUs / n),
+               (unsigned)(stats.sumInferUs / n), (unsigned)stats.maxInferUs);
+}
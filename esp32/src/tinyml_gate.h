@@ -0,0 +1,71 @@
+/**
+ * Filtro de fotos con el clasificador en la cámara (proyecto TPI2)
+ *
+ * Cada foto del PIR o del detector de movimiento viajaba al servidor para
+ * saber si había un hipopótamo; la mayoría eran hojas, sombras o luz. Con
+ * TINYML_GATE la foto se reduce a la rejilla en gris del modelo (motion_jpeg.h)
+ * y pasa por el clasificador int8 compilado en el firmware (tinyml_model.h):
+ *
+ *  - probabilidad < TINYML_NEGATIVE_BELOW_PCT: negativo, no se sube (salvo uno
+ *    de cada TINYML_AUDIT_EVERY, para medir los hipopótamos que se pierden).
+ *  - probabilidad >= TINYML_POSITIVE_FROM_PCT: positivo, se sube.
+ *  - entre medias: dudoso, se sube y decide el servidor.
+ *
+ * Sin modelo (tinyml_model_data.h sin exportar) o si la foto no se puede
+ * decodificar, el veredicto es TINYML_UNKNOWN y la foto se sube como siempre.
+ * Con la respuesta del servidor ("hippoCount") se cuenta la concordancia.
+ *
+ * Solo desde loop(); la memoria se reserva en el primer uso.
+ */
+
+#ifndef TINYML_GATE_H
+#define TINYML_GATE_H
+
+#include <Arduino.h>
+
+enum TinymlVerdict {
+  TINYML_UNKNOWN = 0,
+  TINYML_NEGATIVE,
+  TINYML_UNCERTAIN,
+  TINYML_POSITIVE,
+};
+
+struct TinymlGateStats {
+  uint32_t frames;           // Fotos clasificadas
+  uint32_t negatives;
+  uint32_t uncertain;
+  uint32_t positives;
+  uint32_t dropped;          // Negativos sin subir
+  uint32_t audited;          // Negativos subidos de muestra
+  uint32_t errors;           // Foto no decodificable
+  uint32_t agree;            // Veredicto (positivo / negativo) igual que el servidor
+  uint32_t disagree;
+  uint32_t missed;           // Negativos auditados en los que el servidor vio un hipopótamo
+  uint64_t sumDecodeUs;
+  uint64_t sumInferUs;
+  uint32_t maxInferUs;
+};
+
+// Carga el modelo y reserva la memoria. Devuelve false si está desactivado,
+// no hay modelo o no hay memoria (y entonces todo es TINYML_UNKNOWN).
+bool tinymlGateBegin();
+
+// Clasifica un JPEG. *probabilityPct (opcional): 0-100.
+TinymlVerdict tinymlGateClassify(const uint8_t *jpeg, size_t len, uint8_t *probabilityPct);
+
+// ¿Hay que subir la foto? false para los negativos, salvo la muestra de auditoría
+bool tinymlGateKeep(TinymlVerdict verdict);
+
+// Respuesta del servidor a una foto subida (hippos < 0: no la traía)
+void tinymlGateRecordServer(TinymlVerdict verdict, int hippos);
+
+const char *tinymlVerdictName(TinymlVerdict verdict);
+
+const TinymlGateStats &tinymlGateStats();
+
+// Escribe {"frames":..,"negatives":..,...} en out. Devuelve la longitud (0 si no cabe).
+size_t tinymlGateToJson(char *out, size_t cap);
+
+void tinymlGatePrintStats();
+
+#endif // TINYML_GATE_H
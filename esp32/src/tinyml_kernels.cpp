@@ -0,0 +1,161 @@
+/**
+ * Implementación de los kernels int8 (ver tinyml_kernels.h)
+ */
+
+#include "tinyml_kernels.h"
+
+// ============================================================================
+// REESCALADO
+// ============================================================================
+
+// (a * b * 2) >> 32 redondeado, saturando el único caso que desborda
+static inline int32_t doublingHighMul(int32_t a, int32_t b) {
+  if (a == INT32_MIN && b == INT32_MIN) return INT32_MAX;
+  int64_t ab = (int64_t)a * b;
+  int32_t nudge = ab >= 0 ? (1 << 30) : (1 - (1 << 30));
+  return (int32_t)((ab + nudge) / ((int64_t)1 << 31));
+}
+
+// x / 2^exponent redondeando al más cercano (empates lejos de cero)
+static inline int32_t roundingShiftRight(int32_t x, int exponent) {
+  if (exponent <= 0) return x;
+  int32_t mask = (int32_t)((1u << exponent) - 1);
+  int32_t remainder = x & mask;
+  int32_t threshold = (mask >> 1) + (x < 0 ? 1 : 0);
+  return (x >> exponent) + (remainder > threshold ? 1 : 0);
+}
+
+int32_t tinymlRequantize(int32_t acc, int32_t mult, int32_t shift) {
+  int left = shift > 0 ? (int)shift : 0;
+  int right = shift > 0 ? 0 : (int)-shift;
+  return roundingShiftRight(doublingHighMul(acc * (1 << left), mult), right);
+}
+
+static inline int8_t saturate(int32_t v, int8_t actMin) {
+  if (v < actMin) return actMin;
+  if (v > 127) return 127;
+  return (int8_t)v;
+}
+
+uint16_t tinymlConvOutSize(uint16_t in, uint8_t kernel, uint8_t stride, uint8_t pad) {
+  int span = (int)in + 2 * pad - kernel;
+  if (kernel == 0 || stride == 0 || span < 0) return 0;
+  return (uint16_t)(span / stride + 1);
+}
+
+void tinymlQuantizeGray(const uint8_t *gray, size_t count, int8_t *out) {
+  for (size_t i = 0; i < count; i++) out[i] = (int8_t)(gray[i] - 128);
+}
+
+// ============================================================================
+// CONVOLUCIONES
+// ============================================================================
+
+// Taps del kernel que caen dentro de la imagen para la salida o: [*from, *to)
+static inline void validTaps(int o, const TinymlConvParams &p, int inSize, int *from, int *to) {
+  int origin = o * p.stride - p.pad;
+  *from = origin < 0 ? -origin : 0;
+  *to = origin + p.kernel > inSize ? inSize - origin : p.kernel;
+}
+
+void tinymlConv2d(const int8_t *in, const TinymlShape &inShape, const int8_t *weights,
+                  const TinymlRequant &rq, const TinymlConvParams &p, int8_t *out,
+                  const TinymlShape &outShape) {
+  const int inC = inShape.c;
+  const int k = p.kernel;
+  const int32_t inZero = p.inZero;
+
+  for (int oy = 0; oy < outShape.h; oy++) {
+    int ky0, ky1;
+    validTaps(oy, p, inShape.h, &ky0, &ky1);
+    int iy0 = oy * p.stride - p.pad;
+    for (int ox = 0; ox < outShape.w; ox++) {
+      int kx0, kx1;
+      validTaps(ox, p, inShape.w, &kx0, &kx1);
+      int ix0 = ox * p.stride - p.pad;
+
+      for (int oc = 0; oc < outShape.c; oc++) {
+        const int8_t *w = weights + (size_t)oc * k * k * inC;
+        int32_t acc = rq.bias[oc];
+        // El relleno vale inZero: (inZero - inZero) * w no suma, se salta
+        for (int ky = ky0; ky < ky1; ky++) {
+          const int8_t *row = in + ((size_t)(iy0 + ky) * inShape.w + ix0) * inC;
+          const int8_t *wRow = w + (size_t)ky * k * inC;
+          for (int kx = kx0; kx < kx1; kx++) {
+            const int8_t *px = row + (size_t)kx * inC;
+            const int8_t *wPx = wRow + (size_t)kx * inC;
+            for (int ic = 0; ic < inC; ic++) acc += (px[ic] - inZero) * wPx[ic];
+          }
+        }
+        acc = tinymlRequantize(acc, rq.mult[oc], rq.shift[oc]) + p.outZero;
+        *out++ = saturate(acc, p.actMin);
+      }
+    }
+  }
+}
+
+void tinymlDepthwiseConv2d(const int8_t *in, const TinymlShape &inShape, const int8_t *weights,
+                           const TinymlRequant &rq, const TinymlConvParams &p, int8_t *out,
+                           const TinymlShape &outShape) {
+  const int c = inShape.c;
+  const int k = p.kernel;
+  const int32_t inZero = p.inZero;
+  int32_t acc[TINYML_MAX_CHANNELS];
+
+  for (int oy = 0; oy < outShape.h; oy++) {
+    int ky0, ky1;
+    validTaps(oy, p, inShape.h, &ky0, &ky1);
+    int iy0 = oy * p.stride - p.pad;
+    for (int ox = 0; ox < outShape.w; ox++) {
+      int kx0, kx1;
+      validTaps(ox, p, inShape.w, &kx0, &kx1);
+      int ix0 = ox * p.stride - p.pad;
+
+      // Taps por fuera y canales por dentro: se recorre la memoria en orden
+      for (int ch = 0; ch < c; ch++) acc[ch] = rq.bias[ch];
+      for (int ky = ky0; ky < ky1; ky++) {
+        for (int kx = kx0; kx < kx1; kx++) {
+          const int8_t *px = in + ((size_t)(iy0 + ky) * inShape.w + ix0 + kx) * c;
+          const int8_t *w = weights + (size_t)(ky * k + kx) * c;
+          for (int ch = 0; ch < c; ch++) acc[ch] += (px[ch] - inZero) * w[ch];
+        }
+      }
+      for (int ch = 0; ch < c; ch++) {
+        int32_t v = tinymlRequantize(acc[ch], rq.mult[ch], rq.shift[ch]) + p.outZero;
+        *out++ = saturate(v, p.actMin);
+      }
+    }
+  }
+}
+
+// ============================================================================
+// POOLING Y CAPA DENSA
+// ============================================================================
+
+void tinymlGlobalAvgPool(const int8_t *in, const TinymlShape &inShape, int8_t *out) {
+  const int c = inShape.c;
+  const int32_t count = (int32_t)inShape.w * inShape.h;
+  int32_t acc[TINYML_MAX_CHANNELS];
+  for (int ch = 0; ch < c; ch++) acc[ch] = 0;
+  for (int32_t i = 0; i < count; i++) {
+    const int8_t *px = in + (size_t)i * c;
+    for (int ch = 0; ch < c; ch++) acc[ch] += px[ch];
+  }
+  // Redondeo al más cercano, como el AVERAGE_POOL_2D de TFLite
+  for (int ch = 0; ch < c; ch++) {
+    int32_t v = acc[ch] >= 0 ? (acc[ch] + count / 2) / count : (acc[ch] - count / 2) / count;
+    out[ch] = saturate(v, -128);
+  }
+}
+
+void tinymlFullyConnected(const int8_t *in, uint16_t inLen, const int8_t *weights,
+                          const TinymlRequant &rq, int8_t inZero, int8_t outZero, int8_t actMin,
+                          int8_t *out, uint16_t outLen) {
+  for (int o = 0; o < outLen; o++) {
+    const int8_t *w = weights + (size_t)o * inLen;
+    int32_t acc = rq.bias[o];
+    for (int i = 0; i < inLen; i++) acc += (in[i] - (int32_t)inZero) * w[i];
+    acc = tinymlRequantize(acc, rq.mult[o], rq.shift[o]) + outZero;
+    out[o] = saturate(acc, actMin);
+  }
+}
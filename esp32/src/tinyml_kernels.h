@@ -0,0 +1,79 @@
+/**
+ * Kernels int8 para la red del clasificador en la cámara (proyecto TPI2)
+ *
+ * Las mismas convenciones de cuantización que TensorFlow Lite Micro, para que
+ * un modelo exportado con yolo/export_tinyml.py dé lo mismo aquí que allí:
+ *  - Activaciones int8 asimétricas: real = (q - zero) * scale.
+ *  - Pesos int8 simétricos por canal de salida (sin zero point).
+ *  - Sesgo int32 en la escala entrada * peso.
+ *  - Cada acumulador se reescala con un multiplicador en punto fijo (mult de
+ *    31 bits y desplazamiento, ver tinymlRequantize) calculado al exportar: en
+ *    la cámara no hay coma flotante por píxel.
+ *  - ReLU va fusionada: el resultado se recorta por abajo a actMin.
+ *
+ * Tensores NHWC (canales contiguos) sin lote. Relleno simétrico de pad
+ * píxeles como en PyTorch; el relleno vale el zero point de la entrada.
+ *
+ * Código C++ sin dependencias del firmware (se compila igual en el banco de
+ * pruebas del host).
+ */
+
+#ifndef TINYML_KERNELS_H
+#define TINYML_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Canales como mucho por tensor (acumuladores de la convolución por canal en la pila)
+#define TINYML_MAX_CHANNELS 256
+
+struct TinymlShape {
+  uint16_t w;
+  uint16_t h;
+  uint16_t c;
+};
+
+// Reescalado por canal de salida (outC elementos cada uno)
+struct TinymlRequant {
+  const int32_t *bias;
+  const int32_t *mult;      // Mantisa en [2^30, 2^31)
+  const int32_t *shift;     // Exponente: > 0 a la izquierda, < 0 a la derecha
+};
+
+struct TinymlConvParams {
+  uint8_t kernel;           // Cuadrado: kernel x kernel
+  uint8_t stride;
+  uint8_t pad;
+  int8_t inZero;
+  int8_t outZero;
+  int8_t actMin;            // outZero con ReLU, -128 sin ella
+};
+
+// acc * mult * 2^shift / 2^31 con el redondeo de TFLite
+int32_t tinymlRequantize(int32_t acc, int32_t mult, int32_t shift);
+
+// Tamaño de salida de una convolución (0 si el kernel no cabe)
+uint16_t tinymlConvOutSize(uint16_t in, uint8_t kernel, uint8_t stride, uint8_t pad);
+
+// Gris 0-255 a int8 con scale 1/255 y zero -128 (la entrada de todos los modelos)
+void tinymlQuantizeGray(const uint8_t *gray, size_t count, int8_t *out);
+
+// Convolución normal. weights: [outC][kernel][kernel][in.c]
+void tinymlConv2d(const int8_t *in, const TinymlShape &inShape, const int8_t *weights,
+                  const TinymlRequant &rq, const TinymlConvParams &p, int8_t *out,
+                  const TinymlShape &outShape);
+
+// Convolución por canal (multiplicador 1, out.c == in.c). weights: [kernel][kernel][c]
+void tinymlDepthwiseConv2d(const int8_t *in, const TinymlShape &inShape, const int8_t *weights,
+                           const TinymlRequant &rq, const TinymlConvParams &p, int8_t *out,
+                           const TinymlShape &outShape);
+
+// Media de cada canal sobre toda la imagen; misma escala y zero que la entrada
+void tinymlGlobalAvgPool(const int8_t *in, const TinymlShape &inShape, int8_t *out);
+
+// Capa densa. weights: [outLen][inLen]
+void tinymlFullyConnected(const int8_t *in, uint16_t inLen, const int8_t *weights,
+                          const TinymlRequant &rq, int8_t inZero, int8_t outZero, int8_t actMin,
+                          int8_t *out, uint16_t outLen);
+
+#endif // TINYML_KERNELS_H
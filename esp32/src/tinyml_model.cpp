@@ -0,0 +1,177 @@
+/**
+ * Implementación del intérprete del clasificador (ver tinyml_model.h)
+ */
+
+#include "tinyml_model.h"
+
+#include <math.h>
+#include <string.h>
+
+#define HEADER_BYTES 16
+#define LAYER_BYTES  16
+
+static uint16_t readU16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t readU32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float readF32(const uint8_t *p) {
+  uint32_t bits = readU32(p);
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+TinymlModel::TinymlModel() : input_{0, 0, 0}, layerCount_(0), maxActivation_(0), macs_(0) {}
+
+bool TinymlModel::begin(const uint8_t *blob, size_t len) {
+  layerCount_ = 0;
+  maxActivation_ = 0;
+  macs_ = 0;
+  // Los int32 de cada capa se leen en su sitio: el blob tiene que estar alineado
+  if (blob == NULL || len < HEADER_BYTES || ((uintptr_t)blob & 3) != 0) return false;
+  if (memcmp(blob, "HTM1", 4) != 0 || readU32(blob + 12) != len) return false;
+
+  TinymlShape shape = {readU16(blob + 4), readU16(blob + 6), blob[8]};
+  uint8_t count = blob[9];
+  if (shape.w == 0 || shape.h == 0 || shape.c != 1 || count == 0 || count > TINYML_MAX_LAYERS) {
+    return false;
+  }
+  input_ = shape;
+  size_t maxAct = (size_t)shape.w * shape.h * shape.c;
+  uint32_t macs = 0;
+  int8_t zero = -128;  // Entrada: gris - 128
+
+  size_t off = HEADER_BYTES;
+  for (uint8_t i = 0; i < count; i++) {
+    if (off + LAYER_BYTES > len) return false;
+    const uint8_t *h = blob + off;
+    TinymlLayer &l = layers_[i];
+    l.type = h[0];
+    l.conv.kernel = h[1];
+    l.conv.stride = h[2];
+    l.conv.pad = h[3];
+    l.conv.inZero = zero;
+    l.conv.outZero = (int8_t)h[6];
+    l.conv.actMin = h[7] ? l.conv.outZero : -128;
+    l.outScale = readF32(h + 8);
+    uint32_t dataBytes = readU32(h + 12);
+    off += LAYER_BYTES;
+    if (off + dataBytes > len || (dataBytes & 3) != 0) return false;
+
+    uint16_t outC = readU16(h + 4);
+    l.in = shape;
+    size_t weightCount = 0;
+    switch (l.type) {
+      case TINYML_LAYER_CONV:
+      case TINYML_LAYER_DEPTHWISE: {
+        l.out.w = tinymlConvOutSize(shape.w, l.conv.kernel, l.conv.stride, l.conv.pad);
+        l.out.h = tinymlConvOutSize(shape.h, l.conv.kernel, l.conv.stride, l.conv.pad);
+        l.out.c = outC;
+        size_t taps = (size_t)l.conv.kernel * l.conv.kernel;
+        if (l.type == TINYML_LAYER_DEPTHWISE) {
+          if (outC != shape.c) return false;
+          weightCount = taps * outC;
+          l.macs = (uint32_t)(taps * l.out.w * l.out.h * outC);
+        } else {
+          weightCount = taps * shape.c * outC;
+          l.macs = (uint32_t)(weightCount * l.out.w * l.out.h);
+        }
+        break;
+      }
+      case TINYML_LAYER_AVGPOOL:
+        // Misma cuantización a la entrada y a la salida
+        l.out = {1, 1, shape.c};
+        l.conv.outZero = zero;
+        l.conv.actMin = -128;
+        l.macs = (uint32_t)shape.w * shape.h * shape.c;
+        outC = shape.c;
+        break;
+      case TINYML_LAYER_DENSE:
+        // Solo tras el pooling global: sin ambigüedad NHWC / NCHW al aplanar
+        if (shape.w != 1 || shape.h != 1) return false;
+        l.out = {1, 1, outC};
+        weightCount = (size_t)shape.c * outC;
+        l.macs = (uint32_t)weightCount;
+        break;
+      default:
+        return false;
+    }
+    if (l.out.w == 0 || l.out.h == 0 || outC == 0 || outC > TINYML_MAX_CHANNELS) return false;
+
+    if (l.type == TINYML_LAYER_AVGPOOL) {
+      if (dataBytes != 0) return false;
+      l.rq = {NULL, NULL, NULL};
+      l.weights = NULL;
+    } else {
+      size_t perChannel = (size_t)outC * sizeof(int32_t);
+      if (dataBytes != ((3 * perChannel + weightCount + 3) & ~(size_t)3)) return false;
+      const uint8_t *data = blob + off;
+      l.rq.bias = reinterpret_cast<const int32_t *>(data);
+      l.rq.mult = reinterpret_cast<const int32_t *>(data + perChannel);
+      l.rq.shift = reinterpret_cast<const int32_t *>(data + 2 * perChannel);
+      l.weights = reinterpret_cast<const int8_t *>(data + 3 * perChannel);
+    }
+    off += dataBytes;
+
+    size_t act = (size_t)l.out.w * l.out.h * l.out.c;
+    if (act > maxAct) maxAct = act;
+    macs += l.macs;
+    shape = l.out;
+    zero = l.conv.outZero;
+  }
+
+  // Una sola salida, el logit, de una capa densa
+  const TinymlLayer &last = layers_[count - 1];
+  if (off != len || last.type != TINYML_LAYER_DENSE || last.out.c != 1) return false;
+
+  layerCount_ = count;
+  maxActivation_ = maxAct;
+  macs_ = macs;
+  return true;
+}
+
+int8_t TinymlModel::run(const uint8_t *gray, int8_t *arena, float *probability) const {
+  if (!loaded()) {
+    if (probability) *probability = 0;
+    return 0;
+  }
+  int8_t *src = arena;
+  int8_t *dst = arena + maxActivation_;
+  tinymlQuantizeGray(gray, (size_t)input_.w * input_.h, src);
+
+  for (uint8_t i = 0; i < layerCount_; i++) {
+    const TinymlLayer &l = layers_[i];
+    switch (l.type) {
+      case TINYML_LAYER_CONV:
+        tinymlConv2d(src, l.in, l.weights, l.rq, l.conv, dst, l.out);
+        break;
+      case TINYML_LAYER_DEPTHWISE:
+        tinymlDepthwiseConv2d(src, l.in, l.weights, l.rq, l.conv, dst, l.out);
+        break;
+      case TINYML_LAYER_AVGPOOL:
+        tinymlGlobalAvgPool(src, l.in, dst);
+        break;
+      case TINYML_LAYER_DENSE:
+        tinymlFullyConnected(src, l.in.c, l.weights, l.rq,
+                             l.conv.inZero, l.conv.outZero, l.conv.actMin, dst, l.out.c);
+        break;
+    }
+    int8_t *t = src;
+    src = dst;
+    dst = t;
+  }
+
+  int8_t q = src[0];
+  if (probability) *probability = 1.0f / (1.0f + expf(-logit(q)));
+  return q;
+}
+
+float TinymlModel::logit(int8_t q) const {
+  if (!loaded()) return 0;
+  const TinymlLayer &last = layers_[layerCount_ - 1];
+  return (q - last.conv.outZero) * last.outScale;
+}
@@ -0,0 +1,88 @@
+/**
+ * Intérprete del clasificador de hipopótamos en la cámara (proyecto TPI2)
+ *
+ * yolo/export_tinyml.py entrena una red diminuta (convoluciones por canal al
+ * estilo MobileNet) sobre el dataset de YOLO, la cuantiza a int8 y la
+ * serializa en un blob que va compilado en el firmware (tinyml_model_data.h)
+ * o en un .bin para el banco de pruebas. Todo little-endian:
+ *
+ *   cabecera (16 B): "HTM1", ancho u16, alto u16, canales u8 (1: gris),
+ *                    capas u8, reservado u16, longitud total u32
+ *   por capa (16 B): tipo u8, kernel u8, stride u8, pad u8, canales de
+ *                    salida u16, zero de salida i8, relu u8, scale de salida
+ *                    f32, bytes de datos u32
+ *   datos de capa:   bias, mult y shift int32 por canal de salida, y después
+ *                    los pesos int8, rellenos hasta múltiplo de 4
+ *
+ * La entrada es la rejilla en gris de motion_jpeg.h (scale 1/255, zero -128).
+ * Las capas densas van tras el pooling global; la última tiene una salida: el
+ * logit de "hay hipopótamo".
+ *
+ * Las activaciones van en un arena del llamante (arenaBytes()) repartido en
+ * dos mitades que se alternan capa a capa; los pesos se leen del blob sin
+ * copiarlos (en el ESP32 siguen en flash).
+ *
+ * Sin dependencias del firmware; no es seguro entre tareas.
+ */
+
+#ifndef TINYML_MODEL_H
+#define TINYML_MODEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tinyml_kernels.h"
+
+#define TINYML_MAX_LAYERS 16
+
+enum TinymlLayerType {
+  TINYML_LAYER_CONV = 1,
+  TINYML_LAYER_DEPTHWISE = 2,
+  TINYML_LAYER_AVGPOOL = 3,     // Global: deja un vector de in.c
+  TINYML_LAYER_DENSE = 4,
+};
+
+struct TinymlLayer {
+  uint8_t type;
+  TinymlConvParams conv;        // Zero points y activación también para AVGPOOL / DENSE
+  TinymlShape in;
+  TinymlShape out;
+  float outScale;
+  TinymlRequant rq;
+  const int8_t *weights;
+  uint32_t macs;
+};
+
+class TinymlModel {
+ public:
+  TinymlModel();
+
+  // Interpreta el blob (tiene que seguir en memoria y alineado a 4).
+  // Devuelve false si no es un modelo válido.
+  bool begin(const uint8_t *blob, size_t len);
+
+  bool loaded() const { return layerCount_ > 0; }
+  const TinymlShape &input() const { return input_; }
+  uint8_t layerCount() const { return layerCount_; }
+  const TinymlLayer &layer(uint8_t i) const { return layers_[i]; }
+
+  // Bytes de arena que necesita run() y multiplicaciones por inferencia
+  size_t arenaBytes() const { return 2 * maxActivation_; }
+  uint32_t macs() const { return macs_; }
+
+  // Clasifica una rejilla en gris de input().w x input().h. Devuelve el logit
+  // cuantizado y, en *probability (opcional), su sigmoide (0-1).
+  int8_t run(const uint8_t *gray, int8_t *arena, float *probability) const;
+
+  // Logit real de una salida cuantizada de run()
+  float logit(int8_t q) const;
+
+ private:
+  TinymlShape input_;
+  TinymlLayer layers_[TINYML_MAX_LAYERS];
+  uint8_t layerCount_;
+  size_t maxActivation_;
+  uint32_t macs_;
+};
+
+#endif // TINYML_MODEL_H
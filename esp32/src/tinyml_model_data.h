@@ -0,0 +1,18 @@
+/**
+ * Modelo compilado del clasificador en la cámara (ver tinyml_model.h)
+ *
+ * Lo sobrescribe yolo/export_tinyml.py con el blob int8 del modelo entrenado.
+ * Esta versión no lleva modelo (TINYML_MODEL_LEN 0): con ella el filtro de
+ * tinyml_gate.h no descarta nada y todas las fotos se suben como siempre.
+ */
+
+#ifndef TINYML_MODEL_DATA_H
+#define TINYML_MODEL_DATA_H
+
+#include <stdint.h>
+
+#define TINYML_MODEL_LEN 0
+
+alignas(4) static const uint8_t kTinymlModel[] = {0};
+
+#endif // TINYML_MODEL_DATA_H
@@ -0,0 +1,310 @@
+/**
+ * Implementación del gestor de WiFi no bloqueante (ver wifi_manager.h)
+ */
+
+#include "wifi_manager.h"
+#include "config.h"
+
+#include <Preferences.h>
+#include <WiFi.h>
+
+enum WifiState {
+  WIFI_STATE_CONNECTING,
+  WIFI_STATE_CONNECTED,
+  WIFI_STATE_BACKOFF,
+  WIFI_STATE_SUSPENDED,
+};
+
+static WifiState state = WIFI_STATE_BACKOFF;
+static WifiStats stats;
+static unsigned long beginMs = 0;
+static unsigned long attemptStart = 0;
+static unsigned long retryAt = 0;
+static unsigned long downSince = 0;   // Inicio del corte en curso
+static uint32_t backoffMs = WIFI_BACKOFF_MIN;
+static bool everConnected = false;
+static bool fastPending = false;  // El próximo intento usa la caché
+static bool fastAttempt = false;  // El intento en curso es directo
+static bool resuming = false;     // Reconexión tras dormir, no tras una caída
+
+// Banderas escritas desde la tarea de eventos de WiFi
+static volatile bool eventGotIp = false;
+static volatile bool eventDisconnected = false;
+static volatile uint8_t eventReason = 0;
+
+static void onWifiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      eventGotIp = true;
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      eventReason = info.wifi_sta_disconnected.reason;
+      eventDisconnected = true;
+      break;
+    default:
+      break;
+  }
+}
+
+// ============================================================================
+// CACHÉ DE CONEXIÓN RÁPIDA
+// ============================================================================
+
+#define WIFI_CACHE_MAGIC 0x57464331  // "WFC1"
+
+struct WifiCache {
+  uint32_t magic;
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t reserved;
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+  uint32_t checksum;
+};
+
+// Tras un apagado la RAM RTC contiene basura: de ahí la suma de comprobación
+RTC_NOINIT_ATTR static WifiCache rtcCache;
+
+// FNV-1a sobre todo salvo la propia suma
+static uint32_t cacheChecksum(const WifiCache &c) {
+  const uint8_t *p = (const uint8_t *)&c;
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < offsetof(WifiCache, checksum); i++) h = (h ^ p[i]) * 16777619u;
+  return h;
+}
+
+static bool cacheValid(const WifiCache &c) {
+  return c.magic == WIFI_CACHE_MAGIC && c.channel != 0 && c.checksum == cacheChecksum(c);
+}
+
+// RTC primero (deep sleep / reinicio); si no, la copia de NVS (apagado)
+static bool loadCache() {
+  if (cacheValid(rtcCache)) return true;
+  Preferences prefs;
+  prefs.begin(WIFI_NVS_NAMESPACE, true);
+  size_t n = prefs.getBytes("cache", &rtcCache, sizeof(rtcCache));
+  prefs.end();
+  if (n == sizeof(rtcCache) && cacheValid(rtcCache)) return true;
+  memset(&rtcCache, 0, sizeof(rtcCache));
+  return false;
+}
+
+static void saveCache() {
+  const uint8_t *bssid = WiFi.BSSID();
+  if (!bssid) return;
+
+  WifiCache c = {};
+  c.magic = WIFI_CACHE_MAGIC;
+  memcpy(c.bssid, bssid, sizeof(c.bssid));
+  c.channel = (uint8_t)WiFi.channel();
+  c.ip = WiFi.localIP();
+  c.gateway = WiFi.gatewayIP();
+  c.subnet = WiFi.subnetMask();
+  c.dns = WiFi.dnsIP();
+  c.checksum = cacheChecksum(c);
+
+  // La NVS es flash: solo se reescribe si algo cambió
+  if (cacheValid(rtcCache) && memcmp(&c, &rtcCache, sizeof(c)) == 0) return;
+  rtcCache = c;
+  Preferences prefs;
+  prefs.begin(WIFI_NVS_NAMESPACE, false);
+  prefs.putBytes("cache", &c, sizeof(c));
+  prefs.end();
+  DEBUG_PRINTF("[WIFI] Caché actualizada (canal %u)\n", (unsigned)c.channel);
+}
+
+// ============================================================================
+// MÁQUINA DE ESTADOS
+// ============================================================================
+
+static void startAttempt() {
+  eventGotIp = false;
+  eventDisconnected = false;
+  stats.attempts++;
+  attemptStart = millis();
+  state = WIFI_STATE_CONNECTING;
+
+  fastAttempt = fastPending;
+  fastPending = false;
+  if (fastAttempt) {
+    stats.fastAttempts++;
+#if WIFI_FAST_STATIC_IP
+    WiFi.config(IPAddress(rtcCache.ip), IPAddress(rtcCache.gateway), IPAddress(rtcCache.subnet),
+                IPAddress(rtcCache.dns));
+#endif
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD, rtcCache.channel, rtcCache.bssid);
+    DEBUG_PRINTF("[WIFI] Conexión directa a %s (canal %u, intento %u)...\n", WIFI_SSID,
+                 (unsigned)rtcCache.channel, (unsigned)stats.attempts);
+  } else {
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    DEBUG_PRINTF("[WIFI] Conectando a %s (intento %u)...\n", WIFI_SSID, (unsigned)stats.attempts);
+  }
+}
+
+// AP cambiado de canal, otro router o un corte: conexión normal sin esperar.
+// La caché se conserva; si el escaneo conecta con otros datos, saveCache() la reemplaza.
+static void fallBackToScan() {
+  LOG_WARN("[WIFI] Conexión directa fallida, se intenta con escaneo\n");
+  WiFi.disconnect();
+#if WIFI_FAST_STATIC_IP
+  WiFi.config(IPAddress(), IPAddress(), IPAddress());  // De vuelta a DHCP
+#endif
+  startAttempt();
+}
+
+static void scheduleRetry() {
+  uint32_t wait = backoffMs + (uint32_t)random(0, backoffMs / 4 + 1);
+  retryAt = millis() + wait;
+  state = WIFI_STATE_BACKOFF;
+  backoffMs = min((uint32_t)WIFI_BACKOFF_MAX, backoffMs * 2);
+  DEBUG_PRINTF("[WIFI] Reintento en %u ms\n", (unsigned)wait);
+}
+
+static void onConnected() {
+  unsigned long now = millis();
+  state = WIFI_STATE_CONNECTED;
+  backoffMs = WIFI_BACKOFF_MIN;
+  stats.connects++;
+  stats.lastAttemptMs = now - attemptStart;
+  if (fastAttempt) stats.fastConnects++;
+#if WIFI_FAST_CONNECT
+  saveCache();
+#endif
+
+  if (resuming) {
+    resuming = false;
+  } else if (!everConnected) {
+    everConnected = true;
+    stats.firstConnectMs = now - beginMs;
+    stats.wakeToConnectMs = now;  // millis() vuelve a 0 al arrancar y al despertar
+  } else {
+    uint32_t outage = now - downSince;
+    stats.reconnects++;
+    stats.disconnectedMs += outage;
+    if (outage > stats.longestOutageMs) stats.longestOutageMs = outage;
+    DEBUG_PRINTF("[WIFI] Reconectado tras %u ms sin conexión\n", (unsigned)outage);
+  }
+  DEBUG_PRINTF("[WIFI] ✓ Conectado en %u ms (%s), IP: %s\n", (unsigned)stats.lastAttemptMs,
+               fastAttempt ? "directa" : "con escaneo", WiFi.localIP().toString().c_str());
+}
+
+void wifiManagerBegin() {
+  memset(&stats, 0, sizeof(stats));
+  beginMs = millis();
+  WiFi.mode(WIFI_STA);
+  // La reconexión la lleva este gestor, no la pila de WiFi
+  WiFi.setAutoReconnect(false);
+  // La caché propia sustituye a la que el SDK escribe en flash en cada begin()
+  WiFi.persistent(false);
+  WiFi.onEvent(onWifiEvent);
+#if WIFI_FAST_CONNECT
+  fastPending = loadCache();
+#endif
+  startAttempt();
+}
+
+void wifiManagerLoop() {
+  unsigned long now = millis();
+
+  switch (state) {
+    case WIFI_STATE_CONNECTING:
+      if (eventGotIp && WiFi.status() == WL_CONNECTED) {
+        eventGotIp = false;
+        onConnected();
+      } else if (fastAttempt &&
+                 (eventDisconnected || now - attemptStart >= WIFI_FAST_CONNECT_TIMEOUT)) {
+        fallBackToScan();
+      } else if (eventDisconnected || now - attemptStart >= WIFI_TIMEOUT) {
+        LOG_WARN("[WIFI] Intento fallido (motivo %u)\n",
+                 eventDisconnected ? (unsigned)eventReason : 0U);
+        eventDisconnected = false;
+        stats.lastReason = eventReason;
+        WiFi.disconnect();
+        scheduleRetry();
+      }
+      break;
+
+    case WIFI_STATE_CONNECTED:
+      if (eventDisconnected || WiFi.status() != WL_CONNECTED) {
+        eventDisconnected = false;
+        stats.disconnects++;
+        stats.lastReason = eventReason;
+        downSince = now;
+        LOG_WARN("[WIFI] Conexión perdida (motivo %u)\n", (unsigned)eventReason);
+        // Primer reintento casi inmediato (directo si hay caché); si falla, espera creciente
+        backoffMs = WIFI_BACKOFF_MIN;
+#if WIFI_FAST_CONNECT
+        fastPending = cacheValid(rtcCache);
+#endif
+        retryAt = now;
+        state = WIFI_STATE_BACKOFF;
+      }
+      break;
+
+    case WIFI_STATE_BACKOFF:
+      if ((long)(now - retryAt) >= 0) startAttempt();
+      break;
+
+    case WIFI_STATE_SUSPENDED:
+      break;
+  }
+}
+
+bool wifiManagerConnected() {
+  return state == WIFI_STATE_CONNECTED;
+}
+
+uint32_t wifiManagerOutageMs() {
+  if (state == WIFI_STATE_CONNECTED || state == WIFI_STATE_SUSPENDED || resuming || !everConnected) {
+    return 0;
+  }
+  return millis() - downSince;
+}
+
+const WifiStats &wifiManagerStats() {
+  return stats;
+}
+
+size_t wifiManagerToJson(char *out, size_t cap) {
+  int n = snprintf(out, cap,
+                   "{\"connected\":%s,\"rssi\":%d,\"attempts\":%u,\"reconnects\":%u,"
+                   "\"disconnects\":%u,\"lastReason\":%u,\"firstConnectMs\":%u,"
+                   "\"disconnectedMs\":%llu,\"longestOutageMs\":%u,\"wakeToConnectMs\":%u,"
+                   "\"lastAttemptMs\":%u,\"fastAttempts\":%u,\"fastConnects\":%u}",
+                   wifiManagerConnected() ? "true" : "false",
+                   wifiManagerConnected() ? (int)WiFi.RSSI() : 0, (unsigned)stats.attempts,
+                   (unsigned)stats.reconnects, (unsigned)stats.disconnects,
+                   (unsigned)stats.lastReason, (unsigned)stats.firstConnectMs,
+                   (unsigned long long)(stats.disconnectedMs + wifiManagerOutageMs()),
+                   (unsigned)stats.longestOutageMs, (unsigned)stats.wakeToConnectMs,
+                   (unsigned)stats.lastAttemptMs, (unsigned)stats.fastAttempts,
+                   (unsigned)stats.fastConnects);
+  return (n > 0 && (size_t)n < cap) ? (size_t)n : 0;
+}
+
+void wifiManagerSuspend() {
+  state = WIFI_STATE_SUSPENDED;
+  WiFi.disconnect(true);
+}
+
+void wifiManagerResume() {
+  resuming = true;
+  backoffMs = WIFI_BACKOFF_MIN;
+#if WIFI_FAST_CONNECT
+  fastPending = cacheValid(rtcCache);
+#endif
+  startAttempt();
+}
+
+void wifiManagerPrintStats() {
+  DEBUG_PRINTF("[WIFI] Intentos: %u, reconexiones: %u, caídas: %u, sin conexión: %llu ms "
+               "(corte más largo %u ms), primera conexión en %u ms\n",
+               (unsigned)stats.attempts, (unsigned)stats.reconnects, (unsigned)stats.disconnects,
+               (unsigned long long)(stats.disconnectedMs + wifiManagerOutageMs()),
+               (unsigned)stats.longestOutageMs, (unsigned)stats.firstConnectMs);
+  DEBUG_PRINTF("[WIFI] Arranque a conectado: %u ms, conexiones directas: %u/%u\n",
+               (unsigned)stats.wakeToConnectMs, (unsigned)stats.fastConnects,
+               (unsigned)stats.fastAttempts);
+}
@@ -0,0 +1,68 @@
+/**
+ * Gestor de WiFi no bloqueante (proyecto TPI2)
+ *
+ * Antes, connectWiFi() esperaba con delay(500) hasta WIFI_TIMEOUT y loop() la
+ * llamaba en cuanto caía la red, así que un punto de acceso inestable
+ * congelaba el dispositivo entero. Ahora:
+ *  - Los eventos de WiFi (IP obtenida / desconexión) solo marcan banderas.
+ *  - wifiManagerLoop(), llamada en cada vuelta de loop(), avanza una máquina
+ *    de estados: CONECTANDO -> CONECTADO -> ESPERA -> CONECTANDO...
+ *  - Cada intento dura como mucho WIFI_TIMEOUT; entre intentos fallidos la
+ *    espera se duplica desde WIFI_BACKOFF_MIN hasta WIFI_BACKOFF_MAX (con algo
+ *    de azar para que varias cámaras no reintenten a la vez).
+ *
+ * Mientras tanto el resto del firmware sigue funcionando (captura, cola offline).
+ *
+ * Conexión rápida (WIFI_FAST_CONNECT): tras cada conexión buena se guardan el
+ * BSSID, el canal y la concesión IP en memoria RTC (sobrevive al deep sleep y a
+ * los reinicios) y en NVS (sobrevive a un apagado; solo se escribe si cambian).
+ * El primer intento tras arrancar / despertar / perder la red va directo a ese
+ * AP, sin escaneo y, con WIFI_FAST_STATIC_IP, sin DHCP. Si falla en
+ * WIFI_FAST_CONNECT_TIMEOUT se pasa enseguida a la conexión normal con escaneo.
+ */
+
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <Arduino.h>
+
+struct WifiStats {
+  uint32_t attempts;        // Intentos de conexión lanzados
+  uint32_t connects;        // Conexiones con IP (la primera incluida)
+  uint32_t reconnects;      // Conexiones tras una caída
+  uint32_t disconnects;     // Caídas con la conexión establecida
+  uint8_t lastReason;       // Último wifi_err_reason_t recibido
+  uint32_t firstConnectMs;  // Desde wifiManagerBegin() hasta la primera IP
+  uint32_t wakeToConnectMs; // Desde el arranque / despertar hasta la primera IP
+  uint32_t lastAttemptMs;   // Duración del último intento que consiguió IP
+  uint32_t fastAttempts;    // Intentos directos con la caché
+  uint32_t fastConnects;    // ...que consiguieron IP
+  uint64_t disconnectedMs;  // Tiempo total sin conexión tras caídas (cortes cerrados)
+  uint32_t longestOutageMs;
+};
+
+// Registra los eventos y lanza el primer intento (no espera)
+void wifiManagerBegin();
+
+// Avanza la máquina de estados; no bloquea
+void wifiManagerLoop();
+
+bool wifiManagerConnected();
+
+// Duración del corte en curso (0 si hay conexión o aún no hubo ninguna)
+uint32_t wifiManagerOutageMs();
+
+const WifiStats &wifiManagerStats();
+
+// Escribe {"reconnects":..,"disconnectedMs":..,...} en out. Devuelve la longitud (0 si no cabe).
+size_t wifiManagerToJson(char *out, size_t cap);
+
+void wifiManagerPrintStats();
+
+// Antes de dormir: suelta la conexión y apaga la radio sin contarlo como caída
+void wifiManagerSuspend();
+
+// Al despertar: reconecta (directo a la caché si la hay)
+void wifiManagerResume();
+
+#endif // WIFI_MANAGER_H
@@ -0,0 +1,238 @@
+/**
+ * Implementación del cliente WebSocket de streaming (ver ws_stream.h)
+ */
+
+#include "ws_stream.h"
+
+WsStreamClient wsStream(SERVER_IP, SERVER_PORT, SERVER_WS_STREAM_PATH);
+
+static const uint8_t WS_OP_BINARY = 0x2;
+static const uint8_t WS_OP_CLOSE = 0x8;
+static const uint8_t WS_OP_PING = 0x9;
+static const uint8_t WS_OP_PONG = 0xA;
+
+// Trozo enmascarado por escritura (múltiplo de 4: la clave empieza alineada en cada uno)
+static const size_t WS_MASK_CHUNK = 1024;
+
+// Clave de máscara nueva (generador por hardware) escrita en out[0..3]
+static uint32_t writeMaskKey(uint8_t *out) {
+  uint32_t key = esp_random();
+  memcpy(out, &key, sizeof(key));
+  return key;
+}
+
+// XOR con la clave desde el byte 0 de la clave; de 4 en 4 salvo la cola
+static void applyMask(uint8_t *buf, size_t len, uint32_t key) {
+  const uint8_t *k = (const uint8_t *)&key;
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4) {
+    uint32_t w;
+    memcpy(&w, buf + i, sizeof(w));
+    w ^= key;
+    memcpy(buf + i, &w, sizeof(w));
+  }
+  for (; i < len; i++) buf[i] ^= k[i & 3];
+}
+
+// Clave de handshake: 16 bytes aleatorios en base64 (24 caracteres)
+static void makeHandshakeKey(char out[25]) {
+  static const char alphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  uint8_t raw[18];  // 16 aleatorios + 2 de relleno para agrupar de 3 en 3
+  for (int i = 0; i < 16; i++) raw[i] = (uint8_t)random(0, 256);
+  raw[16] = raw[17] = 0;
+
+  int o = 0;
+  for (int i = 0; i < 18; i += 3) {
+    uint32_t v = ((uint32_t)raw[i] << 16) | ((uint32_t)raw[i + 1] << 8) | raw[i + 2];
+    out[o++] = alphabet[(v >> 18) & 0x3F];
+    out[o++] = alphabet[(v >> 12) & 0x3F];
+    out[o++] = alphabet[(v >> 6) & 0x3F];
+    out[o++] = alphabet[v & 0x3F];
+  }
+  // 16 bytes -> 22 caracteres significativos + "=="
+  out[22] = '=';
+  out[23] = '=';
+  out[24] = '\0';
+}
+
+WsStreamClient::WsStreamClient(const char *host, uint16_t port, const char *path)
+    : host_(host), port_(port), path_(path), open_(false) {
+  memset(&stats_, 0, sizeof(stats_));
+#if USE_HTTPS
+  client_.setInsecure();
+#endif
+}
+
+bool WsStreamClient::connect() {
+  close();
+
+  if (!client_.connect(host_, port_, HTTP_TIMEOUT)) {
+    DEBUG_PRINTLN("[WS] Error al conectar con el servidor");
+    return false;
+  }
+  client_.setNoDelay(true);
+
+  char key[25];
+  makeHandshakeKey(key);
+
+  char request[384];
+  int n = snprintf(request, sizeof(request),
+                   "GET %s HTTP/1.1\r\n"
+                   "Host: %s:%u\r\n"
+                   "Upgrade: websocket\r\n"
+                   "Connection: Upgrade\r\n"
+                   "Sec-WebSocket-Key: %s\r\n"
+                   "Sec-WebSocket-Version: 13\r\n"
+                   "%s%s%s"
+                   "\r\n",
+                   path_, host_, (unsigned)port_, key,
+                   strlen(CAMERA_API_TOKEN) > 0 ? "X-Api-Key: " : "", CAMERA_API_TOKEN,
+                   strlen(CAMERA_API_TOKEN) > 0 ? "\r\n" : "");
+  if (n <= 0 || (size_t)n >= sizeof(request) ||
+      client_.write((const uint8_t *)request, n) != (size_t)n) {
+    client_.stop();
+    return false;
+  }
+  stats_.overheadBytes += n;
+
+  // Respuesta: "HTTP/1.1 101 Switching Protocols" + cabeceras hasta línea vacía.
+  // No se valida Sec-WebSocket-Accept: el servidor es el nuestro y ya respondió 101.
+  unsigned long deadline = millis() + HTTP_TIMEOUT;
+  char line[128];
+  size_t len = 0;
+  bool statusOk = false;
+  bool firstLine = true;
+  while ((long)(deadline - millis()) > 0) {
+    if (!client_.available()) {
+      if (!client_.connected()) break;
+      delay(1);
+      continue;
+    }
+    int c = client_.read();
+    if (c < 0) continue;
+    stats_.overheadBytes++;
+    if (c == '\r') continue;
+    if (c != '\n') {
+      if (len < sizeof(line) - 1) line[len++] = (char)c;
+      continue;
+    }
+    line[len] = '\0';
+    if (firstLine) {
+      statusOk = strncmp(line, "HTTP/1.1 101", 12) == 0;
+      firstLine = false;
+    } else if (len == 0) {
+      open_ = statusOk;
+      break;
+    }
+    len = 0;
+  }
+
+  if (!open_) {
+    DEBUG_PRINTLN("[WS] Handshake rechazado por el servidor");
+    client_.stop();
+    return false;
+  }
+
+  stats_.connects++;
+  DEBUG_PRINTF("[WS] Conectado a %s\n", path_);
+  return true;
+}
+
+bool WsStreamClient::connected() {
+  return open_ && client_.connected();
+}
+
+void WsStreamClient::drainIncoming() {
+  // El servidor no envía datos en este canal salvo control (ping / close)
+  while (client_.available() >= 2) {
+    uint8_t h[2];
+    client_.read(h, 2);
+    uint8_t opcode = h[0] & 0x0F;
+    size_t len = h[1] & 0x7F;
+    if (len >= 126) {
+      // Control frames nunca superan 125 bytes: algo raro, se reinicia la conexión
+      close();
+      return;
+    }
+    uint8_t payload[125];
+    size_t got = 0;
+    unsigned long deadline = millis() + 200;
+    while (got < len && (long)(deadline - millis()) > 0) {
+      int r = client_.read(payload + got, len - got);
+      if (r > 0) got += r;
+    }
+    if (opcode == WS_OP_CLOSE) {
+      DEBUG_PRINTLN("[WS] El servidor cerró la conexión");
+      close();
+      return;
+    }
+    if (opcode == WS_OP_PING) {
+      uint8_t pong[6] = {(uint8_t)(0x80 | WS_OP_PONG), (uint8_t)(0x80 | got)};
+      applyMask(payload, got, writeMaskKey(pong + 2));
+      client_.write(pong, sizeof(pong));
+      client_.write(payload, got);
+      stats_.overheadBytes += sizeof(pong) + got;
+    }
+  }
+}
+
+bool WsStreamClient::sendBinary(const uint8_t *data, size_t len) {
+  if (!connected() && !connect()) {
+    stats_.sendErrors++;
+    return false;
+  }
+  drainIncoming();
+  if (!open_) return false;
+
+  // Cabecera: FIN + binario, longitud (7 / 16 / 64 bits) con bit de máscara y clave
+  uint8_t header[14];
+  size_t h = 0;
+  header[h++] = 0x80 | WS_OP_BINARY;
+  if (len < 126) {
+    header[h++] = 0x80 | (uint8_t)len;
+  } else if (len <= 0xFFFF) {
+    header[h++] = 0x80 | 126;
+    header[h++] = (uint8_t)(len >> 8);
+    header[h++] = (uint8_t)len;
+  } else {
+    header[h++] = 0x80 | 127;
+    for (int i = 7; i >= 0; i--) header[h++] = (uint8_t)((uint64_t)len >> (8 * i));
+  }
+  uint32_t key = writeMaskKey(header + h);
+  h += 4;
+
+  METRIC_START(t0);
+  bool ok = client_.write(header, h) == h;
+  uint8_t chunk[WS_MASK_CHUNK];
+  for (size_t off = 0; ok && off < len; off += WS_MASK_CHUNK) {
+    size_t n = len - off < WS_MASK_CHUNK ? len - off : WS_MASK_CHUNK;
+    memcpy(chunk, data + off, n);
+    applyMask(chunk, n, key);
+    ok = client_.write(chunk, n) == n;
+  }
+  if (!ok) {
+    LOG_ERROR("[WS] Error al enviar frame\n");
+    stats_.sendErrors++;
+    close();
+    return false;
+  }
+
+  METRIC_STOP(METRIC_WS_SEND, t0);
+  METRIC_ADD(METRIC_BYTES_SENT, h + len);
+  stats_.framesSent++;
+  stats_.payloadBytes += len;
+  stats_.overheadBytes += h;
+  return true;
+}
+
+void WsStreamClient::close() {
+  if (open_ && client_.connected()) {
+    // Frame de cierre enmascarado, sin código de estado
+    uint8_t frame[6] = {(uint8_t)(0x80 | WS_OP_CLOSE), 0x80};
+    writeMaskKey(frame + 2);
+    client_.write(frame, sizeof(frame));
+  }
+  open_ = false;
+  client_.stop();
+}
@@ -0,0 +1,69 @@
+/**
+ * Transporte WebSocket para el streaming de frames (proyecto TPI2)
+ *
+ * Mismo canal que usa la Raspberry: `ws://<host>/ws/camera-stream?cameraId=...`.
+ * Cada frame JPEG viaja como un mensaje binario sobre un único socket, sin
+ * cabeceras HTTP ni sobre multipart por frame.
+ *
+ * RFC 6455 (5.3) obliga a enmascarar los frames cliente -> servidor con una
+ * clave nueva e impredecible en cada frame (protege a los proxies intermedios
+ * del envenenamiento de caché). La clave sale de esp_random() y el JPEG se
+ * enmascara por trozos en un buffer de pila al enviarlo: fb->buf no se toca
+ * ni se copia entero.
+ */
+
+#ifndef WS_STREAM_H
+#define WS_STREAM_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "config.h"
+#include "metrics.h"
+
+#if USE_HTTPS
+#include <WiFiClientSecure.h>
+#endif
+
+struct WsStats {
+  uint32_t connects;
+  uint32_t framesSent;
+  uint32_t sendErrors;
+  uint64_t payloadBytes;    // Bytes de JPEG enviados
+  uint64_t overheadBytes;   // Handshake + cabeceras de frame WebSocket
+};
+
+class WsStreamClient {
+ public:
+  WsStreamClient(const char *host, uint16_t port, const char *path);
+
+  // Abre el socket y hace el handshake HTTP Upgrade
+  bool connect();
+  bool connected();
+
+  // Envía un mensaje binario. Reconecta si el socket se cerró.
+  bool sendBinary(const uint8_t *data, size_t len);
+
+  // Cierre ordenado (frame de cierre + socket)
+  void close();
+
+  const WsStats &stats() const { return stats_; }
+
+ private:
+  void drainIncoming();
+
+  const char *host_;
+  uint16_t port_;
+  const char *path_;
+#if USE_HTTPS
+  WiFiClientSecure client_;
+#else
+  WiFiClient client_;
+#endif
+  bool open_;
+  WsStats stats_;
+};
+
+// Cliente hacia SERVER_WS_STREAM_PATH del backend
+extern WsStreamClient wsStream;
+
+#endif // WS_STREAM_H
@@ -32,6 +32,12 @@ const HIPPO_MODEL_PATH =
 // HTTP server (needed to attach WebSocket server)
 const server = http.createServer(app);
 
+// Las cámaras ESP32 reutilizan un único socket keep-alive para control y subidas.
+// El valor por defecto de Node (5 s) lo cerraría entre sondeos en enlaces 4G lentos.
+const HTTP_KEEP_ALIVE_MS = Number(process.env.HTTP_KEEP_ALIVE_MS || '65000');
+server.keepAliveTimeout = HTTP_KEEP_ALIVE_MS;
+server.headersTimeout = HTTP_KEEP_ALIVE_MS + 5000;
+
 // Middlewares
 app.use(express.json({ limit: '10mb' }));
 
@@ -50,7 +56,20 @@ const verifyCameraAuth = (req, res, next) => {
 // In-memory stores for demo / development (non-persistent).
 // latestFrames: cameraId -> { buffer, timestamp, hasHippo?: boolean, hippoDetection?: any }
 const latestFrames = new Map();
-const cameraActions = new Map(); // cameraId -> { photoRequested?: boolean, photoRequestedAt?: number, streamUntil?: number, currentStreamSessionId?: string }
+const cameraMetrics = new Map(); // cameraId -> último informe de métricas (status.metrics)
+const cameraActions = new Map(); // cameraId -> { photoRequested?: boolean, photoRequestedAt?: number, burstRequested?: { count, intervalMs }, streamUntil?: number, streamSentUntil?: number, stopRequested?: boolean, currentStreamSessionId?: string, roi?: { id, x, y, w, h, confirmedAt }, roiSentId?: number }
+
+// Peticiones de control en espera (long-poll): cameraId -> Set<() => void>
+const controlWaiters = new Map();
+const MAX_CONTROL_WAIT_SECONDS = Number(process.env.MAX_CONTROL_WAIT_SECONDS || '30');
+
+// Despierta a las cámaras que esperan en take-photo-or-video?wait=N
+const notifyControlWaiters = (cameraId) => {
+  const waiters = controlWaiters.get(cameraId);
+  if (!waiters) return;
+  controlWaiters.delete(cameraId);
+  waiters.forEach((wake) => wake());
+};
 
 // Healthcheck
 app.get('/api/health', (_req, res) => {
@@ -70,6 +89,7 @@ app.post('/api/cameras/:cameraId/status', verifyCameraAuth, async (req, res) =>
       url,
       enabled = true,
       coordinates,
+      metrics,
     } = req.body || {};
 
     if (!status || !type) {
@@ -103,6 +123,11 @@ app.post('/api/cameras/:cameraId/status', verifyCameraAuth, async (req, res) =>
 
     const saved = await cameraRepo.save(camera);
 
+    // Histogramas de latencia por etapa enviados por la ESP32-CAM (ver esp32/src/metrics.h)
+    if (metrics && typeof metrics === 'object') {
+      cameraMetrics.set(cameraId, { receivedAt: new Date(), ...metrics });
+    }
+
     res.json({ ok: true, camera: saved });
   } catch (err) {
     // eslint-disable-next-line no-console
@@ -111,6 +136,15 @@ app.post('/api/cameras/:cameraId/status', verifyCameraAuth, async (req, res) =>
   }
 });
 
+// Últimas métricas de latencia recibidas de una cámara
+app.get('/api/cameras/:cameraId/metrics', (req, res) => {
+  const metrics = cameraMetrics.get(req.params.cameraId);
+  if (!metrics) {
+    return res.status(404).json({ error: 'No metrics reported for this camera' });
+  }
+  res.json(metrics);
+});
+
 // Receive an event (generic) from a Raspberry Pi
 app.post('/api/cameras/:cameraId/events', verifyCameraAuth, async (req, res) => {
   try {
@@ -348,12 +382,20 @@ const generateVideoForSession = async (sessionId) => {
   }
 };
 
+// Un temporizador por sesión: parar o alargar un streaming lo reprograma
+const videoTimers = new Map(); // sessionId -> Timeout
+
 const scheduleVideoGeneration = (sessionId, durationSeconds) => {
   const bufferSeconds = 5; // margen para últimos frames
   const delayMs = (durationSeconds + bufferSeconds) * 1000;
-  setTimeout(() => {
-    generateVideoForSession(sessionId);
-  }, delayMs);
+  clearTimeout(videoTimers.get(sessionId));
+  videoTimers.set(
+    sessionId,
+    setTimeout(() => {
+      videoTimers.delete(sessionId);
+      generateVideoForSession(sessionId);
+    }, delayMs),
+  );
 };
 
 // ----------------------------
@@ -464,12 +506,40 @@ app.post('/api/cameras/:cameraId/photo', upload.single('image'), async (req, res
     const relativeUrl = `/uploads/${cameraId}/photos/${req.file.filename}`;
     const absolutePath = req.file.path; // ruta en disco que usaremos para la inferencia
 
+    // Fotos reenviadas desde la cola offline de la cámara: capturedAgeMs indica
+    // cuánto hace que se tomó, para no fecharlas en el momento de la subida
+    const capturedAgeMs = Number(req.query.capturedAgeMs);
+    const capturedAt =
+      Number.isFinite(capturedAgeMs) && capturedAgeMs >= 0
+        ? new Date(Date.now() - capturedAgeMs)
+        : new Date();
+
+    // Fotos disparadas por el PIR de la cámara llegan con ?trigger=motion, las
+    // de su detector de movimiento con ?trigger=vision y las de una ráfaga con
+    // ?trigger=burst
+    const triggerSource = ['motion', 'vision', 'burst'].includes(req.query.trigger) ? req.query.trigger : 'device';
+
+    // Foto pedida con request-photo: tiempo desde la petición hasta que llega
+    // (la cámara puede haberla tomado en mitad de un streaming)
+    const actions = cameraActions.get(cameraId);
+    let requestLatencyMs = null;
+    if (triggerSource === 'device' && !Number.isFinite(capturedAgeMs) && actions?.photoRequestedAt) {
+      requestLatencyMs = Date.now() - actions.photoRequestedAt;
+      // eslint-disable-next-line no-console
+      console.log(
+        `[PHOTO] Cámara ${cameraId}: foto pedida hace ${requestLatencyMs} ms` +
+          (actions.photoDuringStream ? ' (durante un streaming)' : ''),
+      );
+      actions.photoRequestedAt = undefined;
+      actions.photoDuringStream = false;
+    }
+
     // Guardar la foto en la base de datos
     const photo = photoRepo.create({
       image_path: relativeUrl,
       thumbnail_path: relativeUrl,
-      trigger_source: 'device',
-      captured_at: new Date(),
+      trigger_source: triggerSource,
+      captured_at: capturedAt,
       camera,
     });
     const savedPhoto = await photoRepo.save(photo);
@@ -530,12 +600,16 @@ app.post('/api/cameras/:cameraId/photo', upload.single('image'), async (req, res
     });
 
     res.status(201).json({
+      // Resumen para la cámara (DETECT_FEEDBACK): va el primero para que lo lea
+      // sin recibir el JSON entero
+      ...(hippoDetection && { hippoCount: hippoDetection.numHippos || 0 }),
       ok: true,
       imageUrl: relativeUrl,
       photo: savedPhoto,
       event: savedEvent,
       hasHippo,
       hippoDetection,
+      requestLatencyMs,
     });
   } catch (err) {
     // eslint-disable-next-line no-console
@@ -647,17 +721,284 @@ app.get('/api/cameras/:cameraId/live-frame-detection', (req, res) => {
   });
 });
 
+// Guarda un frame de streaming en la carpeta de vídeo de la sesión
+// Devuelve { sessionId, fullPath } para que el llamante pueda lanzar inferencia.
+// Sin sesión de streaming, los frames de un mismo evento comparten carpeta
+// (`group`): `preroll-<id>` para el pre-roll de una foto, `motion-<id>` para
+// un streaming que la cámara inició al detectar movimiento.
+// Los frames de un lote llevan su número de secuencia en el nombre: dos pueden
+// compartir milisegundo.
+const saveLiveFrame = (cameraId, buffer, nowTs, group = null, seq = null) => {
+  const actions = cameraActions.get(cameraId) || {};
+  const sessionId = actions.currentStreamSessionId || group || `${Date.now()}`;
+  const videoDir = path.join(uploadsRoot, cameraId || 'unknown', 'videos', sessionId);
+  fs.mkdirSync(videoDir, { recursive: true });
+  const filename = seq === null ? `${nowTs}.jpg` : `${nowTs}-${seq}.jpg`;
+  const fullPath = path.join(videoDir, filename);
+
+  try {
+    fs.writeFileSync(fullPath, buffer);
+  } catch (err) {
+    // eslint-disable-next-line no-console
+    console.error('Error writing video frame to disk', err);
+  }
+
+  return { sessionId, fullPath };
+};
+
+// Suma un frame a las métricas de la sesión de streaming activa (si la hay).
+// Incremento atómico en la base de datos: los frames por WebSocket llegan sin
+// esperar a que termine la actualización anterior.
+const recordSessionFrame = async (cameraId, bytes, frames = 1) => {
+  const actions = cameraActions.get(cameraId) || {};
+  if (!actions.currentStreamSessionId) return;
+  try {
+    const sessionRepo = AppDataSource.getRepository('StreamSession');
+    const where = { id: actions.currentStreamSessionId };
+    await sessionRepo.increment(where, 'frame_count', frames);
+    await sessionRepo.increment(where, 'bytes_sent', bytes);
+  } catch (err) {
+    // eslint-disable-next-line no-console
+    console.error('Error updating stream session metrics', err);
+  }
+};
+
+// Streaming iniciado por la cámara al detectar movimiento (?motion=<id>): sin
+// sesión pedida desde aquí, sus frames se agrupan en `motion-<id>`
+const motionGroup = (req) =>
+  /^\d+$/.test(String(req.query.motion || '')) ? `motion-${req.query.motion}` : null;
+
+// Región de interés del streaming: con hipopótamos en un frame en vivo, la
+// cámara recorta el sensor a la zona donde están (misma resolución de salida,
+// más detalle). Coordenadas en milésimas del campo completo del sensor.
+const STREAM_ROI_ENABLED = process.env.STREAM_ROI !== '0';
+// Sin detecciones que la confirmen, la región caduca y se vuelve al campo completo
+const STREAM_ROI_TTL_MS = Number(process.env.STREAM_ROI_TTL_MS || '5000');
+// Margen alrededor de las cajas (fracción de su tamaño) y lado mínimo (fracción del campo)
+const STREAM_ROI_MARGIN = Number(process.env.STREAM_ROI_MARGIN || '0.5');
+const STREAM_ROI_MIN_SIZE = Number(process.env.STREAM_ROI_MIN_SIZE || '0.25');
+// Si la región ocupa más de esta fracción del campo no compensa recortar
+const STREAM_ROI_MAX_AREA = Number(process.env.STREAM_ROI_MAX_AREA || '0.5');
+// Mientras la región nueva se solape así con la actual, solo se confirma la actual
+const STREAM_ROI_MIN_IOU = 0.6;
+
+const roiTimers = new Map(); // cameraId -> Timeout (caducidad de la región)
+
+// Ventana con la que se capturó un frame (?roi=x,y,w,h en milésimas), en fracciones
+const frameWindow = (req) => {
+  const parts = String(req.query.roi || '').split(',').map(Number);
+  if (parts.length !== 4 || parts.some((v) => !Number.isFinite(v) || v < 0 || v > 1000)) {
+    return { x: 0, y: 0, w: 1, h: 1 };
+  }
+  const [x, y, w, h] = parts.map((v) => v / 1000);
+  return w > 0 && h > 0 ? { x, y, w, h } : { x: 0, y: 0, w: 1, h: 1 };
+};
+
+const rectIou = (a, b) => {
+  const ix = Math.max(0, Math.min(a.x + a.w, b.x + b.w) - Math.max(a.x, b.x));
+  const iy = Math.max(0, Math.min(a.y + a.h, b.y + b.h) - Math.max(a.y, b.y));
+  const inter = ix * iy;
+  const union = a.w * a.h + b.w * b.h - inter;
+  return union > 0 ? inter / union : 0;
+};
+
+// La región vigente de una cámara, o null si no hay o caducó
+const currentStreamRoi = (actions, now = Date.now()) =>
+  actions && actions.roi && now - actions.roi.confirmedAt < STREAM_ROI_TTL_MS ? actions.roi : null;
+
+// La región cambió (o caducó) desde la última respuesta a la cámara
+const streamRoiPending = (cameraId) => {
+  const actions = cameraActions.get(cameraId);
+  const roi = currentStreamRoi(actions);
+  return STREAM_ROI_ENABLED && (roi ? roi.id : 0) !== ((actions && actions.roiSentId) || 0);
+};
+
+// Actualiza la región con la detección de un frame en vivo capturado con la
+// ventana `window`. Solo las detecciones la crean o confirman; si dejan de
+// llegar, caduca y se despierta a la cámara para que vuelva al campo completo.
+const updateStreamRoi = (cameraId, detection, window) => {
+  if (!STREAM_ROI_ENABLED || !detection || !detection.ok) return;
+  const imgW = Number(detection.image_width);
+  const imgH = Number(detection.image_height);
+  const boxes = (detection.hippos || [])
+    .map((h) => h.bbox_xyxy)
+    .filter((b) => Array.isArray(b) && b.length === 4);
+  if (!boxes.length || !(imgW > 0) || !(imgH > 0)) return;
+
+  // Unión de las cajas, del frame (recortado) al campo completo
+  const x1 = Math.min(...boxes.map((b) => b[0])) / imgW;
+  const y1 = Math.min(...boxes.map((b) => b[1])) / imgH;
+  const x2 = Math.max(...boxes.map((b) => b[2])) / imgW;
+  const y2 = Math.max(...boxes.map((b) => b[3])) / imgH;
+  const cx = window.x + ((x1 + x2) / 2) * window.w;
+  const cy = window.y + ((y1 + y2) / 2) * window.h;
+  const w = Math.min(1, Math.max(STREAM_ROI_MIN_SIZE, (x2 - x1) * window.w * (1 + STREAM_ROI_MARGIN)));
+  const h = Math.min(1, Math.max(STREAM_ROI_MIN_SIZE, (y2 - y1) * window.h * (1 + STREAM_ROI_MARGIN)));
+  const rect = {
+    x: Math.min(Math.max(cx - w / 2, 0), 1 - w),
+    y: Math.min(Math.max(cy - h / 2, 0), 1 - h),
+    w,
+    h,
+  };
+
+  const now = Date.now();
+  const actions = cameraActions.get(cameraId) || {};
+  const current = currentStreamRoi(actions, now);
+  let changed = false;
+  if (w * h > STREAM_ROI_MAX_AREA) {
+    // Los animales ocupan casi todo el campo: mejor sin recortar
+    changed = !!current;
+    actions.roi = undefined;
+  } else if (
+    current &&
+    rectIou({ x: current.x / 1000, y: current.y / 1000, w: current.w / 1000, h: current.h / 1000 }, rect) >=
+      STREAM_ROI_MIN_IOU
+  ) {
+    current.confirmedAt = now;
+  } else {
+    actions.roiSeq = (actions.roiSeq || 0) + 1;
+    actions.roi = {
+      id: actions.roiSeq,
+      x: Math.round(rect.x * 1000),
+      y: Math.round(rect.y * 1000),
+      w: Math.round(rect.w * 1000),
+      h: Math.round(rect.h * 1000),
+      confirmedAt: now,
+    };
+    changed = true;
+  }
+  cameraActions.set(cameraId, actions);
+
+  clearTimeout(roiTimers.get(cameraId));
+  if (actions.roi) {
+    roiTimers.set(
+      cameraId,
+      setTimeout(() => {
+        roiTimers.delete(cameraId);
+        notifyControlWaiters(cameraId);
+      }, STREAM_ROI_TTL_MS + 50),
+    );
+  }
+  if (changed) {
+    const { roi } = actions;
+    // eslint-disable-next-line no-console
+    console.log(
+      roi
+        ? `Camera ${cameraId} ROI #${roi.id}: ${roi.x},${roi.y} ${roi.w}x${roi.h} (milésimas)`
+        : `Camera ${cameraId} ROI: campo completo`,
+    );
+    notifyControlWaiters(cameraId);
+  }
+};
+
+// Lote de frames en una sola petición (Content-Type FRAME_BATCH_TYPE), para
+// que en enlaces con mucha latencia no haya una petición por frame:
+//   cabecera: "HTFB" | versión (1 byte, = 1) | n.º de frames (1 byte) | 2 bytes reservados
+//   por frame: seq (u32 LE) | antigüedad en ms al enviar (u32 LE) | longitud (u32 LE) | JPEG
+// Devuelve [{ seq, ageMs, buffer }] o null si el cuerpo está mal formado.
+const FRAME_BATCH_TYPE = 'application/vnd.hipotrack.frames';
+const parseFrameBatch = (body) => {
+  if (!Buffer.isBuffer(body) || body.length < 8) return null;
+  if (body.toString('latin1', 0, 4) !== 'HTFB' || body[4] !== 1) return null;
+  const count = body[5];
+  const frames = [];
+  let off = 8;
+  for (let i = 0; i < count; i += 1) {
+    if (off + 12 > body.length) return null;
+    const seq = body.readUInt32LE(off);
+    const ageMs = body.readUInt32LE(off + 4);
+    const len = body.readUInt32LE(off + 8);
+    off += 12;
+    if (off + len > body.length) return null;
+    frames.push({ seq, ageMs, buffer: body.subarray(off, off + len) });
+    off += len;
+  }
+  return off === body.length ? frames : null;
+};
+
+// Lote de frames: todos se guardan con su instante de captura; el más reciente
+// pasa a ser el frame en vivo y es el único que pasa por la inferencia (así
+// la respuesta no espera una inferencia por frame).
+const handleFrameBatch = async (req, res) => {
+  const { cameraId } = req.params;
+  const group = motionGroup(req);
+  const frames = parseFrameBatch(req.body);
+  if (!frames || !frames.length) {
+    return res.status(400).json({ error: 'Malformed frame batch' });
+  }
+
+  const now = Date.now();
+  let sessionId = null;
+  let newest = null;
+  let bytes = 0;
+  frames.forEach((frame) => {
+    const ts = now - frame.ageMs;
+    const saved = saveLiveFrame(cameraId, frame.buffer, ts, group, frame.seq);
+    sessionId = saved.sessionId;
+    bytes += frame.buffer.length;
+    if (!newest || ts >= newest.ts) newest = { ...frame, ts, fullPath: saved.fullPath };
+  });
+
+  latestFrames.set(cameraId, { buffer: newest.buffer, timestamp: newest.ts });
+
+  const detection = await runHippoInference(newest.fullPath).catch((err) => {
+    // eslint-disable-next-line no-console
+    console.error('Error running hippo inference (live-frame batch)', err);
+    return { ok: false, error: 'inference_exception' };
+  });
+  if (detection && detection.ok) {
+    latestFrames.set(cameraId, {
+      buffer: newest.buffer,
+      timestamp: newest.ts,
+      hasHippo: (detection.num_hippos || 0) > 0,
+      hippoDetection: { numHippos: detection.num_hippos, hippos: detection.hippos },
+    });
+    updateStreamRoi(cameraId, detection, frameWindow(req));
+  }
+
+  await recordSessionFrame(cameraId, bytes, frames.length);
+
+  return res.json({
+    ...(detection && detection.ok && { hippoCount: detection.num_hippos || 0 }),
+    ok: true,
+    sessionId,
+    frames: frames.length,
+    lastSeq: newest.seq,
+  });
+};
+
 // Endpoint para recibir frames de streaming vía HTTP (alternativa al WebSocket).
-// POST /api/cameras/:cameraId/live-frame  (multipart/form-data, campo "image")
-app.post('/api/cameras/:cameraId/live-frame', verifyCameraAuth, memoryUpload.single('image'), async (req, res) => {
+// POST /api/cameras/:cameraId/live-frame  (multipart/form-data, campo "image",
+// o un lote de frames con Content-Type FRAME_BATCH_TYPE)
+const frameBatchBody = express.raw({ type: FRAME_BATCH_TYPE, limit: '10mb' });
+app.post('/api/cameras/:cameraId/live-frame', verifyCameraAuth, frameBatchBody, memoryUpload.single('image'), async (req, res) => {
   try {
     const { cameraId } = req.params;
 
+    if (req.is(FRAME_BATCH_TYPE)) {
+      await handleFrameBatch(req, res);
+      return undefined;
+    }
+
     if (!req.file || !req.file.buffer) {
       return res.status(400).json({ error: 'Missing image file in "image" field' });
     }
 
-    const nowTs = Date.now();
+    // Frames de pre-roll (?preroll=<id>&capturedAgeMs=N): capturados antes de
+    // la acción. Se fechan con su antigüedad para que queden por delante de los
+    // frames en vivo en el vídeo, y no sustituyen al último frame en vivo.
+    const prerollId = /^\d+$/.test(String(req.query.preroll || '')) ? req.query.preroll : null;
+    const capturedAgeMs = Number(req.query.capturedAgeMs);
+    const nowTs =
+      Number.isFinite(capturedAgeMs) && capturedAgeMs >= 0
+        ? Date.now() - capturedAgeMs
+        : Date.now();
+
+    if (prerollId) {
+      const { sessionId } = saveLiveFrame(cameraId, req.file.buffer, nowTs, `preroll-${prerollId}`);
+      await recordSessionFrame(cameraId, req.file.buffer.length);
+      return res.json({ ok: true, sessionId, preroll: true });
+    }
 
     // Actualizar último frame en memoria (detección se rellenará más abajo si procede)
     latestFrames.set(cameraId, {
@@ -666,23 +1007,12 @@ app.post('/api/cameras/:cameraId/live-frame', verifyCameraAuth, memoryUpload.sin
     });
 
     // Guardar frame en disco dentro de una carpeta de vídeo por sesión
-    const actions = cameraActions.get(cameraId) || {};
-    const sessionId = actions.currentStreamSessionId || `${Date.now()}`;
-    const videoDir = path.join(uploadsRoot, cameraId || 'unknown', 'videos', sessionId);
-    fs.mkdirSync(videoDir, { recursive: true });
-    const filename = `${nowTs}.jpg`;
-    const fullPath = path.join(videoDir, filename);
-
-    try {
-      fs.writeFileSync(fullPath, req.file.buffer);
-    } catch (err) {
-      // eslint-disable-next-line no-console
-      console.error('Error writing video frame to disk', err);
-    }
+    const { sessionId, fullPath } = saveLiveFrame(cameraId, req.file.buffer, nowTs, motionGroup(req));
 
     // Ejecutar inferencia de hipopótamos sobre el frame de streaming,
     // igual que hacemos con las fotos. Esto garantiza que la detección
     // en vivo se comporte igual que la de fotos individuales.
+    let hippoCount;
     try {
       const detection = await runHippoInference(fullPath).catch((err) => {
         // eslint-disable-next-line no-console
@@ -696,6 +1026,7 @@ app.post('/api/cameras/:cameraId/live-frame', verifyCameraAuth, memoryUpload.sin
           hippos: detection.hippos,
         };
         const hasHippo = (detection.num_hippos || 0) > 0;
+        hippoCount = detection.num_hippos || 0;
 
         const existing = latestFrames.get(cameraId) || {};
         latestFrames.set(cameraId, {
@@ -705,6 +1036,7 @@ app.post('/api/cameras/:cameraId/live-frame', verifyCameraAuth, memoryUpload.sin
           hasHippo,
           hippoDetection,
         });
+        updateStreamRoi(cameraId, detection, frameWindow(req));
       }
     } catch (err) {
       // eslint-disable-next-line no-console
@@ -712,24 +1044,10 @@ app.post('/api/cameras/:cameraId/live-frame', verifyCameraAuth, memoryUpload.sin
     }
 
     // Actualizar métricas de la sesión en la base de datos
-    if (actions.currentStreamSessionId) {
-      try {
-        const sessionRepo = AppDataSource.getRepository('StreamSession');
-        const session = await sessionRepo.findOne({
-          where: { id: actions.currentStreamSessionId },
-        });
-        if (session) {
-          session.frame_count += 1;
-          session.bytes_sent = Number(session.bytes_sent || 0) + req.file.buffer.length;
-          await sessionRepo.save(session);
-        }
-      } catch (err) {
-        // eslint-disable-next-line no-console
-        console.error('Error updating stream session metrics', err);
-      }
-    }
+    await recordSessionFrame(cameraId, req.file.buffer.length);
 
-    return res.json({ ok: true, sessionId });
+    // hippoCount primero, como en /photo
+    return res.json({ ...(hippoCount !== undefined && { hippoCount }), ok: true, sessionId });
   } catch (err) {
     // eslint-disable-next-line no-console
     console.error('Error handling live-frame upload', err);
@@ -769,16 +1087,38 @@ app.post('/api/cameras/:cameraId/request-photo', (req, res) => {
   actions.photoRequested = true;
   actions.photoRequestedAt = Date.now();
   cameraActions.set(cameraId, actions);
+  notifyControlWaiters(cameraId);
 
   res.json({ ok: true, cameraId, action: 'photo' });
 });
 
+// Ráfaga: la cámara toma `count` fotos seguidas (cada `intervalMs`, 0 = lo que dé
+// el sensor), las guarda en memoria y las sube al terminar con ?trigger=burst.
+// POST /api/cameras/:cameraId/request-burst  { count?: number, intervalMs?: number }
+app.post('/api/cameras/:cameraId/request-burst', (req, res) => {
+  const { cameraId } = req.params;
+  const actions = cameraActions.get(cameraId) || {};
+
+  const count = Math.min(Math.max(Math.round(Number(req.body?.count) || 5), 1), 20);
+  const intervalMs = Math.min(Math.max(Math.round(Number(req.body?.intervalMs) || 0), 0), 10000);
+  actions.burstRequested = { count, intervalMs };
+  cameraActions.set(cameraId, actions);
+  notifyControlWaiters(cameraId);
+
+  res.json({ ok: true, cameraId, action: 'burst', count, intervalMs });
+});
+
 // Endpoint para que el frontend/server solicite que una cámara haga streaming durante un tiempo.
-// POST /api/cameras/:cameraId/request-stream  { durationSeconds?: number }
+// POST /api/cameras/:cameraId/request-stream  { durationSeconds?: number, transport?: "http" | "ws" }
+// `transport` permite elegir por sesión cómo envía la ESP32 los frames (por defecto, su config.h).
 app.post('/api/cameras/:cameraId/request-stream', async (req, res) => {
   try {
     const { cameraId } = req.params;
-    const { durationSeconds = 300 } = req.body || {};
+    const { durationSeconds = 300, transport } = req.body || {};
+
+    if (transport !== undefined && !['http', 'ws'].includes(transport)) {
+      return res.status(400).json({ error: 'transport must be "http" or "ws"' });
+    }
 
     const cameraRepo = AppDataSource.getRepository('Camera');
     const sessionRepo = AppDataSource.getRepository('StreamSession');
@@ -807,7 +1147,9 @@ app.post('/api/cameras/:cameraId/request-stream', async (req, res) => {
     const actions = cameraActions.get(cameraId) || {};
     actions.streamUntil = until;
     actions.currentStreamSessionId = savedSession.id;
+    actions.streamTransport = transport;
     cameraActions.set(cameraId, actions);
+    notifyControlWaiters(cameraId);
 
     // Programamos generación del MP4 para cuando termine el streaming (no bloquea el backend)
     scheduleVideoGeneration(savedSession.id, durationSeconds);
@@ -818,6 +1160,7 @@ app.post('/api/cameras/:cameraId/request-stream', async (req, res) => {
       action: 'stream',
       streamUntil: new Date(until).toISOString(),
       durationSeconds,
+      transport: transport || null,
       sessionId: savedSession.id,
     });
   } catch (err) {
@@ -827,36 +1170,176 @@ app.post('/api/cameras/:cameraId/request-stream', async (req, res) => {
   }
 });
 
-// Endpoint que la Raspberry consulta periódicamente para saber si debe tomar foto o hacer streaming.
-// GET /api/camera/:cameraId/take-photo-or-video
-// Respuesta: { action: "none" | "photo" | "stream", streamDurationSeconds?: number }
-app.get('/api/camera/:cameraId/take-photo-or-video', verifyCameraAuth, (req, res) => {
+// Parar un streaming en curso: la cámara lo recibe como "stop" en su siguiente consulta
+// POST /api/cameras/:cameraId/stop-stream
+app.post('/api/cameras/:cameraId/stop-stream', (req, res) => {
   const { cameraId } = req.params;
+  const actions = cameraActions.get(cameraId) || {};
+
+  actions.streamUntil = undefined;
+  actions.stopRequested = true;
+  cameraActions.set(cameraId, actions);
+  notifyControlWaiters(cameraId);
+
+  // El vídeo de la sesión se genera ya, sin esperar a la duración pedida
+  if (actions.currentStreamSessionId) scheduleVideoGeneration(actions.currentStreamSessionId, 0);
+
+  res.json({ ok: true, cameraId, action: 'stop' });
+});
+
+// Alargar el streaming en curso `seconds` segundos (la cámara recibe la nueva duración)
+// POST /api/cameras/:cameraId/extend-stream  { seconds?: number }
+app.post('/api/cameras/:cameraId/extend-stream', (req, res) => {
+  const { cameraId } = req.params;
+  const actions = cameraActions.get(cameraId) || {};
+  const now = Date.now();
+
+  if (!actions.streamUntil || actions.streamUntil <= now) {
+    return res.status(409).json({ error: 'No active stream for this camera' });
+  }
+  const seconds = Math.min(Math.max(Math.round(Number(req.body?.seconds) || 60), 1), 3600);
+  actions.streamUntil += seconds * 1000;
+  cameraActions.set(cameraId, actions);
+  notifyControlWaiters(cameraId);
+
+  const remainingSeconds = Math.round((actions.streamUntil - now) / 1000);
+  if (actions.currentStreamSessionId) {
+    scheduleVideoGeneration(actions.currentStreamSessionId, remainingSeconds);
+  }
+
+  return res.json({
+    ok: true,
+    cameraId,
+    action: 'stream',
+    streamUntil: new Date(actions.streamUntil).toISOString(),
+    durationSeconds: remainingSeconds,
+  });
+});
+
+// Calcula (y consume, en el caso de la foto) la siguiente acción pendiente de una cámara.
+// `streaming`: la cámara consulta en mitad de un streaming; solo se le avisa si
+// cambió el final del streaming o si hay que pararlo, y la ráfaga espera.
+const takeCameraAction = (cameraId, streaming = false) => {
   const now = Date.now();
   const actions = cameraActions.get(cameraId) || {};
 
   let action = 'none';
   let streamDurationSeconds = 0;
+  let burst = null;
 
-  // Prioridad: primero foto (evento puntual), luego stream, luego nada
+  // Prioridad: primero foto (evento puntual), luego parar, ráfaga, stream y nada
   if (actions.photoRequested) {
     action = 'photo';
     actions.photoRequested = false; // se consume la petición de foto
+    actions.photoDuringStream = streaming;
+  } else if (streaming && actions.stopRequested) {
+    action = 'stop';
+    actions.stopRequested = false;
+  } else if (actions.burstRequested && !streaming) {
+    action = 'burst';
+    burst = actions.burstRequested;
+    actions.burstRequested = undefined;
   } else if (actions.streamUntil && actions.streamUntil > now) {
-    action = 'stream';
-    streamDurationSeconds = Math.round((actions.streamUntil - now) / 1000);
+    if (!streaming || actions.streamSentUntil !== actions.streamUntil) {
+      action = 'stream';
+      streamDurationSeconds = Math.round((actions.streamUntil - now) / 1000);
+      actions.streamSentUntil = actions.streamUntil;
+    }
   } else {
     // Si ya ha pasado el tiempo de streaming, limpiamos
     actions.streamUntil = undefined;
   }
+  // Una orden de parar que llega con la cámara ya fuera del streaming no aplica
+  if (!streaming) actions.stopRequested = false;
 
   cameraActions.set(cameraId, actions);
 
-  res.json({
+  const response = {
     cameraId,
     action,
     streamDurationSeconds,
+  };
+  if (action === 'stream' && actions.streamTransport) {
+    response.transport = actions.streamTransport;
+  }
+  if (burst) {
+    response.count = burst.count;
+    response.intervalMs = burst.intervalMs;
+  }
+  // En mitad de un streaming cada respuesta lleva la región vigente; sin "roi",
+  // la cámara vuelve al campo completo
+  if (streaming && STREAM_ROI_ENABLED) {
+    const roi = currentStreamRoi(actions, now);
+    actions.roiSentId = roi ? roi.id : 0;
+    if (roi) {
+      response.roi = {
+        x: roi.x,
+        y: roi.y,
+        w: roi.w,
+        h: roi.h,
+        ttlMs: Math.max(0, STREAM_ROI_TTL_MS - (now - roi.confirmedAt)),
+      };
+    }
+  }
+  return response;
+};
+
+// Endpoint que la Raspberry consulta periódicamente para saber si debe tomar foto o hacer streaming.
+// GET /api/camera/:cameraId/take-photo-or-video[?wait=N][&streaming=1]
+// Respuesta: { action: "none" | "photo" | "burst" | "stream" | "stop", streamDurationSeconds?: number,
+//              transport?: "http" | "ws", count?: number, intervalMs?: number, longPoll?: true }
+//
+// Con ?streaming=1 (la cámara está en mitad de un streaming) "stream" solo llega si
+// cambió la duración y "stop" pide cortarlo. Además lleva la región de interés vigente,
+// roi?: { x, y, w, h (milésimas del campo completo), ttlMs }, y un long-poll vuelve
+// en cuanto aparece, cambia o caduca.
+//
+// Con ?wait=N (segundos, máx. MAX_CONTROL_WAIT_SECONDS) y sin acción pendiente, la respuesta
+// se retiene hasta que llegue una acción o venza la espera (long-poll). `longPoll: true`
+// indica a la cámara que el servidor lo soporta; si falta, la cámara vuelve a sondear.
+app.get('/api/camera/:cameraId/take-photo-or-video', verifyCameraAuth, (req, res) => {
+  const { cameraId } = req.params;
+  const waitSeconds = Math.min(Math.max(Number(req.query.wait) || 0, 0), MAX_CONTROL_WAIT_SECONDS);
+  const longPoll = waitSeconds > 0;
+  const streaming = req.query.streaming === '1';
+
+  const roiPending = streaming && streamRoiPending(cameraId);
+  const first = takeCameraAction(cameraId, streaming);
+  if (first.action !== 'none' || roiPending || !longPoll) {
+    return res.json(longPoll ? { ...first, longPoll } : first);
+  }
+
+  let done = false;
+  const finish = () => {
+    if (done) return;
+    done = true;
+    clearTimeout(timer);
+    const waiters = controlWaiters.get(cameraId);
+    if (waiters) {
+      waiters.delete(finish);
+      if (!waiters.size) controlWaiters.delete(cameraId);
+    }
+    if (!res.writableEnded && !res.destroyed) {
+      res.json({ ...takeCameraAction(cameraId, streaming), longPoll });
+    }
+  };
+
+  const timer = setTimeout(finish, waitSeconds * 1000);
+  if (!controlWaiters.has(cameraId)) controlWaiters.set(cameraId, new Set());
+  controlWaiters.get(cameraId).add(finish);
+
+  // Si la cámara corta la conexión, se deja de esperar sin consumir acciones
+  res.on('close', () => {
+    if (done) return;
+    done = true;
+    clearTimeout(timer);
+    const waiters = controlWaiters.get(cameraId);
+    if (waiters) {
+      waiters.delete(finish);
+      if (!waiters.size) controlWaiters.delete(cameraId);
+    }
   });
+  return undefined;
 });
 
 // Simple endpoints for the frontend to read current state
@@ -1200,11 +1683,20 @@ wss.on('connection', (ws, req) => {
     // Aceptamos tanto binario puro como texto y lo convertimos siempre a Buffer
     const buffer = isBinary || Buffer.isBuffer(data) ? data : Buffer.from(data);
 
+    const nowTs = Date.now();
     latestFrames.set(cameraId, {
       buffer,
-      timestamp: Date.now(),
+      timestamp: nowTs,
     });
 
+    // Con una sesión de streaming activa (p. ej. ESP32 en modo WebSocket) el frame
+    // se guarda y se contabiliza igual que los que llegan por POST /live-frame.
+    const actions = cameraActions.get(cameraId) || {};
+    if (actions.currentStreamSessionId && actions.streamUntil && actions.streamUntil > nowTs) {
+      saveLiveFrame(cameraId, buffer, nowTs);
+      recordSessionFrame(cameraId, buffer.length);
+    }
+
     // eslint-disable-next-line no-console
     console.log('[WS] Frame recibido de cámara', cameraId, 'bytes:', buffer.length);
   });
@@ -0,0 +1,578 @@
+#!/usr/bin/env python3
+"""
+Entrena el clasificador diminuto de hipopótamos que corre en la ESP32-CAM,
+lo cuantiza a int8 y lo exporta para el firmware (`esp32/src/tinyml_model.h`).
+
+La cámara no puede con YOLO: este modelo solo decide si una foto pequeña en
+gris (96x96) tiene o no un hipopótamo, para no subir las que no. Se entrena
+con el mismo dataset unificado que `train_unified_yolo.py` (una imagen es
+positiva si tiene alguna caja de hipopótamo) y se cuantiza como TFLite Micro:
+activaciones int8 asimétricas, pesos int8 por canal y reescalado en punto fijo.
+
+Salidas:
+    - esp32/src/tinyml_model_data.h: el blob compilado en el firmware
+    - hippo_tinyml.bin: el mismo blob, para `pio run -e bench_tinyml --model`
+
+Con --teacher y --label-images, además, etiqueta imágenes con el modelo YOLO
+del servidor (una línea "<imagen> <hipopótamos>") para medir en el banco de
+pruebas la concordancia del clasificador con él.
+
+Requisitos:
+    pip install ultralytics opencv-python
+
+Uso de ejemplo:
+    python export_tinyml.py --epochs 30
+    python export_tinyml.py --skip-train --teacher best.pt \
+        --label-images ../runs/detect/val/*.jpg
+"""
+
+from __future__ import annotations
+
+import argparse
+import math
+import random
+import struct
+from pathlib import Path
+from typing import Dict, List, Tuple
+
+import cv2
+import torch
+import torch.nn as nn
+import yaml
+
+from hippo_inference import get_hippo_class_ids
+
+
+DEFAULT_DATA_YAML = Path(
+    "/media/sergio/DATOS/TPI2/yolo/unified_yolo_dataset/data.yaml"
+)
+REPO_ROOT = Path(__file__).resolve().parent.parent
+DEFAULT_HEADER = REPO_ROOT / "esp32" / "src" / "tinyml_model_data.h"
+IMAGE_SUFFIXES = {".jpg", ".jpeg", ".png", ".bmp"}
+
+# Tipos de capa del blob (TinymlLayerType en tinyml_model.h)
+LAYER_CONV = 1
+LAYER_DEPTHWISE = 2
+LAYER_AVGPOOL = 3
+LAYER_DENSE = 4
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(
+        description=(
+            "Entrenar, cuantizar a int8 y exportar el clasificador de "
+            "hipopótamos de la ESP32-CAM."
+        )
+    )
+    parser.add_argument(
+        "--data",
+        type=str,
+        default=str(DEFAULT_DATA_YAML),
+        help="Ruta a data.yaml del dataset unificado.",
+    )
+    parser.add_argument(
+        "--imgsz",
+        type=int,
+        default=96,
+        help="Lado de la rejilla en gris (por defecto 96, la del detector de movimiento).",
+    )
+    parser.add_argument(
+        "--epochs",
+        type=int,
+        default=30,
+        help="Épocas de entrenamiento (por defecto 30; el modelo es diminuto).",
+    )
+    parser.add_argument(
+        "--batch",
+        type=int,
+        default=64,
+        help="Tamaño de batch (por defecto 64).",
+    )
+    parser.add_argument(
+        "--device",
+        type=str,
+        default="cpu",
+        help='Dispositivo para entrenar: "cpu" (por defecto) o índice de GPU.',
+    )
+    parser.add_argument(
+        "--calib",
+        type=int,
+        default=200,
+        help="Imágenes de entrenamiento para calibrar los rangos int8 (por defecto 200).",
+    )
+    parser.add_argument(
+        "--out-header",
+        type=str,
+        default=str(DEFAULT_HEADER),
+        help="Cabecera del firmware a sobrescribir con el modelo.",
+    )
+    parser.add_argument(
+        "--out-bin",
+        type=str,
+        default="hippo_tinyml.bin",
+        help="Blob del modelo para el banco de pruebas.",
+    )
+    parser.add_argument(
+        "--skip-train",
+        action="store_true",
+        help="No entrenar ni exportar (solo etiquetar con --teacher).",
+    )
+    parser.add_argument(
+        "--teacher",
+        type=str,
+        default=None,
+        help="Pesos YOLO del servidor (.pt) para etiquetar --label-images.",
+    )
+    parser.add_argument(
+        "--label-images",
+        type=str,
+        nargs="*",
+        default=[],
+        help="Imágenes a etiquetar con el modelo del servidor.",
+    )
+    parser.add_argument(
+        "--labels-out",
+        type=str,
+        default="tinyml_labels.txt",
+        help='Fichero de etiquetas para el banco ("<imagen> <hipopótamos>").',
+    )
+    parser.add_argument(
+        "--conf",
+        type=float,
+        default=0.4,
+        help="Confianza mínima del modelo del servidor (por defecto 0.4, como hippo_inference.py).",
+    )
+    return parser.parse_args()
+
+
+# ============================================================================
+# DATASET
+# ============================================================================
+
+
+def load_gray(path: Path, size: int) -> torch.Tensor | None:
+    """Imagen en gris reducida a size x size promediando, como motion_jpeg.h."""
+    img = cv2.imread(str(path), cv2.IMREAD_GRAYSCALE)
+    if img is None:
+        return None
+    img = cv2.resize(img, (size, size), interpolation=cv2.INTER_AREA)
+    return torch.from_numpy(img).float().div_(255.0).unsqueeze(0)
+
+
+def split_images(data: dict, data_yaml: Path, split: str) -> List[Path]:
+    entry = data.get(split)
+    if not entry:
+        return []
+    root = Path(data.get("path") or data_yaml.parent)
+    if not root.is_absolute():
+        root = data_yaml.parent / root
+    entries = entry if isinstance(entry, list) else [entry]
+    images: List[Path] = []
+    for e in entries:
+        d = Path(e) if Path(e).is_absolute() else root / e
+        images += sorted(p for p in d.rglob("*") if p.suffix.lower() in IMAGE_SUFFIXES)
+    return images
+
+
+def label_path(image: Path) -> Path:
+    """images/xxx.jpg -> labels/xxx.txt (estructura de Ultralytics)."""
+    parts = list(image.parts)
+    for i in range(len(parts) - 1, -1, -1):
+        if parts[i] == "images":
+            parts[i] = "labels"
+            break
+    return Path(*parts).with_suffix(".txt")
+
+
+def has_hippo(image: Path, hippo_ids: List[int]) -> bool:
+    labels = label_path(image)
+    if not labels.is_file():
+        return False
+    for line in labels.read_text().splitlines():
+        fields = line.split()
+        if fields and int(float(fields[0])) in hippo_ids:
+            return True
+    return False
+
+
+def load_split(
+    images: List[Path], hippo_ids: List[int], size: int
+) -> Tuple[torch.Tensor, torch.Tensor]:
+    xs, ys = [], []
+    for image in images:
+        x = load_gray(image, size)
+        if x is None:
+            continue
+        xs.append(x)
+        ys.append(1.0 if has_hippo(image, hippo_ids) else 0.0)
+    if not xs:
+        return torch.empty(0, 1, size, size), torch.empty(0)
+    return torch.stack(xs), torch.tensor(ys)
+
+
+# ============================================================================
+# MODELO
+# ============================================================================
+
+
+def conv_bn(cin: int, cout: int, k: int, stride: int, groups: int = 1) -> nn.Sequential:
+    return nn.Sequential(
+        nn.Conv2d(cin, cout, k, stride, k // 2, groups=groups, bias=False),
+        nn.BatchNorm2d(cout),
+        nn.ReLU(inplace=True),
+    )
+
+
+class TinyHippoNet(nn.Module):
+    """Misma arquitectura que el modelo aleatorio de esp32/bench/tinyml_bench.cpp."""
+
+    def __init__(self) -> None:
+        super().__init__()
+        self.features = nn.Sequential(
+            conv_bn(1, 8, 3, 2),
+            conv_bn(8, 8, 3, 2, groups=8),
+            conv_bn(8, 16, 1, 1),
+            conv_bn(16, 16, 3, 2, groups=16),
+            conv_bn(16, 32, 1, 1),
+            conv_bn(32, 32, 3, 2, groups=32),
+            conv_bn(32, 64, 1, 1),
+        )
+        self.pool = nn.AdaptiveAvgPool2d(1)
+        self.fc = nn.Linear(64, 1)
+
+    def forward(self, x: torch.Tensor) -> torch.Tensor:
+        return self.fc(self.pool(self.features(x)).flatten(1)).squeeze(1)
+
+
+def augment(x: torch.Tensor) -> torch.Tensor:
+    """Volteo horizontal y cambios de brillo / contraste (luz de la charca)."""
+    flip = torch.rand(x.shape[0], device=x.device) < 0.5
+    x = torch.where(flip[:, None, None, None], x.flip(3), x)
+    gain = 0.7 + 0.6 * torch.rand(x.shape[0], 1, 1, 1, device=x.device)
+    offset = 0.15 * (torch.rand(x.shape[0], 1, 1, 1, device=x.device) - 0.5)
+    return (x * gain + offset).clamp_(0.0, 1.0)
+
+
+def accuracy(model: nn.Module, x: torch.Tensor, y: torch.Tensor, device: str) -> float:
+    if len(x) == 0:
+        return float("nan")
+    model.eval()
+    with torch.no_grad():
+        logits = torch.cat([model(x[i:i + 256].to(device)).cpu() for i in range(0, len(x), 256)])
+    return float(((logits > 0).float() == y).float().mean())
+
+
+def train(
+    model: nn.Module,
+    data: Tuple[torch.Tensor, torch.Tensor],
+    val: Tuple[torch.Tensor, torch.Tensor],
+    args: argparse.Namespace,
+) -> nn.Module:
+    x, y = data
+    positives = float(y.sum())
+    # Las fotos sin hipopótamo suelen ser mayoría: se compensa en la pérdida
+    pos_weight = torch.tensor([(len(y) - positives) / max(positives, 1.0)], device=args.device)
+    loss_fn = nn.BCEWithLogitsLoss(pos_weight=pos_weight)
+    optimizer = torch.optim.Adam(model.parameters(), lr=3e-3)
+    scheduler = torch.optim.lr_scheduler.CosineAnnealingLR(optimizer, args.epochs)
+
+    best_acc, best_state = -1.0, None
+    for epoch in range(1, args.epochs + 1):
+        model.train()
+        order = torch.randperm(len(x))
+        total = 0.0
+        for i in range(0, len(x), args.batch):
+            idx = order[i:i + args.batch]
+            xb = augment(x[idx].to(args.device))
+            loss = loss_fn(model(xb), y[idx].to(args.device))
+            optimizer.zero_grad()
+            loss.backward()
+            optimizer.step()
+            total += float(loss) * len(idx)
+        scheduler.step()
+
+        val_acc = accuracy(model, *val, args.device)
+        print(f"Época {epoch}/{args.epochs}: pérdida {total / len(x):.4f}, acierto val {val_acc:.3f}")
+        if math.isnan(val_acc) or val_acc >= best_acc:
+            best_acc = val_acc
+            best_state = {k: v.detach().clone() for k, v in model.state_dict().items()}
+
+    if best_state is not None:
+        model.load_state_dict(best_state)
+    return model.cpu().eval()
+
+
+# ============================================================================
+# CUANTIZACIÓN INT8
+# ============================================================================
+
+
+class FusedLayer:
+    """Capa con la BatchNorm ya metida en los pesos (lo que ejecuta la cámara)."""
+
+    def __init__(self, kind: int, weight: torch.Tensor | None, bias: torch.Tensor | None,
+                 kernel: int = 0, stride: int = 0, pad: int = 0, relu: bool = False,
+                 channels: int = 0) -> None:
+        self.kind = kind
+        self.weight = weight
+        self.bias = bias
+        self.kernel = kernel
+        self.stride = stride
+        self.pad = pad
+        self.relu = relu
+        self.channels = channels
+
+    def forward(self, x: torch.Tensor) -> torch.Tensor:
+        if self.kind == LAYER_AVGPOOL:
+            return x.mean(dim=(2, 3), keepdim=True)
+        if self.kind == LAYER_DENSE:
+            y = x.flatten(1) @ self.weight.t() + self.bias
+            return y[:, :, None, None]
+        groups = self.channels if self.kind == LAYER_DEPTHWISE else 1
+        y = nn.functional.conv2d(x, self.weight, self.bias, self.stride, self.pad, groups=groups)
+        return y.clamp(min=0) if self.relu else y
+
+
+def fuse(model: TinyHippoNet) -> List[FusedLayer]:
+    layers: List[FusedLayer] = []
+    for block in model.features:
+        conv, bn = block[0], block[1]
+        scale = bn.weight / torch.sqrt(bn.running_var + bn.eps)
+        weight = conv.weight * scale[:, None, None, None]
+        bias = bn.bias - bn.running_mean * scale
+        depthwise = conv.groups > 1
+        layers.append(FusedLayer(
+            LAYER_DEPTHWISE if depthwise else LAYER_CONV, weight.detach(), bias.detach(),
+            conv.kernel_size[0], conv.stride[0], conv.padding[0], True, conv.out_channels,
+        ))
+    layers.append(FusedLayer(LAYER_AVGPOOL, None, None, channels=model.fc.in_features))
+    layers.append(FusedLayer(LAYER_DENSE, model.fc.weight.detach(), model.fc.bias.detach(),
+                             channels=1))
+    return layers
+
+
+def activation_params(lo: float, hi: float) -> Tuple[float, int]:
+    """Scale y zero point int8 asimétricos que cubren [lo, hi] (con el 0 dentro)."""
+    lo, hi = min(lo, 0.0), max(hi, 0.0)
+    scale = max(hi - lo, 1e-6) / 255.0
+    zero = int(round(-128 - lo / scale))
+    return scale, max(-128, min(127, zero))
+
+
+def quantize_multiplier(real: float) -> Tuple[int, int]:
+    """real = mult * 2^shift / 2^31 con mult en [2^30, 2^31) (tinymlRequantize)."""
+    if real == 0.0:
+        return 0, 0
+    mantissa, exponent = math.frexp(real)
+    q = int(round(mantissa * (1 << 31)))
+    if q == 1 << 31:
+        q //= 2
+        exponent += 1
+    return q, exponent
+
+
+def calibrate(layers: List[FusedLayer], x: torch.Tensor) -> List[Tuple[float, float]]:
+    ranges = []
+    with torch.no_grad():
+        for layer in layers:
+            x = layer.forward(x)
+            ranges.append((float(x.min()), float(x.max())))
+    return ranges
+
+
+class QuantLayer:
+    def __init__(self, fused: FusedLayer, in_params: Tuple[float, int],
+                 out_params: Tuple[float, int]) -> None:
+        self.fused = fused
+        self.in_scale, self.in_zero = in_params
+        self.out_scale, self.out_zero = out_params
+        self.weights: torch.Tensor | None = None
+        self.bias: List[int] = []
+        self.mult: List[int] = []
+        self.shift: List[int] = []
+        self.real_mult: List[float] = []
+        if fused.weight is None:
+            return
+        w = fused.weight
+        flat = w.reshape(w.shape[0], -1)
+        w_scale = flat.abs().max(dim=1).values.clamp(min=1e-8) / 127.0
+        shape = (-1,) + (1,) * (w.dim() - 1)
+        self.weights = torch.round(w / w_scale.reshape(shape)).clamp(-127, 127).to(torch.int8)
+        for c in range(w.shape[0]):
+            acc_scale = self.in_scale * float(w_scale[c])
+            self.bias.append(int(round(float(fused.bias[c]) / acc_scale)))
+            real = acc_scale / self.out_scale
+            self.real_mult.append(real)
+            m, s = quantize_multiplier(real)
+            self.mult.append(m)
+            self.shift.append(s)
+
+    def run(self, q: torch.Tensor) -> torch.Tensor:
+        """Inferencia entera simulada (float64 exacto en los acumuladores)."""
+        f = self.fused
+        if f.kind == LAYER_AVGPOOL:
+            return torch.round(q.double().mean(dim=(2, 3), keepdim=True))
+        x = q.double() - self.in_zero
+        w = self.weights.double()
+        bias = torch.tensor(self.bias, dtype=torch.float64)
+        if f.kind == LAYER_DENSE:
+            acc = (x.flatten(1) @ w.t() + bias)[:, :, None, None]
+        else:
+            groups = f.channels if f.kind == LAYER_DEPTHWISE else 1
+            acc = nn.functional.conv2d(x, w, bias, f.stride, f.pad, groups=groups)
+        real = torch.tensor(self.real_mult, dtype=torch.float64)[None, :, None, None]
+        y = torch.round(acc * real) + self.out_zero
+        low = self.out_zero if f.relu else -128
+        return y.clamp(low, 127)
+
+    def serialize(self) -> bytes:
+        f = self.fused
+        if f.kind == LAYER_AVGPOOL:
+            data = b""
+            channels = f.channels
+        else:
+            w = self.weights
+            if f.kind == LAYER_CONV:
+                w = w.permute(0, 2, 3, 1)          # OIHW -> OHWI
+            elif f.kind == LAYER_DEPTHWISE:
+                w = w[:, 0].permute(1, 2, 0)       # C1HW -> HWC
+            channels = len(self.bias)
+            data = struct.pack(f"<{channels}i", *self.bias)
+            data += struct.pack(f"<{channels}i", *self.mult)
+            data += struct.pack(f"<{channels}i", *self.shift)
+            data += w.contiguous().numpy().tobytes()
+            data += b"\0" * (-len(data) % 4)
+        header = struct.pack(
+            "<BBBBHbBfI", f.kind, f.kernel, f.stride, f.pad, channels, self.out_zero,
+            1 if f.relu else 0, self.out_scale, len(data),
+        )
+        return header + data
+
+
+def quantize(layers: List[FusedLayer], calib: torch.Tensor) -> List[QuantLayer]:
+    ranges = calibrate(layers, calib)
+    in_params = (1.0 / 255.0, -128)       # Gris: q = píxel - 128
+    quant = []
+    for layer, (lo, hi) in zip(layers, ranges):
+        # El pooling no cambia la cuantización
+        out_params = in_params if layer.kind == LAYER_AVGPOOL else activation_params(lo, hi)
+        quant.append(QuantLayer(layer, in_params, out_params))
+        in_params = out_params
+    return quant
+
+
+def run_int8(quant: List[QuantLayer], x: torch.Tensor) -> torch.Tensor:
+    """Logits reales del modelo int8 para un lote de imágenes 0-1."""
+    q = torch.round(x.double() * 255.0) - 128
+    for layer in quant:
+        q = layer.run(q)
+    last = quant[-1]
+    return ((q - last.out_zero) * last.out_scale).flatten().float()
+
+
+def serialize(quant: List[QuantLayer], size: int) -> bytes:
+    body = b"".join(layer.serialize() for layer in quant)
+    total = 16 + len(body)
+    header = b"HTM1" + struct.pack("<HHBBHI", size, size, 1, len(quant), 0, total)
+    return header + body
+
+
+def write_header(blob: bytes, path: Path) -> None:
+    lines = [
+        "/**",
+        " * Modelo compilado del clasificador en la cámara (ver tinyml_model.h)",
+        " *",
+        " * Generado por yolo/export_tinyml.py: no editar a mano.",
+        " */",
+        "",
+        "#ifndef TINYML_MODEL_DATA_H",
+        "#define TINYML_MODEL_DATA_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"#define TINYML_MODEL_LEN {len(blob)}",
+        "",
+        "alignas(4) static const uint8_t kTinymlModel[] = {",
+    ]
+    for i in range(0, len(blob), 16):
+        lines.append("    " + ", ".join(f"0x{b:02x}" for b in blob[i:i + 16]) + ",")
+    lines += ["};", "", "#endif // TINYML_MODEL_DATA_H", ""]
+    path.write_text("\n".join(lines))
+
+
+# ============================================================================
+# ETIQUETAS DEL MODELO DEL SERVIDOR
+# ============================================================================
+
+
+def label_with_teacher(args: argparse.Namespace) -> None:
+    from ultralytics import YOLO
+
+    teacher = YOLO(args.teacher)
+    hippo_ids = get_hippo_class_ids(teacher.names)
+    lines = [f"# {args.teacher} conf={args.conf}"]
+    for image in args.label_images:
+        results = teacher(image, conf=args.conf, verbose=False)
+        count = 0
+        if results:
+            count = sum(1 for box in results[0].boxes if int(box.cls) in hippo_ids)
+        lines.append(f"{Path(image).name} {count}")
+        print(f"{Path(image).name}: {count} hipopótamos")
+    Path(args.labels_out).write_text("\n".join(lines) + "\n")
+    print(f"Etiquetas guardadas en: {args.labels_out}")
+
+
+def main() -> None:
+    args = parse_args()
+
+    if args.teacher and args.label_images:
+        label_with_teacher(args)
+    if args.skip_train:
+        return
+
+    data_yaml = Path(args.data)
+    if not data_yaml.is_file():
+        raise FileNotFoundError(f"No se encontró data.yaml en: {data_yaml}")
+    data = yaml.safe_load(data_yaml.read_text())
+    names: Dict[int, str] = data["names"]
+    if isinstance(names, list):
+        names = dict(enumerate(names))
+    hippo_ids = get_hippo_class_ids(names)
+    if not hippo_ids:
+        raise ValueError(f"Ninguna clase de hipopótamo en {data_yaml}: {names}")
+
+    train_set = load_split(split_images(data, data_yaml, "train"), hippo_ids, args.imgsz)
+    val_set = load_split(split_images(data, data_yaml, "val"), hippo_ids, args.imgsz)
+    if len(train_set[0]) == 0:
+        raise FileNotFoundError("No se encontraron imágenes de entrenamiento")
+    print(
+        f"Entrenamiento: {len(train_set[0])} imágenes ({int(train_set[1].sum())} con hipopótamo), "
+        f"validación: {len(val_set[0])}"
+    )
+
+    random.seed(0)
+    torch.manual_seed(0)
+    model = train(TinyHippoNet().to(args.device), train_set, val_set, args)
+
+    # Cuantización con imágenes de entrenamiento y comprobación en validación
+    calib_idx = torch.randperm(len(train_set[0]))[: args.calib]
+    quant = quantize(fuse(model), train_set[0][calib_idx])
+    if len(val_set[0]) > 0:
+        with torch.no_grad():
+            float_logits = model(val_set[0])
+        int8_logits = run_int8(quant, val_set[0])
+        same = float(((float_logits > 0) == (int8_logits > 0)).float().mean())
+        acc = float(((int8_logits > 0).float() == val_set[1]).float().mean())
+        print(f"Validación int8: acierto {acc:.3f}, mismo veredicto que float {same:.3f}")
+
+    blob = serialize(quant, args.imgsz)
+    Path(args.out_bin).write_bytes(blob)
+    write_header(blob, Path(args.out_header))
+    weights = sum(l.weights.numel() for l in quant if l.weights is not None)
+    print(f"Modelo int8: {len(blob)} bytes ({weights} pesos)")
+    print(f"Blob guardado en: {args.out_bin}")
+    print(f"Cabecera del firmware: {args.out_header}")
+
+
+if __name__ == "__main__":
+    main()
@@ -169,6 +169,9 @@ def main() -> None:
     # Estructura de salida común (fácil de parsear)
     result_data = {
         "image": str(image_path),
+        # Tamaño de la imagen analizada: las cajas van en sus píxeles
+        "image_width": int(result.orig_shape[1]),
+        "image_height": int(result.orig_shape[0]),
         "num_hippos": len(hippo_detections),
         "hippos": [
             {